@@ -0,0 +1,430 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "kit-alloc.h"
+#include "sxe-jitson.h"
+#include "sxe-jitson-in.h"
+#include "sxe-jitson-intersect.h"
+
+#define PARSE_BYTES 100000000    // Default number of bytes of each document to parse or generate
+
+static const char *only = NULL;    // If not NULL, only run benchmarks whose names begin with this prefix
+
+static const struct {
+    const char *suffix;    // Appended to the document name to give the variant reported
+    uint32_t    flags;     // Flags to parse with
+} parse_modes[] = {{"", SXE_JITSON_FLAG_STRICT}, {"-optimize", SXE_JITSON_FLAG_OPTIMIZE}, {"-lazy", SXE_JITSON_FLAG_LAZY}};
+
+static uint64_t
+usec_elapsed(struct timeval *start, struct timeval *end)
+{
+    struct timeval end_time;
+
+    if (end == NULL) {
+        end = &end_time;
+        assert(gettimeofday(end, NULL) == 0);
+    }
+
+    return (uint64_t)(end->tv_sec - start->tv_sec) * 1000000 + end->tv_usec - start->tv_usec;
+}
+
+/* Return true if the named benchmark was selected to be run
+ */
+static bool
+selected(const char *bench)
+{
+    return only == NULL || strncmp(bench, only, strlen(only)) == 0;
+}
+
+/* Report a result as a single line of space separated name=value pairs. The names and their order are stable, so tools can track
+ * trends in the results. If bytes is not 0, throughput is included.
+ */
+static void
+report(const char *bench, const char *variant, unsigned long ops, size_t bytes, uint64_t usec)
+{
+    printf("bench=%s variant=%s ops=%lu usec=%"PRIu64" ns_per_op=%.1f", bench, variant, ops, usec,
+           ops ? (double)usec * 1000.0 / ops : 0.0);
+
+    if (bytes)
+        printf(" bytes=%zu mb_per_sec=%.1f", bytes, usec ? (double)bytes / usec : 0.0);
+
+    printf("\n");
+    fflush(stdout);
+}
+
+/* Documents used to benchmark parsing and encoding, each representative of a kind of JSON commonly handled
+ */
+static char *
+make_small_object(void)
+{
+    return kit_strdup("{\"id\":12345,\"name\":\"Jane Doe\",\"active\":true,\"score\":97.5,\"tags\":[\"admin\",\"dev\"],"
+                      "\"address\":{\"city\":\"Ottawa\",\"zip\":\"K1A 0B1\"}}");
+}
+
+static char *
+make_numeric_array(unsigned elements)
+{
+    size_t   len, size = (size_t)elements * 24 + 2;
+    char    *json;
+    unsigned i;
+
+    assert((json = kit_malloc(size)));
+
+    for (len = 0, i = 0; i < elements; i++)
+        len += i % 2 ? snprintf(&json[len], size - len, ",%u", i * 7919)
+                     : snprintf(&json[len], size - len, "%c%u.%03u", i ? ',' : '[', i, i % 1000);
+
+    snprintf(&json[len], size - len, "]");
+    return json;
+}
+
+static char *
+make_string_array(unsigned elements)
+{
+    size_t   len, size = (size_t)elements * 64 + 2;
+    char    *json;
+    unsigned i;
+
+    assert((json = kit_malloc(size)));
+
+    for (len = 0, i = 0; i < elements; i++)
+        len += i % 8 ? snprintf(&json[len], size - len, "%c\"a plain run of text number %u\"", i ? ',' : '[', i)
+                     : snprintf(&json[len], size - len, "%c\"escapes\\t\\\"%u\\\"\\u00e9\"", i ? ',' : '[', i);
+
+    snprintf(&json[len], size - len, "]");
+    return json;
+}
+
+static char *
+make_nested(unsigned depth)
+{
+    size_t   len, size = (size_t)depth * 16 + 8;
+    char    *json;
+    unsigned i;
+
+    assert((json = kit_malloc(size)));
+
+    for (len = 0, i = 0; i < depth; i++)
+        len += snprintf(&json[len], size - len, "{\"n\":%u,\"a\":[", i);
+
+    len += snprintf(&json[len], size - len, "null");
+
+    for (i = 0; i < depth; i++)
+        len += snprintf(&json[len], size - len, "]}");
+
+    return json;
+}
+
+/* Benchmark parsing a document repeatedly until about 'bytes' bytes have been parsed, then encoding it back to JSON the same way
+ */
+static void
+bench_parse_and_encode(const char *variant, char *json, size_t bytes)
+{
+    struct sxe_jitson_source source;
+    struct sxe_jitson_stack *stack;
+    struct sxe_jitson       *jitson;
+    struct timeval           start_time;
+    char                    *encoded;
+    size_t                   encoded_len, len, total;
+    unsigned long            i, iterations;
+    unsigned                 mode;
+    char                     name[64];
+
+    assert((stack = sxe_jitson_stack_get_thread()));
+    len        = strlen(json);
+    iterations = bytes / len ?: 1;
+
+    for (mode = 0; mode < sizeof(parse_modes) / sizeof(parse_modes[0]) && selected("parse"); mode++) {
+        assert(gettimeofday(&start_time, NULL) == 0);
+
+        for (i = 0; i < iterations; i++) {
+            sxe_jitson_source_from_buffer(&source, json, len, parse_modes[mode].flags);
+            assert(sxe_jitson_stack_load_json(stack, &source));
+            sxe_jitson_free(sxe_jitson_stack_get_jitson(stack));
+        }
+
+        snprintf(name, sizeof(name), "%s%s", variant, parse_modes[mode].suffix);
+        report("parse", name, iterations, iterations * len, usec_elapsed(&start_time, NULL));
+    }
+
+    if (!selected("to_json"))
+        return;
+
+    sxe_jitson_source_from_buffer(&source, json, len, SXE_JITSON_FLAG_STRICT);
+    assert(sxe_jitson_stack_load_json(stack, &source));
+    assert((jitson = sxe_jitson_stack_get_jitson(stack)));
+    assert(gettimeofday(&start_time, NULL) == 0);
+
+    for (total = 0, i = 0; i < iterations; i++) {
+        assert((encoded = sxe_jitson_to_json(jitson, &encoded_len)));
+        total += encoded_len;
+        kit_free(encoded);
+    }
+
+    report("to_json", variant, iterations, total, usec_elapsed(&start_time, NULL));
+    sxe_jitson_free(jitson);
+}
+
+/* Benchmark looking up members of a large object, with a perfect hash index if optimize is true. Cold lookups are the first on
+ * each freshly parsed object, and include building its index. Warm lookups use the index.
+ */
+static void
+bench_member_lookup(unsigned members, unsigned long lookups, bool optimize)
+{
+    struct sxe_jitson_source  source;
+    struct sxe_jitson_stack  *stack;
+    struct sxe_jitson        *object;
+    char                    **names;
+    char                     *json;
+    struct timeval            start_time;
+    uint64_t                  usec;
+    size_t                    len, size;
+    unsigned long             cold, i;
+    char                      name[32];
+
+    size = (size_t)members * (sizeof(name) + 16) + 2;
+    assert((json  = kit_malloc(size)));
+    assert((names = kit_malloc(members * sizeof(*names))));
+
+    for (len = 0, i = 0; i < members; i++) {
+        snprintf(name, sizeof(name), "match_variable_%lx", i);
+        assert((names[i] = kit_strdup(name)));
+        len += snprintf(&json[len], size - len, "%c\"%s\":%lu", i ? ',' : '{', name, i);
+    }
+
+    snprintf(&json[len], size - len, "}");
+    assert((stack = sxe_jitson_stack_get_thread()));
+    cold = lookups / members / 16 ?: 1;    // Index building is costly, so do far fewer cold lookups
+
+    for (usec = 0, i = 0; i < cold; i++) {
+        sxe_jitson_source_from_string(&source, json, optimize ? SXE_JITSON_FLAG_OPTIMIZE : SXE_JITSON_FLAG_STRICT);
+        assert(sxe_jitson_stack_load_json(stack, &source));
+        assert((object = sxe_jitson_stack_get_jitson(stack)));
+        assert(gettimeofday(&start_time, NULL) == 0);
+        assert(sxe_jitson_object_get_member(object, names[i % members], 0));    // Index the object
+        usec += usec_elapsed(&start_time, NULL);
+
+        if (i < cold - 1)
+            sxe_jitson_free(object);
+    }
+
+    report("member-lookup-cold", optimize ? "perfect" : "chained", cold, 0, usec);
+    assert(gettimeofday(&start_time, NULL) == 0);
+
+    for (i = 0; i < lookups; i++)
+        assert(sxe_jitson_get_uint(sxe_jitson_object_get_member(object, names[i % members], 0)) == i % members);
+
+    report("member-lookup-warm", optimize ? "perfect" : "chained", lookups, 0, usec_elapsed(&start_time, NULL));
+
+    for (i = 0; i < members; i++)
+        kit_free(names[i]);
+
+    sxe_jitson_free(object);
+    kit_free(names);
+    kit_free(json);
+}
+
+/* Benchmark looking up elements of a large array of variably sized strings, which must be indexed, and of a uniform array of
+ * numbers, which needn't be. Cold lookups are the first on each freshly parsed array. Warm lookups use the index.
+ */
+static void
+bench_element_lookup(unsigned elements, unsigned long lookups)
+{
+    struct sxe_jitson_source  source;
+    struct sxe_jitson_stack  *stack;
+    struct sxe_jitson        *array;
+    char                     *json;
+    struct timeval            start_time;
+    uint64_t                  usec;
+    unsigned long             cold, i, variant;
+
+    assert((stack = sxe_jitson_stack_get_thread()));
+    cold = lookups / elements / 16 ?: 1;
+
+    for (variant = 0; variant < 2; variant++) {
+        json = variant ? make_numeric_array(elements) : make_string_array(elements);
+
+        for (usec = 0, i = 0; i < cold; i++) {
+            sxe_jitson_source_from_string(&source, json, SXE_JITSON_FLAG_OPTIMIZE);
+            assert(sxe_jitson_stack_load_json(stack, &source));
+            assert((array = sxe_jitson_stack_get_jitson(stack)));
+            assert(gettimeofday(&start_time, NULL) == 0);
+            assert(sxe_jitson_array_get_element(array, (i * 7919) % elements));
+            usec += usec_elapsed(&start_time, NULL);
+
+            if (i < cold - 1)
+                sxe_jitson_free(array);
+        }
+
+        report("element-lookup-cold", variant ? "numbers" : "strings", cold, 0, usec);
+        assert(gettimeofday(&start_time, NULL) == 0);
+
+        for (i = 0; i < lookups; i++)
+            assert(sxe_jitson_array_get_element(array, (i * 7919) % elements));
+
+        report("element-lookup-warm", variant ? "numbers" : "strings", lookups, 0, usec_elapsed(&start_time, NULL));
+        sxe_jitson_free(array);
+        kit_free(json);
+    }
+}
+
+#define EVEN_ORDERED   0    // Ascending numbers, searched by bisection
+#define EVEN_UNORDERED 1    // Descending numbers, which are uniformly sized and searched with a hash set
+#define EVEN_MIXED     2    // Descending numbers with every fourth one a longer string, so the array is indexed and hashed
+
+static const char *even_variants[] = {"ordered", "unordered", "mixed"};
+
+/* Make an array of 'elements' even numbers starting at offset, in ascending order for EVEN_ORDERED or descending order otherwise.
+ * For EVEN_MIXED, every fourth value is added as a string of its digits long enough to take more than one jitson.
+ */
+static struct sxe_jitson *
+make_even_array(unsigned elements, unsigned offset, unsigned variant)
+{
+    struct sxe_jitson_stack *stack;
+    char                     string[32];
+    unsigned                 i, value;
+
+    assert((stack = sxe_jitson_stack_get_thread()));
+    assert(sxe_jitson_stack_open_collection(stack, SXE_JITSON_TYPE_ARRAY));
+
+    for (i = 0; i < elements; i++) {
+        value = offset + 2 * (variant == EVEN_ORDERED ? i : elements - 1 - i);
+
+        if (variant == EVEN_MIXED && value % 8 == 0) {
+            snprintf(string, sizeof(string), "even-number-%u", value);
+            assert(sxe_jitson_stack_add_string(stack, string, SXE_JITSON_TYPE_IS_COPY));
+        }
+        else
+            assert(sxe_jitson_stack_add_uint(stack, value));
+    }
+
+    assert(sxe_jitson_stack_close_collection(stack));
+    return sxe_jitson_stack_get_jitson(stack);
+}
+
+/* Benchmark the IN and INTERSECT operators on ordered arrays and on unordered arrays of uniformly and variably sized elements
+ */
+static void
+bench_in_and_intersect(unsigned elements, unsigned long lookups)
+{
+    struct sxe_jitson        value;
+    struct sxe_jitson       *left, *right;
+    const struct sxe_jitson *result;
+    struct timeval           start_time;
+    unsigned long            i, iterations;
+    unsigned                 variant;
+
+    iterations = lookups / elements ?: 1;
+
+    for (variant = EVEN_ORDERED; variant <= EVEN_MIXED; variant++) {
+        assert((right = make_even_array(elements, 0, variant)));
+
+        if (selected("in")) {
+            assert(gettimeofday(&start_time, NULL) == 0);
+
+            for (i = 0; i < lookups; i++)    // Half of the values looked for are odd, and so aren't found
+                assert(sxe_jitson_in(sxe_jitson_make_uint(&value, (i * 7919) % (2 * elements)), right));
+
+            report("in", even_variants[variant], lookups, 0, usec_elapsed(&start_time, NULL));
+        }
+
+        if (selected("intersect")) {
+            assert((left = make_even_array(elements, elements, variant)));    // Overlaps the upper half of right
+            assert(gettimeofday(&start_time, NULL) == 0);
+
+            for (i = 0; i < iterations; i++) {
+                assert((result = sxe_jitson_intersect(left, right)));
+                sxe_jitson_free(result);
+            }
+
+            report("intersect", even_variants[variant], iterations, 0, usec_elapsed(&start_time, NULL));
+            assert(gettimeofday(&start_time, NULL) == 0);
+
+            for (i = 0; i < iterations; i++)
+                assert(sxe_jitson_intersect_test(left, right) == sxe_jitson_true);
+
+            report("intersect-test", even_variants[variant], iterations, 0, usec_elapsed(&start_time, NULL));
+            sxe_jitson_free(left);
+        }
+
+        sxe_jitson_free(right);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    char          *end, *json;
+    unsigned long  lookups  = 10000000;
+    size_t         bytes    = PARSE_BYTES;
+    unsigned       members  = 4096;
+    bool           optimize = true;
+
+    while (argc > 1) {
+        if (strcmp(argv[1], "-b") == 0) {
+            assert(argc > 2);
+            argv += 1;
+            argc -= 1;
+            only = argv[1];
+        }
+        else if (strcmp(argv[1], "-l") == 0) {
+            assert(argc > 2);
+            argv += 1;
+            argc -= 1;
+            lookups = strtoul(argv[1], &end, 10);
+        }
+        else if (strcmp(argv[1], "-m") == 0) {
+            assert(argc > 2);
+            argv += 1;
+            argc -= 1;
+            members = strtoul(argv[1], &end, 10);
+        }
+        else if (strcmp(argv[1], "-n") == 0)
+            optimize = false;
+        else if (strcmp(argv[1], "-t") == 0) {
+            assert(argc > 2);
+            argv += 1;
+            argc -= 1;
+            bytes = strtoul(argv[1], &end, 10);
+        }
+        else {
+            fprintf(stderr, "usage: jitson-bench [-b <bench-prefix>] [-l <lookups>] [-m <members>] [-n] [-t <bytes>]\n"
+                            "error: invalid argument '%s'\n", argv[1]);
+            exit(1);
+        }
+
+        argv += 1;
+        argc -= 1;
+    }
+
+    assert(members > 0);
+    sxe_jitson_initialize(0, SXE_JITSON_FLAG_OPTIMIZE);    // Arrays constructed on stacks are checked for order
+    sxe_jitson_in_init();
+    sxe_jitson_intersect_init();
+
+    if (selected("parse") || selected("to_json")) {
+        bench_parse_and_encode("small-object", json = make_small_object(), bytes);
+        kit_free(json);
+        bench_parse_and_encode("numeric-array", json = make_numeric_array(100000), bytes);
+        kit_free(json);
+        bench_parse_and_encode("string-array", json = make_string_array(100000), bytes);
+        kit_free(json);
+        bench_parse_and_encode("nested", json = make_nested(256), bytes);
+        kit_free(json);
+    }
+
+    if (selected("member-lookup"))
+        bench_member_lookup(members, lookups, optimize);
+
+    if (selected("element-lookup"))
+        bench_element_lookup(members, lookups);
+
+    if (selected("in") || selected("intersect"))
+        bench_in_and_intersect(members, lookups);
+
+    sxe_jitson_finalize();
+    return 0;
+}
@@ -26,6 +26,66 @@
 
 #include "kit-alloc.h"
 
-void kit_memory_initialize_counters(void);
+#define KIT_MEMORY_FREE ((void *)~0UL)    // Internal size_out value to kit_memory_check to invalidate the fore guard before a free
+
+#define KIT_MEMORY_GUARD_SAMPLED   ((size_t)1 << 63)    // Flags the size in the fore guard of sampled guarded memory
+#define KIT_MEMORY_PROFILE_SAMPLED ((size_t)1 << 62)    // Flags the size in the fore guard of memory sampled by the profiler
+#define KIT_MEMORY_LEAKED          ((void *)1)          // Returned by kit_memory_guard_find if guarded memory can't be freed
+
+struct kit_memory_table {    // Lock free table of entries that begin with the pointer they're keyed by; see kit-memory-table.c
+    char    *entries;
+    size_t   entry_size;
+    unsigned mask;           // Number of entries - 1; the number of entries must be a power of 2
+};
+
+extern unsigned         kit_memory_guard_rate;
+extern __thread int     kit_memory_guard_countdown;
+extern uint64_t         kit_memory_guard_live;
+extern size_t           kit_memory_profile_rate;
+extern __thread int64_t kit_memory_profile_countdown;
+extern uint64_t         kit_memory_profile_live;
+
+void             kit_memory_count_alloc(bool failed, size_t size);
+void             kit_memory_count_free(void);
+unsigned         kit_memory_get_flags(void);
+char            *kit_memory_guard_alloc(size_t size, size_t alignment, int flags);
+void            *kit_memory_guard_find(const void *ptr, bool remove);
+void             kit_memory_guard_initialize(char **result_in_out, size_t size, size_t alignment);
+void             kit_memory_guard_mark(void *ptr, size_t flag);
+bool             kit_memory_guard_sample(void);
+void             kit_memory_guard_set(char **result_in_out, size_t size, size_t alignment);
+size_t           kit_memory_guard_size(size_t size, size_t alignment);
+void             kit_memory_initialize_counters(void);
+bool             kit_memory_profile_alloc(void *ptr, size_t size, const char *file, int line);
+bool             kit_memory_profile_find(const void *ptr, bool remove);
+bool             kit_memory_profile_sample(void);
+unsigned         kit_memory_table_add(struct kit_memory_table *table, void *ptr);
+unsigned         kit_memory_table_find(const struct kit_memory_table *table, const void *ptr);
+void             kit_memory_table_remove(struct kit_memory_table *table, unsigned idx);
+void             kit_memory_tag_account(kit_memory_tag_t tag, int64_t bytes);
+kit_memory_tag_t kit_memory_tag_current(void);
+
+/* Hooks called by the kit allocation functions; they only call the profiler if the thread's byte countdown has run out or if
+ * sampled allocations are live. KIT_MEMORY_PROFILE_DUE checks whether allocating size bytes would be sampled without counting
+ * them.
+ */
+#define KIT_MEMORY_PROFILE_SAMPLE(size)                                                                                     \
+    (__atomic_load_n(&kit_memory_profile_rate, __ATOMIC_RELAXED) && (kit_memory_profile_countdown -= (int64_t)(size)) <= 0 \
+     && kit_memory_profile_sample())
+#define KIT_MEMORY_PROFILE_DUE(size) \
+    (__atomic_load_n(&kit_memory_profile_rate, __ATOMIC_RELAXED) && kit_memory_profile_countdown <= (int64_t)(size))
+#define KIT_MEMORY_PROFILE_COUNT(size)                                  \
+    do {                                                                \
+        if (__atomic_load_n(&kit_memory_profile_rate, __ATOMIC_RELAXED)) \
+            kit_memory_profile_countdown -= (int64_t)(size);            \
+    } while (0)
+#define KIT_MEMORY_PROFILE_LIVE() __atomic_load_n(&kit_memory_profile_live, __ATOMIC_RELAXED)
+
+/* Hooks called by the kit allocation functions; they only call the sampled overflow guards if the thread's sampling countdown
+ * has run out or if guarded allocations are live
+ */
+#define KIT_MEMORY_GUARD_SAMPLE() \
+    (__atomic_load_n(&kit_memory_guard_rate, __ATOMIC_RELAXED) && --kit_memory_guard_countdown <= 0 && kit_memory_guard_sample())
+#define KIT_MEMORY_GUARD_LIVE() __atomic_load_n(&kit_memory_guard_live, __ATOMIC_RELAXED)
 
 #endif
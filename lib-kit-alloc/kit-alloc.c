@@ -72,6 +72,7 @@
  */
 
 #define KIT_ALLOC_LOG(...) do { if (kit_memory_diagnostics) SXEL5(__VA_ARGS__); } while (0)
+#define MEMORY_PAGE_MIN    4096    // The smallest page size of any supported platform
 
 struct kit_memory_guard {    // If overflow detection is enabled, allocate on of these before the memory, and a stamp after
     size_t size;             // Size of memory allocated (rounded up)
@@ -80,6 +81,14 @@ struct kit_memory_guard {    // If overflow detection is enabled, allocate on of
 
 static_assert(sizeof(struct kit_memory_guard) == 16, "Unexpected size for kit_memory_guard; must be a power of 2");
 
+struct kit_memory_tag_header {    // If tagging allocations, allocate one of these before the memory (and its fore guard, if any)
+    uint32_t tag;                 // Tag the memory was allocated under, or KIT_MEMORY_TAG_NONE
+    uint32_t offset;              // Offset of the end of the header from the start of the memory allocated
+    size_t   size;                // Size of memory allocated, including the header
+};
+
+static_assert(sizeof(struct kit_memory_tag_header) == 16, "Unexpected size for kit_memory_tag_header; must be 16");
+
 #if SXE_DEBUG    // In a debug build of libkit, check for memory overflows by default
     static unsigned kit_memory_flags = KIT_MEMORY_CHECK_OVERFLOWS;
 #else            // In the release build of libkit, overflow checking is disabled by default
@@ -117,6 +126,7 @@ counter_bytes_combine_handler(int threadnum)
  *
  * @param flags KIT_MEMORY_ABORT_ON_ENOMEM to abort on memory allocation failure (returns ENOMEM if unset)
  *              KIT_MEMORY_CHECK_OVERFLOWS to check for memory overflows on relloc/free and abort if found
+ *              KIT_MEMORY_TAG_ALLOCATIONS to account for the bytes allocated under each allocation tag
  *
  * @note The flags must not be changed once this module has been initialized
  */
@@ -147,6 +157,7 @@ kit_memory_set_assert_on_enomem(bool assert_on_enomem)
  *
  * @param flags KIT_MEMORY_ABORT_ON_ENOMEM to abort on memory allocation failure (returns ENOMEM if unset)
  *              KIT_MEMORY_CHECK_OVERFLOWS to check for memory overflows on relloc/free and abort if found
+ *              KIT_MEMORY_TAG_ALLOCATIONS to account for the bytes allocated under each allocation tag
  *
  * @note This function should only be used if accurate counters are not required; preferably use kit_counters_initialize
  */
@@ -222,6 +233,16 @@ kit_memory_allocations(void)
          - kit_counter_get(KIT_COUNTER_MEMORY_FREE);
 }
 
+/* Determine the size of memory with guard words, whether or not overflow checking is on
+ */
+size_t
+kit_memory_guard_size(size_t size, size_t alignment)
+{
+    alignment     = alignment >= sizeof(size_t) ? alignment : sizeof(size_t);
+    size_t offset = sizeof(struct kit_memory_guard) >= alignment ? sizeof(struct kit_memory_guard) : alignment;
+    return offset + size + sizeof(void *);
+}
+
 /**
  * Determine the size of memory with guard words
  *
@@ -233,50 +254,170 @@ kit_memory_allocations(void)
 size_t
 kit_memory_size(size_t size, size_t alignment)
 {
-    if (kit_memory_flags & KIT_MEMORY_CHECK_OVERFLOWS) {
-        alignment     = alignment >= sizeof(size_t) ? alignment : sizeof(size_t);
-        size_t offset = sizeof(struct kit_memory_guard) >= alignment ? sizeof(struct kit_memory_guard) : alignment;
-        size          = offset + size + sizeof(void *);
+    return kit_memory_flags & KIT_MEMORY_CHECK_OVERFLOWS ? kit_memory_guard_size(size, alignment) : size;
+}
+
+/* Set the guards around memory of size bytes returned by kit_memory_guard_size, advancing the pointer past the fore guard
+ */
+void
+kit_memory_guard_set(char **result_in_out, size_t size, size_t alignment)
+{
+    ((struct kit_memory_guard *)*result_in_out)->size  = size;
+    ((struct kit_memory_guard *)*result_in_out)->stamp = *result_in_out;
+    *(void **)(*result_in_out + size - sizeof(void *)) = *result_in_out;
+
+    if (alignment > sizeof(struct kit_memory_guard)) {    // Need a guard right before the address returned
+        char *near_guard = *result_in_out + alignment - sizeof(struct kit_memory_guard);
+        memcpy(near_guard, *result_in_out, sizeof(struct kit_memory_guard));
+        *result_in_out += alignment;
     }
+    else
+        *result_in_out += sizeof(struct kit_memory_guard);
+}
+
+/* Mark the fore guards of memory returned by kit_memory_guard_set with a flag (KIT_MEMORY_GUARD_SAMPLED or
+ * KIT_MEMORY_PROFILE_SAMPLED) as those of a sampled allocation, so that frees of memory that isn't marked don't have to look it
+ * up
+ */
+void
+kit_memory_guard_mark(void *ptr, size_t flag)
+{
+    struct kit_memory_guard *guard = (struct kit_memory_guard *)ptr - 1;
+
+    guard->size |= flag;
 
-    return size;
+    if (guard->stamp != guard)    // There's another guard at the beginning of the memory
+        ((struct kit_memory_guard *)guard->stamp)->size |= flag;
 }
 
+/* Initialize the guards around memory of size bytes returned by kit_memory_size, advancing the pointer past the fore guard
+ */
+void
+kit_memory_guard_initialize(char **result_in_out, size_t size, size_t alignment)
+{
+    if (*result_in_out && kit_memory_flags & KIT_MEMORY_CHECK_OVERFLOWS)
+        kit_memory_guard_set(result_in_out, size, alignment);
+}
+
+/* Return the flags that affect the behaviour of the kit memory management interface
+ */
+unsigned
+kit_memory_get_flags(void)
+{
+    return kit_memory_flags;
+}
+
+/* Determine the offset of the end of the tag header from the start of memory allocated with the given alignment, or 0 if not
+ * tagging allocations
+ */
+static size_t
+memory_tag_offset(size_t alignment)
+{
+    if (!(kit_memory_flags & KIT_MEMORY_TAG_ALLOCATIONS))
+        return 0;
+
+    return alignment > sizeof(struct kit_memory_tag_header) ? alignment : sizeof(struct kit_memory_tag_header);
+}
+
+/* Set the tag header at the start of size bytes of memory, accounting for them and advancing the pointer past the header
+ */
 static void
-guard_initialize(char **result_in_out, size_t size, size_t alignment)
+memory_tag_initialize(char **result_in_out, size_t offset, size_t size)
 {
-    if (*result_in_out && kit_memory_flags & KIT_MEMORY_CHECK_OVERFLOWS) {
-        ((struct kit_memory_guard *)*result_in_out)->size  = size;
-        ((struct kit_memory_guard *)*result_in_out)->stamp = *result_in_out;
-        *(void **)(*result_in_out + size - sizeof(void *)) = *result_in_out;
+    struct kit_memory_tag_header *header = (struct kit_memory_tag_header *)(*result_in_out + offset) - 1;
 
-        if (alignment > sizeof(struct kit_memory_guard)) {    // Need a guard right before the address returned
-            char *near_guard = *result_in_out + alignment - sizeof(struct kit_memory_guard);
-            memcpy(near_guard, *result_in_out, sizeof(struct kit_memory_guard));
-            *result_in_out += alignment;
-        }
-        else
-            *result_in_out += sizeof(struct kit_memory_guard);
+    header->tag     = kit_memory_tag_current();
+    header->offset  = offset;
+    header->size    = size;
+    *result_in_out += offset;
+    kit_memory_tag_account(header->tag, (int64_t)size);
+}
+
+/* Free memory returned by kit_memory_check, accounting for it if it was tagged. NULL means the memory was leaked deliberately.
+ */
+static void
+memory_free(void *ptr)
+{
+    struct kit_memory_tag_header *header;
+
+    if (!ptr)
+        return;
+
+    if (kit_memory_flags & KIT_MEMORY_TAG_ALLOCATIONS) {
+        header = (struct kit_memory_tag_header *)ptr - 1;
+        kit_memory_tag_account(header->tag, -(int64_t)header->size);
+        ptr = (char *)ptr - header->offset;
     }
+
+    dallocx(ptr, 0);
 }
 
-/* Internal memory allocator that supports jemalloc mallocx flags
+/* Internal memory allocator that supports jemalloc mallocx flags. When overflow checking is off, allocations that are sampled
+ * are guarded anyway. Allocations sampled by the profiler are recorded against file:line, and their fore guards are marked.
  */
 static void *
-memory_alloc(size_t size, size_t alignment, int flags)
+memory_alloc(size_t size, size_t alignment, int flags, const char *file, int line)
 {
     char  *result;
+    size_t offset, length;
+    bool   guarded;
+    bool   sampled = KIT_MEMORY_PROFILE_SAMPLE(size);
 
-    size = kit_memory_size(size, alignment);
+    if (!sampled && !(kit_memory_flags & (KIT_MEMORY_CHECK_OVERFLOWS | KIT_MEMORY_TAG_ALLOCATIONS)) && KIT_MEMORY_GUARD_SAMPLE())
+        result = MOCKERROR(kit_malloc_diag, NULL, ENOMEM, kit_memory_guard_alloc(size, alignment, flags));
+    else {
+AGAIN:
+        guarded = sampled || (kit_memory_flags & KIT_MEMORY_CHECK_OVERFLOWS);
+        offset  = memory_tag_offset(alignment);
+        length  = guarded ? kit_memory_guard_size(size, alignment) : size;
+
+        if ((result = MOCKERROR(kit_malloc_diag, NULL, ENOMEM, mallocx(offset + length, flags)))) {
+            if (offset)
+                memory_tag_initialize(&result, offset, offset + length);
+
+            if (guarded)
+                kit_memory_guard_set(&result, length, alignment);
+
+            if (sampled && kit_memory_profile_alloc(result, size, file, line))
+                kit_memory_guard_mark(result, KIT_MEMORY_PROFILE_SAMPLED);
+            else if (sampled && !(kit_memory_flags & KIT_MEMORY_CHECK_OVERFLOWS)) {    // Only sampled memory may be guarded
+                memory_free(((struct kit_memory_guard *)result - 1)->stamp);    /* COVERAGE EXCLUSION: Table is full */
+                sampled = false;                                                /* COVERAGE EXCLUSION: Table is full */
+                goto AGAIN;                                                     /* COVERAGE EXCLUSION: Table is full */
+            }
+        }
+    }
 
-    if ((result = MOCKERROR(kit_malloc_diag, NULL, ENOMEM, mallocx(size, flags))))
-        guard_initialize(&result, size, alignment);
-    else
+    if (!result)
         SXEA1(!(kit_memory_flags & KIT_MEMORY_ABORT_ON_ENOMEM) , ": failed to allocate %zu bytes", size);
 
     return result;
 }
 
+/* Reallocate memory returned by kit_memory_check to size bytes, keeping its tag header and alignment, if any
+ */
+static char *
+memory_realloc(char *ptr, size_t size)
+{
+    struct kit_memory_tag_header header;
+    char                        *result;
+    int                          flags;
+
+    if (!(kit_memory_flags & KIT_MEMORY_TAG_ALLOCATIONS))
+        return MOCKERROR(kit_realloc_diag, NULL, ENOMEM, rallocx(ptr, size, 0));
+
+    header = ((struct kit_memory_tag_header *)ptr)[-1];
+    flags  = header.offset > sizeof(header) ? MALLOCX_LG_ALIGN(sxe_uint64_log2(header.offset)) : 0;    // Offset was aligned
+
+    if (!(result = MOCKERROR(kit_realloc_diag, NULL, ENOMEM, rallocx(ptr - header.offset, header.offset + size, flags))))
+        return NULL;
+
+    result += header.offset;
+    ((struct kit_memory_tag_header *)result)[-1].size = header.offset + size;
+    kit_memory_tag_account(header.tag, (int64_t)(header.offset + size) - (int64_t)header.size);    // Stays with its original tag
+    return result;
+}
+
 static void
 count_malloc_increment(bool failed)
 {
@@ -296,7 +437,7 @@ count_malloc_increment(bool failed)
 __attribute__((malloc)) void *
 kit_malloc_diag(size_t size, const char *file, int line)
 {
-    char *result = memory_alloc(size, 0, 0);
+    char *result = memory_alloc(size, 0, 0, file, line);
     count_malloc_increment(result == NULL);
     KIT_ALLOC_LOG("%s: %d: %p = kit_malloc(%zu)", file, line, result, size);
     return result;
@@ -308,7 +449,7 @@ kit_memalign_diag(size_t alignment, size_t size, const char *file, int line)
     int lg_align = sxe_uint64_log2(alignment);
     SXEA1(1ULL << lg_align == alignment, ": Alignment %zu is not a power of 2", alignment);
 
-    void *result = memory_alloc(size, alignment, MALLOCX_LG_ALIGN(lg_align));
+    void *result = memory_alloc(size, alignment, MALLOCX_LG_ALIGN(lg_align), file, line);
     count_malloc_increment(result == NULL);
     KIT_ALLOC_LOG("%s: %d: %p = kit_memalign(%zu,%zu)", file, line, result, alignment, size);
     return result;
@@ -325,7 +466,7 @@ kit_calloc_diag(size_t num, size_t size, const char *file, int line)
         errno = ENOMEM;
     }
     else
-        result = memory_alloc(total_size, 0, MALLOCX_ZERO);
+        result = memory_alloc(total_size, 0, MALLOCX_ZERO, file, line);
 
     SXEA1(!(kit_memory_flags & KIT_MEMORY_ABORT_ON_ENOMEM) || result, ": failed to allocate %zu %zu byte objects", num, size);
 
@@ -354,7 +495,53 @@ count_free_increment(void)
         count_free++;
 }
 
-#define KIT_MEMORY_FREE ((void *)~0UL)    // Internal size_out value to invalidate the fore guard before a free
+/* Count an allocation made by another kit allocator (e.g. a slab), aborting on failure if KIT_MEMORY_ABORT_ON_ENOMEM is set
+ */
+void
+kit_memory_count_alloc(bool failed, size_t size)
+{
+    SXEA1(!failed || !(kit_memory_flags & KIT_MEMORY_ABORT_ON_ENOMEM), ": failed to allocate %zu bytes", size);
+    count_malloc_increment(failed);
+}
+
+/* Count a free made by another kit allocator
+ */
+void
+kit_memory_count_free(void)
+{
+    count_free_increment();
+}
+
+/* Determine whether memory may have been marked with a flag by kit_memory_guard_mark. Unless the memory starts within a guard's
+ * size of a page, where the memory before it may not be readable, the flag in its fore guard is checked, so that most memory that
+ * isn't marked isn't looked up.
+ */
+static bool
+memory_may_be_marked(const void *ptr, size_t flag)
+{
+    return (uintptr_t)ptr % MEMORY_PAGE_MIN < sizeof(struct kit_memory_guard)
+        || ((const struct kit_memory_guard *)ptr - 1)->size & flag;
+}
+
+/* Look up memory that may have been guarded because it was sampled
+ */
+static void *
+memory_guard_find(const void *ptr, bool remove)
+{
+    if (!KIT_MEMORY_GUARD_LIVE() || !memory_may_be_marked(ptr, KIT_MEMORY_GUARD_SAMPLED))
+        return NULL;
+
+    return kit_memory_guard_find(ptr, remove);
+}
+
+/* Look up memory that may have been sampled by the profiler
+ */
+static bool
+memory_profile_find(const void *ptr, bool remove)
+{
+    return KIT_MEMORY_PROFILE_LIVE() && memory_may_be_marked(ptr, KIT_MEMORY_PROFILE_SAMPLED)
+        && kit_memory_profile_find(ptr, remove);
+}
 
 /**
  * Check kit allocated memory for overflows
@@ -362,21 +549,29 @@ count_free_increment(void)
  * @param ptr      Pointer returned by a kit allocation
  * @param size_out NULL, a pointer to store the size of the allocation or 0 if not bounds checking, or ~0UL (internal use)
  *
- * @return ptr if not checking overflows or a pointer to the guard structure
+ * @return ptr if not checking overflows or a pointer to the guard structure, or NULL if size_out is ~0UL and the memory must
+ *         not be freed because it was guarded by a page that couldn't be made accessible again
  *
  * @note Aborts if the guard stamps before or after the memory have been overwritten
  */
 void *
 kit_memory_check(void *ptr, size_t *size_out)
 {
-    if (!(kit_memory_flags & KIT_MEMORY_CHECK_OVERFLOWS)) {
+    struct kit_memory_guard *guard;
+    void                    *base = NULL;
+    size_t                   size;
+
+    if (kit_memory_flags & KIT_MEMORY_CHECK_OVERFLOWS)    // All memory is guarded, but a sample must be forgotten before a free
+        memory_profile_find(ptr, size_out == KIT_MEMORY_FREE);
+    else if (!(base = memory_guard_find(ptr, size_out == KIT_MEMORY_FREE))
+          && !memory_profile_find(ptr, size_out == KIT_MEMORY_FREE)) {
         if (size_out && size_out != KIT_MEMORY_FREE)
             *size_out = 0;
 
         return ptr;
     }
 
-    struct kit_memory_guard *guard = (struct kit_memory_guard *)ptr - 1;
+    guard = (struct kit_memory_guard *)ptr - 1;
 
     if (guard->stamp != guard) {    // This can happen if alignment > sizeof(kit_memory_guard)
         SXEA1(((uintptr_t)guard->stamp & (2 * sizeof(struct kit_memory_guard) - 1)) == 0,
@@ -386,16 +581,20 @@ kit_memory_check(void *ptr, size_t *size_out)
         guard = guard->stamp;    // There should be another guard at the beginning of the malloced area
     }
 
+    size = guard->size & ~(KIT_MEMORY_GUARD_SAMPLED | KIT_MEMORY_PROFILE_SAMPLED);
     SXEA1(guard->stamp == guard, "Fore guard stamp at %p corrupted", &guard->stamp);
-    SXEA1(*(void **)((char *)guard + guard->size - sizeof(void *)) == guard, "Rear guard stamp at %p corrupted",
-          (char *)guard + guard->size - sizeof(void *));
+    SXEA1(*(void **)((char *)guard + size - sizeof(void *)) == guard, "Rear guard stamp at %p corrupted",
+          (char *)guard + size - sizeof(void *));
 
     if (size_out == KIT_MEMORY_FREE)
         guard->stamp = KIT_MEMORY_FREE;    // Invalidate the fore guard (prior to freeing the memory)
     else if (size_out)
-        *size_out = guard->size - ((uintptr_t)ptr - (uintptr_t)guard) - sizeof(void *);
+        *size_out = size - ((uintptr_t)ptr - (uintptr_t)guard) - sizeof(void *);
 
-    return guard;
+    if (base == KIT_MEMORY_LEAKED)
+        return NULL;
+
+    return base ?: guard;    // If the allocation was sampled, the guard may not be at the start of the memory allocated
 }
 
 void
@@ -406,7 +605,7 @@ kit_free_diag(void *ptr, const char *file, int line)
         SXEA1(!(((long)ptr) & (sizeof(void *) - 1)), "ungranular free(%p)", ptr);
         count_free_increment();
         ptr = kit_memory_check(ptr, KIT_MEMORY_FREE);    // Get back the actual memory allocated if overflow checking
-        dallocx(ptr, 0);
+        memory_free(ptr);
     }
 #if SXE_DEBUG
     else if (kit_memory_diagnostics > 1)
@@ -421,22 +620,41 @@ void *
 kit_realloc_diag(void *ptr, size_t size, const char *file, int line)
 {
     char  *result = NULL;
+    char  *copy;
     void  *optr   = ptr;
     size_t osize  = size;
+    size_t osize_guarded;
 
     if (!ptr)
-        result = memory_alloc(size, 0, 0);
+        result = memory_alloc(size, 0, 0, file, line);
+    else if (size && ((!(kit_memory_flags & KIT_MEMORY_CHECK_OVERFLOWS) && memory_guard_find(ptr, false))
+                      || memory_profile_find(ptr, false))) {
+        kit_memory_check(ptr, &osize_guarded);    // Sampled memory is moved, so that the copy can be placed like a new allocation
+
+        if ((result = memory_alloc(size, 0, 0, file, line))) {
+            memcpy(result, ptr, osize_guarded < size ? osize_guarded : size);
+            memory_free(kit_memory_check(ptr, KIT_MEMORY_FREE));
+        }
+    }
     else if (size) {
         ptr              = kit_memory_check(ptr, NULL);     // Get back the actual memory allocated (even if bounds checking)
         size_t alignment = (char *)optr - (char *)ptr;
         size             = kit_memory_size(size, alignment);    // Keep alignment padding consistent
-        result           = MOCKERROR(kit_realloc_diag, NULL, ENOMEM, rallocx(ptr, size, 0));
+        result           = memory_realloc(ptr, size);
 
-        guard_initialize(&result, size, alignment);
+        kit_memory_guard_initialize(&result, size, alignment);
+
+        if (!result || !KIT_MEMORY_PROFILE_DUE(osize))    // Count the reallocated memory like a new allocation
+            KIT_MEMORY_PROFILE_COUNT(osize);
+        else if ((copy = memory_alloc(osize, 0, 0, file, line))) {    // It's due to be sampled, so move it to a guarded copy
+            memcpy(copy, result, osize);
+            memory_free(kit_memory_check(result, KIT_MEMORY_FREE));
+            result = copy;
+        }
     }
     else {
         ptr = kit_memory_check(ptr, KIT_MEMORY_FREE);    // Get back the actual memory allocated if overflow checking
-        dallocx(ptr, 0);
+        memory_free(ptr);
     }
 
     if (result == NULL && (size || ptr == NULL)) {
@@ -483,7 +701,7 @@ __attribute__((malloc)) char *
 kit_strdup_diag(const char *txt, const char *file, int line)
 {
     size_t len    = strlen(txt);
-    void  *result = memory_alloc(len + 1, 0, 0);
+    void  *result = memory_alloc(len + 1, 0, 0, file, line);
 
     if (result)
         memcpy(result, txt, len + 1);
@@ -497,7 +715,7 @@ __attribute__((malloc)) char *
 kit_strndup_diag(const char *txt, size_t size, const char *file, int line)
 {
     size_t len    = strnlen(txt, size);
-    char  *result = memory_alloc(len + 1, 0, 0);
+    char  *result = memory_alloc(len + 1, 0, 0, file, line);
 
     if (result) {
         memcpy(result, txt, len);
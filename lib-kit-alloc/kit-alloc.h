@@ -39,6 +39,18 @@
 
 #define KIT_MEMORY_ABORT_ON_ENOMEM 0x00000001    // Abort if an allocate call returns ENOMEM (out of memory)
 #define KIT_MEMORY_CHECK_OVERFLOWS 0x00000002    // Add guard words around allocations and check them on realloc/free
+#define KIT_MEMORY_TAG_ALLOCATIONS 0x00000004    // Add a header to allocations recording their tag (see kit_memory_tag_push)
+
+#define KIT_MEMORY_GUARD_PAGE 0x00000001    // Put sampled allocations at the end of a page, followed by an inaccessible page
+
+#define KIT_MEMORY_GUARD_RATE_DEFAULT   1000            // Default number of allocations per thread for each one guarded
+#define KIT_MEMORY_PROFILE_RATE_DEFAULT (512 * 1024)    // Default mean bytes allocated between samples when profiling
+
+#define KIT_MEMORY_TAG_NONE  0     // Allocations made when no tag has been pushed aren't accounted for by tag
+#define KIT_MEMORY_TAGS_MAX  64    // Maximum number of allocation tags, including KIT_MEMORY_TAG_NONE
+#define KIT_MEMORY_TAG_DEPTH 16    // Maximum number of allocation tags pushed by each thread
+
+typedef unsigned kit_memory_tag_t;
 
 struct kit_memory_counters {
     kit_counter_t bytes;
@@ -72,6 +84,7 @@ extern int                        kit_memory_diagnostics;      // Set > 0 to tur
 #define kit_realloc(ptr, size) kit_realloc_diag(ptr, size, __FILE__, __LINE__)    /* CONVENTION EXCLUSION: these are supposed to look like functions */
 #define kit_free(ptr)          kit_free_diag(ptr, __FILE__, __LINE__)             /* CONVENTION EXCLUSION: these are supposed to look like functions */
 #define kit_strndup(txt, size) kit_strndup_diag(txt, size, __FILE__, __LINE__)    /* CONVENTION EXCLUSION: these are supposed to look like functions */
+#define kit_malloc_tagged(tag, size) kit_malloc_tagged_diag(tag, size, __FILE__, __LINE__)    /* CONVENTION EXCLUSION: like kit_malloc */
 
 extern void kit_memory_set_flags(unsigned flags);
 extern void kit_memory_set_assert_on_enomem(bool assert_on_enomem);
@@ -91,6 +104,19 @@ extern void  kit_free_diag(void *ptr, const char *file, int line);
 extern __attribute__((malloc)) char *kit_strndup_diag(const char *txt, size_t size , const char *file, int line);
 extern bool kit_memory_log_growth(__printflike(1, 2) int (*printer)(const char *format, ...));
 extern bool kit_memory_log_stats(__printflike(1, 2) int (*printer)(const char *format, ...), const char *options);
+extern bool kit_memory_guard_start(unsigned rate, unsigned flags);
+extern void kit_memory_guard_stop(void);
+extern bool kit_memory_guarded(const void *ptr);
+extern __attribute__((malloc)) void *kit_malloc_tagged_diag(kit_memory_tag_t tag, size_t size, const char *file, int line);
+extern kit_memory_tag_t kit_memory_tag_reg(const char *name);
+extern void kit_memory_tag_push(kit_memory_tag_t tag);
+extern void kit_memory_tag_pop(void);
+extern uint64_t kit_memory_tag_bytes(kit_memory_tag_t tag);
+extern uint64_t kit_memory_tag_peak(kit_memory_tag_t tag);
+extern bool kit_memory_profile_start(size_t rate);
+extern void kit_memory_profile_stop(void);
+extern bool kit_memory_profile_get(const char *file, int line, uint64_t *live_bytes_out, uint64_t *live_allocs_out);
+extern bool kit_memory_profile_dump(__printflike(1, 2) int (*printer)(const char *format, ...), unsigned max_sites);
 
 /* The following functions are for DPT-2036. Their use should be thoughtful and not just part of a kit alloc pattern.
  * They should be used in _init and _fini functions, but not in _new and _free.
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Arenas of memory for short lived objects that are all freed at once, such as those allocated while handling a request.
+ * Allocation just advances a pointer in the current block of the arena, allocating another block when it's full. Objects are
+ * never freed individually; instead, the arena is reset, either to empty or to a mark taken earlier.
+ *
+ * Blocks are allocated with kit_malloc, so the memory used by arenas is included in the kit memory counters.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "kit-alloc.h"
+#include "kit-arena.h"
+#include "kit-mockfail.h"
+#include "sxe-log.h"
+
+#define KIT_ARENA_ALIGN      16            // Default alignment, the same as malloc's on 64 bit platforms
+#define KIT_ARENA_BLOCK_SIZE (16 * 1024)   // Default size of each block of an arena
+
+struct kit_arena_block {
+    struct kit_arena_block *next;    // Previously allocated block
+    size_t                  size;    // Number of bytes in the block
+    size_t                  used;    // Number of bytes used
+    char                    bytes[] __attribute__((aligned(KIT_ARENA_ALIGN)));
+};
+
+struct kit_arena {
+    struct kit_arena_block *blocks;        // Block being allocated from, followed by the blocks allocated before it
+    size_t                  block_size;    // Number of bytes in each block, unless an allocation needs a larger one
+};
+
+/**
+ * Create an arena
+ *
+ * @param block_size Number of bytes in each block of memory allocated by the arena, or 0 for the default (16KB)
+ *
+ * @return The arena or NULL on failure to allocate memory (ENOMEM)
+ */
+struct kit_arena *
+kit_arena_new(size_t block_size)
+{
+    struct kit_arena *arena;
+
+    if (!(arena = kit_malloc(sizeof(*arena))))
+        return NULL;
+
+    arena->blocks     = NULL;
+    arena->block_size = block_size ?: KIT_ARENA_BLOCK_SIZE;
+    return arena;
+}
+
+/**
+ * Allocate aligned memory from an arena
+ *
+ * @param arena     The arena
+ * @param alignment The alignment, which must be a power of 2
+ * @param size      The number of bytes needed
+ *
+ * @return A pointer to the memory or NULL on failure to allocate a block or if size is too large (ENOMEM)
+ */
+void *
+kit_arena_memalign(struct kit_arena *arena, size_t alignment, size_t size)
+{
+    struct kit_arena_block *block = arena->blocks;
+    size_t                  offset, block_size;
+
+    SXEA6(alignment && (alignment & (alignment - 1)) == 0, "Alignment %zu is not a power of 2", alignment);
+
+    if (block) {
+        offset = (((uintptr_t)&block->bytes[block->used] + alignment - 1) & ~(alignment - 1)) - (uintptr_t)block->bytes;
+
+        if (size <= SIZE_MAX - offset && offset + size <= block->size) {
+            block->used = offset + size;
+            return &block->bytes[offset];
+        }
+    }
+
+    if (size > SIZE_MAX - sizeof(*block) - alignment) {    // The size of the block needed would overflow
+        SXEL2(": Can't allocate %zu bytes from an arena", size);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    block_size = alignment > KIT_ARENA_ALIGN ? size + alignment - KIT_ARENA_ALIGN : size;
+    block_size = block_size > arena->block_size ? block_size : arena->block_size;
+
+    if (!(block = MOCKERROR(kit_arena_memalign, NULL, ENOMEM, kit_malloc(sizeof(*block) + block_size)))) {
+        SXEL2(": Failed to allocate a block of %zu bytes for an arena", block_size);
+        return NULL;
+    }
+
+    block->next   = arena->blocks;
+    block->size   = block_size;
+    offset        = (((uintptr_t)block->bytes + alignment - 1) & ~(alignment - 1)) - (uintptr_t)block->bytes;
+    block->used   = offset + size;
+    arena->blocks = block;
+    return &block->bytes[offset];
+}
+
+/**
+ * Allocate memory from an arena, aligned like memory returned by malloc
+ *
+ * @param arena The arena
+ * @param size  The number of bytes needed
+ *
+ * @return A pointer to the memory or NULL on failure to allocate a block (ENOMEM)
+ */
+void *
+kit_arena_alloc(struct kit_arena *arena, size_t size)
+{
+    return kit_arena_memalign(arena, KIT_ARENA_ALIGN, size);
+}
+
+/**
+ * Duplicate a string in an arena
+ *
+ * @return The duplicate or NULL on failure to allocate a block (ENOMEM)
+ */
+char *
+kit_arena_strdup(struct kit_arena *arena, const char *string)
+{
+    size_t size = strlen(string) + 1;
+    char  *dup;
+
+    if ((dup = kit_arena_memalign(arena, 1, size)))
+        memcpy(dup, string, size);
+
+    return dup;
+}
+
+/**
+ * Mark the current position in an arena, so that it can later be reset to it
+ *
+ * @param arena The arena
+ * @param mark  Set to the current position
+ */
+void
+kit_arena_mark(const struct kit_arena *arena, struct kit_arena_mark *mark)
+{
+    mark->block = arena->blocks;
+    mark->used  = arena->blocks ? arena->blocks->used : 0;
+}
+
+/**
+ * Free all memory allocated from an arena, or all memory allocated since a mark was taken
+ *
+ * @param arena The arena
+ * @param mark  A mark taken by kit_arena_mark, or NULL to free everything
+ *
+ * @note When resetting to empty, one block of memory is kept to be reused. A mark is invalidated by resetting the arena to an
+ *       earlier mark.
+ */
+void
+kit_arena_reset(struct kit_arena *arena, const struct kit_arena_mark *mark)
+{
+    struct kit_arena_block *block, *next;
+
+    if (mark && mark->block) {
+        for (block = arena->blocks; block != mark->block; block = next) {
+            SXEA6(block, "Mark's block %p was not found in the arena", mark->block);
+            next = block->next;
+            kit_free(block);
+        }
+
+        arena->blocks = block;
+        block->used   = mark->used;
+        return;
+    }
+
+    for (block = arena->blocks; block && (next = block->next); block = next)    // Keep only the first block allocated
+        kit_free(block);
+
+    if ((arena->blocks = block))
+        block->used = 0;
+}
+
+/**
+ * Free an arena and all memory allocated from it
+ */
+void
+kit_arena_free(struct kit_arena *arena)
+{
+    if (!arena)
+        return;
+
+    kit_arena_reset(arena, NULL);
+    kit_free(arena->blocks);
+    kit_free(arena);
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef KIT_ARENA_H
+#define KIT_ARENA_H
+
+#include <stddef.h>
+
+struct kit_arena;    // Arena of memory that is freed all at once; see kit-arena.c
+
+struct kit_arena_mark {               // A position in an arena that it can be reset to
+    struct kit_arena_block *block;    // Block being allocated from when the mark was taken, or NULL if none
+    size_t                  used;     // Number of bytes of the block used when the mark was taken
+};
+
+#include "kit-arena-proto.h"
+
+#endif
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Export of counters in a named shared memory segment, so that tools such as kit-counters-read can read them from outside the
+ * process without any work being done by it.
+ *
+ * When export is enabled, every per thread counter block is allocated from the segment, and the name of every counter is
+ * recorded in it. Space in the segment is allocated by bumping an offset, and is never reused: blocks that are replaced because
+ * they have grown are marked as no longer live. If the segment fills up, blocks are allocated from the heap and not exported.
+ * The layout of the segment is described in kit-counters.h.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "kit-alloc.h"
+#include "kit-counters.h"
+#include "sxe-log.h"
+
+#define SHM_ALIGN KIT_COUNTERS_CACHE_LINE
+
+static struct kit_counters_shm_header *shm      = NULL;    // The exported segment, or NULL if not exporting
+static char                           *shm_name = NULL;
+static bool                            shm_full = false;   // Set once the segment has run out of space
+
+/* Allocate zeroed space from the segment, returning its offset or 0 if there's no room
+ */
+static uint64_t
+shm_alloc(size_t size)
+{
+    uint64_t offset;
+
+    size   = (size + SHM_ALIGN - 1) & ~(SHM_ALIGN - 1);
+    offset = __atomic_fetch_add(&shm->used, size, __ATOMIC_RELAXED);
+
+    if (offset + size > shm->size) {
+        if (!__atomic_exchange_n(&shm_full, true, __ATOMIC_RELAXED))
+            SXEL2(": Shared memory segment %s is full; further counter blocks won't be exported", shm_name);
+
+        return 0;
+    }
+
+    return offset;
+}
+
+/* Add a record to the front of a list in the segment
+ */
+static void
+shm_link(uint64_t *head, uint64_t *next, uint64_t offset)
+{
+    *next = __atomic_load_n(head, __ATOMIC_RELAXED);
+
+    while (!__atomic_compare_exchange_n(head, next, offset, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * Record a counter's name in the exported segment, if counters are being exported
+ *
+ * @param counter The counter
+ * @param count   The number of counters in the range beginning with the counter
+ * @param txt     The counter's name
+ */
+void
+kit_counters_shm_name(kit_counter_t counter, unsigned count, const char *txt)
+{
+    struct kit_counters_shm_name *name;
+    uint64_t                      offset;
+    size_t                        len;
+
+    if (!shm)
+        return;
+
+    len = strlen(txt);
+
+    if (!(offset = shm_alloc(sizeof(*name) + len + 1)))
+        return;
+
+    name          = (struct kit_counters_shm_name *)((char *)shm + offset);
+    name->counter = counter;
+    name->count   = count;
+    memcpy(name->name, txt, len + 1);
+    shm_link(&shm->names, &name->next, offset);
+}
+
+/**
+ * Allocate a zeroed counter block from the exported segment
+ *
+ * @param size The size of the block in bytes
+ *
+ * @return The block, or NULL if counters are not being exported or the segment is full
+ */
+struct kit_counters *
+kit_counters_shm_alloc(size_t size)
+{
+    struct kit_counters_shm_block *block;
+    uint64_t                       offset;
+
+    if (!shm || !(offset = shm_alloc(KIT_COUNTERS_CACHE_LINE + size)))
+        return NULL;
+
+    block       = (struct kit_counters_shm_block *)((char *)shm + offset);
+    block->live = 1;
+    shm_link(&shm->blocks, &block->next, offset);
+    return (struct kit_counters *)((char *)block + KIT_COUNTERS_CACHE_LINE);
+}
+
+/**
+ * Retire a counter block if it was allocated from the exported segment
+ *
+ * @return true if the block was in the segment, false if it must be freed by the caller
+ */
+bool
+kit_counters_shm_free(struct kit_counters *counters)
+{
+    if (!shm || (char *)counters < (char *)shm || (char *)counters >= (char *)shm + shm->size)
+        return false;
+
+    ((struct kit_counters_shm_block *)((char *)counters - KIT_COUNTERS_CACHE_LINE))->live = 0;
+    return true;
+}
+
+/**
+ * Tell readers that counter values are about to be moved between blocks, so they shouldn't trust what they read
+ */
+void
+kit_counters_shm_begin_change(void)
+{
+    if (shm) {
+        __atomic_add_fetch(&shm->writers,    1, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&shm->generation, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+/**
+ * Tell readers that counter values have been moved between blocks
+ */
+void
+kit_counters_shm_end_change(void)
+{
+    if (shm) {
+        __atomic_add_fetch(&shm->generation, 1, __ATOMIC_SEQ_CST);
+        __atomic_sub_fetch(&shm->writers,    1, __ATOMIC_SEQ_CST);
+    }
+}
+
+/**
+ * Create the shared memory segment that counters are exported in; called by kit_counters_export_shm
+ *
+ * @return true on success, false on failure with errno set
+ */
+bool
+kit_counters_shm_create(const char *name, size_t size)
+{
+    void *addr;
+    int   fd;
+
+    SXEA1(!shm, "Counters are already being exported");
+    SXEA1(size >= sizeof(*shm), "Shared memory segment size %zu is too small", size);
+
+    if ((fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644)) < 0) {
+        SXEL2(": Failed to open shared memory segment %s: %s", name, strerror(errno));
+        return false;
+    }
+
+    if (ftruncate(fd, size) < 0 || (addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        SXEL2(": Failed to size or map shared memory segment %s: %s", name, strerror(errno));    /* COVERAGE EXCLUSION: OS */
+        close(fd);                                                                             /* COVERAGE EXCLUSION: OS */
+        shm_unlink(name);                                                                      /* COVERAGE EXCLUSION: OS */
+        return false;                                                                          /* COVERAGE EXCLUSION: OS */
+    }
+
+    close(fd);
+
+    if (!(shm_name = kit_strdup(name))) {
+        munmap(addr, size);    /* COVERAGE EXCLUSION: Out of memory */
+        shm_unlink(name);      /* COVERAGE EXCLUSION: Out of memory */
+        return false;          /* COVERAGE EXCLUSION: Out of memory */
+    }
+
+    shm          = addr;
+    shm->version = KIT_COUNTERS_SHM_VERSION;
+    shm->pid     = getpid();
+    shm->size    = size;
+    shm->used    = (sizeof(*shm) + SHM_ALIGN - 1) & ~(SHM_ALIGN - 1);
+    return true;
+}
+
+/**
+ * Mark the exported segment as ready to be read, once the names of any counters registered before it was created are recorded
+ */
+void
+kit_counters_shm_ready(void)
+{
+    if (shm)
+        memcpy(shm->magic, KIT_COUNTERS_SHM_MAGIC, sizeof(shm->magic));
+}
+
+/**
+ * Remove the name of the exported segment, so that it's freed when the process exits and no reader has it open
+ */
+void
+kit_counters_shm_unlink(void)
+{
+    if (shm_name) {
+        shm_unlink(shm_name);
+        kit_free(shm_name);
+        shm_name = NULL;
+    }
+}
@@ -24,55 +24,229 @@
 /*
  * This module implements fast thread safe counters. libkit uses it to track memory allocations.
  *
- * Theory of operation: Each thread has its own set of counters, which it can modify without locking. When a count is needed,
+ * Theory of operation: Each thread has its own block of counters, which it can modify without locking. When a count is needed,
  * it's summed up from all the per thread counts. This is safe to do locklessly because the counts are stored in inherently
  * atomic integers.
  *
- * Currently, threads that don't explicitly allocate counters can use shared counters which are modified using atomic
- * instructions. This is comparatively slow, and so should be avoided. A typical use would be for threads created under the
- * control of a third party library. In future, we may deal with this via an injectable shim library that takes over thread
- * creation.
+ * Blocks are cache line aligned and sized dynamically, so counters can be registered at any time. Only the thread that owns a
+ * block ever grows it, the first time it touches a counter past the end of the block, and the new block is swapped in under
+ * the lock that is held while counters are combined. Groups of counters that are modified together can be registered with
+ * kit_counter_reg_group so that they share a cache line.
+ *
+ * Currently, threads that don't explicitly allocate counters can use shared counters which are modified with atomic adds.
+ * This is comparatively slow, and so should be avoided. A typical use would be for threads created under the control of a
+ * third party library. In future, we may deal with this via an injectable shim library that takes over thread creation.
+ *
+ * So that the shared counters (and those of threads that have exited) can be modified without the lock, their blocks are never
+ * moved. Instead, when a counter past the end of the newest block is touched, a new block is added under the lock, and only the
+ * counters past the end of the previous block are modified in it.
  */
 
 #include "kit-alloc-private.h"
 #include "kit-counters.h"
 
+#include <jemalloc/jemalloc.h>
 #include <pthread.h>
 #include <string.h>
 #include <sxe-util.h>
+#include <time.h>
 
-#define COUNTER_ISVALID(c) (((c) != KIT_COUNTERS_INVALID) && ((c) <= num_counters))
+#define COUNTER_ISVALID(c)    (((c) != KIT_COUNTERS_INVALID) && ((c) <= max_counter) && counter_txt[c])
+#define COUNTERS_PER_LINE     (KIT_COUNTERS_CACHE_LINE / sizeof(unsigned long long))
+#define COUNTERS_ROUND_UP(n)  (((n) + COUNTERS_PER_LINE - 1) & ~(COUNTERS_PER_LINE - 1))
+#define COUNTERS_MIN_CAPACITY 64
+#define COUNTERS_GENERATIONS  32    // Enough blocks for any capacity, since the capacity at least doubles each time one is added
 
 // Counters states
 #define COUNTER_DYNAMIC    1
 #define COUNTER_STATIC     2
 #define COUNTER_USED       4
 
-static struct combine_handler {
+struct counters_generations {    // Blocks modified without the lock. Each holds the counters past the end of the one before.
+    struct kit_counters *block[COUNTERS_GENERATIONS];
+    unsigned             count;
+};
+
+struct combine_handler {
     kit_counter_t counter;
     unsigned long long (*handler)(int);
-} combine_handlers[KIT_COUNTERS_MAX];
-
-static bool          initialized         = false;
-static bool          thread0_initialized = false;
-static bool          allow_shared        = false;
-static kit_mibfn_t   mibfns[KIT_COUNTERS_MAX];
-static kit_counter_t sorted_index[KIT_COUNTERS_MAX];
-static const char   *counter_txt[KIT_COUNTERS_MAX];
-static unsigned      max_counters;
-static unsigned      num_counters;
-static unsigned      num_handlers;
-pthread_spinlock_t   counter_lock;                      // For updating maxthreads
-static unsigned      maxthreads;                        // How many threads
-static uint8_t      *counter_state;                     // State of counters per thread
+};
+
+static bool                    initialized         = false;
+static bool                    thread0_initialized = false;
+static bool                    allow_shared        = false;
+static bool                    auto_threads        = false; // Give unmanaged threads their own counters on first use
+static pthread_key_t           auto_thread_key;        // Releases an automatically registered thread's slot
+static kit_mibfn_t            *mibfns;                 // Indexed by counter
+static kit_counter_t          *sorted_index;           // Registered counters, sorted by their text
+static const char            **counter_txt;            // Indexed by counter; NULL for counters skipped to align groups
+static struct combine_handler *combine_handlers;
+static unsigned                counter_capacity;       // Number of counters the registry has room for
+static unsigned                max_counter;            // Highest counter registered
+static unsigned                num_counters;           // Number of counters registered
+static unsigned                num_handlers;
+pthread_spinlock_t             counter_lock;           // For updating maxthreads and swapping counter blocks
+static unsigned                maxthreads;             // How many threads
+static uint8_t                *counter_state;          // State of counters per thread
 
 /* Counters
  */
-static struct kit_counters **volatile         all_counters;              // All per thread counters
-static struct kit_counters                    thread0_counters;          // Counter structure for the main thread
-static struct kit_counters                    dead_thread_counters;      // Counter structure for dead dynamic threads
-static struct kit_counters                    shared_counters;           // Counter structure for third party threads (atomic)
-static __thread struct kit_counters *volatile thread_counters = NULL;    // Pointer to counter structure for local thread
+static struct kit_counters                    empty_counters;                          // Sentinel for blocks not yet allocated
+static struct kit_counters                    exited_counters;                         // Sentinel for threads that have exited
+static struct kit_counters **volatile         all_counters;                            // All per thread counters
+static struct kit_counters                   *thread0_counters     = &empty_counters;  // Main thread's block before init
+static struct counters_generations            dead_thread_counters;                    // For dead dynamic threads (atomic)
+static struct counters_generations            shared_counters;                         // For third party threads (atomic)
+static unsigned long long                     shared_invalid       = 0;                // Shared uses of the invalid counter
+static __thread struct kit_counters *volatile thread_counters      = NULL;             // Pointer to local thread's block
+static __thread int                           thread_slot          = -1;               // Local thread's slot or -1 if none
+
+/* Allocate a zeroed block with room for size counters that is private to the process. Counter blocks are allocated directly
+ * from jemalloc so that growing them can't recurse into the memory counters.
+ */
+static struct kit_counters *
+counters_alloc_private(unsigned size)
+{
+    struct kit_counters *counters;
+
+    size = COUNTERS_ROUND_UP(size);
+    SXEA1(counters = mallocx(sizeof(*counters) + size * sizeof(counters->val[0]),
+                             MALLOCX_LG_ALIGN(sxe_uint64_log2(KIT_COUNTERS_CACHE_LINE)) | MALLOCX_ZERO),
+          "Failed to allocate a block of %u counters", size);
+    counters->size = size;
+    return counters;
+}
+
+/* Allocate a zeroed block with room for size counters, from the exported segment if counters are being exported
+ */
+static struct kit_counters *
+counters_alloc(unsigned size)
+{
+    struct kit_counters *counters;
+
+    size = COUNTERS_ROUND_UP(size);
+
+    if ((counters = kit_counters_shm_alloc(sizeof(*counters) + size * sizeof(counters->val[0])))) {    // If exporting counters
+        counters->size = size;
+        return counters;
+    }
+
+    return counters_alloc_private(size);
+}
+
+static void
+counters_free(struct kit_counters *counters)
+{
+    if (counters != &empty_counters && counters != &exited_counters && !kit_counters_shm_free(counters))
+        dallocx(counters, 0);
+}
+
+/* Grow the local thread's block. Only the owning thread modifies its block, so only swapping it must be done under the lock.
+ */
+static void
+counters_grow_thread(void)
+{
+    struct kit_counters *old = thread_counters, *grown = counters_alloc(counter_capacity);
+
+    if (initialized)
+        pthread_spin_lock(&counter_lock);
+
+    kit_counters_shm_begin_change();
+    memcpy(grown->val, old->val, old->size * sizeof(old->val[0]));
+
+    if (thread_slot >= 0)
+        all_counters[thread_slot] = grown;
+    else
+        thread0_counters = grown;
+
+    thread_counters = grown;
+    counters_free(old);
+    kit_counters_shm_end_change();
+
+    if (initialized)
+        pthread_spin_unlock(&counter_lock);
+}
+
+/* Get a pointer to a counter in the blocks modified without the lock, or NULL if a block must be added to hold it
+ */
+static inline unsigned long long *
+counters_generations_val(struct counters_generations *gens, kit_counter_t c)
+{
+    unsigned count = __atomic_load_n(&gens->count, __ATOMIC_ACQUIRE);
+    unsigned i;
+
+    for (i = 0; i < count; i++)
+        if (c < gens->block[i]->size)
+            return &gens->block[i]->val[c];
+
+    return NULL;
+}
+
+/* Make sure the blocks modified without the lock have room for every registered counter. Must be called with the lock.
+ */
+static void
+counters_generations_reserve_locked(struct counters_generations *gens)
+{
+    if (gens->count && gens->block[gens->count - 1]->size > max_counter)
+        return;
+
+    SXEA1(gens->count < COUNTERS_GENERATIONS, "Too many generations of counter blocks");
+    gens->block[gens->count] = counters_alloc(counter_capacity);
+    __atomic_store_n(&gens->count, gens->count + 1, __ATOMIC_RELEASE);    // Publish the block after it's been zeroed
+}
+
+/* Add the counters from a block to a block of sums, up to but not including counter 'limit'
+ */
+static void
+counters_sum(struct kit_counters *sums, const struct kit_counters *counters, unsigned limit)
+{
+    unsigned n;
+
+    limit = limit < counters->size ? limit : counters->size;
+
+    for (n = 0; n < limit; n++)
+        sums->val[n] += counters->val[n];
+}
+
+/* Add the counters from the blocks modified without the lock to a block of sums; the counters not held by a block are all 0
+ */
+static void
+counters_generations_sum(struct kit_counters *sums, const struct counters_generations *gens, unsigned limit)
+{
+    unsigned count = __atomic_load_n(&gens->count, __ATOMIC_ACQUIRE);
+    unsigned i;
+
+    for (i = 0; i < count; i++)
+        counters_sum(sums, gens->block[i], limit);
+}
+
+/* Grow the registry so that it has room for at least 'needed' counters. Registry arrays are allocated directly from jemalloc for
+ * the same reason as counter blocks.
+ */
+static void
+registry_grow(unsigned needed)
+{
+    unsigned capacity = counter_capacity ?: COUNTERS_MIN_CAPACITY;
+
+    while (capacity < needed)
+        capacity *= 2;
+
+    capacity = COUNTERS_ROUND_UP(capacity);
+    SXEA1(mibfns = counter_capacity ? rallocx(mibfns, capacity * sizeof(*mibfns), 0) : mallocx(capacity * sizeof(*mibfns), 0),
+          "Failed to allocate %u mib functions", capacity);
+    SXEA1(counter_txt = counter_capacity ? rallocx(counter_txt, capacity * sizeof(*counter_txt), 0)
+                                         : mallocx(capacity * sizeof(*counter_txt), 0),
+          "Failed to allocate %u counter names", capacity);
+    SXEA1(sorted_index = counter_capacity ? rallocx(sorted_index, capacity * sizeof(*sorted_index), 0)
+                                          : mallocx(capacity * sizeof(*sorted_index), 0),
+          "Failed to allocate a sorted index of %u counters", capacity);
+    SXEA1(combine_handlers = counter_capacity ? rallocx(combine_handlers, capacity * sizeof(*combine_handlers), 0)
+                                              : mallocx(capacity * sizeof(*combine_handlers), 0),
+          "Failed to allocate %u combine handlers", capacity);
+    memset(&mibfns[counter_capacity],      0, (capacity - counter_capacity) * sizeof(*mibfns));
+    memset(&counter_txt[counter_capacity], 0, (capacity - counter_capacity) * sizeof(*counter_txt));
+    counter_capacity = capacity;
+}
 
 /*
  * Maintain an array of counter indexes in sorted (by txt value) order, so that sorted text
@@ -96,12 +270,15 @@ add_to_sorted_index(kit_counter_t counter, const char *txt)
  * Register a new counter, along with optional combine handler and mibfn.
  */
 static kit_counter_t
-add_counter(const char *txt, unsigned long long (*combine_handler)(int), kit_mibfn_t mibfn)
+add_counter(const char *txt, unsigned long long (*combine_handler)(int), kit_mibfn_t mibfn, unsigned count)
 {
     kit_counter_t counter;
 
-    counter = ++num_counters;
-    SXEA1(counter < KIT_COUNTERS_MAX, "Counter %d exceeds KIT_COUNTERS_MAX (%d).", counter, KIT_COUNTERS_MAX);
+    if (max_counter + 1 >= counter_capacity)
+        registry_grow(max_counter + 2);
+
+    counter = ++max_counter;
+    num_counters++;
     SXEA1(!counter_txt[counter], "Adding counter %d with value '%s' when it already has a value '%s'.", counter, txt, counter_txt[counter]);
     counter_txt[counter] = txt;
     add_to_sorted_index(counter, counter_txt[counter]);
@@ -113,6 +290,7 @@ add_counter(const char *txt, unsigned long long (*combine_handler)(int), kit_mib
     }
 
     mibfns[counter] = mibfn;
+    kit_counters_shm_name(counter, count, txt);
     return counter;
 }
 
@@ -145,13 +323,14 @@ kit_counter_txt(kit_counter_t c)
  *
  * @param txt Name of the counter (e.g. memory.malloc)
  *
- * @note The txt is not duplicated, so it must be static or in memory reserved by the caller for the lifetime of the counter
+ * @note The txt is not duplicated, so it must be static or in memory reserved by the caller for the lifetime of the counter.
+ *       Counters can be registered after initialization, but not concurrently with other registrations or kit_counters_mib_text.
  */
 kit_counter_t
 kit_counter_reg(const char *txt)
 {
     SXEA1(txt, "Can't register a counter with no text.");
-    return add_counter(txt, NULL, NULL);
+    return add_counter(txt, NULL, NULL, 1);
 }
 
 /**
@@ -166,7 +345,7 @@ kit_counter_t
 kit_counter_reg_with_combine_handler(const char *txt, unsigned long long (*combine_handler)(int))
 {
     SXEA1(txt, "Can't register a counter with no text.");
-    return add_counter(txt, combine_handler, NULL);
+    return add_counter(txt, combine_handler, NULL, 1);
 }
 
 /**
@@ -181,7 +360,180 @@ kit_counter_t
 kit_counter_reg_with_mibfn(const char *txt, kit_mibfn_t mibfn)
 {
     SXEA1(txt, "Can't register a counter with no text.");
-    return add_counter(txt, NULL, mibfn);
+    return add_counter(txt, NULL, mibfn, 1);
+}
+
+/**
+ * Register a group of counters that are laid out contiguously, so that a hot path that modifies them touches as few cache lines
+ * as possible
+ *
+ * @param txts  Names of the counters
+ * @param count Number of counters in the group
+ *
+ * @return The first counter in the group; the others follow it in order
+ *
+ * @note A group of up to 8 counters is guaranteed to share a single cache line in each thread's counter block
+ */
+kit_counter_t
+kit_counter_reg_group(const char *const *txts, unsigned count)
+{
+    kit_counter_t first;
+    unsigned      i, start;
+
+    SXEA1(txts && count, "Can't register an empty group of counters.");
+    start = max_counter + 1;
+
+    if (start % COUNTERS_PER_LINE + count > COUNTERS_PER_LINE)    // If the group won't fit in the current line, skip to the next
+        start = COUNTERS_ROUND_UP(start);
+
+    if (start + count > counter_capacity)
+        registry_grow(start + count);
+
+    max_counter = start - 1;    // The counters skipped are left unregistered
+    first       = kit_counter_reg(txts[0]);
+
+    for (i = 1; i < count; i++)
+        kit_counter_reg(txts[i]);
+
+    return first;
+}
+
+/**
+ * Register a counter that is followed by unnamed counters only accessible through it, for counter types with several values
+ *
+ * @param txt   Name of the counter
+ * @param mibfn Pointer to a function that produces the mib text for the values, or NULL
+ * @param count Total number of counters, including the named one
+ *
+ * @return The named counter; the others follow it in order. The counters start on a cache line.
+ */
+kit_counter_t
+kit_counter_reg_range(const char *txt, kit_mibfn_t mibfn, unsigned count)
+{
+    kit_counter_t first;
+    unsigned      start;
+
+    SXEA1(txt && count, "Can't register an empty range of counters or one with no text.");
+    start = COUNTERS_ROUND_UP(max_counter + 1);
+
+    if (start + count > counter_capacity)
+        registry_grow(start + count);
+
+    max_counter  = start - 1;    // The counters skipped are left unregistered
+    first        = add_counter(txt, NULL, mibfn, count);
+    max_counter += count - 1;    // The rest of the range is reserved but unnamed
+    return first;
+}
+
+/* Add slots in the given state to the per thread arrays, returning false if the number of slots changed while allocating them
+ */
+static bool
+counters_add_slots(unsigned count, uint8_t state)
+{
+    struct kit_counters **ncounters, **ocounters;
+    unsigned i, nthreads, othreads;
+    uint8_t *nstate, *ostate;
+
+    othreads = maxthreads;
+    nthreads = othreads + count;
+    SXEA1(nstate = kit_malloc(nthreads * sizeof(*nstate)),
+          "Failed to allocate %zu bytes for per-thread counter_state", nthreads * sizeof(*nstate));
+    SXEA1(ncounters = kit_malloc(nthreads * sizeof(*ncounters)),
+          "Failed to allocate %zu bytes for per-thread counter block pointers", nthreads * sizeof(*ncounters));
+
+    for (i = othreads; i < nthreads; i++) {
+        nstate[i] = state;
+        ncounters[i] = counters_alloc(counter_capacity);
+    }
+
+    ocounters = ncounters;
+    ostate    = nstate;
+    pthread_spin_lock(&counter_lock);
+
+    if (maxthreads == othreads) {
+        /* Good, nothing's changed! */
+        memcpy(ncounters, all_counters, maxthreads * sizeof(*ncounters));
+        memcpy(nstate, counter_state, maxthreads * sizeof(*nstate));
+        ostate = counter_state;
+        ocounters = all_counters;
+        counter_state = nstate;
+        all_counters = ncounters;
+        maxthreads = nthreads;
+    }
+
+    pthread_spin_unlock(&counter_lock);
+
+    if (ocounters == ncounters)    // Lost a race with another thread, so throw away the new slots
+        for (i = othreads; i < nthreads; i++)
+            counters_free(ncounters[i]);
+
+    kit_free(ocounters);
+    kit_free(ostate);
+    return ocounters != ncounters;
+}
+
+/* Thread exit destructor that releases the slot of a thread that was automatically given its own counters
+ */
+static void
+counters_auto_thread_exit(void *slot_plus_one)
+{
+    kit_counters_fini_dynamic_thread((unsigned)(uintptr_t)slot_plus_one - 1);
+}
+
+/* Give an unmanaged thread a dynamic slot of its own. Only free slots are taken, so that slots prepared for managed dynamic
+ * threads with kit_counters_prepare_dynamic_threads are left for them.
+ */
+static void
+counters_auto_register_thread(void)
+{
+    unsigned slot;
+
+    thread_counters = &exited_counters;    // Count any allocations made while registering with the dead thread counters
+
+    for (;;) {
+        pthread_spin_lock(&counter_lock);
+
+        for (slot = 0; slot < maxthreads; slot++)
+            if (!counter_state[slot])
+                break;
+
+        if (slot < maxthreads) {
+            counter_state[slot] = COUNTER_USED | COUNTER_DYNAMIC;
+            pthread_spin_unlock(&counter_lock);
+            break;
+        }
+
+        pthread_spin_unlock(&counter_lock);
+        counters_add_slots(1, 0);
+    }
+
+    SXEA1(pthread_setspecific(auto_thread_key, (void *)(uintptr_t)(slot + 1)) == 0, "Failed to set the thread's counter slot");
+    thread_counters = all_counters[slot];
+    thread_slot     = slot;
+    memset(thread_counters->val, '\0', thread_counters->size * sizeof(thread_counters->val[0]));
+}
+
+/**
+ * Automatically give threads that use counters without having initialized them their own per thread counters
+ *
+ * @param enable True to give each such thread a dynamic slot the first time it modifies a counter, or false (default) to have
+ *               them use the slower shared counters
+ *
+ * @note Must be called after kit_counters_initialize. Slots are released when the threads exit, and reused.
+ */
+void
+kit_counters_set_auto_threads(bool enable)
+{
+    static bool key_created = false;
+
+    SXEA1(initialized, "Counters not yet initialized");
+
+    if (enable && !key_created) {
+        SXEA1(pthread_key_create(&auto_thread_key, counters_auto_thread_exit) == 0, "Failed to create a thread key");
+        key_created = true;
+    }
+
+    auto_threads = enable;
 }
 
 /* Determine whether the current thread has its own counters or needs to use the slower shared counters
@@ -193,51 +545,88 @@ kit_counters_are_shared(void)
         return false;
 
     if (!thread0_initialized) {
-        thread_counters     = &thread0_counters;
+        thread_counters     = thread0_counters;
         thread0_initialized = true;
         return false;
     }
 
+    if (auto_threads) {
+        counters_auto_register_thread();
+        return false;
+    }
+
     SXEA1(allow_shared, "Shared counters have been disabled and this thread's counters aren't initialized");
     return true;
 }
 
-void
-kit_counter_incr(kit_counter_t c)
+/* Slow path for modifying a counter: the thread's block needs to be set up or grown, or the thread has no block of its own. The
+ * lock is only taken if a block must be added to the shared or dead thread counters.
+ */
+static void
+counter_update(kit_counter_t c, unsigned long long value, bool zero)
 {
-    if (c > num_counters)
-        return;
+    struct counters_generations *gens;
+    unsigned long long          *val;
 
     if (kit_counters_are_shared()) {
-        if (c == KIT_COUNTERS_INVALID)    // Make sure unitialized shared counters don't slow us down
-            shared_counters.val[c]++;
-        else
-            __atomic_add_fetch(&shared_counters.val[c], 1, __ATOMIC_SEQ_CST);
+        if (c == KIT_COUNTERS_INVALID) {    // Make sure unitialized shared counters don't slow us down
+            shared_invalid = zero ? 0 : shared_invalid + value;
+            return;
+        }
+
+        gens = &shared_counters;
     }
+    else if (thread_counters == &exited_counters)    // Thread destructors may still call kit_free()
+        gens = &dead_thread_counters;
+    else {
+        if (c >= thread_counters->size)
+            counters_grow_thread();
+
+        thread_counters->val[c] = zero ? 0 : thread_counters->val[c] + value;
+        return;
+    }
+
+    while (!(val = counters_generations_val(gens, c))) {
+        pthread_spin_lock(&counter_lock);
+        counters_generations_reserve_locked(gens);
+        pthread_spin_unlock(&counter_lock);
+    }
+
+    if (zero)
+        __atomic_store_n(val, 0, __ATOMIC_RELAXED);
     else
+        __atomic_add_fetch(val, value, __ATOMIC_RELAXED);
+}
+
+void
+kit_counter_incr(kit_counter_t c)
+{
+    if (c > max_counter)
+        return;
+
+    if (thread_counters && c < thread_counters->size)
         thread_counters->val[c]++;
+    else
+        counter_update(c, 1, false);
 }
 
 void
 kit_counter_decr(kit_counter_t c)
 {
-    if (c > num_counters)
+    if (c > max_counter)
         return;
 
-    if (kit_counters_are_shared()) {
-        if (c == KIT_COUNTERS_INVALID)    // Make sure unitialized shared counters don't slow us down
-            shared_counters.val[c]--;
-        else
-            __atomic_add_fetch(&shared_counters.val[c], -1LL, __ATOMIC_SEQ_CST);
-    }
-    else
+    if (thread_counters && c < thread_counters->size)
         thread_counters->val[c]--;
+    else
+        counter_update(c, -1ULL, false);
 }
 
 /**
  * Initialize counters
  *
- * @params counts        Maximum number of counters supported; defaults to KIT_COUNTERS_MAX and currently aborts if greater
+ * @params counts        Number of counters to reserve room for in each thread's block (e.g. KIT_COUNTERS_DEFAULT). More
+ *                       counters can be registered, in which case the blocks are grown.
  * @params threads       Maximum number of threads supported; more can be requested with kit_counters_prepare_dynamic_threads
  * @params allow_sharing True (default) to allow shared counters (which are slower) to be used after initialization
  */
@@ -247,22 +636,22 @@ kit_counters_initialize(unsigned counts, unsigned threads, bool allow_sharing)
     unsigned i;
 
     SXEE6("(counts=%u,threads=%u,allow_sharing=%s)", counts, threads, allow_sharing ? "true" : "false");
-    SXEA1(counts <= KIT_COUNTERS_MAX,  "Currently, counts cannot be greater than %u", KIT_COUNTERS_MAX);
     SXEA1(threads,                     "At least one counter slot is required");
     SXEA1(!initialized,                "Already initialized!");
 
     kit_memory_initialize(~0U);    // Initialize memory with default flags or flags set with kit_memory_flags_set
 
+    if (counts > counter_capacity)
+        registry_grow(counts);
+
     if (!thread0_initialized) {    // If no counter has been touched
         SXEA6(!thread_counters, "Per thread counters are set without initializing the main thread");
-        thread_counters     = &thread0_counters;
+        thread_counters     = thread0_counters;
         thread0_initialized = true;
     }
 
     SXEA6(!all_counters && !counter_state, "Partially initialized!");
     pthread_spin_init(&counter_lock, PTHREAD_PROCESS_PRIVATE);
-    initialized  = true;
-    max_counters = counts;
     maxthreads   = threads;
     allow_shared = allow_sharing;
     SXEA1(counter_state = kit_malloc(maxthreads * sizeof(*counter_state)),
@@ -274,22 +663,59 @@ kit_counters_initialize(unsigned counts, unsigned threads, bool allow_sharing)
     SXEA1(all_counters = kit_malloc(maxthreads * sizeof(*all_counters)),
           "Failed to allocate %zu bytes for per-thread counter block pointers", maxthreads * sizeof(*all_counters));
 
-    all_counters[0]   = &thread0_counters;
+    counters_free(thread0_counters);    // Early counts are thrown away, so there's nothing to copy
+    thread0_counters = counters_alloc(counter_capacity);
+    thread_counters   = thread0_counters;
+    thread_slot       = 0;
+    all_counters[0]   = thread0_counters;
     counter_state[0] |= COUNTER_USED;
-    memset(&thread0_counters, 0, sizeof(thread0_counters));    // Throw away any early counts, some of which will be invalid
 
     for (i = 1; i < maxthreads; i++)
-        SXEA1(all_counters[i] = kit_calloc(1, sizeof(*all_counters[i])),
-              "Failed to allocate %zu bytes for a thread counter block", maxthreads * sizeof(*all_counters[i]));
+        all_counters[i] = counters_alloc(counter_capacity);
 
+    initialized = true;
     kit_memory_initialize_counters();    // Tell the memory system to switch over to using counters
     SXER6("return");
 }
 
+/**
+ * Export the counters in a named shared memory segment, so that they can be read by other processes (e.g. kit-counters-read)
+ *
+ * @param name The name of the segment (e.g. "/myprogram-counters"), which is created or truncated; see shm_open(3)
+ * @param size The size of the segment, which must be large enough for all per thread counter blocks as they grow
+ *
+ * @return true on success, false on failure with errno set
+ *
+ * @note Must be called before kit_counters_initialize. Counters with combine handlers are exported as the sum of their per
+ *       thread values, since the handlers can only be run in the process.
+ */
+bool
+kit_counters_export_shm(const char *name, size_t size)
+{
+    kit_counter_t c, next;
+
+    SXEA1(!initialized, "Counters must be exported before they are initialized");
+
+    if (!kit_counters_shm_create(name, size))
+        return false;
+
+    for (c = 1; c <= max_counter; c = next) {    // Record the names of any counters already registered
+        for (next = c + 1; next <= max_counter && !counter_txt[next]; next++) {
+        }
+
+        if (counter_txt[c])
+            kit_counters_shm_name(c, next - c, counter_txt[c]);
+    }
+
+    kit_counters_shm_ready();
+    return true;
+}
+
 /**
  * Allow a thread to test whether it's counters have been initialized.
  *
- * @note If this API is called before any use of counters, it returns true. For unmanaged threads, it always returns false.
+ * @note If this API is called before any use of counters, it returns true. For unmanaged threads, it returns false unless
+ *       kit_counters_set_auto_threads has given them counters of their own.
  */
 bool
 kit_counters_usable(void)
@@ -297,35 +723,134 @@ kit_counters_usable(void)
     return !thread0_initialized || thread_counters;
 }
 
-/* Create a combined structure of the counters for 'threadnum', or all threads if threadnm is -1 */
+/**
+ * Allocate a zeroed block with room for all counters registered so far, for use with kit_counters_combine
+ *
+ * @note Free the block with kit_counters_free
+ */
+struct kit_counters *
+kit_counters_new(void)
+{
+    return counters_alloc_private(max_counter + 1);    // Totals must not be exported, or readers would count them
+}
+
+/**
+ * Free a block of counters allocated by kit_counters_new
+ */
+void
+kit_counters_free(struct kit_counters *counters)
+{
+    if (counters)
+        counters_free(counters);
+}
+
+/* Add the counters for 'threadnum', or all threads if threadnum is -1, to a block; counters that don't fit are ignored */
 void
 kit_counters_combine(struct kit_counters *out_counter, int threadnum)
 {
-    unsigned from, i, n, to;
+    unsigned from, i, limit, to;
 
     SXEA6(all_counters && out_counter, "Can't combine counters that aren't initialized");
     from = threadnum == -1 ? 0 : (unsigned)threadnum;
     to   = threadnum == -1 ? maxthreads : (unsigned)threadnum < maxthreads ? (unsigned)threadnum + 1 : maxthreads;
 
-    /* Total up every field */
+    /* Total up every live counter */
     pthread_spin_lock(&counter_lock);
+    limit = max_counter + 1 < out_counter->size ? max_counter + 1 : out_counter->size;
 
     for (i = from; i < to; i++)
         if (counter_state[i] & COUNTER_USED)
-            for (n = 0; n <= num_counters; n++)
-                out_counter->val[n] += all_counters[i]->val[n];
+            counters_sum(out_counter, all_counters[i], limit);
 
-    if (threadnum == -1)
-        for (n = 0; n <= num_counters; n++) {
-            out_counter->val[n] += dead_thread_counters.val[n];
-            out_counter->val[n] += shared_counters.val[n];
-        }
+    if (threadnum == -1) {
+        counters_generations_sum(out_counter, &dead_thread_counters, limit);
+        counters_generations_sum(out_counter, &shared_counters,      limit);
+
+        if (limit)
+            out_counter->val[KIT_COUNTERS_INVALID] += shared_invalid;
+    }
 
     pthread_spin_unlock(&counter_lock);
 
     /* Update "special" fields that are not continuously updated */
     for (i = 0; i < num_handlers; i++)
-        out_counter->val[combine_handlers[i].counter] = combine_handlers[i].handler(threadnum);
+        if (combine_handlers[i].counter < limit)
+            out_counter->val[combine_handlers[i].counter] = combine_handlers[i].handler(threadnum);
+}
+
+/**
+ * Take a snapshot of the values of all counters, combined for all threads
+ *
+ * @return The snapshot; free it with kit_counters_snapshot_free
+ *
+ * @note Snapshots are allocated directly from jemalloc, so taking them periodically doesn't change the memory counters
+ */
+struct kit_counters_snapshot *
+kit_counters_snapshot(void)
+{
+    struct kit_counters_snapshot *snapshot;
+    struct timespec               now;
+
+    SXEA1(snapshot = mallocx(sizeof(*snapshot), 0), "Failed to allocate a counters snapshot");
+    SXEA1(clock_gettime(CLOCK_MONOTONIC, &now) == 0, "Can't get the monotonic clock time");
+    snapshot->nsec   = now.tv_sec * 1000000000ULL + now.tv_nsec;
+    snapshot->totals = kit_counters_new();
+    kit_counters_combine(snapshot->totals, KIT_THREAD_TOTAL);
+    return snapshot;
+}
+
+void
+kit_counters_snapshot_free(struct kit_counters_snapshot *snapshot)
+{
+    if (snapshot) {
+        counters_free(snapshot->totals);
+        dallocx(snapshot, 0);
+    }
+}
+
+/**
+ * Compute the change in every counter between two snapshots
+ *
+ * @param prev The earlier snapshot
+ * @param cur  The later snapshot
+ *
+ * @return The changes, with the time between the snapshots; free it with kit_counters_delta_free
+ *
+ * @note Counters registered after prev was taken are treated as having been 0 in it
+ */
+struct kit_counters_delta *
+kit_counters_delta(const struct kit_counters_snapshot *prev, const struct kit_counters_snapshot *cur)
+{
+    struct kit_counters_delta *delta;
+    unsigned                   i;
+
+    SXEA1(delta = mallocx(sizeof(*delta) + cur->totals->size * sizeof(delta->val[0]), 0),
+          "Failed to allocate a delta of %u counters", cur->totals->size);
+    delta->seconds = (cur->nsec - prev->nsec) / 1000000000.0;
+    delta->size    = cur->totals->size;
+
+    for (i = 0; i < delta->size; i++)
+        delta->val[i] = cur->totals->val[i] - (i < prev->totals->size ? prev->totals->val[i] : 0);
+
+    return delta;
+}
+
+void
+kit_counters_delta_free(struct kit_counters_delta *delta)
+{
+    if (delta)
+        dallocx(delta, 0);
+}
+
+/**
+ * Get the rate at which a counter changed between the snapshots a delta was computed from
+ *
+ * @return The change per second, or 0 if the counter isn't in the delta or no time passed between the snapshots
+ */
+double
+kit_counters_delta_rate(const struct kit_counters_delta *delta, kit_counter_t c)
+{
+    return c < delta->size && delta->seconds > 0.0 ? delta->val[c] / delta->seconds : 0.0;
 }
 
 /* Set the per-thread pointer to a counter structure */
@@ -336,9 +861,36 @@ kit_counters_init_thread(unsigned slot)
     SXEA1(slot < maxthreads,                     "thread initialized as slot %u, but slot_count is %u", slot, maxthreads);
     SXEA1(!(counter_state[slot] & COUNTER_USED), "thread initialized as slot %u, but that slot is already in use", slot);
     thread_counters      = all_counters[slot];
+    thread_slot          = slot;
     counter_state[slot] |= COUNTER_USED;
 }
 
+/* Fold an exiting thread's counts into the dead thread counters, redirect any further counts there, and put its slot in a new
+ * state. This is all done under the lock, so that the counts are never seen twice or not at all when they're combined.
+ */
+static void
+counters_retire_thread(unsigned slot, uint8_t state)
+{
+    struct kit_counters *counters;
+    unsigned             c, limit;
+
+    pthread_spin_lock(&counter_lock);
+    counters_generations_reserve_locked(&dead_thread_counters);
+    counters = all_counters[slot];
+    limit    = max_counter + 1 < counters->size ? max_counter + 1 : counters->size;
+    kit_counters_shm_begin_change();
+
+    for (c = 0; c < limit; c++)    // Other exited threads may be modifying the dead thread counters without the lock
+        __atomic_add_fetch(counters_generations_val(&dead_thread_counters, c), counters->val[c], __ATOMIC_RELAXED);
+
+    memset(counters->val, '\0', counters->size * sizeof(counters->val[0]));
+    kit_counters_shm_end_change();
+    counter_state[slot] = state;
+    pthread_spin_unlock(&counter_lock);
+    thread_counters = &exited_counters;    /* So that thread destructors can call kit_free() - see pthread_key_create() */
+    thread_slot     = -1;
+}
+
 void
 kit_counters_fini_thread(unsigned slot)
 {
@@ -346,10 +898,7 @@ kit_counters_fini_thread(unsigned slot)
     SXEA1(slot < maxthreads,                     "thread finailized at slot %u, but slot_count is %u", slot, maxthreads);
     SXEA1(counter_state[slot] & COUNTER_USED,    "thread finalized at slot %u, but that slot isn't in use", slot);
     SXEA1(thread_counters == all_counters[slot], "thread finalized at wrong slot %u", slot);
-    kit_counters_combine(&dead_thread_counters, slot);
-    memset(thread_counters, '\0', sizeof(*thread_counters));
-    thread_counters = &dead_thread_counters;    /* So that thread destructors can call kit_free() - see pthread_key_create() */
-    counter_state[slot] &= ~COUNTER_USED;
+    counters_retire_thread(slot, counter_state[slot] & ~COUNTER_USED);
 }
 
 /**
@@ -365,32 +914,34 @@ kit_counters_fini_thread(unsigned slot)
 unsigned long long
 kit_counter_get_data(kit_counter_t c, int threadnum)
 {
-    unsigned long long out_counter = 0;
+    unsigned long long  out_counter = 0;
+    unsigned long long *val;
     unsigned from, i, to;
 
     SXEA6(threadnum >= 0 || threadnum == KIT_THREAD_TOTAL || threadnum == KIT_THREAD_SHARED, "Invalid threadnum");
     SXEA6(thread0_initialized,                            "%s: Main thread not initialized!",    __FUNCTION__);
     SXEA6(allow_shared || threadnum != KIT_THREAD_SHARED, "%s: Shared counters are not enabled", __FUNCTION__);
 
-    if (c <= num_counters && threadnum < (int)maxthreads) {
+    if (c <= max_counter && threadnum < (int)maxthreads) {
         if (!initialized) {
-            SXEA1(thread_counters == &thread0_counters, "Can only be called by the main thread before counter initialization");
-            out_counter = thread_counters->val[c];
-        } else if (threadnum == KIT_THREAD_SHARED) {
-            out_counter = shared_counters.val[c];
+            SXEA1(thread_counters == thread0_counters, "Can only be called by the main thread before counter initialization");
+            out_counter = c < thread_counters->size ? thread_counters->val[c] : 0;
         } else {
             from = threadnum == KIT_THREAD_TOTAL ? 0          : (unsigned)threadnum;
             to   = threadnum == KIT_THREAD_TOTAL ? maxthreads : (unsigned)threadnum + 1;
             pthread_spin_lock(&counter_lock);
 
-            for (i = from; i < to; i++)
-                if (counter_state[i] & COUNTER_USED)
-                    out_counter += all_counters[i]->val[c];
+            if (threadnum != KIT_THREAD_SHARED)
+                for (i = from; i < to; i++)
+                    if (counter_state[i] & COUNTER_USED && c < all_counters[i]->size)
+                        out_counter += all_counters[i]->val[c];
 
-            if (threadnum == KIT_THREAD_TOTAL) {
-                out_counter += dead_thread_counters.val[c];
-                out_counter += shared_counters.val[c];
-            }
+            if (threadnum == KIT_THREAD_TOTAL && (val = counters_generations_val(&dead_thread_counters, c)))
+                out_counter += *val;
+
+            if (threadnum == KIT_THREAD_TOTAL || threadnum == KIT_THREAD_SHARED)
+                out_counter += c == KIT_COUNTERS_INVALID                          ? shared_invalid
+                             : (val = counters_generations_val(&shared_counters, c)) ? *val : 0;
 
             pthread_spin_unlock(&counter_lock);
         }
@@ -409,17 +960,13 @@ kit_counter_get_data(kit_counter_t c, int threadnum)
 void
 kit_counter_add(kit_counter_t c, unsigned long long value)
 {
-    if (c > num_counters)
+    if (c > max_counter)
         return;
 
-    if (kit_counters_are_shared()) {
-        if (c == KIT_COUNTERS_INVALID)    // Make sure unitialized shared counters don't slow us down
-            shared_counters.val[c] += value;
-        else
-            __atomic_add_fetch(&shared_counters.val[c], value, __ATOMIC_SEQ_CST);
-    }
-    else
+    if (thread_counters && c < thread_counters->size)
         thread_counters->val[c] += value;
+    else
+        counter_update(c, value, false);
 }
 
 unsigned long long
@@ -431,13 +978,13 @@ kit_counter_get(kit_counter_t c)
 void
 kit_counter_zero(kit_counter_t c)
 {
-    if (c > num_counters)
+    if (c > max_counter)
         return;
 
-    if (kit_counters_are_shared())
-        shared_counters.val[c] = 0;
-    else
+    if (thread_counters && c < thread_counters->size)
         thread_counters->val[c] = 0;
+    else
+        counter_update(c, 0, true);
 }
 
 unsigned
@@ -455,20 +1002,19 @@ kit_counters_init_dynamic_thread(void)
 
     SXEA1(slot < maxthreads, "Cannot locate a dynamic thread slot");
     thread_counters = all_counters[slot];
+    thread_slot     = slot;
     counter_state[slot] |= COUNTER_USED;
 
     pthread_spin_unlock(&counter_lock);
 
-    memset(thread_counters, '\0', sizeof(*thread_counters));
+    memset(thread_counters->val, '\0', thread_counters->size * sizeof(thread_counters->val[0]));
     return slot;
 }
 
 void
 kit_counters_prepare_dynamic_threads(unsigned count)
 {
-    struct kit_counters **ncounters, **ocounters;
-    unsigned done, i, nthreads;
-    uint8_t *nstate, *ostate;
+    unsigned done, i;
 
     SXEA6(initialized, "Counters not yet initialized");
 
@@ -483,39 +1029,9 @@ kit_counters_prepare_dynamic_threads(unsigned count)
 
         pthread_spin_unlock(&counter_lock);
 
-        while (done < count) {
-            nthreads = maxthreads + count - done;
-            SXEA1(nstate = kit_malloc(nthreads * sizeof(*nstate)),
-                  "Failed to allocate %zu bytes for per-thread counter_state", nthreads * sizeof(*nstate));
-            SXEA1(ncounters = kit_malloc(nthreads * sizeof(*ncounters)),
-                  "Failed to allocate %zu bytes for per-thread counter block pointers", nthreads * sizeof(*ncounters));
-
-            for (i = maxthreads; i < nthreads; i++) {
-                nstate[i] = COUNTER_DYNAMIC;
-                SXEA1(ncounters[i] = kit_malloc(sizeof(*ncounters[i])),
-                      "Failed to allocate %zu bytes for a thread counter block", sizeof(*ncounters[i]));
-            }
-
-            ocounters = NULL;
-            ostate    = NULL;
-            pthread_spin_lock(&counter_lock);
-
-            if (maxthreads == nthreads - count + done) {
-                /* Good, nothing's changed!  There should only be one thing calling us anyway */
-                memcpy(ncounters, all_counters, maxthreads * sizeof(*ncounters));
-                memcpy(nstate, counter_state, maxthreads * sizeof(*nstate));
-                ostate = counter_state;
-                ocounters = all_counters;
-                counter_state = nstate;
-                all_counters = ncounters;
-                done += nthreads - maxthreads;
-                maxthreads = nthreads;
-            }
-
-            pthread_spin_unlock(&counter_lock);
-            kit_free(ocounters);
-            kit_free(ostate);
-        }
+        while (done < count)
+            if (counters_add_slots(count - done, COUNTER_DYNAMIC))
+                done = count;
     }
 }
 
@@ -525,9 +1041,7 @@ kit_counters_fini_dynamic_thread(unsigned slot)
     SXEA6(initialized, "Counters not yet initialized");
     SXEA1(slot < maxthreads, "thread finalized as slot %u, but slot_count is %u", slot, maxthreads);
     SXEA1(counter_state[slot] == (COUNTER_USED|COUNTER_DYNAMIC), "thread finalized as slot %u, but that slot is not dynamic and in use", slot);
-    kit_counters_combine(&dead_thread_counters, slot);
-    thread_counters = &dead_thread_counters;    /* So that thread destructors can call kit_free() - see pthread_key_create() */
-    counter_state[slot] = 0;
+    counters_retire_thread(slot, 0);
 }
 
 bool
@@ -538,10 +1052,25 @@ kit_mibintree(const char *tree, const char *mib)
     return strncmp(tree, mib, len) == 0 && (len == 0 || mib[len] == '\0' || mib[len] == '.');
 }
 
-void
-kit_counters_mib_text(const char *subtree, void *v, kit_counters_mib_callback_t cb, int threadnum, unsigned cflags)
+/* Return true if a counter, or any of the counters in a range registered with it, changed between the snapshots
+ */
+static bool
+counter_changed(kit_counter_t c, const struct kit_counters_snapshot *prev, const struct kit_counters_snapshot *cur)
+{
+    do {
+        if (cur->totals->val[c] != (c < prev->totals->size ? prev->totals->val[c] : 0))
+            return true;
+    } while (++c <= max_counter && c < cur->totals->size && !counter_txt[c]);    // Ranges are followed by unnamed counters
+
+    return false;
+}
+
+/* Call back with the text of the counters in a subtree, skipping unchanged counters if a previous snapshot is given
+ */
+static void
+counters_mib_text(const char *subtree, void *v, kit_counters_mib_callback_t cb, int threadnum, unsigned cflags,
+                  const struct kit_counters_snapshot *prev, const struct kit_counters_snapshot *cur)
 {
-    struct kit_counters counter_totals;
     unsigned long long val;
     const char *name;
     kit_mibfn_t mibfn;
@@ -549,16 +1078,14 @@ kit_counters_mib_text(const char *subtree, void *v, kit_counters_mib_callback_t
     kit_counter_t c;
     unsigned i;
 
-    SXEE6("(subtree=%s,v=%p,cb=%p,threadnum=%d)", subtree, v, cb, threadnum);
-
-    memset(&counter_totals, '\0', sizeof(counter_totals));
-    kit_counters_combine(&counter_totals, threadnum);
-
     for (i = 0; i < num_counters; i++) {
         c = kit_sorted_index(i);
         SXEA6(kit_counter_isvalid(c), "Invalid counter %u at index %u", c, i);
 
-        val = counter_totals.val[c];
+        if (c >= cur->totals->size || (prev && !counter_changed(c, prev, cur)))    // Registered since the snapshot or unchanged
+            continue;
+
+        val = cur->totals->val[c];
         name = kit_counter_txt(c);
         mibfn = mibfns[c];
 
@@ -571,6 +1098,40 @@ kit_counters_mib_text(const char *subtree, void *v, kit_counters_mib_callback_t
             cb(v, name, buf);
         }
     }
+}
+
+void
+kit_counters_mib_text(const char *subtree, void *v, kit_counters_mib_callback_t cb, int threadnum, unsigned cflags)
+{
+    struct kit_counters_snapshot snapshot;
+
+    SXEE6("(subtree=%s,v=%p,cb=%p,threadnum=%d)", subtree, v, cb, threadnum);
 
+    snapshot.totals = kit_counters_new();
+    kit_counters_combine(snapshot.totals, threadnum);
+    counters_mib_text(subtree, v, cb, threadnum, cflags, NULL, &snapshot);
+    kit_counters_free(snapshot.totals);
+    SXER6("return");
+}
+
+/**
+ * Call back with the text of the counters in a subtree that changed between two snapshots
+ *
+ * @param subtree Subtree of counters to include, or "" for all counters
+ * @param v       Value passed through to the callback
+ * @param cb      Callback, called with v, the name of the counter and its value in cur
+ * @param prev    The earlier snapshot, or NULL to include all counters
+ * @param cur     The later snapshot
+ * @param cflags  KIT_COUNTERS_FLAG_NONE or KIT_COUNTERS_FLAG_SUMMARIZE
+ *
+ * @note Counters with mib functions (e.g. histograms) are included if any of their counters changed, and their text is based on
+ *       the current values rather than the snapshot
+ */
+void
+kit_counters_mib_text_changed(const char *subtree, void *v, kit_counters_mib_callback_t cb,
+                              const struct kit_counters_snapshot *prev, const struct kit_counters_snapshot *cur, unsigned cflags)
+{
+    SXEE6("(subtree=%s,v=%p,cb=%p,prev=%p,cur=%p)", subtree, v, cb, prev, cur);
+    counters_mib_text(subtree, v, cb, KIT_THREAD_TOTAL, cflags, prev, cur);
     SXER6("return");
 }
@@ -26,7 +26,9 @@
 
 #include <sxe-log.h>
 
-#define KIT_COUNTERS_MAX            600
+#define KIT_COUNTERS_DEFAULT        600                     // Default number of counters to reserve room for per thread
+#define KIT_COUNTERS_MAX            KIT_COUNTERS_DEFAULT    // Deprecated: counters are no longer limited to this number
+#define KIT_COUNTERS_CACHE_LINE     64
 #define KIT_COUNTERS_INVALID        0       // Uninitialized counters hopefully have this value
 #define KIT_COUNTERS_FLAG_NONE      0x00
 #define KIT_COUNTERS_FLAG_SUMMARIZE 0x01
@@ -40,13 +42,59 @@
 #include <stdbool.h>
 
 struct kit_counters {
-    unsigned long long val[KIT_COUNTERS_MAX];
+    unsigned           size;                                                     // Number of counters the block has room for
+    unsigned long long val[] __attribute__((aligned(KIT_COUNTERS_CACHE_LINE)));    // Values, indexed by counter
+};
+
+struct kit_counters_snapshot {
+    uint64_t             nsec;      // Monotonic time when the snapshot was taken, in nanoseconds
+    struct kit_counters *totals;    // Values of all counters, combined for all threads
+};
+
+struct kit_counters_delta {
+    double    seconds;    // Time between the snapshots
+    unsigned  size;       // Number of counters in the delta
+    long long val[];      // Change in each counter's value, indexed by counter
 };
 
 typedef unsigned kit_counter_t;
 typedef void (*kit_counters_mib_callback_t)(void *, const char *, const char *);
 typedef void (*kit_mibfn_t)(kit_counter_t, const char *subtree, const char *mib, void *v, kit_counters_mib_callback_t cb, int threadnum, unsigned cflags);
 
+/* Layout of a shared memory segment that counters are exported in (see kit-counters-shm.c). All offsets are from the start of
+ * the segment. Readers must check the magic and version, and retry if writers is nonzero or generation changes while reading.
+ */
+#define KIT_COUNTERS_SHM_MAGIC   "KITCNTRS"
+#define KIT_COUNTERS_SHM_VERSION 1
+
+struct kit_counters_shm_header {
+    char     magic[8];      // KIT_COUNTERS_SHM_MAGIC, not NUL terminated
+    uint32_t version;       // KIT_COUNTERS_SHM_VERSION
+    uint32_t pid;           // Process that exported the counters
+    uint64_t size;          // Size of the segment
+    uint64_t used;          // Number of bytes of the segment allocated, including the header
+    uint64_t generation;    // Changed whenever counter values are moved between blocks
+    uint64_t writers;       // Number of threads moving counter values between blocks
+    uint64_t blocks;        // Offset of the most recently allocated block record, or 0
+    uint64_t names;         // Offset of the most recently registered name record, or 0
+};
+
+struct kit_counters_shm_block {    // Followed, at offset KIT_COUNTERS_CACHE_LINE, by a struct kit_counters
+    uint64_t next;                 // Offset of the previously allocated block record, or 0
+    uint64_t live;                 // Nonzero if the block is in use; blocks that are replaced are never reused
+};
+
+struct kit_counters_shm_name {
+    uint64_t next;       // Offset of the previously registered name record, or 0
+    uint32_t counter;    // Counter with the name
+    uint32_t count;      // Number of counters in the range starting with the counter (more than 1 for histograms)
+    char     name[];     // NUL terminated name
+};
+
+struct kit_histogram;    // Distribution of values recorded in per thread counters; see kit-histogram.c
+
 #include "kit-counters-proto.h"
+#include "kit-counters-shm-proto.h"
+#include "kit-histogram-proto.h"
 
 #endif
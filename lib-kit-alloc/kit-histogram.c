@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Histograms of values such as latencies, recorded in per thread counters so that recording is as fast as kit_counter_incr.
+ *
+ * Buckets are log-linear, in the style of HDR histograms: values below 8 each have their own bucket, and each power of 2 above
+ * that is split into 8 linear sub-buckets, so a value's bucket is never more than 12.5% wider than the value. Each bucket is a
+ * counter, and the buckets of a histogram are registered as a range of counters, so they are summed with all other counters
+ * by kit_counters_combine. In the mib text, a histogram is shown as its count, percentiles and nonzero buckets.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "kit-alloc.h"
+#include "kit-counters.h"
+#include "sxe-log.h"
+
+#define HISTOGRAM_SUB_BITS    3
+#define HISTOGRAM_SUB_BUCKETS (1U << HISTOGRAM_SUB_BITS)
+
+struct kit_histogram {
+    kit_counter_t first;      // Counter of the first bucket, which is registered with the histogram's name
+    unsigned      buckets;    // Number of buckets; values too big for the last bucket are counted in it
+};
+
+static struct kit_histogram **histograms     = NULL;    // All histograms registered, for use by histogram_mibfn
+static unsigned               num_histograms = 0;
+
+static const unsigned histogram_percentiles[] = {500, 900, 990, 999};    // Percentiles shown in the mib text, in per mille
+
+/* Map a value to its bucket
+ */
+static inline unsigned
+histogram_bucket(uint64_t value)
+{
+    unsigned msb;
+
+    if (value < HISTOGRAM_SUB_BUCKETS)
+        return value;
+
+    msb = 63 - __builtin_clzll(value);
+    return (msb - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS
+         + ((value >> (msb - HISTOGRAM_SUB_BITS)) & (HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+/* Return the highest value that maps to a bucket
+ */
+static uint64_t
+histogram_bucket_max(unsigned bucket)
+{
+    unsigned shift;
+
+    if (bucket < HISTOGRAM_SUB_BUCKETS)
+        return bucket;
+
+    shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    return ((uint64_t)(HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS) << shift) + ((1ULL << shift) - 1);
+}
+
+static struct kit_histogram *
+histogram_find(kit_counter_t c)
+{
+    unsigned i;
+
+    for (i = 0; i < num_histograms; i++)
+        if (histograms[i]->first == c)
+            return histograms[i];
+
+    return NULL;    /* COVERAGE EXCLUSION: Only histograms are registered with histogram_mibfn */
+}
+
+/* Return the highest value in the bucket that contains the value at a percentile, given the combined counters
+ */
+static uint64_t
+histogram_value_at(const struct kit_histogram *histogram, const struct kit_counters *totals, unsigned permille)
+{
+    unsigned long long count, rank, seen;
+    unsigned           i;
+
+    for (count = 0, i = 0; i < histogram->buckets; i++)
+        count += totals->val[histogram->first + i];
+
+    if (count == 0)
+        return 0;
+
+    rank = (count * permille + 999) / 1000 ?: 1;    // The rank of the value at the percentile, rounded up
+
+    for (seen = 0, i = 0; i < histogram->buckets - 1; i++)
+        if ((seen += totals->val[histogram->first + i]) >= rank)
+            break;
+
+    return histogram_bucket_max(i);
+}
+
+/* Produce the mib text for a histogram: <name>.count, <name>.p50 ... <name>.p999, and <name>.bucket.<max> for nonzero buckets
+ */
+static void
+histogram_mibfn(kit_counter_t c, const char *subtree, const char *mib, void *v, kit_counters_mib_callback_t cb, int threadnum,
+                unsigned cflags)
+{
+    struct kit_histogram *histogram = histogram_find(c);
+    struct kit_counters  *totals;
+    unsigned long long    count;
+    char                  buf[32], submib[256];
+    unsigned              i;
+
+    SXE_UNUSED_PARAMETER(cflags);
+
+    if (!histogram)
+        return;    /* COVERAGE EXCLUSION: Only histograms are registered with histogram_mibfn */
+
+    totals = kit_counters_new();
+    kit_counters_combine(totals, threadnum);
+
+    for (count = 0, i = 0; i < histogram->buckets; i++)
+        count += totals->val[histogram->first + i];
+
+    snprintf(submib, sizeof(submib), "%s.count", mib);
+
+    if (kit_mibintree(subtree, submib)) {
+        snprintf(buf, sizeof(buf), "%llu", count);
+        cb(v, submib, buf);
+    }
+
+    for (i = 0; i < sizeof(histogram_percentiles) / sizeof(histogram_percentiles[0]); i++) {
+        snprintf(submib, sizeof(submib), "%s.p%u", mib,
+                 histogram_percentiles[i] % 10 ? histogram_percentiles[i] : histogram_percentiles[i] / 10);
+
+        if (kit_mibintree(subtree, submib)) {
+            snprintf(buf, sizeof(buf), "%" PRIu64, histogram_value_at(histogram, totals, histogram_percentiles[i]));
+            cb(v, submib, buf);
+        }
+    }
+
+    for (i = 0; i < histogram->buckets; i++) {
+        if (!totals->val[histogram->first + i])
+            continue;
+
+        snprintf(submib, sizeof(submib), "%s.bucket.%" PRIu64, mib, histogram_bucket_max(i));
+
+        if (kit_mibintree(subtree, submib)) {
+            snprintf(buf, sizeof(buf), "%llu", totals->val[histogram->first + i]);
+            cb(v, submib, buf);
+        }
+    }
+
+    kit_counters_free(totals);
+}
+
+/**
+ * Register a histogram
+ *
+ * @param txt       Name of the histogram (e.g. cdb.lookup.usec)
+ * @param max_value Largest value to be tracked precisely; larger values are counted in the last bucket
+ *
+ * @return The histogram, which can't be unregistered
+ *
+ * @note The txt is not duplicated, so it must be static or in memory reserved by the caller for the lifetime of the histogram.
+ *       The counter registered with the txt is the histogram's first bucket.
+ */
+struct kit_histogram *
+kit_histogram_reg(const char *txt, uint64_t max_value)
+{
+    struct kit_histogram *histogram;
+
+    SXEA1(histogram = kit_malloc(sizeof(*histogram)), "Failed to allocate a histogram");
+    SXEA1(histograms = kit_realloc(histograms, (num_histograms + 1) * sizeof(*histograms)), "Failed to allocate a histogram");
+    histogram->buckets           = histogram_bucket(max_value) + 1;
+    histogram->first             = kit_counter_reg_range(txt, histogram_mibfn, histogram->buckets);
+    histograms[num_histograms++] = histogram;
+    return histogram;
+}
+
+/**
+ * Record a value in a histogram
+ */
+void
+kit_histogram_record(const struct kit_histogram *histogram, uint64_t value)
+{
+    unsigned bucket = histogram_bucket(value);
+
+    kit_counter_incr(histogram->first + (bucket < histogram->buckets ? bucket : histogram->buckets - 1));
+}
+
+/**
+ * Get the value at a percentile of a histogram
+ *
+ * @param histogram The histogram
+ * @param permille  The percentile in parts per thousand (e.g. 999 for p99.9)
+ * @param threadnum Thread slot number or KIT_THREAD_TOTAL for all threads
+ *
+ * @return The highest value in the bucket containing the value at the percentile, or 0 if no values have been recorded
+ */
+uint64_t
+kit_histogram_get_percentile(const struct kit_histogram *histogram, unsigned permille, int threadnum)
+{
+    struct kit_counters *totals = kit_counters_new();
+    uint64_t             value;
+
+    SXEA6(permille <= 1000, "Percentile %u is more than 1000 per mille", permille);
+    kit_counters_combine(totals, threadnum);
+    value = histogram_value_at(histogram, totals, permille);
+    kit_counters_free(totals);
+    return value;
+}
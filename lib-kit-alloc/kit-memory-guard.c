@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Sampled overflow guards. Checking every allocation for overflows (KIT_MEMORY_CHECK_OVERFLOWS) is too expensive for production,
+ * so when it's off, one in every rate allocations made by each thread can be guarded instead. Each thread counts down its own
+ * allocations, so sampling takes no shared atomics and no division, and starts counting at a different phase derived from the
+ * address of its countdown, so that threads doing the same work aren't all guarded at the same points in it.
+ *
+ * Guarded allocations have the same guards as when checking every allocation, with a flag set in the size in their fore guards,
+ * and are recorded in a lock free table (see kit-memory-table.c) so that they can be recognized and checked when they are freed.
+ * Frees of memory whose fore guard isn't flagged don't look it up. With KIT_MEMORY_GUARD_PAGE, up to GUARD_PAGES_MAX guarded
+ * allocations are each placed at the end of their own pages, followed by a page that is made inaccessible, so that an overflow of
+ * more than a few bytes faults immediately. If the page can't be made accessible again when the memory is freed, the memory is
+ * leaked rather than returned to jemalloc. The tables are allocated directly from jemalloc, so they are not counted as kit
+ * allocations.
+ */
+
+#include <errno.h>
+#include <jemalloc/jemalloc.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "kit-alloc-private.h"
+#include "kit-mockfail.h"
+#include "sxe-util.h"
+
+#define GUARD_POINTERS  65536    // Maximum number of live guarded allocations, a power of 2
+#define GUARD_PAGES_MAX 1024     // Maximum number of live guarded allocations followed by inaccessible pages
+#define GUARD_MIN_ALIGN 16       // jemalloc's minimum alignment
+
+struct kit_memory_guard_pointer {
+    void *ptr;     // Guarded allocation; see kit-memory-table.c
+    void *base;    // Memory actually allocated
+    void *page;    // Inaccessible page after the allocation, or NULL if none
+};
+
+unsigned                                kit_memory_guard_rate      = 0;        // Guard 1 in rate allocations, or 0 if not sampling
+__thread int                            kit_memory_guard_countdown = 0;        // Allocations by this thread until one is guarded
+uint64_t                                kit_memory_guard_live      = 0;        // Number of live guarded allocations
+static unsigned                         guard_flags                = 0;        // KIT_MEMORY_GUARD_PAGE or 0
+static size_t                           guard_page_size            = 0;
+static struct kit_memory_guard_pointer *guard_pointers             = NULL;
+static struct kit_memory_table          guard_table;                           // Table of guard_pointers
+static unsigned                         guard_pages                = 0;        // Inaccessible pages, including any leaked
+static __thread bool                    guard_phased               = false;    // Whether this thread's countdown was started
+
+/* Called while sampling when this thread's countdown runs out, returning true if the allocation should be guarded. The first
+ * time, the countdown is started at the thread's phase instead, unless its phase is 0.
+ */
+bool
+kit_memory_guard_sample(void)
+{
+    uint64_t hash;
+
+    if (!guard_phased) {
+        hash                       = (uintptr_t)&kit_memory_guard_countdown * 0x9E3779B97F4A7C15ULL;
+        kit_memory_guard_countdown = (int)((hash >> 32) % kit_memory_guard_rate);
+        guard_phased               = true;
+
+        if (kit_memory_guard_countdown)
+            return false;
+    }
+
+    kit_memory_guard_countdown = (int)kit_memory_guard_rate;
+    return true;
+}
+
+/* Record a guarded allocation, returning false if the table is full
+ */
+static bool
+guard_record(void *ptr, void *base, void *page)
+{
+    unsigned idx;
+
+    if ((idx = kit_memory_table_add(&guard_table, ptr)) == ~0U)
+        return false;    /* COVERAGE EXCLUSION: Too many live guarded allocations */
+
+    guard_pointers[idx].base = base;
+    guard_pointers[idx].page = page;
+    __atomic_add_fetch(&kit_memory_guard_live, 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* Make the inaccessible page after guarded memory accessible again, returning false if it can't be, in which case the memory must
+ * be leaked
+ */
+static bool
+guard_unprotect(const void *ptr, void *page)
+{
+    if (MOCKERROR(kit_free_diag, -1, ENOMEM, mprotect(page, guard_page_size, PROT_READ | PROT_WRITE)) != 0) {
+        SXEL2("Failed to unprotect the page after guarded memory %p; leaking it: %s", ptr, strerror(errno));
+        return false;
+    }
+
+    __atomic_sub_fetch(&guard_pages, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+/* Reserve one of the GUARD_PAGES_MAX inaccessible pages, returning false if they're all in use
+ */
+static bool
+guard_reserve_page(void)
+{
+    if (__atomic_add_fetch(&guard_pages, 1, __ATOMIC_RELAXED) <= GUARD_PAGES_MAX)
+        return true;
+
+    __atomic_sub_fetch(&guard_pages, 1, __ATOMIC_RELAXED);
+    return false;
+}
+
+/* Allocate guarded memory, which is recorded so that kit_memory_check can check it. If it can't be recorded, it's unguarded.
+ */
+char *
+kit_memory_guard_alloc(size_t size, size_t alignment, int flags)
+{
+    size_t guarded = kit_memory_guard_size(size, alignment);
+    size_t align   = alignment > GUARD_MIN_ALIGN ? alignment : GUARD_MIN_ALIGN;
+    size_t length;
+    char  *base, *page, *result;
+    int    page_flags;
+
+    page = NULL;
+
+    if ((guard_flags & KIT_MEMORY_GUARD_PAGE) && align <= guard_page_size && guard_reserve_page()) {
+        length     = (guarded + guard_page_size - 1) & ~(guard_page_size - 1);
+        page_flags = (flags & MALLOCX_ZERO) | MALLOCX_LG_ALIGN(sxe_uint64_log2(guard_page_size));
+
+        if (!(base = mallocx(length + guard_page_size, page_flags))) {
+            __atomic_sub_fetch(&guard_pages, 1, __ATOMIC_RELAXED);
+            return NULL;
+        }
+
+        page   = base + length;
+        result = (char *)((uintptr_t)(page - guarded) & ~(align - 1));    // As close to the inaccessible page as alignment allows
+
+        if (mprotect(page, guard_page_size, PROT_NONE) != 0) {
+            SXEL2("Failed to protect the page after guarded memory: %s", strerror(errno));    /* COVERAGE EXCLUSION: mprotect */
+            __atomic_sub_fetch(&guard_pages, 1, __ATOMIC_RELAXED);                             /* COVERAGE EXCLUSION: mprotect */
+            page = NULL;                                                                       /* COVERAGE EXCLUSION: mprotect */
+        }
+    }
+    else if (!(result = base = mallocx(guarded, flags)))
+        return NULL;
+
+    kit_memory_guard_set(&result, guarded, alignment);
+    kit_memory_guard_mark(result, KIT_MEMORY_GUARD_SAMPLED);
+
+    if (guard_record(result, base, page))
+        return result;
+
+    if (!page || guard_unprotect(result, page))    /* COVERAGE EXCLUSION: Table is full */
+        dallocx(base, 0);                          /* COVERAGE EXCLUSION: Table is full */
+
+    return mallocx(size, flags);                   /* COVERAGE EXCLUSION: Table is full */
+}
+
+/* Look up a pointer to memory that may be guarded, returning the memory actually allocated or NULL if it's not guarded. If remove
+ * is true, the memory is about to be freed, so its inaccessible page is made accessible again and it's forgotten. If the page
+ * can't be made accessible, KIT_MEMORY_LEAKED is returned, and the memory must not be freed.
+ */
+void *
+kit_memory_guard_find(const void *ptr, bool remove)
+{
+    struct kit_memory_guard_pointer *entry;
+    unsigned                         idx;
+    void                            *base;
+
+    if ((idx = kit_memory_table_find(&guard_table, ptr)) == ~0U)
+        return NULL;    // Not guarded
+
+    entry = &guard_pointers[idx];
+    base  = entry->base;
+
+    if (remove) {
+        if (entry->page && !guard_unprotect(ptr, entry->page))
+            base = KIT_MEMORY_LEAKED;
+
+        kit_memory_table_remove(&guard_table, idx);
+        __atomic_sub_fetch(&kit_memory_guard_live, 1, __ATOMIC_RELEASE);
+    }
+
+    return base;
+}
+
+/**
+ * Start guarding a sample of the allocations made with the kit allocation functions
+ *
+ * @param rate  The number of allocations made by each thread for each one guarded, or 0 for the default
+ *              (KIT_MEMORY_GUARD_RATE_DEFAULT)
+ * @param flags KIT_MEMORY_GUARD_PAGE to place guarded allocations before an inaccessible page, or 0
+ *
+ * @return true on success, false if KIT_MEMORY_CHECK_OVERFLOWS is set, so all allocations are already guarded, or
+ *         KIT_MEMORY_TAG_ALLOCATIONS is set (EINVAL), or if the tables couldn't be allocated (ENOMEM)
+ *
+ * @note Guards are checked when guarded memory is reallocated or freed; overwriting them aborts the process. Other threads
+ *       that were already sampling finish their current countdowns at the previous rate.
+ */
+bool
+kit_memory_guard_start(unsigned rate, unsigned flags)
+{
+    struct kit_memory_guard_pointer *pointers;
+
+    if (kit_memory_get_flags() & (KIT_MEMORY_CHECK_OVERFLOWS | KIT_MEMORY_TAG_ALLOCATIONS)) {    // Every allocation has a header
+        errno = EINVAL;
+        return false;
+    }
+
+    if (!guard_pointers) {
+        if (!(pointers = mallocx(GUARD_POINTERS * sizeof(*pointers), MALLOCX_ZERO))) {
+            errno = ENOMEM;                 /* COVERAGE EXCLUSION: Out of memory condition */
+            return false;                   /* COVERAGE EXCLUSION: Out of memory condition */
+        }
+
+        guard_page_size        = (size_t)sysconf(_SC_PAGESIZE);
+        guard_pointers         = pointers;
+        guard_table.entries    = (char *)pointers;
+        guard_table.entry_size = sizeof(*pointers);
+        guard_table.mask       = GUARD_POINTERS - 1;
+    }
+
+    guard_flags                = flags;
+    guard_phased               = false;    // Restart the calling thread's countdown at the new rate
+    kit_memory_guard_countdown = 0;
+    __atomic_store_n(&kit_memory_guard_rate, rate ?: KIT_MEMORY_GUARD_RATE_DEFAULT, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * Stop guarding allocations. Memory that was already guarded is still checked when it's reallocated or freed.
+ */
+void
+kit_memory_guard_stop(void)
+{
+    __atomic_store_n(&kit_memory_guard_rate, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Determine whether memory allocated by the kit allocation functions was guarded because it was sampled
+ */
+bool
+kit_memory_guarded(const void *ptr)
+{
+    return KIT_MEMORY_GUARD_LIVE() && kit_memory_guard_find(ptr, false);
+}
@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Sampling allocation profiler. When profiling is on, each thread counts down the bytes it allocates, sampling the allocation
+ * that reaches zero and restarting the count from a random interval with an exponential distribution whose mean is the sampling
+ * rate. This samples about one allocation in every rate bytes, and makes large allocations proportionately more likely to be
+ * sampled. Sampled allocations are recorded against their kit_malloc call site (file and line) and in a table of sampled
+ * pointers, so that freeing them can reduce their call site's live bytes.
+ *
+ * Sampled allocations are given guards, and the size in the fore guard is flagged with KIT_MEMORY_PROFILE_SAMPLED, so frees of
+ * memory that isn't flagged don't have to look it up (see kit-alloc.c). Only sampled allocations touch the tables, which are lock
+ * free (see kit-memory-table.c), so that memory freed by a different thread than the one that allocated it is accounted for
+ * correctly. Each sample is weighted by the inverse of the probability it
+ * would be sampled, so the counts and bytes reported are unbiased estimates of the totals. The tables are allocated directly from
+ * jemalloc, so they are not counted as kit allocations.
+ */
+
+#include <errno.h>
+#include <jemalloc/jemalloc.h>
+#include <string.h>
+
+#include "kit-alloc-private.h"
+
+#define PROFILE_SITES    4096     // Maximum number of call sites, a power of 2
+#define PROFILE_POINTERS 65536    // Size of the table of live sampled allocations, a power of 2
+#define PROFILE_LIVE_MAX 32768    // Maximum number of live sampled allocations, so that the table never fills
+#define PROFILE_LN2      0.6931471805599453
+#define PROFILE_ONE      65536    // Estimates are kept in fixed point, in units of 1/PROFILE_ONE, so weights aren't rounded
+
+#define PROFILE_ROUND(fixed) (((fixed) + PROFILE_ONE / 2) / PROFILE_ONE)    // Round a fixed point estimate when reporting it
+
+struct kit_memory_profile_site {
+    const char *file;           // File of the call site, or NULL if the entry is unused
+    int         line;           // Line of the call site, or 0 if the entry is still being claimed
+    uint64_t    allocations;    // Estimated number of allocations, in fixed point
+    uint64_t    bytes;          // Estimated number of bytes allocated, in fixed point
+    int64_t     live_allocations;
+    int64_t     live_bytes;
+};
+
+struct kit_memory_profile_pointer {
+    void    *ptr;            // Sampled allocation; see kit-memory-table.c
+    unsigned site;           // Index of the call site
+    uint64_t allocations;    // Estimated number of allocations the sample represents, in fixed point
+    uint64_t bytes;          // Estimated number of bytes the sample represents, in fixed point
+};
+
+size_t                                    kit_memory_profile_rate      = 0;    // Mean bytes between samples, or 0 if off
+__thread int64_t                          kit_memory_profile_countdown = 0;    // Bytes this thread can allocate before a sample
+uint64_t                                  kit_memory_profile_live      = 0;    // Number of live sampled allocations
+static uint64_t                           profile_dropped              = 0;    // Samples dropped because there were too many
+static struct kit_memory_profile_site    *profile_sites                = NULL;
+static struct kit_memory_profile_pointer *profile_pointers             = NULL;
+static struct kit_memory_table            profile_table;                       // Table of profile_pointers
+static __thread uint64_t                  profile_random               = 0;    // State of this thread's random number generator
+
+/* Compute the natural log of x > 0 without libm, accurate to about 1e-6, which is plenty for sampling
+ */
+static double
+profile_ln(double x)
+{
+    double   z, z2;
+    int      exponent = 0;
+
+    for (; x >= 2.0; x /= 2.0)
+        exponent++;
+
+    for (; x < 1.0; x *= 2.0)
+        exponent--;
+
+    z  = (x - 1.0) / (x + 1.0);    // ln(x) = 2 atanh(z), with 0 <= z < 1/3
+    z2 = z * z;
+    return exponent * PROFILE_LN2 + 2.0 * z * (1.0 + z2 * (1.0 / 3 + z2 * (1.0 / 5 + z2 * (1.0 / 7 + z2 / 9))));
+}
+
+/* Compute e to the power -x for x >= 0 without libm, accurate to about 1e-6
+ */
+static double
+profile_exp_neg(double x)
+{
+    double   y;
+    unsigned i;
+
+    if (x > 40.0)
+        return 0.0;
+
+    y = x / 64.0;    // e^-x = (e^-y)^64, and e^-y is well approximated by a short series for small y
+    y = 1.0 - y * (1.0 - y / 2 * (1.0 - y / 3 * (1.0 - y / 4)));
+
+    for (i = 0; i < 6; i++)
+        y *= y;
+
+    return y;
+}
+
+/* Choose the number of bytes until the next sample, which is exponentially distributed with mean kit_memory_profile_rate
+ */
+static int64_t
+profile_interval(void)
+{
+    uint64_t bits;
+
+    if (profile_random == 0)    // Seed each thread differently
+        profile_random = ((uintptr_t)&profile_random | 1) * 0x9E3779B97F4A7C15ULL;
+
+    profile_random ^= profile_random << 13;    // xorshift64
+    profile_random ^= profile_random >> 7;
+    profile_random ^= profile_random << 17;
+    bits            = (profile_random >> 11) + 1;    // Uniform in [1, 2^53]
+    return (int64_t)(-profile_ln((double)bits / 9007199254740992.0) * (double)kit_memory_profile_rate) + 1;
+}
+
+static unsigned
+profile_hash_site(const char *file, int line)
+{
+    uint64_t hash = (uint64_t)line * 0x9E3779B97F4A7C15ULL;
+
+    for (; *file; file++)    // Hash the file name, since different pointers may be used for the same file's name
+        hash = (hash ^ (uint8_t)*file) * 0x100000001B3ULL;
+
+    return (unsigned)(hash ^ hash >> 32);
+}
+
+/* Find or add a call site, returning its index or ~0U if the table is full
+ */
+static unsigned
+profile_get_site(const char *file, int line)
+{
+    const char *found;
+    unsigned    i, idx;
+    int         found_line;
+
+    for (i = 0, idx = profile_hash_site(file, line); i < PROFILE_SITES; i++, idx++) {
+        idx  &= PROFILE_SITES - 1;
+        found = __atomic_load_n(&profile_sites[idx].file, __ATOMIC_ACQUIRE);
+
+        if (!found) {
+            if (!__atomic_compare_exchange_n(&profile_sites[idx].file, &found, file, false, __ATOMIC_ACQ_REL,
+                                             __ATOMIC_ACQUIRE)) {
+                i--, idx--;    // Another thread claimed the entry; look at it again
+                continue;
+            }
+
+            __atomic_store_n(&profile_sites[idx].line, line, __ATOMIC_RELEASE);
+            return idx;
+        }
+
+        while ((found_line = __atomic_load_n(&profile_sites[idx].line, __ATOMIC_ACQUIRE)) == 0)
+            ;    /* COVERAGE EXCLUSION: Another thread is claiming the entry */
+
+        if (found_line == line && (found == file || strcmp(found, file) == 0))
+            return idx;
+    }
+
+    return ~0U;
+}
+
+/* Estimate the number of allocations like a sample of size bytes that it represents, which is the inverse of the probability it
+ * was sampled, in fixed point. Rounding it to a whole number of allocations would bias every estimate.
+ */
+static uint64_t
+profile_weight(size_t size)
+{
+    if (size == 0)    // Zero byte allocations can only be sampled if the interval is exhausted by previous allocations
+        return PROFILE_ONE;
+
+    return (uint64_t)(PROFILE_ONE / (1.0 - profile_exp_neg((double)size / (double)kit_memory_profile_rate)) + 0.5);
+}
+
+/* Called while profiling when this thread's countdown runs out, returning true if the next allocation should be sampled. The
+ * countdown is restarted, and the sample is dropped if there are already too many live sampled allocations.
+ */
+bool
+kit_memory_profile_sample(void)
+{
+    kit_memory_profile_countdown = profile_interval();
+
+    if (__atomic_load_n(&kit_memory_profile_live, __ATOMIC_RELAXED) < PROFILE_LIVE_MAX)
+        return true;
+
+    __atomic_add_fetch(&profile_dropped, 1, __ATOMIC_RELAXED);    /* COVERAGE EXCLUSION: Too many live sampled allocations */
+    return false;                                                 /* COVERAGE EXCLUSION: Too many live sampled allocations */
+}
+
+/* Record a sampled allocation of size bytes at file:line, returning false if it can't be recorded because a table is full
+ */
+bool
+kit_memory_profile_alloc(void *ptr, size_t size, const char *file, int line)
+{
+    struct kit_memory_profile_site *site;
+    uint64_t                        allocations;
+    unsigned                        site_idx, idx;
+
+    if ((site_idx = profile_get_site(file ?: "unknown", line)) == ~0U
+     || (idx = kit_memory_table_add(&profile_table, ptr)) == ~0U) {
+        __atomic_add_fetch(&profile_dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    allocations                       = profile_weight(size);
+    profile_pointers[idx].site        = site_idx;
+    profile_pointers[idx].allocations = allocations;
+    profile_pointers[idx].bytes       = allocations * size;
+    site                              = &profile_sites[site_idx];
+    __atomic_add_fetch(&site->allocations,      allocations,        __ATOMIC_RELAXED);
+    __atomic_add_fetch(&site->bytes,            allocations * size, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&site->live_allocations, allocations,        __ATOMIC_RELAXED);
+    __atomic_add_fetch(&site->live_bytes,       allocations * size, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&kit_memory_profile_live, 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* Look up a pointer to memory that may have been sampled, returning true if it was. If remove is true, the memory is about to be
+ * freed, so it's forgotten.
+ */
+bool
+kit_memory_profile_find(const void *ptr, bool remove)
+{
+    struct kit_memory_profile_pointer *entry;
+    struct kit_memory_profile_site    *site;
+    unsigned                           idx;
+
+    if ((idx = kit_memory_table_find(&profile_table, ptr)) == ~0U)
+        return false;    // Not sampled
+
+    if (remove) {
+        entry = &profile_pointers[idx];
+        site  = &profile_sites[entry->site];
+        __atomic_sub_fetch(&site->live_allocations, entry->allocations, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&site->live_bytes,       entry->bytes,       __ATOMIC_RELAXED);
+        kit_memory_table_remove(&profile_table, idx);
+        __atomic_sub_fetch(&kit_memory_profile_live, 1, __ATOMIC_RELEASE);
+    }
+
+    return true;
+}
+
+/**
+ * Start sampling allocations made with the kit allocation functions
+ *
+ * @param rate The mean number of bytes allocated between samples, or 0 for the default (KIT_MEMORY_PROFILE_RATE_DEFAULT)
+ *
+ * @return true on success, false if the profiler's tables couldn't be allocated (ENOMEM)
+ *
+ * @note Call sites are accumulated from the first time profiling is started; stopping and restarting it doesn't clear them.
+ *       The calling thread's countdown is restarted at the new rate, but other threads finish their current countdowns first.
+ */
+bool
+kit_memory_profile_start(size_t rate)
+{
+    struct kit_memory_profile_site    *sites;
+    struct kit_memory_profile_pointer *pointers;
+
+    if (!profile_sites) {
+        if (!(sites = mallocx(PROFILE_SITES * sizeof(*sites), MALLOCX_ZERO))
+         || !(pointers = mallocx(PROFILE_POINTERS * sizeof(*pointers), MALLOCX_ZERO))) {
+            if (sites)                      /* COVERAGE EXCLUSION: Out of memory condition */
+                dallocx(sites, 0);          /* COVERAGE EXCLUSION: Out of memory condition */
+
+            errno = ENOMEM;                 /* COVERAGE EXCLUSION: Out of memory condition */
+            return false;                   /* COVERAGE EXCLUSION: Out of memory condition */
+        }
+
+        profile_pointers         = pointers;
+        profile_table.entries    = (char *)pointers;
+        profile_table.entry_size = sizeof(*pointers);
+        profile_table.mask       = PROFILE_POINTERS - 1;
+        profile_sites            = sites;
+    }
+
+    __atomic_store_n(&kit_memory_profile_rate, rate ?: KIT_MEMORY_PROFILE_RATE_DEFAULT, __ATOMIC_RELEASE);
+    kit_memory_profile_countdown = profile_interval();
+    return true;
+}
+
+/**
+ * Stop sampling allocations. Frees of allocations that were already sampled are still accounted for.
+ */
+void
+kit_memory_profile_stop(void)
+{
+    __atomic_store_n(&kit_memory_profile_rate, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Get the estimated allocations and bytes allocated at a call site
+ *
+ * @param file             The file name of the call site
+ * @param line             The line number of the call site
+ * @param live_bytes_out   NULL or a pointer to a variable to store the estimated live (unfreed) bytes allocated there
+ * @param live_allocs_out  NULL or a pointer to a variable to store the estimated number of live allocations there
+ *
+ * @return true if any allocation at the call site has been sampled, false if not
+ */
+bool
+kit_memory_profile_get(const char *file, int line, uint64_t *live_bytes_out, uint64_t *live_allocs_out)
+{
+    unsigned i, idx;
+
+    if (!profile_sites)
+        return false;
+
+    for (i = 0, idx = profile_hash_site(file, line); i < PROFILE_SITES; i++, idx++) {
+        idx &= PROFILE_SITES - 1;
+
+        if (!profile_sites[idx].file)
+            return false;
+
+        if (profile_sites[idx].line == line && strcmp(profile_sites[idx].file, file) == 0) {
+            if (live_bytes_out)
+                *live_bytes_out = (uint64_t)PROFILE_ROUND(__atomic_load_n(&profile_sites[idx].live_bytes, __ATOMIC_RELAXED));
+
+            if (live_allocs_out)
+                *live_allocs_out = (uint64_t)PROFILE_ROUND(__atomic_load_n(&profile_sites[idx].live_allocations,
+                                                                            __ATOMIC_RELAXED));
+
+            return true;
+        }
+    }
+
+    return false;    /* COVERAGE EXCLUSION: Site table is full */
+}
+
+/* Order call sites by decreasing live bytes, then by decreasing total bytes
+ */
+static int
+profile_site_compare(const void *left_void, const void *right_void)
+{
+    const struct kit_memory_profile_site *left  = *(const struct kit_memory_profile_site *const *)left_void;
+    const struct kit_memory_profile_site *right = *(const struct kit_memory_profile_site *const *)right_void;
+
+    if (left->live_bytes != right->live_bytes)
+        return left->live_bytes < right->live_bytes ? 1 : -1;
+
+    return left->bytes < right->bytes ? 1 : left->bytes > right->bytes ? -1 : 0;
+}
+
+/**
+ * Print the call sites with the most live bytes allocated
+ *
+ * @param printer   A printf like function to print each line
+ * @param max_sites The maximum number of call sites to print, or 0 to print them all
+ *
+ * @return true if anything was printed, false if no allocations have been sampled or on error (ENOMEM)
+ *
+ * @note The byte and allocation counts are estimates, scaled up from the samples taken
+ */
+bool
+kit_memory_profile_dump(__printflike(1, 2) int (*printer)(const char *format, ...), unsigned max_sites)
+{
+    const struct kit_memory_profile_site **sorted;
+    unsigned                               count, i;
+
+    if (!profile_sites)
+        return false;
+
+    if (!(sorted = mallocx(PROFILE_SITES * sizeof(*sorted), 0))) {
+        errno = ENOMEM;    /* COVERAGE EXCLUSION: Out of memory condition */
+        return false;      /* COVERAGE EXCLUSION: Out of memory condition */
+    }
+
+    for (count = 0, i = 0; i < PROFILE_SITES; i++)
+        if (__atomic_load_n(&profile_sites[i].line, __ATOMIC_ACQUIRE))
+            sorted[count++] = &profile_sites[i];
+
+    qsort(sorted, count, sizeof(*sorted), profile_site_compare);
+
+    if (count)
+        (*printer)("Sampled memory allocations (mean %zu bytes between samples, %"PRIu64" samples dropped):\n",
+                   kit_memory_profile_rate, __atomic_load_n(&profile_dropped, __ATOMIC_RELAXED));
+
+    for (i = 0; i < count && (max_sites == 0 || i < max_sites); i++)
+        (*printer)("%s:%d live_bytes=%"PRId64" live_allocations=%"PRId64" bytes=%"PRIu64" allocations=%"PRIu64"\n",
+                   sorted[i]->file, sorted[i]->line, PROFILE_ROUND(sorted[i]->live_bytes),
+                   PROFILE_ROUND(sorted[i]->live_allocations), PROFILE_ROUND(sorted[i]->bytes),
+                   PROFILE_ROUND(sorted[i]->allocations));
+
+    dallocx(sorted, 0);
+    return count > 0;
+}
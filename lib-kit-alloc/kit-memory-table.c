@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Lock free tables of pointers, used to remember the allocations sampled by the memory profiler and the sampled overflow guards.
+ * Each table is open addressed and linearly probed, and each of its entries begins with the pointer it's keyed by, which is NULL
+ * if the entry is unused or TABLE_TOMBSTONE if it was removed. A lookup stops at the first unused entry, so a tombstone is turned
+ * back into an unused entry if the entry after it is unused. Otherwise, a table with many removals would fill with tombstones and
+ * looking up a pointer that isn't in it would have to probe every entry.
+ *
+ * While a tombstone is being turned back into an unused entry, it's marked TABLE_RECLAIMING. Lookups step over it, but adds don't
+ * reuse it. An add that passed a tombstone before the entry it took checks afterward that the tombstone wasn't made unused, and
+ * if it was, adds the pointer again, so that every pointer in the table can always be reached from where its probing starts.
+ */
+
+#include "kit-alloc-private.h"
+
+#define TABLE_TOMBSTONE  ((void *)1)    // Marks an entry whose pointer was removed
+#define TABLE_RECLAIMING ((void *)2)    // Marks a tombstone that's being made unused
+
+static inline void **
+table_slot(const struct kit_memory_table *table, unsigned idx)
+{
+    return (void **)(table->entries + (size_t)(idx & table->mask) * table->entry_size);
+}
+
+static unsigned
+table_hash(const void *ptr)
+{
+    return (unsigned)(((uintptr_t)ptr >> 4) * 0x9E3779B97F4A7C15ULL >> 32);    // Allocations are at least 16 byte aligned
+}
+
+/* Turn the tombstone at idx, and any tombstones before it, back into unused entries as long as the entry after each is unused
+ */
+static void
+table_reclaim(struct kit_memory_table *table, unsigned idx)
+{
+    void **slot;
+    void  *found;
+
+    for (;; idx--) {
+        slot  = table_slot(table, idx);
+        found = TABLE_TOMBSTONE;
+
+        if (!__atomic_compare_exchange_n(slot, &found, TABLE_RECLAIMING, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            return;    // Not a tombstone, or it was reused by an add
+
+        if (__atomic_load_n(table_slot(table, idx + 1), __ATOMIC_SEQ_CST)) {    // The next entry is used, so keep the tombstone
+            __atomic_store_n(slot, TABLE_TOMBSTONE, __ATOMIC_SEQ_CST);
+            return;
+        }
+
+        __atomic_store_n(slot, NULL, __ATOMIC_SEQ_CST);
+    }
+}
+
+/**
+ * Add a pointer to a table
+ *
+ * @return The index of the pointer's entry, which the caller may fill in after the pointer, or ~0U if the table is full
+ */
+unsigned
+kit_memory_table_add(struct kit_memory_table *table, void *ptr)
+{
+    void   **slot;
+    void    *found;
+    unsigned home, i, j;
+
+    home = table_hash(ptr);
+
+AGAIN:
+    for (i = 0; i <= table->mask; i++) {
+        slot  = table_slot(table, home + i);
+        found = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+
+        if (found != NULL && found != TABLE_TOMBSTONE)
+            continue;
+
+        if (!__atomic_compare_exchange_n(slot, &found, ptr, false, __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE)) {
+            i--;    // The entry changed; look at it again
+            continue;
+        }
+
+        for (j = 0; j < i; j++) {    // Make sure no entry passed was made unused
+            while ((found = __atomic_load_n(table_slot(table, home + j), __ATOMIC_SEQ_CST)) == TABLE_RECLAIMING)
+                ;    /* COVERAGE EXCLUSION: Another thread is reclaiming a tombstone */
+
+            if (!found) {
+                __atomic_store_n(slot, TABLE_TOMBSTONE, __ATOMIC_SEQ_CST);    /* COVERAGE EXCLUSION: Race with a reclaim */
+                goto AGAIN;                                                   /* COVERAGE EXCLUSION: Race with a reclaim */
+            }
+        }
+
+        return (home + i) & table->mask;
+    }
+
+    return ~0U;    /* COVERAGE EXCLUSION: Table is full */
+}
+
+/**
+ * Find a pointer in a table
+ *
+ * @return The index of the pointer's entry, or ~0U if it isn't in the table
+ */
+unsigned
+kit_memory_table_find(const struct kit_memory_table *table, const void *ptr)
+{
+    void    *found;
+    unsigned home, i;
+
+    for (i = 0, home = table_hash(ptr); i <= table->mask; i++) {
+        if ((found = __atomic_load_n(table_slot(table, home + i), __ATOMIC_ACQUIRE)) == NULL)
+            return ~0U;
+
+        if (found == ptr)
+            return (home + i) & table->mask;
+    }
+
+    return ~0U;    /* COVERAGE EXCLUSION: Table is full of other pointers */
+}
+
+/**
+ * Remove the pointer in an entry of a table, which must have been found by kit_memory_table_find
+ */
+void
+kit_memory_table_remove(struct kit_memory_table *table, unsigned idx)
+{
+    __atomic_store_n(table_slot(table, idx), TABLE_TOMBSTONE, __ATOMIC_SEQ_CST);
+    table_reclaim(table, idx);
+}
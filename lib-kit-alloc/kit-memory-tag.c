@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Allocation tags. When KIT_MEMORY_TAG_ALLOCATIONS is set, each kit allocation has a header recording the tag on top of its
+ * thread's tag stack when it was allocated, so that the bytes allocated under each tag can be accounted for when they're freed,
+ * even by another thread. Reallocated memory keeps its original tag.
+ *
+ * The bytes allocated under a tag are kept in a per thread counter, which is registered as memory.tag.<name> and shown in the
+ * mib text as memory.tag.<name>.bytes and memory.tag.<name>.peak. To track the peak without contending on a shared total for
+ * every allocation, each thread adds the bytes it has accounted to a tag to the tag's total once they reach TAG_BATCH, and when
+ * it exits, so the peak may be underestimated by up to TAG_BATCH bytes per thread.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "kit-alloc-private.h"
+#include "kit-counters.h"
+#include "sxe-log.h"
+
+#define TAG_BATCH (64 * 1024)    // Bytes a thread accounts to a tag before adding them to the tag's total
+
+struct kit_memory_tag {
+    kit_counter_t counter;                              // Counter of the bytes allocated under the tag
+    int64_t       total;                                // Bytes allocated under the tag, less bytes threads haven't yet added
+    int64_t       peak;                                 // Highest total seen
+    char          txt[sizeof("memory.tag.") + 32];      // Name of the counter
+};
+
+static struct kit_memory_tag     memory_tags[KIT_MEMORY_TAGS_MAX];    // Indexed by tag; KIT_MEMORY_TAG_NONE is unused
+static unsigned                  num_tags    = 1;
+static __thread int64_t          tag_pending[KIT_MEMORY_TAGS_MAX];    // Bytes this thread hasn't yet added to each tag's total
+static __thread kit_memory_tag_t tag_stack[KIT_MEMORY_TAG_DEPTH];
+static __thread unsigned         tag_depth   = 0;
+static __thread bool             tag_pending_registered;              // Set once this thread will add its pending bytes on exit
+static pthread_key_t             tag_pending_key;
+
+/* Thread exit destructor that adds the bytes the thread accounted to each tag to the tag's total
+ */
+static void
+tag_pending_add_all(void *unused)
+{
+    unsigned tag;
+
+    SXE_UNUSED_PARAMETER(unused);
+
+    for (tag = 1; tag < num_tags; tag++)
+        if (tag_pending[tag]) {
+            __atomic_add_fetch(&memory_tags[tag].total, tag_pending[tag], __ATOMIC_RELAXED);
+            tag_pending[tag] = 0;
+        }
+
+    tag_pending_registered = false;    // If a later destructor frees tagged memory, register again
+}
+
+/* Raise a tag's peak to at least a total
+ */
+static void
+tag_raise_peak(struct kit_memory_tag *tag, int64_t total)
+{
+    int64_t peak = __atomic_load_n(&tag->peak, __ATOMIC_RELAXED);
+
+    while (total > peak && !__atomic_compare_exchange_n(&tag->peak, &peak, total, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+/* Account for bytes allocated (or freed, if negative) under a tag
+ */
+void
+kit_memory_tag_account(kit_memory_tag_t tag, int64_t bytes)
+{
+    int64_t total;
+
+    if (tag == KIT_MEMORY_TAG_NONE)
+        return;
+
+    kit_counter_add(memory_tags[tag].counter, (unsigned long long)bytes);    // Per thread values wrap, but their sum is correct
+
+    if (!tag_pending_registered) {
+        pthread_setspecific(tag_pending_key, &tag_pending_registered);
+        tag_pending_registered = true;
+    }
+
+    if ((tag_pending[tag] += bytes) < TAG_BATCH && tag_pending[tag] > -TAG_BATCH)
+        return;
+
+    total            = __atomic_add_fetch(&memory_tags[tag].total, tag_pending[tag], __ATOMIC_RELAXED);
+    tag_pending[tag] = 0;
+    tag_raise_peak(&memory_tags[tag], total);
+}
+
+/* Return the tag on top of the current thread's stack
+ */
+kit_memory_tag_t
+kit_memory_tag_current(void)
+{
+    return tag_depth ? tag_stack[tag_depth - 1] : KIT_MEMORY_TAG_NONE;
+}
+
+/* Produce the mib text for a tag: <name>.bytes and, for the total of all threads, <name>.peak
+ */
+static void
+tag_mibfn(kit_counter_t c, const char *subtree, const char *mib, void *v, kit_counters_mib_callback_t cb, int threadnum,
+          unsigned cflags)
+{
+    char     buf[32], submib[256];
+    unsigned tag;
+
+    SXE_UNUSED_PARAMETER(cflags);
+
+    for (tag = 1; tag < num_tags && memory_tags[tag].counter != c; tag++)
+        ;
+
+    snprintf(submib, sizeof(submib), "%s.bytes", mib);
+
+    if (kit_mibintree(subtree, submib)) {
+        snprintf(buf, sizeof(buf), "%llu", kit_counter_get_data(c, threadnum));
+        cb(v, submib, buf);
+    }
+
+    snprintf(submib, sizeof(submib), "%s.peak", mib);
+
+    if (threadnum == KIT_THREAD_TOTAL && tag < num_tags && kit_mibintree(subtree, submib)) {
+        snprintf(buf, sizeof(buf), "%" PRIu64, kit_memory_tag_peak(tag));
+        cb(v, submib, buf);
+    }
+}
+
+/**
+ * Register an allocation tag
+ *
+ * @param name Name of the tag (e.g. sxe-cdb); its bytes are shown in the mib text as memory.tag.<name>.bytes and .peak
+ *
+ * @return The tag, which can't be unregistered
+ *
+ * @note Tags are registered like counters, so not concurrently with other registrations or kit_counters_mib_text
+ */
+kit_memory_tag_t
+kit_memory_tag_reg(const char *name)
+{
+    struct kit_memory_tag *tag;
+
+    SXEA1(num_tags < KIT_MEMORY_TAGS_MAX, "Can't register more than %u allocation tags", KIT_MEMORY_TAGS_MAX - 1);
+
+    if (num_tags == 1)
+        SXEA1(pthread_key_create(&tag_pending_key, tag_pending_add_all) == 0, "Failed to create a thread key");
+
+    tag = &memory_tags[num_tags];
+    SXEA1((size_t)snprintf(tag->txt, sizeof(tag->txt), "memory.tag.%s", name) < sizeof(tag->txt),
+          "Allocation tag name '%s' is too long", name);
+    tag->counter = kit_counter_reg_with_mibfn(tag->txt, tag_mibfn);
+    return num_tags++;
+}
+
+/**
+ * Push a tag on the current thread's tag stack, so that kit allocations made by the thread are accounted for under it
+ *
+ * @note Allocations are only accounted for by tag if KIT_MEMORY_TAG_ALLOCATIONS is set. Pop the tag with kit_memory_tag_pop.
+ */
+void
+kit_memory_tag_push(kit_memory_tag_t tag)
+{
+    SXEA1(tag < num_tags,                   "Allocation tag %u is not registered", tag);
+    SXEA1(tag_depth < KIT_MEMORY_TAG_DEPTH, "Can't push more than %u allocation tags", KIT_MEMORY_TAG_DEPTH);
+    tag_stack[tag_depth++] = tag;
+}
+
+/**
+ * Pop the tag pushed most recently on the current thread's tag stack
+ */
+void
+kit_memory_tag_pop(void)
+{
+    SXEA1(tag_depth, "No allocation tag has been pushed");
+    tag_depth--;
+}
+
+/**
+ * Get the bytes currently allocated under a tag by all threads, including kit's overhead
+ */
+uint64_t
+kit_memory_tag_bytes(kit_memory_tag_t tag)
+{
+    return tag < num_tags && tag != KIT_MEMORY_TAG_NONE ? kit_counter_get(memory_tags[tag].counter) : 0;
+}
+
+/**
+ * Get the most bytes allocated under a tag at any time
+ *
+ * @note The peak may be underestimated by up to 64KB for each thread that allocated under the tag
+ */
+uint64_t
+kit_memory_tag_peak(kit_memory_tag_t tag)
+{
+    if (tag >= num_tags || tag == KIT_MEMORY_TAG_NONE)
+        return 0;
+
+    tag_raise_peak(&memory_tags[tag], (int64_t)kit_memory_tag_bytes(tag));    // The current bytes are exact
+    return (uint64_t)__atomic_load_n(&memory_tags[tag].peak, __ATOMIC_RELAXED);
+}
+
+/**
+ * Allocate memory under a tag, as if the tag was pushed for the allocation
+ */
+__attribute__((malloc)) void *
+kit_malloc_tagged_diag(kit_memory_tag_t tag, size_t size, const char *file, int line)
+{
+    void *result;
+
+    kit_memory_tag_push(tag);
+    result = kit_malloc_diag(size, file, line);
+    kit_memory_tag_pop();
+    return result;
+}
@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Slabs of small fixed size objects with per thread caches. Each thread allocates from and frees to its own list of free objects,
+ * so the fast paths take no locks and make no calls to jemalloc. Objects are carved out of chunks allocated by jemalloc, and
+ * are moved between the thread caches and a list shared by all threads in batches when a thread runs out of free objects or
+ * accumulates too many, and when a thread exits, the objects in its caches are returned to the shared lists. Memory is only
+ * returned to jemalloc when the slab is freed.
+ *
+ * Each slab has an id, which is reused after the slab is deleted, and a generation, which isn't. A thread cache is only used for
+ * the slab whose generation it was filled for, so that objects of a deleted slab still cached by other threads are forgotten.
+ *
+ * Allocations and frees are counted in the kit memory counters, so leak checks using kit_memory_allocations work, and objects
+ * are surrounded by guards if KIT_MEMORY_CHECK_OVERFLOWS is set.
+ */
+
+#include <errno.h>
+#include <jemalloc/jemalloc.h>
+#include <pthread.h>
+
+#include "kit-alloc-private.h"
+#include "kit-mockfail.h"
+#include "kit-slab.h"
+
+#define KIT_SLAB_CHUNK_SIZE (64 * 1024)    // Size of each chunk of objects allocated from jemalloc
+#define KIT_SLAB_BATCH      32             // Number of objects moved between a thread's cache and the shared list at a time
+
+struct kit_slab_chunk {
+    struct kit_slab_chunk *next;
+    size_t                 pad;    // Keep objects 16 byte aligned
+};
+
+struct kit_slab {
+    size_t                 size;          // Size of the objects
+    size_t                 slot;          // Size of the memory used for each object, including any guards
+    unsigned               id;            // Index of the slab's cache in each thread's array of caches
+    unsigned               generation;    // Distinguishes the slab from earlier slabs that had the same id
+    unsigned               free_count;    // Number of objects in the shared free list
+    void                  *free;          // Shared list of free objects
+    struct kit_slab_chunk *chunks;        // Chunks of memory allocated for the slab
+    pthread_mutex_t        lock;          // Protects the shared free list and chunk list
+};
+
+struct kit_slab_cache {
+    void    *free;          // List of free objects, linked through their first word
+    unsigned count;         // Number of objects in the list
+    unsigned generation;    // Generation of the slab the objects belong to, or 0 if the cache hasn't been used
+};
+
+static __thread struct kit_slab_cache kit_slab_caches[KIT_SLAB_MAX];
+static struct kit_slab               *kit_slab_slabs[KIT_SLAB_MAX];                       // Live slabs, indexed by id
+static unsigned                       kit_slab_generation = 0;                            // Generation of the last slab created
+static pthread_mutex_t                kit_slab_lock       = PTHREAD_MUTEX_INITIALIZER;    // Protects the above
+static pthread_key_t                  kit_slab_key;                                       // Returns a thread's caches on exit
+static pthread_once_t                 kit_slab_once       = PTHREAD_ONCE_INIT;
+
+/* Thread exit destructor that returns the objects in the thread's caches to the shared lists of the slabs that are still live
+ */
+static void
+kit_slab_thread_exit(void *caches)
+{
+    struct kit_slab_cache *cache;
+    struct kit_slab       *slab;
+    void                  *last;
+    unsigned               id;
+
+    pthread_mutex_lock(&kit_slab_lock);    // Keeps the slabs from being deleted
+
+    for (id = 0; id < KIT_SLAB_MAX; id++) {
+        cache = &((struct kit_slab_cache *)caches)[id];
+
+        if (cache->free && (slab = kit_slab_slabs[id]) && slab->generation == cache->generation) {
+            for (last = cache->free; *(void **)last; last = *(void **)last) {
+            }
+
+            pthread_mutex_lock(&slab->lock);
+            *(void **)last    = slab->free;
+            slab->free        = cache->free;
+            slab->free_count += cache->count;
+            pthread_mutex_unlock(&slab->lock);
+        }
+
+        cache->free       = NULL;
+        cache->count      = 0;
+        cache->generation = 0;
+    }
+
+    pthread_mutex_unlock(&kit_slab_lock);
+}
+
+static void
+kit_slab_create_key(void)
+{
+    SXEA1(pthread_key_create(&kit_slab_key, kit_slab_thread_exit) == 0, "Failed to create the slab thread key");
+}
+
+/* Get the calling thread's cache for a slab, emptying it first if it was last used for a deleted slab that had the same id
+ */
+static inline struct kit_slab_cache *
+kit_slab_get_cache(const struct kit_slab *slab)
+{
+    struct kit_slab_cache *cache = &kit_slab_caches[slab->id];
+
+    if (cache->generation != slab->generation) {
+        cache->free       = NULL;    // Any objects cached belong to a deleted slab, whose memory has been freed
+        cache->count      = 0;
+        cache->generation = slab->generation;
+        SXEA1(pthread_setspecific(kit_slab_key, kit_slab_caches) == 0, "Failed to set the slab thread key");
+    }
+
+    return cache;
+}
+
+/**
+ * Create a slab of fixed size objects
+ *
+ * @param size The size of each object, which must be no more than 1/16th of the chunk size (4096 bytes)
+ *
+ * @return The slab or NULL on failure (ENOMEM if out of memory or ENOSPC if KIT_SLAB_MAX slabs already exist)
+ *
+ * @note Objects are aligned on 16 bytes if size is a multiple of 16, or on 8 bytes otherwise. Slabs must be created after
+ *       kit_memory_initialize, since the space needed for each object depends on whether KIT_MEMORY_CHECK_OVERFLOWS is set.
+ */
+struct kit_slab *
+kit_slab_create(size_t size)
+{
+    struct kit_slab *slab;
+    size_t           align = size % 16 == 0 ? 16 : 8;
+    unsigned         id;
+
+    SXEA1(size && size <= KIT_SLAB_CHUNK_SIZE / 16, "Slab object size %zu is not between 1 and %u", size,
+          KIT_SLAB_CHUNK_SIZE / 16);
+    pthread_once(&kit_slab_once, kit_slab_create_key);
+
+    if (!(slab = kit_malloc(sizeof(*slab))))
+        return NULL;
+
+    pthread_mutex_lock(&kit_slab_lock);
+
+    for (id = 0; id < KIT_SLAB_MAX && kit_slab_slabs[id]; id++) {
+    }
+
+    if (id == KIT_SLAB_MAX) {
+        pthread_mutex_unlock(&kit_slab_lock);
+        kit_free(slab);
+        SXEL2(": Can't create more than %u slabs", KIT_SLAB_MAX);
+        errno = ENOSPC;
+        return NULL;
+    }
+
+    slab->size         = size;
+    slab->slot         = (kit_memory_size((size + align - 1) & ~(align - 1), 0) + align - 1) & ~(align - 1);
+    slab->id           = id;
+    slab->generation   = ++kit_slab_generation;
+    slab->free_count   = 0;
+    slab->free         = NULL;
+    slab->chunks       = NULL;
+    pthread_mutex_init(&slab->lock, NULL);
+    kit_slab_slabs[id] = slab;
+    pthread_mutex_unlock(&kit_slab_lock);
+    return slab;
+}
+
+/**
+ * Free a slab and all of the memory allocated for its objects
+ *
+ * @note All objects allocated from the slab must have been freed, and the slab must not be used by any thread afterward. Its id
+ *       may be reused by a slab created later.
+ */
+void
+kit_slab_delete(struct kit_slab *slab)
+{
+    struct kit_slab_chunk *chunk, *next;
+
+    if (!slab)
+        return;
+
+    pthread_mutex_lock(&kit_slab_lock);    // Once the slab is forgotten, exiting threads won't return objects to it
+    kit_slab_slabs[slab->id] = NULL;
+    pthread_mutex_unlock(&kit_slab_lock);
+
+    for (chunk = slab->chunks; chunk; chunk = next) {
+        next = chunk->next;
+        dallocx(chunk, 0);
+    }
+
+    pthread_mutex_destroy(&slab->lock);    // Threads' cached objects are forgotten when the id is next used
+    kit_free(slab);
+}
+
+/* Refill an empty thread cache from the shared list or, if it's empty, a new chunk
+ */
+static bool
+kit_slab_refill(struct kit_slab *slab, struct kit_slab_cache *cache)
+{
+    struct kit_slab_chunk *chunk;
+    char                  *object, *end;
+    void                  *last;
+
+    pthread_mutex_lock(&slab->lock);
+
+    if (slab->free) {    // Take up to a batch of objects from the shared list
+        for (cache->free = last = slab->free, cache->count = 1; cache->count < KIT_SLAB_BATCH && *(void **)last; cache->count++)
+            last = *(void **)last;
+
+        slab->free        = *(void **)last;
+        slab->free_count -= cache->count;
+        *(void **)last    = NULL;
+        pthread_mutex_unlock(&slab->lock);
+        return true;
+    }
+
+    if (!(chunk = MOCKERROR(kit_slab_alloc, NULL, ENOMEM, mallocx(KIT_SLAB_CHUNK_SIZE, 0)))) {
+        pthread_mutex_unlock(&slab->lock);
+        return false;
+    }
+
+    chunk->next  = slab->chunks;
+    slab->chunks = chunk;
+    pthread_mutex_unlock(&slab->lock);
+
+    /* Carve the chunk into objects, linking them in address order
+     */
+    end = (char *)chunk + KIT_SLAB_CHUNK_SIZE - slab->slot;
+
+    for (object = (char *)(chunk + 1), cache->count = 0; object <= end; object += slab->slot, cache->count++)
+        *(void **)object = object + slab->slot <= end ? object + slab->slot : NULL;
+
+    cache->free = chunk + 1;
+    return true;
+}
+
+/**
+ * Allocate an object from a slab
+ *
+ * @return The object, or NULL on failure to allocate memory (ENOMEM)
+ */
+void *
+kit_slab_alloc(struct kit_slab *slab)
+{
+    struct kit_slab_cache *cache = kit_slab_get_cache(slab);
+    char                  *object;
+
+    if (!(object = cache->free)) {
+        if (!kit_slab_refill(slab, cache)) {
+            kit_memory_count_alloc(true, slab->size);
+            return NULL;
+        }
+
+        object = cache->free;
+    }
+
+    cache->free = *(void **)object;
+    cache->count--;
+    kit_memory_count_alloc(false, slab->size);
+    kit_memory_guard_initialize(&object, slab->slot, 0);
+    return object;
+}
+
+/**
+ * Free an object allocated from a slab
+ *
+ * @note Objects can be freed by a different thread than the one that allocated them
+ */
+void
+kit_slab_free(struct kit_slab *slab, void *object)
+{
+    struct kit_slab_cache *cache;
+    void                  *last;
+    unsigned               i;
+
+    if (!object)
+        return;
+
+    kit_memory_count_free();
+    object           = kit_memory_check(object, KIT_MEMORY_FREE);    // Get back the start of the object's slot if guarded
+    cache            = kit_slab_get_cache(slab);
+    *(void **)object = cache->free;
+    cache->free      = object;
+
+    if (++cache->count < 2 * KIT_SLAB_BATCH)
+        return;
+
+    /* The thread has too many free objects, so move a batch of them to the shared list
+     */
+    for (last = object, i = 1; i < KIT_SLAB_BATCH; i++)
+        last = *(void **)last;
+
+    cache->free   = *(void **)last;
+    cache->count -= KIT_SLAB_BATCH;
+    pthread_mutex_lock(&slab->lock);
+    *(void **)last    = slab->free;
+    slab->free        = object;
+    slab->free_count += KIT_SLAB_BATCH;
+    pthread_mutex_unlock(&slab->lock);
+}
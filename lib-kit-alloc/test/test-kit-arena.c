@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <tap.h>
+
+#include "kit-alloc.h"
+#include "kit-arena.h"
+#include "kit-mockfail.h"
+
+int
+main(void)
+{
+    struct kit_arena      *arena;
+    struct kit_arena_mark  mark;
+    char                  *first, *second, *big, *string;
+    uint64_t               start_allocations;
+    unsigned               i;
+
+    plan_tests(22);
+    kit_memory_initialize(KIT_MEMORY_CHECK_OVERFLOWS);
+    start_allocations = kit_memory_allocations();
+
+    ok(arena = kit_arena_new(1024),                     "Created an arena with 1KB blocks");
+    ok(first = kit_arena_alloc(arena, 5),               "Allocated 5 bytes");
+    ok(second = kit_arena_alloc(arena, 8),              "Allocated 8 more bytes");
+    is(second - first, 16,                              "They're 16 bytes apart");
+    is((uintptr_t)second % 16, 0,                       "The second is aligned like malloc");
+    ok(first = kit_arena_memalign(arena, 1, 3),         "Allocated 3 unaligned bytes");
+    is(first - second, 8,                               "They immediately follow the 8 bytes");
+    ok(second = kit_arena_memalign(arena, 256, 1),      "Allocated 1 byte aligned on 256 bytes");
+    is((uintptr_t)second % 256, 0,                      "It's aligned");
+    is(kit_memory_allocations(), start_allocations + 2, "The arena and its first block are allocated");
+
+    kit_arena_mark(arena, &mark);
+    ok(big = kit_arena_alloc(arena, 4096),              "Allocated more than a block");
+    memset(big, 0, 4096);
+    ok(string = kit_arena_strdup(arena, "hello"),       "Duplicated a string");
+    is_eq(string, "hello",                              "It's a copy");
+    is(kit_memory_allocations(), start_allocations + 4, "Another 2 blocks are allocated");
+    kit_arena_reset(arena, &mark);
+    is(kit_memory_allocations(), start_allocations + 2, "Resetting to the mark freed the blocks allocated after it");
+    is(kit_arena_memalign(arena, 1, 1), second + 1,     "The next byte is allocated right after the mark");
+
+    for (i = 0; i < 100; i++)
+        kit_arena_alloc(arena, 100);
+
+    kit_arena_reset(arena, NULL);
+    is(kit_memory_allocations(), start_allocations + 2, "Resetting to empty kept one block");
+
+    MOCKFAIL_START_TESTS(2, kit_arena_memalign);
+    errno = 0;
+    ok(!kit_arena_alloc(arena, 2048), "Failed to allocate when a new block can't be allocated");
+    is(errno, ENOMEM,                 "Got the expected error");
+    MOCKFAIL_END_TESTS();
+
+    errno = 0;
+    ok(!kit_arena_alloc(arena, SIZE_MAX) && errno == ENOMEM,             "Failed to allocate SIZE_MAX bytes (ENOMEM)");
+    errno = 0;
+    ok(!kit_arena_memalign(arena, 64, SIZE_MAX - 32) && errno == ENOMEM, "Failed to allocate almost SIZE_MAX aligned bytes");
+
+    kit_arena_free(arena);
+    kit_arena_free(NULL);
+    is(kit_memory_allocations(), start_allocations, "No memory was leaked");
+    return exit_status();
+}
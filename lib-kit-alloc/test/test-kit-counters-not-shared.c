@@ -21,6 +21,7 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <stdio.h>
 #include <sxe-log.h>
 #include <tap.h>
 #include <pthread.h>
@@ -29,8 +30,11 @@
 #include "kit-counters.h"
 #include "kit-mockfail.h"
 
+#define MANY_COUNTERS 1000    // More than KIT_COUNTERS_DEFAULT
+
 kit_counter_t KIT_EARLY;
 kit_counter_t KIT_COUNT;
+kit_counter_t many_counters[MANY_COUNTERS];
 
 static void
 static_thread_cleanup(void *v)
@@ -59,6 +63,19 @@ static_thread(void *v)
     return NULL;
 }
 
+static void *
+many_counters_thread(void *v)
+{
+    SXE_UNUSED_PARAMETER(v);
+    kit_counters_init_thread(1);
+
+    for (unsigned i = 0; i < MANY_COUNTERS; i++)
+        kit_counter_add(many_counters[i], i);
+
+    kit_counters_fini_thread(1);
+    return NULL;
+}
+
 static void
 dynamic_thread_cleanup(void *v)
 {
@@ -87,6 +104,18 @@ dynamic_thread(void *v)
     return NULL;
 }
 
+static void *
+auto_thread(void *v)
+{
+    void *mem;
+
+    SXE_UNUSED_PARAMETER(v);
+    kit_counter_add(KIT_COUNT, 100);
+    mem = kit_malloc(64);
+    kit_free(mem);
+    return (void *)(uintptr_t)kit_counters_usable();
+}
+
 int
 main(void)
 {
@@ -94,7 +123,7 @@ main(void)
     void     *ret;
     size_t    size;
 
-    plan_tests(10);
+    plan_tests(23);
 
     KIT_EARLY = kit_counter_reg("kit.early");
     kit_counter_incr(KIT_EARLY);
@@ -135,5 +164,63 @@ main(void)
         kit_free(ret);
     }
 
+    diag("Test registering more than the default number of counters after initialization");
+    {
+        static const char *group[] = {"kit.group.a", "kit.group.b", "kit.group.c", "kit.group.d", "kit.group.e"};
+        static char        names[MANY_COUNTERS][32];
+        struct kit_counters *totals;
+        kit_counter_t        first;
+        unsigned             i, wrong;
+
+        for (i = 0; i < MANY_COUNTERS; i++) {
+            snprintf(names[i], sizeof(names[i]), "kit.many.%u", i);
+            many_counters[i] = kit_counter_reg(names[i]);
+        }
+
+        ok(kit_counter_isvalid(many_counters[MANY_COUNTERS - 1]), "Registered %u more counters", MANY_COUNTERS);
+        kit_counter_add(many_counters[MANY_COUNTERS - 1], 1);
+
+        if (ok(pthread_create(&thr, NULL, many_counters_thread, NULL) == 0, "Created a thread that uses the new counters"))
+            pthread_join(thr, &ret);
+
+        for (wrong = 0, i = 0; i < MANY_COUNTERS; i++)
+            wrong += kit_counter_get(many_counters[i]) != i + (i == MANY_COUNTERS - 1);
+
+        is(wrong, 0, "All of the new counters have the expected totals");
+
+        first = kit_counter_reg_group(group, 5);
+        ok(first % 8 + 5 <= 8,                           "A group of 5 counters fits in one cache line");
+        is_eq(kit_counter_txt(first + 4), "kit.group.e", "The counters in the group are contiguous");
+        ok(first - 1 == many_counters[MANY_COUNTERS - 1] || !kit_counter_isvalid(first - 1),
+           "Any counters skipped to align the group are not valid");
+
+        kit_counter_add(first + 2, 3);
+        totals = kit_counters_new();
+        kit_counters_combine(totals, -1);
+        is(totals->val[first + 2], 3, "Combining sums the group's counters");
+        kit_counters_free(totals);
+    }
+
+    diag("Test automatically giving unmanaged threads their own counters");
+    {
+        unsigned long long allocs;
+
+        kit_counters_set_auto_threads(true);
+        allocs = kit_counter_get(KIT_COUNTER_MEMORY_MALLOC);
+
+        if (ok(pthread_create(&thr, NULL, auto_thread, NULL) == 0, "Created an unmanaged thread"))
+            pthread_join(thr, &ret);
+
+        ok(ret,                                                 "The unmanaged thread's counters were usable");
+        is(kit_counter_get(KIT_COUNT), 109,                     "Its count was kept when it exited");
+        ok(kit_counter_get(KIT_COUNTER_MEMORY_MALLOC) > allocs, "Its allocations were counted");
+
+        if (ok(pthread_create(&thr, NULL, auto_thread, NULL) == 0, "Created another unmanaged thread, reusing the slot"))
+            pthread_join(thr, &ret);
+
+        is(kit_counter_get(KIT_COUNT), 209, "Its count was also kept");
+        kit_counters_set_auto_threads(false);
+    }
+
     return exit_status();
 }
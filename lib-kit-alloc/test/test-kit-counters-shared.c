@@ -21,9 +21,11 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <limits.h>
 #include <pthread.h>
 #include <string.h>
 #include <tap.h>
+#include <unistd.h>
 
 #include "kit-alloc.h"
 #include "kit-counters.h"
@@ -230,6 +232,41 @@ unmanaged_thread(void *v)
     return NULL;
 }
 
+#define ADDERS 4
+#define ADDS   10000
+
+static kit_counter_t added;    // Counter modified concurrently by unmanaged threads
+
+static void *
+adder_thread(void *v)
+{
+    unsigned i;
+
+    SXE_UNUSED_PARAMETER(v);
+
+    for (i = 0; i < ADDS; i++)
+        kit_counter_incr(added);
+
+    return NULL;
+}
+
+/* Have several unmanaged threads increment the shared counter 'added' at once, returning true if they were all created
+ */
+static bool
+run_adders(void)
+{
+    pthread_t thrs[ADDERS];
+    unsigned  i, n;
+
+    for (n = 0; n < ADDERS && pthread_create(&thrs[n], NULL, adder_thread, NULL) == 0; n++) {
+    }
+
+    for (i = 0; i < n; i++)
+        pthread_join(thrs[i], NULL);
+
+    return n == ADDERS;
+}
+
 int
 main(void)
 {
@@ -239,7 +276,7 @@ main(void)
     void *thread_retval;
     unsigned i;
 
-    plan_tests(157);
+    plan_tests(174);
 
     /* Initialize counters before memory. test-kit-alloc tests the opposite order
      */
@@ -423,6 +460,44 @@ main(void)
         is(kit_counter_get_data(my.c3, KIT_THREAD_SHARED), 0, "Shared counter was 0");
     }
 
+    diag("Test snapshots, deltas, and getting the text of changed counters");
+    {
+        struct kit_counters_snapshot *prev, *cur;
+        struct kit_counters_delta    *delta;
+        double                        rate;
+
+        my_handler_value = 12345;
+        prev             = kit_counters_snapshot();
+        kit_counter_add(my.c2, 7);
+        my_handler_value = 12346;
+        usleep(10000);
+        cur = kit_counters_snapshot();
+        ok(cur->nsec >= prev->nsec + 10000000,                          "The second snapshot was taken at least 10ms later");
+        is(cur->totals->val[my.c2], kit_counter_get(my.c2),             "The snapshot has the value of hello.city");
+        is(cur->totals->val[my.c1], 12346,                              "The snapshot has the handler's value of hello.world");
+
+        delta = kit_counters_delta(prev, cur);
+        ok(delta->seconds >= 0.01,                                      "The delta is over at least 10ms");
+        is(delta->val[my.c2], 7,                                        "hello.city went up by 7");
+        is(delta->val[my.c1], 1,                                        "hello.world went up by 1");
+        is(delta->val[my.c3], 0,                                        "hi.there didn't change");
+        rate = kit_counters_delta_rate(delta, my.c2);
+        ok(rate > 0.0 && rate <= 700.0,                                 "hello.city's rate is %f per second", rate);
+        ok(kit_counters_delta_rate(delta, delta->size) == 0.0,          "The rate of a counter not in the delta is 0");
+        kit_counters_delta_free(delta);
+
+        memset(&cg, 0xff, sizeof(cg));    // ULONG_MAX means not called back
+        kit_counters_mib_text_changed("", &cg, counter_callback, prev, cur, 0);
+        ok(cg.hello_city == cur->totals->val[my.c2] && cg.hello_world == 12346, "Got the text of the changed counters");
+        ok(cg.hi_there == ULONG_MAX && cg.this_path_has_a_value == ULONG_MAX,   "Didn't get the text of unchanged counters");
+
+        cg.hi_there = ULONG_MAX;
+        kit_counters_mib_text_changed("hi", &cg, counter_callback, NULL, cur, 0);
+        is(cg.hi_there, cur->totals->val[my.c3],                        "With no previous snapshot, every counter is included");
+        kit_counters_snapshot_free(prev);
+        kit_counters_snapshot_free(cur);
+    }
+
     diag("Test out of range counters");
     {
         unsigned non_existent_counter = kit_num_counters() + 1;
@@ -440,5 +515,17 @@ main(void)
     ok(kit_counters_usable(),                             "Counters are usable in the main thread");
     is(kit_num_counters(),                            10, "Number of counters is as expected (4 + 6 memory counters)");
     is(kit_counter_get_data(KIT_COUNTERS_INVALID, -1), 0, "The invalid counter has not been touched");
+
+    diag("Test unmanaged threads modifying shared counters at once, before and after the shared counters must grow");
+    {
+        added = my.c2;
+        ok(run_adders(),                                                         "Ran %u unmanaged threads", ADDERS);
+        is(kit_counter_get_data(added, KIT_THREAD_SHARED), ADDERS * ADDS,       "None of their increments were lost");
+        added = kit_counter_reg_range("shared.range", NULL, 256) + 255;         // Past the end of the shared counters
+        ok(run_adders(),                                                         "Ran %u more unmanaged threads", ADDERS);
+        is(kit_counter_get_data(added, KIT_THREAD_SHARED), ADDERS * ADDS,       "None of their increments were lost");
+        is(kit_counter_get_data(my.c2, KIT_THREAD_SHARED), ADDERS * ADDS,       "The earlier counts are still there");
+    }
+
     return exit_status();
 }
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <tap.h>
+#include <unistd.h>
+
+#include "kit-alloc.h"
+#include "kit-counters.h"
+
+#define SHM_SIZE (1024 * 1024)
+
+static kit_counter_t early;
+static kit_counter_t requests;
+static char          shm_name[64];
+
+/* Read a counter from the segment the way an external reader would, summing it over all live blocks
+ */
+static unsigned long long
+shm_counter(const char *name)
+{
+    const struct kit_counters_shm_header *header;
+    const struct kit_counters_shm_block  *block;
+    const struct kit_counters_shm_name   *record;
+    const struct kit_counters            *counters;
+    unsigned long long                    sum = 0;
+    uint64_t                              offset;
+    int                                   fd;
+
+    fd     = shm_open(shm_name, O_RDONLY, 0);
+    header = mmap(NULL, SHM_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    for (offset = header->names; offset; offset = record->next) {
+        record = (const struct kit_counters_shm_name *)((const char *)header + offset);
+
+        if (strcmp(record->name, name) == 0)
+            break;
+    }
+
+    if (!offset)
+        sum = ~0ULL;    // Not found
+    else
+        for (offset = header->blocks; offset; offset = block->next) {
+            block    = (const struct kit_counters_shm_block *)((const char *)header + offset);
+            counters = (const struct kit_counters *)((const char *)block + KIT_COUNTERS_CACHE_LINE);
+
+            if (block->live && record->counter < counters->size)
+                sum += counters->val[record->counter];
+        }
+
+    munmap((void *)(uintptr_t)header, SHM_SIZE);
+    return sum;
+}
+
+static void *
+request_thread(void *v)
+{
+    SXE_UNUSED_PARAMETER(v);
+    kit_counters_init_thread(1);
+    kit_counter_add(requests, 5);
+    kit_counters_fini_thread(1);
+    return NULL;
+}
+
+int
+main(void)
+{
+    const struct kit_counters_shm_header *header;
+    pthread_t                             thr;
+    kit_counter_t                         many[700];
+    unsigned                              i;
+    int                                   fd;
+
+    plan_tests(11);
+    snprintf(shm_name, sizeof(shm_name), "/test-kit-counters-shm-%d", getpid());
+    early = kit_counter_reg("test.early");
+    ok(kit_counters_export_shm(shm_name, SHM_SIZE), "Exported counters in %s", shm_name);
+    kit_counters_initialize(KIT_COUNTERS_DEFAULT, 2, false);
+    requests = kit_counter_reg("test.requests");
+
+    ok((fd = shm_open(shm_name, O_RDONLY, 0)) >= 0, "Opened the segment");
+    header = mmap(NULL, SHM_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    ok(memcmp(header->magic, KIT_COUNTERS_SHM_MAGIC, sizeof(header->magic)) == 0, "The segment has the magic number");
+    is(header->version, KIT_COUNTERS_SHM_VERSION,                                   "It has the current version");
+    is(header->pid, (uint32_t)getpid(),                                             "It has the exporting process's pid");
+    munmap((void *)(uintptr_t)header, SHM_SIZE);
+
+    kit_counter_add(early, 2);
+    kit_counter_incr(requests);
+    is(shm_counter("test.early"), 2,    "A counter registered before export is read from the segment");
+    is(shm_counter("test.requests"), 1, "A counter registered after initialization is read from the segment");
+
+    pthread_create(&thr, NULL, request_thread, NULL);
+    pthread_join(thr, NULL);
+    is(shm_counter("test.requests"), 6, "Counts from a thread that has exited are read from the segment");
+    ok(shm_counter("memory.malloc") > 0, "Memory counters are exported");
+
+    for (i = 0; i < 700; i++)
+        many[i] = kit_counter_reg("test.many");    // Names need not be unique
+
+    kit_counter_incr(many[699]);    // This grows the main thread's block, which replaces it in the segment
+    is(shm_counter("test.requests"), 6, "After the main thread's block grew, the counts are still correct");
+
+    kit_counters_shm_unlink();
+    ok(shm_open(shm_name, O_RDONLY, 0) < 0, "The segment was unlinked");
+    return exit_status();
+}
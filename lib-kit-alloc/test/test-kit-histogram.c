@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tap.h>
+
+#include "kit-alloc.h"
+#include "kit-counters.h"
+
+static struct kit_histogram *latency;
+static char                  output[4096];
+
+static void
+gather(void *v, const char *mib, const char *value)
+{
+    SXE_UNUSED_PARAMETER(v);
+    snprintf(&output[strlen(output)], sizeof(output) - strlen(output), "%s=%s\n", mib, value);
+}
+
+static void *
+record_thread(void *v)
+{
+    SXE_UNUSED_PARAMETER(v);
+    kit_counters_init_thread(1);
+
+    for (unsigned i = 501; i <= 1000; i++)
+        kit_histogram_record(latency, i);
+
+    kit_counters_fini_thread(1);
+    return NULL;
+}
+
+int
+main(void)
+{
+    pthread_t thr;
+    uint64_t  value;
+    unsigned  i;
+
+    plan_tests(13);
+    kit_counters_initialize(KIT_COUNTERS_DEFAULT, 2, false);
+    ok(latency = kit_histogram_reg("test.latency", 1000000), "Registered a histogram");
+    is(kit_histogram_get_percentile(latency, 500, KIT_THREAD_TOTAL), 0, "The median of an empty histogram is 0");
+
+    for (i = 1; i <= 500; i++)
+        kit_histogram_record(latency, i);
+
+    pthread_create(&thr, NULL, record_thread, NULL);
+    pthread_join(thr, NULL);
+
+    value = kit_histogram_get_percentile(latency, 500, KIT_THREAD_TOTAL);
+    ok(value >= 500 && value <= 500 * 9 / 8,  "The median of 1 to 1000 is close to 500 (%" PRIu64 ")", value);
+    value = kit_histogram_get_percentile(latency, 990, KIT_THREAD_TOTAL);
+    ok(value >= 990 && value <= 990 * 9 / 8,  "p99 of 1 to 1000 is close to 990 (%" PRIu64 ")", value);
+    is(kit_histogram_get_percentile(latency, 0, KIT_THREAD_TOTAL), 1, "p0 is the smallest value");
+    value = kit_histogram_get_percentile(latency, 500, 0);
+    ok(value >= 250 && value <= 250 * 9 / 8,  "The median of the main thread's values is close to 250 (%" PRIu64 ")", value);
+
+    kit_histogram_record(latency, 5);
+    kit_histogram_record(latency, 1ULL << 40);    // Too big, so counted in the last bucket
+    kit_counters_mib_text("test.latency", NULL, gather, KIT_THREAD_TOTAL, 0);
+    ok(strstr(output, "test.latency.count=1002\n"),       "Got the count");
+    ok(strstr(output, "test.latency.p50="),               "Got p50");
+    ok(strstr(output, "test.latency.p90="),               "Got p90");
+    ok(strstr(output, "test.latency.p99="),               "Got p99");
+    ok(strstr(output, "test.latency.p999="),              "Got p999");
+    ok(strstr(output, "test.latency.bucket.5=2\n"),       "Got the count of the bucket holding only 5");
+    ok(!strstr(output, "test.latency.bucket.0="),         "Empty buckets are not shown");
+    return exit_status();
+}
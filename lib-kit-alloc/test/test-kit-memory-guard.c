@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <signal.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <tap.h>
+#include <unistd.h>
+
+#include "kit-alloc.h"
+#include "kit-mockfail.h"
+
+#define BLOCKS      8
+#define BLOCK_SIZE  100
+#define RATE        4
+#define GUARD_PAGES 1100    // More than the maximum number of live allocations followed by inaccessible pages
+
+/* Run a function that overflows memory in a child process, returning the signal that killed the child or 0 if it exited
+ */
+static int
+overflow_in_child(void (*overflow)(void))
+{
+    int status;
+
+    if (fork() == 0) {
+        overflow();
+        _exit(0);
+    }
+
+    wait(&status);
+    return WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+}
+
+static void
+overflow_rear_guard(void)
+{
+    char    *block;
+    unsigned i;
+
+    for (i = 0; i < RATE; i++)    // One in every RATE allocations by a thread is guarded
+        if (kit_memory_guarded(block = kit_malloc(BLOCK_SIZE)))
+            break;
+
+    block[BLOCK_SIZE] = 'X';
+    kit_free(block);
+}
+
+static void
+overflow_into_page(void)
+{
+    char *block = kit_malloc(BLOCK_SIZE);
+
+    memset(block, 'X', BLOCK_SIZE + 64);
+    kit_free(block);
+}
+
+int
+main(void)
+{
+    char    *blocks[BLOCKS];
+    char    *page_blocks[GUARD_PAGES];
+    char    *block;
+    size_t   page_size, size;
+    unsigned first, guarded, i, near_page;
+
+    plan_tests(21);
+    kit_memory_initialize(0);    // Don't check every allocation for overflows
+    page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    ok(kit_memory_guard_start(RATE, 0),                                     "Started guarding 1 in %u allocations", RATE);
+
+    for (first = BLOCKS, guarded = i = 0; i < BLOCKS; i++) {
+        blocks[i] = kit_malloc(BLOCK_SIZE);
+
+        if (kit_memory_guarded(blocks[i])) {
+            first    = first < i ? first : i;
+            guarded += 1;
+        }
+    }
+
+    is(guarded, BLOCKS / RATE,                                              "Guarded 1 in %u allocations by the thread", RATE);
+    ok(first < RATE,                                                        "One of the first %u allocations was guarded", RATE);
+    ok(kit_memory_check(blocks[first], &size) && size == BLOCK_SIZE,        "The guards of the first one guarded are intact");
+    strcpy(blocks[first], "guarded");
+    ok(blocks[first] = kit_realloc(blocks[first], 2 * BLOCK_SIZE),          "Reallocated the guarded memory");
+    is_eq(blocks[first], "guarded",                                         "Its contents were copied");
+
+    for (i = 0; i < BLOCKS; i++)
+        kit_free(blocks[i]);
+
+    is(overflow_in_child(overflow_rear_guard), SIGABRT,                     "Overflowing guarded memory aborts when it's freed");
+
+    diag("Guard pages");
+    {
+        kit_memory_guard_stop();
+        ok(kit_memory_guard_start(1, KIT_MEMORY_GUARD_PAGE),                "Started guarding every allocation with a page");
+        ok(kit_memory_guarded(block = kit_malloc(BLOCK_SIZE)),              "Memory was guarded");
+        ok(page_size - ((uintptr_t)block + BLOCK_SIZE) % page_size <= 16,   "It ends within 16 bytes of the end of a page");
+        kit_free(block);
+        ok((block = kit_memalign(64, BLOCK_SIZE)) && (uintptr_t)block % 64 == 0, "Guarded memory can be aligned");
+        kit_free(block);
+        ok((block = kit_calloc(1, BLOCK_SIZE)) && block[0] == 0 && block[BLOCK_SIZE - 1] == 0, "Guarded memory can be zeroed");
+        kit_free(block);
+        is(overflow_in_child(overflow_into_page), SIGSEGV,                  "Overflowing guarded memory into the page faults");
+
+        for (guarded = near_page = i = 0; i < GUARD_PAGES; i++) {    // More than the number of pages that can be guarded at once
+            page_blocks[i] = kit_malloc(BLOCK_SIZE);
+            guarded       += kit_memory_guarded(page_blocks[i]);
+            near_page     += page_size - ((uintptr_t)page_blocks[i] + BLOCK_SIZE) % page_size <= 16;
+        }
+
+        is(guarded, GUARD_PAGES,                                            "All %u allocations were guarded", GUARD_PAGES);
+        ok(near_page < GUARD_PAGES,                                         "Not all were followed by pages (%u were)", near_page);
+
+        for (i = 0; i < GUARD_PAGES; i++)
+            kit_free(page_blocks[i]);
+
+        block = kit_malloc(BLOCK_SIZE);
+        MOCKFAIL_START_TESTS(1, kit_free_diag);
+        kit_free(block);    // The page can't be made accessible, so the memory is leaked
+        ok(!kit_memory_guarded(block),                                      "Leaked guarded memory is forgotten");
+        MOCKFAIL_END_TESTS();
+        ok((block = kit_malloc(BLOCK_SIZE)) && kit_memory_guarded(block),   "Memory is still guarded after a leak");
+        kit_free(block);
+    }
+
+    kit_memory_guard_stop();
+    ok(!kit_memory_guarded(block = kit_malloc(BLOCK_SIZE)),                 "Memory isn't guarded after stopping");
+    ok(kit_memory_check(block, &size) == block && size == 0,                "Checking it does nothing");
+    kit_free(block);
+    ok(!kit_memory_guarded(NULL),                                           "NULL isn't guarded");
+    is(kit_memory_allocations(), 0,                                         "No kit memory was leaked");
+    return exit_status();
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <tap.h>
+
+#include "kit-alloc.h"
+
+#define BLOCKS     2000
+#define BLOCK_SIZE 1000
+#define RATE       4096
+
+static char     output[4096];
+static unsigned output_lines = 0;
+static int      block_line;     // Line of the allocation of the blocks
+static int      string_line;    // Line of the allocation of the strings
+static int      sample_line;    // Line of the allocation of a block that's sampled
+static int      rate_line;      // Line of an allocation made when every allocation is sampled
+static int      stopped_line;   // Line of an allocation made after profiling is stopped
+
+static __printflike(1, 2) int
+test_printer(const char *format, ...)
+{
+    va_list  args;
+    size_t   len = strlen(output);
+    int      written;
+
+    va_start(args, format);
+    written = vsnprintf(&output[len], sizeof(output) - len, format, args);
+    va_end(args);
+    output_lines++;
+    return written;
+}
+
+int
+main(void)
+{
+    char    *blocks[BLOCKS];
+    char    *string;
+    uint64_t live_bytes, live_allocs, sampled_bytes;
+    unsigned i;
+
+    plan_tests(20);
+    kit_memory_initialize(0);
+
+    ok(!kit_memory_profile_dump(test_printer, 0),                              "Nothing to dump before profiling is started");
+    ok(!kit_memory_profile_get(__FILE__, __LINE__, NULL, NULL),                 "No call sites before profiling is started");
+    ok(kit_memory_profile_start(RATE),                                          "Started profiling");
+
+    for (i = 0; i < BLOCKS; i++) {
+        block_line = __LINE__; blocks[i] = kit_malloc(BLOCK_SIZE);
+    }
+
+    for (i = 0; i < BLOCKS; i++) {    // Allocate and free the same number of bytes at another call site
+        string_line = __LINE__; string = kit_calloc(1, BLOCK_SIZE);
+        kit_free(string);
+    }
+
+    ok(kit_memory_profile_get(__FILE__, block_line, &live_bytes, &live_allocs), "The live blocks' call site was sampled");
+    ok(live_bytes > BLOCKS * BLOCK_SIZE * 7 / 10 && live_bytes < BLOCKS * BLOCK_SIZE * 13 / 10,
+       "Estimated live bytes %"PRIu64" is within 30%% of %u", live_bytes, BLOCKS * BLOCK_SIZE);
+    ok(live_allocs > BLOCKS * 7 / 10 && live_allocs < BLOCKS * 13 / 10,
+       "Estimated live allocations %"PRIu64" is within 30%% of %u", live_allocs, BLOCKS);
+    ok(kit_memory_profile_get(__FILE__, string_line, &live_bytes, &live_allocs), "The freed strings' call site was sampled");
+    is(live_bytes, 0,                                                           "None of its bytes are live");
+    is(live_allocs, 0,                                                          "None of its allocations are live");
+
+    ok(kit_memory_profile_dump(test_printer, 1),                                "Dumped the top call site");
+    is(output_lines, 2,                                                         "Printed a heading and one call site");
+    ok(strstr(output, "test-kit-memory-profile.c:"),                            "The call site's file was printed");
+    output[0]    = '\0';
+    output_lines = 0;
+    ok(kit_memory_profile_dump(test_printer, 0) && output_lines == 3,           "Dumped both call sites");
+
+    for (i = 0; i < BLOCKS; i++)    // Reallocating blocks moves their live bytes to the realloc call site
+        blocks[i] = kit_realloc(blocks[i], 2 * BLOCK_SIZE);
+
+    kit_memory_profile_get(__FILE__, block_line, &live_bytes, NULL);
+    is(live_bytes, 0,                                                           "The reallocated blocks are no longer live");
+
+    for (i = 0; i < BLOCKS; i++) {    // Allocate and free strings until one is sampled, then keep the sampled one
+        sample_line = __LINE__; string = kit_malloc(BLOCK_SIZE);
+
+        if (kit_memory_profile_get(__FILE__, sample_line, NULL, NULL))
+            break;
+
+        kit_free(string);
+    }
+
+    ok(kit_memory_profile_get(__FILE__, sample_line, &sampled_bytes, NULL),     "A string was sampled");
+    ok(!kit_realloc(string, SIZE_MAX / 2),                                      "Failed to reallocate the string to a huge size");
+    kit_memory_profile_get(__FILE__, sample_line, &live_bytes, NULL);
+    is(live_bytes, sampled_bytes,                                               "The string is still live after failing");
+    kit_free(string);
+
+    kit_memory_profile_start(1);    // Sample every allocation
+    rate_line = __LINE__; string = kit_malloc(BLOCK_SIZE);
+    ok(kit_memory_profile_get(__FILE__, rate_line, NULL, NULL),                 "An allocation is sampled at a rate of 1 byte");
+    kit_free(string);
+    kit_memory_profile_stop();
+
+    for (i = 0; i < BLOCKS; i++)    // Frees are still accounted for after profiling stops
+        kit_free(blocks[i]);
+
+    stopped_line = __LINE__; string = kit_malloc(BLOCK_SIZE);
+    ok(!kit_memory_profile_get(__FILE__, stopped_line, NULL, NULL),             "No allocations are sampled after stopping");
+    kit_free(string);
+    is(kit_memory_allocations(), 0,                                             "No kit memory was leaked");
+    return exit_status();
+}
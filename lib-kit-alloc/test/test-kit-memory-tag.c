@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <tap.h>
+
+#include "kit-alloc.h"
+#include "kit-counters.h"
+
+#define BLOCK_SIZE 100
+#define HEADER     16              // Size of the tag header added to each allocation
+#define BIG_SIZE   (256 * 1024)    // Big enough that the peak is recorded as soon as it's allocated
+
+static char output[4096];
+
+static void
+gather(void *v, const char *mib, const char *value)
+{
+    SXE_UNUSED_PARAMETER(v);
+    snprintf(&output[strlen(output)], sizeof(output) - strlen(output), "%s=%s\n", mib, value);
+}
+
+static void *
+free_thread(void *block)
+{
+    kit_counters_init_thread(1);
+    kit_free(block);
+    kit_counters_fini_thread(1);
+    return NULL;
+}
+
+int
+main(void)
+{
+    kit_memory_tag_t cache, parser;
+    pthread_t        thr;
+    char            *block, *other;
+
+    plan_tests(26);
+    kit_memory_set_flags(KIT_MEMORY_TAG_ALLOCATIONS);    // Don't check every allocation for overflows
+    kit_counters_initialize(KIT_COUNTERS_DEFAULT, 2, false);
+    cache  = kit_memory_tag_reg("cache");
+    parser = kit_memory_tag_reg("parser");
+    ok(cache != KIT_MEMORY_TAG_NONE && parser != cache,                "Registered two tags");
+    is(kit_memory_tag_bytes(cache), 0,                                 "Nothing is allocated under the cache tag");
+
+    block = kit_malloc(BLOCK_SIZE);
+    is(kit_memory_tag_bytes(cache) + kit_memory_tag_bytes(parser), 0, "Memory allocated without a tag isn't accounted for");
+    kit_free(block);
+
+    kit_memory_tag_push(cache);
+    block = kit_malloc(BLOCK_SIZE);
+    is(kit_memory_tag_bytes(cache), BLOCK_SIZE + HEADER,               "Memory allocated under the cache tag is accounted for");
+
+    kit_memory_tag_push(parser);
+    other = kit_calloc(1, BLOCK_SIZE);
+    kit_memory_tag_pop();
+    is(kit_memory_tag_bytes(parser), BLOCK_SIZE + HEADER,              "Memory allocated under a nested tag is accounted for");
+    is(kit_memory_tag_bytes(cache), BLOCK_SIZE + HEADER,               "It isn't accounted for under the outer tag");
+    ok(other[0] == 0 && other[BLOCK_SIZE - 1] == 0,                    "Tagged memory can be zeroed");
+    kit_memory_tag_pop();
+    kit_free(other);
+
+    strcpy(block, "tagged");
+    ok(block = kit_realloc(block, 2 * BLOCK_SIZE),                     "Reallocated the memory with no tag pushed");
+    is_eq(block, "tagged",                                             "Its contents were kept");
+    is(kit_memory_tag_bytes(cache), 2 * BLOCK_SIZE + HEADER,           "It's still accounted for under its original tag");
+    kit_free(block);
+    is(kit_memory_tag_bytes(cache), 0,                                 "Freeing it accounted for it");
+
+    ok((block = kit_malloc_tagged(cache, BLOCK_SIZE)),                 "Allocated memory under a tag without pushing it");
+    is(kit_memory_tag_bytes(cache), BLOCK_SIZE + HEADER,               "It's accounted for under the tag");
+    kit_free(block);
+
+    kit_memory_tag_push(cache);
+    ok((block = kit_memalign(64, BLOCK_SIZE)) && (uintptr_t)block % 64 == 0, "Tagged memory can be aligned");
+    kit_memory_tag_pop();
+    is(kit_memory_tag_bytes(cache), BLOCK_SIZE + 64,                   "The header is padded to the alignment");
+    ok(block = kit_realloc(block, 2 * BLOCK_SIZE),                     "Reallocated the aligned memory");
+    ok((uintptr_t)block % 64 == 0,                                     "It's still aligned");
+    kit_free(block);
+
+    diag("Peaks and mib text");
+    {
+        other = kit_malloc_tagged(parser, BLOCK_SIZE);
+        block = kit_malloc_tagged(cache, BIG_SIZE);
+        kit_free(block);
+        is(kit_memory_tag_bytes(cache), 0,                             "The big allocation was freed");
+        ok(kit_memory_tag_peak(cache) >= BIG_SIZE,                     "The peak is at least the big allocation");
+        is(kit_memory_tag_peak(parser), BLOCK_SIZE + HEADER,           "The parser tag peaked at its one allocation");
+
+        kit_counters_mib_text("memory.tag", NULL, gather, KIT_THREAD_TOTAL, 0);
+        ok(strstr(output, "memory.tag.parser.bytes=116\n"),            "The mib text includes the bytes under a tag");
+        ok(strstr(output, "memory.tag.parser.peak=116\n"),             "The mib text includes the peak under a tag");
+        output[0] = '\0';
+        kit_counters_mib_text("memory.tag.cache.bytes", NULL, gather, 0, 0);
+        is_eq(output, "memory.tag.cache.bytes=0\n",                    "The mib text for a thread includes only the bytes");
+        kit_free(other);
+    }
+
+    other = kit_malloc_tagged(parser, BLOCK_SIZE);
+    ok(pthread_create(&thr, NULL, free_thread, other) == 0 && pthread_join(thr, NULL) == 0, "Freed memory in another thread");
+    is(kit_memory_tag_bytes(parser), 0,                                "It was accounted for under its tag");
+
+    errno = 0;
+    ok(!kit_memory_guard_start(1, 0) && errno == EINVAL,               "Can't guard sampled allocations when tagging them");
+    return exit_status();
+}
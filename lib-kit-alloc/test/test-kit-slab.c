@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <tap.h>
+
+#include "kit-alloc.h"
+#include "kit-mockfail.h"
+#include "kit-slab.h"
+
+#define OBJECTS 5000    // Enough objects to need several chunks
+#define CACHED  500     // More objects than a thread moves to the shared list at a time, but fewer than a chunk holds
+
+static struct kit_slab *slab;
+static void            *objects[OBJECTS];
+
+/* Free half the objects from another thread
+ */
+static void *
+free_half(void *arg)
+{
+    for (unsigned i = 0; i < OBJECTS; i += 2)
+        kit_slab_free(slab, objects[i]);
+
+    return arg;
+}
+
+/* Allocate and free an object, leaving the rest of a chunk's objects in the thread's cache when it exits
+ */
+static void *
+alloc_and_exit(void *arg)
+{
+    kit_slab_free(arg, kit_slab_alloc(arg));
+    return NULL;
+}
+
+int
+main(void)
+{
+    struct kit_slab *slab16, *exited;
+    pthread_t        thread;
+    uint64_t         start_allocations;
+    size_t           size;
+    char            *object;
+    unsigned         created, i, j, unique;
+
+    plan_tests(21);
+    kit_memory_initialize(KIT_MEMORY_CHECK_OVERFLOWS);
+    start_allocations = kit_memory_allocations();
+
+    ok(slab = kit_slab_create(40), "Created a slab of 40 byte objects");
+    ok(object = kit_slab_alloc(slab), "Allocated an object");
+    is((uintptr_t)object % 8, 0,      "It's 8 byte aligned");
+    ok(kit_memory_check(object, &size), "Its guards are intact");
+    ok(size >= 40,                      "It has at least 40 usable bytes (%zu)", size);
+    memset(object, 0xFF, 40);
+    kit_slab_free(slab, object);
+    kit_slab_free(slab, NULL);
+    is(kit_memory_allocations(), start_allocations + 1, "Only the slab itself is still allocated");
+
+    for (i = 0; i < OBJECTS; i++) {
+        objects[i] = kit_slab_alloc(slab);
+        memset(objects[i], i & 0xFF, 40);
+    }
+
+    for (unique = 0, i = 0; i < OBJECTS; i++) {
+        for (j = 0; j < 40 && ((unsigned char *)objects[i])[j] == (i & 0xFF); j++) {
+        }
+
+        unique += j == 40;
+    }
+
+    is(unique, OBJECTS, "Allocated %u objects from several chunks without overlap", OBJECTS);
+    is(kit_memory_allocations(), start_allocations + 1 + OBJECTS, "All the objects are counted");
+
+    pthread_create(&thread, NULL, free_half, NULL);
+    pthread_join(thread, NULL);
+    is(kit_memory_allocations(), start_allocations + 1 + OBJECTS / 2, "Half of the objects were freed by another thread");
+
+    for (i = 1; i < OBJECTS; i += 2)
+        kit_slab_free(slab, objects[i]);
+
+    is(kit_memory_allocations(), start_allocations + 1, "The rest were freed by this thread");
+    ok(object = kit_slab_alloc(slab), "Allocated an object after the frees");
+
+    for (i = 0; i < OBJECTS && objects[i] != object; i++) {
+    }
+
+    ok(i < OBJECTS, "It reused the memory of a freed object");
+    kit_slab_free(slab, object);
+
+    ok(slab16 = kit_slab_create(32), "Created a slab of 32 byte objects");
+    MOCKFAIL_START_TESTS(2, kit_slab_alloc);
+    errno = 0;
+    ok(!kit_slab_alloc(slab16), "Failed to allocate an object when a new chunk can't be allocated");
+    is(errno, ENOMEM,           "Got the expected error");
+    MOCKFAIL_END_TESTS();
+    start_allocations++;    // Like kit_malloc, failed allocations are counted as mallocs
+    ok(object = kit_slab_alloc(slab16), "Allocated an object");
+    is((uintptr_t)object % 16, 0,       "It's 16 byte aligned");
+    kit_slab_free(slab16, object);
+    kit_slab_delete(slab16);
+
+    ok(exited = kit_slab_create(32), "Created a slab used by a thread that exits");
+    pthread_create(&thread, NULL, alloc_and_exit, exited);
+    pthread_join(thread, NULL);
+    MOCKFAIL_START_TESTS(1, kit_slab_alloc);
+    MOCKFAIL_SET_FREQ(1);
+
+    for (i = 0; i < CACHED && (objects[i] = kit_slab_alloc(exited)); i++) {
+    }
+
+    is(i, CACHED, "Allocated %u objects cached by the exited thread without allocating a chunk", CACHED);
+    MOCKFAIL_END_TESTS();
+
+    for (j = 0; j < i; j++)
+        kit_slab_free(exited, objects[j]);
+
+    kit_slab_delete(exited);
+
+    for (created = 0, i = 0; i < 2 * KIT_SLAB_MAX; i++)
+        if ((slab16 = kit_slab_create(16))) {
+            created++;
+            kit_slab_free(slab16, kit_slab_alloc(slab16));
+            kit_slab_delete(slab16);
+        }
+
+    is(created, 2 * KIT_SLAB_MAX, "Created and deleted twice the maximum number of slabs");
+
+    kit_slab_delete(slab);
+    is(kit_memory_allocations(), start_allocations, "No memory was leaked");
+    return exit_status();
+}
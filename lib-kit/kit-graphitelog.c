@@ -40,6 +40,7 @@ static __thread int      graphitelog_fd = -1;
 static volatile unsigned graphitelog_json_limit;
 static volatile unsigned graphitelog_interval;
 static volatile unsigned graphitelog_timeout_ms = -1;
+static volatile bool     graphitelog_changed_only;
 static volatile bool     timetodie;
 
 struct kit_graphitelog_buffer {
@@ -105,6 +106,20 @@ kit_graphitelog_update_set_options(unsigned json_limit, unsigned interval, unsig
     graphitelog_timeout_ms = timeout_ms;
 }
 
+/**
+ * Set whether to output only the counters that changed since the previous interval
+ *
+ * @param changed_only true to output only changed counters, or false (default) to output all counters every interval
+ *
+ * @note Every counter is output in the first interval, and intervals in which no counter changed are skipped
+ */
+void
+kit_graphitelog_set_changed_only(bool changed_only)
+{
+    SXEL6("(changed_only=%s)", changed_only ? "true" : "false");
+    graphitelog_changed_only = changed_only;
+}
+
 /**
  * Launch the graphite logging thread
  *
@@ -116,6 +131,7 @@ kit_graphitelog_start_routine(void *arg)
     uint64_t                             interval_ns, sleep_ns, wall_ns;
     const struct kit_graphitelog_thread *thr = arg;
     struct kit_graphitelog_buffer        buffer;
+    struct kit_counters_snapshot        *prev, *cur;
     struct timespec                      wall_time, delay_time;
 
     SXEL4("(): thread started");
@@ -125,6 +141,7 @@ kit_graphitelog_start_routine(void *arg)
     delay_time.tv_sec = 0;
     graphitelog_fd    = thr->fd;
     sleep_ns          = 0;          // Shut gcc up
+    prev              = NULL;
     SXEL6("Graphitelog is %s", graphitelog_fd >= 0 ? "enabled" : "disabled");
 
     for (;;) {
@@ -133,8 +150,17 @@ kit_graphitelog_start_routine(void *arg)
         buffer.now = wall_time.tv_sec;
 
         if (graphitelog_fd >= 0) {
-            buffer.counter = 0;
-            kit_counters_mib_text("", &buffer, kit_graphitelog_counter_callback, -1, KIT_COUNTERS_FLAG_NONE);
+            buffer.counter       = 0;
+            buffer.json_complete = 1;    // Nothing to complete unless a counter is output
+
+            if (graphitelog_changed_only) {
+                cur = kit_counters_snapshot();
+                kit_counters_mib_text_changed("", &buffer, kit_graphitelog_counter_callback, prev, cur, KIT_COUNTERS_FLAG_NONE);
+                kit_counters_snapshot_free(prev);
+                prev = cur;
+            } else
+                kit_counters_mib_text("", &buffer, kit_graphitelog_counter_callback, -1, KIT_COUNTERS_FLAG_NONE);
+
             kit_graphitelog_complete(&buffer);
         }
 
@@ -160,6 +186,7 @@ kit_graphitelog_start_routine(void *arg)
         nanosleep(&delay_time, NULL);
     }
 
+    kit_counters_snapshot_free(prev);
     SXEL4(": thread exiting");
     return NULL;
 }
@@ -24,6 +24,8 @@
 #include <fcntl.h>
 #include <pthread.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <tap.h>
@@ -37,6 +39,7 @@
 
 static const char *graphite_log_file = "graphite_log_file";
 static kit_counter_t COUNTER;
+static kit_counter_t OTHER;
 static bool thread_started;
 
 static void
@@ -45,22 +48,53 @@ started(void)
     thread_started = true;
 }
 
+/* Return true if a graphitelog record has a counter other than the changed counter (if any) and the memory.bytes gauge, which
+ * changes in every interval because the graphitelog thread allocates memory
+ */
+static bool
+has_unchanged_counters(const char *record, const char *changed)
+{
+    const char *p;
+    unsigned    values;
+
+    for (values = 0, p = record; (p = strstr(p, "\":\"")) != NULL; p++)    // The first value is the log timestamp
+        values++;
+
+    return values > 1U + (strstr(record, "\"memory.bytes\"") ? 1U : 0U) + (changed && strstr(record, changed) ? 1U : 0U);
+}
+
+/* Sleep until just after the start of the next interval, half way between the graphitelog thread's outputs
+ */
+static void
+sleep_to_next_interval(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    usleep((INTERVAL - now.tv_sec % INTERVAL) * 1000000 - now.tv_nsec / 1000 + 100000);
+}
+
 int
 main(void)
 {
     struct kit_graphitelog_thread gthr;
     unsigned long                 lastval, val;
     const char                   *eor, *p;
+    char                         *line, *save;
     ssize_t                       read_bytes;
     pthread_t                     thread;
+    struct stat                   st;
+    off_t                         changed_offset;
     unsigned                      i, rec;
+    bool                          first_counter, first_other, second_changed, second_unchanged, third_output;
     char                          buf[4096];
 
-    plan_tests(11);
+    plan_tests(15);
 
     // Initializer counters
     kit_counters_initialize(KIT_COUNTERS_MAX, 2, false);
     COUNTER = kit_counter_reg("counter");
+    OTHER   = kit_counter_reg("other");
     ok(kit_counter_isvalid(COUNTER), "Created counter");
     is(kit_counter_get(COUNTER), 0, "Counter was initialized to zero");
 
@@ -86,6 +120,16 @@ main(void)
     kit_counter_add(COUNTER, 5);
     usleep(1000000 * INTERVAL * 3 + 1000000);
 
+    // Output only changed counters, remembering where their output starts, then bump one counter in the second interval
+    sleep_to_next_interval();
+    kit_graphitelog_set_changed_only(true);
+    fstat(gthr.fd, &st);
+    changed_offset = st.st_size;
+    sleep_to_next_interval();
+    kit_counter_incr(OTHER);
+    sleep_to_next_interval();
+    sleep_to_next_interval();    // Nothing changes in the third interval
+
     // Terminate the graphitelog thread
     kit_graphitelog_terminate();
     pthread_join(thread, NULL);
@@ -131,6 +175,33 @@ main(void)
     }
 
     pass("Record %u: timestamp %lu could be anything (last record)", ++rec, lastval);
+
+    ok((read_bytes = pread(gthr.fd, buf, sizeof(buf) - 1, changed_offset)) > 0, "Read changed only graphitelog output");
+    buf[read_bytes < 0 ? 0 : read_bytes] = '\0';
+    first_counter = first_other = second_changed = second_unchanged = third_output = false;
+
+    for (lastval = 0, rec = 0, line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        p   = strstr(line, TSDATA);
+        val = p ? kit_strtoul(p + sizeof(TSDATA) - 1, NULL, 10) : 0;
+
+        if (val != lastval) {    // Each interval's counters may be split over several records with the same timestamp
+            lastval = val;
+            rec++;
+        }
+
+        if (rec == 1) {
+            first_counter = first_counter || strstr(line, "\"counter\":\"5\"");
+            first_other   = first_other   || strstr(line, "\"other\":\"0\"");
+        } else if (rec == 2) {
+            second_changed   = second_changed || strstr(line, "\"other\":\"1\"");
+            second_unchanged = second_unchanged || has_unchanged_counters(line, "\"other\"");
+        } else
+            third_output = third_output || has_unchanged_counters(line, NULL);
+    }
+
+    ok(first_counter && first_other,          "The first changed only interval output every counter");
+    ok(second_changed && !second_unchanged,   "The next interval output only the changed counter");
+    ok(rec >= 2 && !third_output,             "The interval with no changes output nothing but the memory.bytes gauge");
     close(gthr.fd);
     return exit_status();
 }
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Arenas of jitsons. Jitsons gotten from a stack that uses an arena are copied into the arena's blocks instead of each being
+ * allocated, and are all freed together when the arena is reset. This saves allocating and freeing memory for each of the many
+ * short lived values parsed while handling a request.
+ *
+ * Each thread also has an arena that is used between sxe_jitson_arena_begin_request and sxe_jitson_arena_end_request by APIs that
+ * opt in to it (currently only sxe_jitson_expr_eval), so that the temporary results of expressions evaluated while handling a
+ * request are freed all at once at its end. Other APIs (e.g. sxe_jitson_new, sxe_jitson_dup and operators called directly) always
+ * return allocated values, which the caller must free.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "kit-alloc.h"
+#include "kit-mockfail.h"
+#include "sxe-jitson.h"
+#include "sxe-log.h"
+#include "sxe-thread.h"
+
+#define JITSON_ARENA_BLOCK_SIZE 4096    // Default number of jitsons in each block of an arena
+
+struct sxe_jitson_arena_block {
+    struct sxe_jitson_arena_block *next;         // Previously allocated block
+    unsigned                       size;         // Number of jitsons in the block
+    unsigned                       used;         // Number of jitsons used
+    struct sxe_jitson              jitsons[];
+};
+
+struct sxe_jitson_arena {
+    struct sxe_jitson_arena_block *blocks;        // Block being allocated from, followed by the blocks allocated before it
+    unsigned                       block_size;    // Number of jitsons in each block, unless a value needs a larger one
+};
+
+static __thread struct sxe_jitson_arena *jitson_arena_thread = NULL;    // The thread's arena, allocated on first use
+static __thread unsigned                 jitson_arena_depth  = 0;       // Number of requests begun but not yet ended
+
+/**
+ * Create an arena of jitsons
+ *
+ * @param block_size Number of jitsons in each block of memory allocated by the arena, or 0 for the default (4096)
+ *
+ * @return The arena or NULL on failure to allocate memory (ENOMEM)
+ */
+struct sxe_jitson_arena *
+sxe_jitson_arena_new(unsigned block_size)
+{
+    struct sxe_jitson_arena *arena;
+
+    if (!(arena = MOCKERROR(MOCK_FAIL_ARENA_NEW, NULL, ENOMEM, kit_malloc(sizeof(*arena)))))
+        return NULL;
+
+    arena->blocks     = NULL;
+    arena->block_size = block_size ?: JITSON_ARENA_BLOCK_SIZE;
+    return arena;
+}
+
+/**
+ * Allocate jitsons from an arena
+ *
+ * @param arena The arena
+ * @param size  The number of jitsons needed, which must be the size of the value that will be stored in them
+ *
+ * @return A pointer to the jitsons or NULL on failure to allocate memory (ENOMEM)
+ */
+struct sxe_jitson *
+sxe_jitson_arena_alloc(struct sxe_jitson_arena *arena, unsigned size)
+{
+    struct sxe_jitson_arena_block *block = arena->blocks;
+    unsigned                       block_size;
+
+    if (!block || block->used + size > block->size) {
+        block_size = size > arena->block_size ? size : arena->block_size;
+
+        if (!(block = MOCKERROR(MOCK_FAIL_ARENA_BLOCK, NULL, ENOMEM,
+                                kit_malloc(sizeof(*block) + (size_t)block_size * sizeof(block->jitsons[0]))))) {
+            SXEL2(": Failed to allocate a block of %u jitsons for an arena", block_size);
+            return NULL;
+        }
+
+        block->next   = arena->blocks;
+        block->size   = block_size;
+        block->used   = 0;
+        arena->blocks = block;
+    }
+
+    block->used += size;
+    return &block->jitsons[block->used - size];
+}
+
+/**
+ * Duplicate a jitson value in an arena, deep cloning any indices or content it owns
+ *
+ * @param arena  The arena
+ * @param jitson The jitson value to duplicate
+ *
+ * @return The duplicate, which will be freed when the arena is reset, or NULL on failure to allocate memory (ENOMEM)
+ */
+struct sxe_jitson *
+sxe_jitson_arena_dup(struct sxe_jitson_arena *arena, const struct sxe_jitson *jitson)
+{
+    struct sxe_jitson *dup;
+    unsigned           size;
+
+    jitson = sxe_jitson_dereference(jitson);
+    size   = sxe_jitson_size(jitson);
+
+    if (!(dup = sxe_jitson_arena_alloc(arena, size)))
+        return NULL;
+
+    memcpy(dup, jitson, size * sizeof(*jitson));
+    dup->type &= ~SXE_JITSON_TYPE_ALLOCED;
+
+    if (!sxe_jitson_clone(jitson, dup)) {    // If the type requires a deep clone, do it
+        arena->blocks->used -= size;         // Give back the space, which was the last allocated
+        return NULL;
+    }
+
+    return dup;
+}
+
+/**
+ * Create a reference in an arena to another jitson that will behave exactly like the original jitson
+ *
+ * @param arena The arena
+ * @param to    The jitson to refer to, which must not be freed before the arena is reset
+ *
+ * @return The reference, which will be freed when the arena is reset, or NULL on failure to allocate memory (ENOMEM)
+ */
+struct sxe_jitson *
+sxe_jitson_arena_reference(struct sxe_jitson_arena *arena, const struct sxe_jitson *to)
+{
+    struct sxe_jitson *reference;
+
+    if (!(reference = sxe_jitson_arena_alloc(arena, 1)))
+        return NULL;
+
+    return sxe_jitson_make_reference(reference, to);
+}
+
+/**
+ * Free all jitsons allocated from an arena, keeping one block of memory to be reused
+ *
+ * @note Any memory owned by the values in the arena (e.g. copies of long strings and indices) is also freed
+ */
+void
+sxe_jitson_arena_reset(struct sxe_jitson_arena *arena)
+{
+    struct sxe_jitson_arena_block *block, *next;
+    unsigned                       i, size;
+
+    for (block = arena->blocks; block; block = next) {
+        for (i = 0; i < block->used; i += size) {    // Values are stored one after another in each block
+            size = sxe_jitson_size(&block->jitsons[i]);
+            sxe_jitson_free_containee(&block->jitsons[i]);
+        }
+
+        block->used = 0;
+
+        if ((next = block->next)) {    // Keep only the first block allocated, which is at the end of the list
+            arena->blocks = next;
+            kit_free(block);
+        }
+    }
+}
+
+/**
+ * Free an arena and all jitsons allocated from it
+ */
+void
+sxe_jitson_arena_free(struct sxe_jitson_arena *arena)
+{
+    if (!arena)
+        return;
+
+    sxe_jitson_arena_reset(arena);
+    kit_free(arena->blocks);
+    kit_free(arena);
+}
+
+/**
+ * Begin a request. Until it ends, the results of expressions evaluated with sxe_jitson_expr_eval are allocated from the thread's
+ * arena instead of each being allocated. The thread's stack is not otherwise affected, so values returned by other APIs must
+ * still be freed by the caller.
+ *
+ * @return The thread's arena, or NULL on failure to allocate it (ENOMEM)
+ *
+ * @note Requests can be nested, in which case the values are freed when the outermost request ends. Values that must outlive
+ *       the request must be duplicated with sxe_jitson_dup before it ends.
+ */
+struct sxe_jitson_arena *
+sxe_jitson_arena_begin_request(void)
+{
+    if (!jitson_arena_thread) {
+        if (!(jitson_arena_thread = MOCKERROR(MOCK_FAIL_ARENA_THREAD, NULL, ENOMEM,
+                                              sxe_thread_malloc(sizeof(*jitson_arena_thread),
+                                                                (void (*)(void *))sxe_jitson_arena_free, NULL)))) {
+            SXEL2(": Failed to allocate a per thread jitson arena");
+            return NULL;
+        }
+
+        jitson_arena_thread->blocks     = NULL;
+        jitson_arena_thread->block_size = JITSON_ARENA_BLOCK_SIZE;
+    }
+
+    jitson_arena_depth++;
+    return jitson_arena_thread;
+}
+
+/**
+ * End a request, freeing all jitsons allocated from the thread's arena during it if it's the outermost request
+ */
+void
+sxe_jitson_arena_end_request(void)
+{
+    SXEA1(jitson_arena_depth, "Can't end a request that was never begun");
+
+    if (--jitson_arena_depth == 0)
+        sxe_jitson_arena_reset(jitson_arena_thread);
+}
+
+/**
+ * Get the thread's arena if a request is in progress
+ *
+ * @return The arena temporary values should be allocated from, or NULL if no request is in progress
+ */
+struct sxe_jitson_arena *
+sxe_jitson_arena_get_request(void)
+{
+    return jitson_arena_depth ? jitson_arena_thread : NULL;
+}
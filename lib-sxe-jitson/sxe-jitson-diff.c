@@ -0,0 +1,625 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Structural diffs, patches, and merges of jitson values. A diff is a patch in the form of an array of RFC 6902 operations. The
+ * results of patches and merges refer to the unchanged parts of the value being patched or merged into, so the cost of applying
+ * a change is proportional to the size of the change and of the arrays and objects along the path to it rather than to the size
+ * of the whole value.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sxe-jitson.h"
+
+#define PATCH_OP_ADD     0
+#define PATCH_OP_REMOVE  1
+#define PATCH_OP_REPLACE 2
+
+/* Append a member name or array index to a JSON pointer (RFC 6901), escaping '~' and '/', returning the previous length
+ */
+static size_t
+diff_path_push(struct sxe_factory *path, const char *segment, size_t len)
+{
+    size_t saved = path->len;
+    size_t i;
+
+    sxe_factory_add(path, "/", 1);
+
+    for (i = 0; i < len; i++)
+        if (segment[i] == '~')
+            sxe_factory_add(path, "~0", 2);
+        else if (segment[i] == '/')
+            sxe_factory_add(path, "~1", 2);
+        else
+            sxe_factory_add(path, &segment[i], 1);
+
+    return saved;
+}
+
+/* Truncate a JSON pointer to a previous length
+ */
+static void
+diff_path_pop(struct sxe_factory *path, size_t saved)
+{
+    if (path->data) {
+        path->len         = saved;
+        path->data[saved] = '\0';
+    }
+}
+
+/* Add an operation to the patch under construction. If value is not NULL, a duplicate of it is added.
+ */
+static bool
+diff_add_op(struct sxe_jitson_stack *stack, const char *op, struct sxe_factory *path, const struct sxe_jitson *value)
+{
+    const char *pointer = sxe_factory_look(path, NULL);
+
+    return sxe_jitson_stack_open_collection(stack, SXE_JITSON_TYPE_OBJECT)
+        && sxe_jitson_stack_add_member_name(stack, "op", SXE_JITSON_TYPE_IS_REF)
+        && sxe_jitson_stack_add_string(stack, op, SXE_JITSON_TYPE_IS_REF)
+        && sxe_jitson_stack_add_member_name(stack, "path", SXE_JITSON_TYPE_IS_REF)
+        && sxe_jitson_stack_add_string(stack, pointer ?: "", SXE_JITSON_TYPE_IS_COPY)
+        && (!value || (sxe_jitson_stack_add_member_name(stack, "value", SXE_JITSON_TYPE_IS_REF)
+                    && sxe_jitson_stack_add_dup(stack, value)))
+        && sxe_jitson_stack_close_collection(stack);
+}
+
+/* Add the operations needed to change one value into another to the patch under construction
+ */
+static bool
+diff_values(struct sxe_jitson_stack *stack, struct sxe_factory *path, const struct sxe_jitson *from, const struct sxe_jitson *to)
+{
+    const struct sxe_jitson *member, *value, *other;
+    const char              *name;
+    char                     index[24];
+    size_t                   len, saved;
+    unsigned                 from_len, i, to_len;
+    uint32_t                 type;
+    bool                     ok;
+
+    from = sxe_jitson_dereference(from);
+    to   = sxe_jitson_dereference(to);
+
+    if (from == to)    // Shared values, like those in the results of patches and merges, are the same
+        return true;
+
+    if ((type = sxe_jitson_get_type(from)) != sxe_jitson_get_type(to))
+        return diff_add_op(stack, "replace", path, to);
+
+    switch (type) {
+    case SXE_JITSON_TYPE_OBJECT:    // Remove or diff the members of from, then add the members only in to
+        for (i = 0, member = from + 1; i < from->len; i++, member = value + sxe_jitson_size(value)) {
+            value = member + sxe_jitson_size(member);
+            name  = sxe_jitson_get_string(member, &len);
+            saved = diff_path_push(path, name, len);
+            ok    = (other = sxe_jitson_object_get_member(to, name, len)) ? diff_values(stack, path, value, other)
+                                                                          : diff_add_op(stack, "remove", path, NULL);
+            diff_path_pop(path, saved);
+
+            if (!ok)
+                return false;
+        }
+
+        for (i = 0, member = to + 1; i < to->len; i++, member = value + sxe_jitson_size(value)) {
+            value = member + sxe_jitson_size(member);
+            name  = sxe_jitson_get_string(member, &len);
+
+            if (sxe_jitson_object_get_member(from, name, len))
+                continue;
+
+            saved = diff_path_push(path, name, len);
+            ok    = diff_add_op(stack, "add", path, value);
+            diff_path_pop(path, saved);
+
+            if (!ok)
+                return false;
+        }
+
+        return true;
+
+    case SXE_JITSON_TYPE_ARRAY:    // Diff the common elements, then add elements to or remove them from the end
+        from_len = sxe_jitson_len(from);
+        to_len   = sxe_jitson_len(to);
+
+        for (i = 0; i < to_len; i++) {
+            if (i < from_len) {
+                saved = diff_path_push(path, index, (size_t)snprintf(index, sizeof(index), "%u", i));
+                ok    = diff_values(stack, path, sxe_jitson_array_get_element(from, i), sxe_jitson_array_get_element(to, i));
+            }
+            else {
+                saved = diff_path_push(path, "-", 1);    // Append the element
+                ok    = diff_add_op(stack, "add", path, sxe_jitson_array_get_element(to, i));
+            }
+
+            diff_path_pop(path, saved);
+
+            if (!ok)
+                return false;
+        }
+
+        for (i = from_len; i-- > to_len;) {    // Remove from the end so that the indices of the other elements don't change
+            saved = diff_path_push(path, index, (size_t)snprintf(index, sizeof(index), "%u", i));
+            ok    = diff_add_op(stack, "remove", path, NULL);
+            diff_path_pop(path, saved);
+
+            if (!ok)
+                return false;
+        }
+
+        return true;
+
+    default:
+        return sxe_jitson_eq(from, to) == SXE_JITSON_TEST_TRUE ? true : diff_add_op(stack, "replace", path, to);
+    }
+}
+
+/**
+ * Compute the difference between two values as a patch
+ *
+ * @param from The value to be changed
+ * @param to   The value it is to be changed into
+ *
+ * @return An array of RFC 6902 "add", "remove", and "replace" operations that changes from into to, or NULL on error (ENOMEM)
+ *
+ * @note Members are matched by name. Array elements are matched by index, with any extra elements added to or removed from the
+ *       end. The values in the patch are duplicates, so the patch doesn't refer to either value.
+ */
+struct sxe_jitson *
+sxe_jitson_diff(const struct sxe_jitson *from, const struct sxe_jitson *to)
+{
+    struct sxe_jitson_stack *stack = sxe_jitson_stack_get_thread();
+    struct sxe_jitson_stack  iou;
+    struct sxe_jitson       *patch = NULL;
+    struct sxe_factory       path;
+
+    sxe_factory_alloc_make(&path, 0, 0);
+    sxe_jitson_stack_borrow(stack, &iou);
+
+    if (sxe_jitson_stack_open_collection(stack, SXE_JITSON_TYPE_ARRAY) && diff_values(stack, &path, from, to)
+     && sxe_jitson_stack_close_collection(stack))
+        patch = sxe_jitson_stack_get_jitson(stack);
+    else
+        sxe_jitson_stack_clear(stack);    /* COVERAGE EXCLUSION: Out of memory condition */
+
+    sxe_jitson_stack_return(stack, &iou);
+    kit_free(sxe_factory_remove(&path, NULL));
+    return patch;
+}
+
+/* The value being patched and the range of jitsons that will be freed once the next operation is applied to it
+ */
+struct patch_state {
+    const struct sxe_jitson *value;
+    const struct sxe_jitson *start;
+    const struct sxe_jitson *end;
+};
+
+/* Add a value to the array or object under construction. Values in the result of a previous operation are duplicated, since
+ * it will be freed. Values bigger than a reference in the value originally being patched are shared by reference.
+ */
+static bool
+patch_add_shared(struct sxe_jitson_stack *stack, const struct patch_state *state, const struct sxe_jitson *value)
+{
+    if ((value >= state->start && value < state->end) || sxe_jitson_size(value) == 1)
+        return sxe_jitson_stack_add_dup(stack, value);
+
+    return sxe_jitson_stack_add_reference(stack, value);
+}
+
+/* Add a member name to the object under construction, copying it if it's in the result of a previous operation
+ */
+static bool
+patch_add_member_name(struct sxe_jitson_stack *stack, const struct patch_state *state, const struct sxe_jitson *name)
+{
+    return sxe_jitson_stack_add_member_name(stack, sxe_jitson_get_string(name, NULL),
+                                            name >= state->start && name < state->end ? SXE_JITSON_TYPE_IS_COPY
+                                                                                      : SXE_JITSON_TYPE_IS_REF);
+}
+
+/* Parse an array index in a JSON pointer, returning the index, len if it's "-", or ~0U if it's invalid
+ */
+static unsigned
+patch_index(const char *segment, unsigned len)
+{
+    unsigned long idx;
+    char         *end;
+
+    if (segment[0] == '-' && segment[1] == '\0')
+        return len;
+
+    if (segment[0] < '0' || segment[0] > '9' || (segment[0] == '0' && segment[1] != '\0'))    // No signs or leading zeros
+        return ~0U;
+
+    idx = strtoul(segment, &end, 10);
+    return *end == '\0' && idx < ~0U ? (unsigned)idx : ~0U;
+}
+
+/* Split a JSON pointer in place into unescaped, NUL terminated segments, returning the number of segments or ~0U if invalid
+ */
+static unsigned
+patch_split_path(char *pointer, char **segments)
+{
+    unsigned count = 0;
+    char    *from, *to;
+
+    if (*pointer == '\0')    // The empty pointer refers to the whole value
+        return 0;
+
+    if (*pointer != '/')
+        return ~0U;
+
+    for (from = to = pointer; *from;) {
+        if (*from == '/') {
+            *to++             = '\0';
+            segments[count++] = to;
+            from++;
+        }
+        else if (*from == '~') {
+            if (from[1] != '0' && from[1] != '1')
+                return ~0U;
+
+            *to++  = from[1] == '0' ? '~' : '/';
+            from  += 2;
+        }
+        else
+            *to++ = *from++;
+    }
+
+    *to = '\0';
+    return count;
+}
+
+/* Check that an operation can be applied to a value, so that building its result can only fail if out of memory
+ */
+static bool
+patch_check(const struct sxe_jitson *value, char **segments, unsigned count, unsigned op)
+{
+    unsigned depth, idx, len;
+
+    for (depth = 0; depth < count; depth++) {
+        value = sxe_jitson_dereference(value);
+
+        switch (sxe_jitson_get_type(value)) {
+        case SXE_JITSON_TYPE_OBJECT:
+            if (depth == count - 1 && op == PATCH_OP_ADD)    // Adding a member that's already there replaces it
+                return true;
+
+            value = sxe_jitson_object_get_member(value, segments[depth], 0);
+            break;
+
+        case SXE_JITSON_TYPE_ARRAY:
+            len = sxe_jitson_len(value);
+
+            if ((idx = patch_index(segments[depth], len)) == ~0U || idx > len)
+                return false;
+
+            if (idx == len)    // Only adds may refer to the end of the array
+                return depth == count - 1 && op == PATCH_OP_ADD;
+
+            value = sxe_jitson_array_get_element(value, idx);
+            break;
+
+        default:
+            return false;
+        }
+
+        if (!value)
+            return false;
+    }
+
+    return true;
+}
+
+/* Add a copy of a value with an operation applied at the path below it to the array or object under construction. The
+ * operation must already have been checked.
+ */
+static bool
+patch_build(struct sxe_jitson_stack *stack, const struct patch_state *state, const struct sxe_jitson *value, char **segments,
+            unsigned count, unsigned op, const struct sxe_jitson *new_value)
+{
+    const struct sxe_jitson *member, *element;
+    size_t                   len;
+    unsigned                 i, idx;
+    bool                     found;
+
+    value = sxe_jitson_dereference(value);
+
+    if (sxe_jitson_get_type(value) == SXE_JITSON_TYPE_OBJECT) {
+        if (!sxe_jitson_stack_open_collection(stack, SXE_JITSON_TYPE_OBJECT))
+            return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+        for (found = false, i = 0, member = value + 1; i < value->len; i++, member = element + sxe_jitson_size(element)) {
+            element = member + sxe_jitson_size(member);
+
+            if (strcmp(sxe_jitson_get_string(member, &len), segments[0]) != 0) {
+                if (!patch_add_member_name(stack, state, member) || !patch_add_shared(stack, state, element))
+                    return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+                continue;
+            }
+
+            found = true;
+
+            if (count == 1 && op == PATCH_OP_REMOVE)
+                continue;
+
+            if (!patch_add_member_name(stack, state, member))
+                return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+            if (!(count == 1 ? sxe_jitson_stack_add_dup(stack, new_value)
+                             : patch_build(stack, state, element, segments + 1, count - 1, op, new_value)))
+                return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+        }
+
+        if (!found && (!sxe_jitson_stack_add_member_name(stack, segments[0], SXE_JITSON_TYPE_IS_COPY)
+                    || !sxe_jitson_stack_add_dup(stack, new_value)))
+            return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+        return sxe_jitson_stack_close_collection(stack);
+    }
+
+    SXEA6(sxe_jitson_get_type(value) == SXE_JITSON_TYPE_ARRAY, "Patch operations must have been checked");
+
+    if (!sxe_jitson_stack_open_collection(stack, SXE_JITSON_TYPE_ARRAY))
+        return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+    idx = patch_index(segments[0], len = sxe_jitson_len(value));
+
+    for (i = 0; i <= len; i++) {
+        element = i < len ? sxe_jitson_array_get_element(value, i) : NULL;
+
+        if (i == idx) {
+            if (count > 1) {
+                if (!patch_build(stack, state, element, segments + 1, count - 1, op, new_value))
+                    return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+                continue;
+            }
+
+            if (op != PATCH_OP_REMOVE && !sxe_jitson_stack_add_dup(stack, new_value))
+                return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+            if (op != PATCH_OP_ADD)    // Removed or replaced elements aren't added
+                continue;
+        }
+
+        if (element && !patch_add_shared(stack, state, element))
+            return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+    }
+
+    return sxe_jitson_stack_close_collection(stack);
+}
+
+/* Apply one operation to a value, returning the result or NULL on error (EINVAL if the operation is invalid or ENOMEM)
+ */
+static struct sxe_jitson *
+patch_apply(const struct patch_state *state, const struct sxe_jitson *operation)
+{
+    struct sxe_jitson_stack *stack;
+    struct sxe_jitson_stack  iou;
+    const struct sxe_jitson *op_string, *path, *new_value = NULL;
+    struct sxe_jitson       *result = NULL;
+    char                   **segments;
+    const char              *pointer;
+    size_t                   len;
+    unsigned                 count, i, op;
+
+    operation = sxe_jitson_dereference(operation);
+
+    if (sxe_jitson_get_type(operation) != SXE_JITSON_TYPE_OBJECT
+     || !(op_string = sxe_jitson_object_get_member(operation, "op", 2))
+     || sxe_jitson_get_type(op_string) != SXE_JITSON_TYPE_STRING
+     || !(path = sxe_jitson_object_get_member(operation, "path", 4))
+     || sxe_jitson_get_type(path) != SXE_JITSON_TYPE_STRING)
+        goto INVALID;
+
+    if (strcmp(sxe_jitson_get_string(op_string, NULL), "add") == 0)
+        op = PATCH_OP_ADD;
+    else if (strcmp(sxe_jitson_get_string(op_string, NULL), "remove") == 0)
+        op = PATCH_OP_REMOVE;
+    else if (strcmp(sxe_jitson_get_string(op_string, NULL), "replace") == 0)
+        op = PATCH_OP_REPLACE;
+    else
+        goto INVALID;
+
+    if (op != PATCH_OP_REMOVE && !(new_value = sxe_jitson_object_get_member(operation, "value", 5)))
+        goto INVALID;
+
+    pointer = sxe_jitson_get_string(path, &len);
+
+    for (count = 1, i = 0; i < len; i++)    // Worst case number of segments
+        count += pointer[i] == '/';
+
+    if (!(segments = kit_malloc(count * sizeof(*segments) + len + 1)))
+        return NULL;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+    memcpy(&segments[count], pointer, len + 1);
+
+    if ((count = patch_split_path((char *)&segments[count], segments)) == ~0U
+     || !patch_check(state->value, segments, count, op) || (count == 0 && op == PATCH_OP_REMOVE)) {
+        kit_free(segments);
+        goto INVALID;
+    }
+
+    if (count == 0)    // Adding or replacing the whole value
+        result = sxe_jitson_dup(new_value);
+    else {
+        stack = sxe_jitson_stack_get_thread();
+        sxe_jitson_stack_borrow(stack, &iou);
+
+        if (patch_build(stack, state, state->value, segments, count, op, new_value))
+            result = sxe_jitson_stack_get_jitson(stack);
+        else
+            sxe_jitson_stack_clear(stack);    /* COVERAGE EXCLUSION: Out of memory condition */
+
+        sxe_jitson_stack_return(stack, &iou);
+    }
+
+    kit_free(segments);
+    return result;
+
+INVALID:
+    SXEL2("Invalid patch operation");
+    errno = EINVAL;
+    return NULL;
+}
+
+/**
+ * Apply a patch to a value
+ *
+ * @param value The value to patch
+ * @param patch An array of RFC 6902 operations, like those returned by sxe_jitson_diff
+ *
+ * @return The patched value or NULL on error (EINVAL if the patch is invalid or can't be applied or ENOMEM)
+ *
+ * @note Only the "add", "remove", and "replace" operations are supported. Operations are applied in order, each rebuilding only
+ *       the arrays and objects along its path. Unchanged members and elements of value are shared by reference, so the result
+ *       must be freed before value is.
+ */
+struct sxe_jitson *
+sxe_jitson_patch(const struct sxe_jitson *value, const struct sxe_jitson *patch)
+{
+    struct patch_state state;
+    struct sxe_jitson *previous = NULL;
+    struct sxe_jitson *result   = NULL;
+    unsigned           i, len;
+
+    patch = sxe_jitson_dereference(patch);
+
+    if (sxe_jitson_get_type(patch) != SXE_JITSON_TYPE_ARRAY) {
+        SXEL2("A patch must be an array, not a %s", sxe_jitson_get_type_as_str(patch));
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if ((len = sxe_jitson_len(patch)) == 0)
+        return sxe_jitson_create_reference(value);
+
+    state.value = value;
+    state.start = state.end = NULL;
+
+    for (i = 0; i < len; i++) {
+        result = patch_apply(&state, sxe_jitson_array_get_element(patch, i));
+
+        if (previous)    // Free the result of the previous operation
+            sxe_jitson_free(previous);
+
+        if (!result)
+            return NULL;
+
+        state.value = state.start = previous = result;
+        state.end   = result + sxe_jitson_size(result);
+    }
+
+    return result;
+}
+
+/* Add the result of merging a patch into a value to the array or object under construction. Members of the value are shared by
+ * reference unless they're patched, members of the patch are duplicated, and null members of the patch are removed.
+ */
+static bool
+merge_build(struct sxe_jitson_stack *stack, const struct sxe_jitson *value, const struct sxe_jitson *patch)
+{
+    const struct sxe_jitson *member, *element, *patched;
+    const char              *name;
+    size_t                   len;
+    unsigned                 i;
+
+    patch = sxe_jitson_dereference(patch);
+
+    if (sxe_jitson_get_type(patch) != SXE_JITSON_TYPE_OBJECT)
+        return sxe_jitson_stack_add_dup(stack, patch);
+
+    if (value && sxe_jitson_get_type(value = sxe_jitson_dereference(value)) != SXE_JITSON_TYPE_OBJECT)
+        value = NULL;    // Merging an object into a non-object replaces it
+
+    if (!sxe_jitson_stack_open_collection(stack, SXE_JITSON_TYPE_OBJECT))
+        return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+    for (i = 0, member = value ? value + 1 : NULL; value && i < value->len; i++, member = element + sxe_jitson_size(element)) {
+        element = member + sxe_jitson_size(member);
+        name    = sxe_jitson_get_string(member, &len);
+        patched = sxe_jitson_object_get_member(patch, name, len);
+
+        if (patched && sxe_jitson_get_type(patched) == SXE_JITSON_TYPE_NULL)    // Null members are removed
+            continue;
+
+        if (!sxe_jitson_stack_add_member_name(stack, name, SXE_JITSON_TYPE_IS_REF))
+            return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+        if (!(patched ? merge_build(stack, element, patched)
+                      : sxe_jitson_size(element) == 1 ? sxe_jitson_stack_add_dup(stack, element)
+                                                      : sxe_jitson_stack_add_reference(stack, element)))
+            return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+    }
+
+    for (i = 0, member = patch + 1; i < patch->len; i++, member = element + sxe_jitson_size(element)) {
+        element = member + sxe_jitson_size(member);
+        name    = sxe_jitson_get_string(member, &len);
+
+        if (sxe_jitson_get_type(element) == SXE_JITSON_TYPE_NULL || (value && sxe_jitson_object_get_member(value, name, len)))
+            continue;
+
+        if (!sxe_jitson_stack_add_member_name(stack, name, SXE_JITSON_TYPE_IS_COPY)
+         || !merge_build(stack, NULL, element))
+            return false;    /* COVERAGE EXCLUSION: Out of memory condition */
+    }
+
+    return sxe_jitson_stack_close_collection(stack);
+}
+
+/**
+ * Merge a patch into a value as specified by RFC 7396 (JSON Merge Patch)
+ *
+ * @param value The value to merge into
+ * @param patch The merge patch. Members of an object patch are merged into the value's members, with null members removing
+ *              them. Any other patch replaces the value.
+ *
+ * @return The merged value or NULL on error (ENOMEM)
+ *
+ * @note Members of value that aren't patched are shared by reference, so the result must be freed before value is.
+ */
+struct sxe_jitson *
+sxe_jitson_merge(const struct sxe_jitson *value, const struct sxe_jitson *patch)
+{
+    struct sxe_jitson_stack *stack;
+    struct sxe_jitson_stack  iou;
+    struct sxe_jitson       *result = NULL;
+
+    if (sxe_jitson_get_type(patch) != SXE_JITSON_TYPE_OBJECT)
+        return sxe_jitson_dup(patch);
+
+    stack = sxe_jitson_stack_get_thread();
+    sxe_jitson_stack_borrow(stack, &iou);
+
+    if (merge_build(stack, value, patch))
+        result = sxe_jitson_stack_get_jitson(stack);
+    else
+        sxe_jitson_stack_clear(stack);    /* COVERAGE EXCLUSION: Out of memory condition */
+
+    sxe_jitson_stack_return(stack, &iou);
+    return result;
+}
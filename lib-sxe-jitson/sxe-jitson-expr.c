@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Compiled expressions. An expression tree of sxe-jitson operators is compiled, by emitting its values and operators in postfix
+ * order, into a list of instructions, each with its own handler. When the type of an operator's argument is known at compile
+ * time (because it is a constant or a typed argument), the operator's implementation for that type is resolved once, and the
+ * instruction calls it directly if the argument has the expected type at run time. Operators whose arguments are all constant
+ * are evaluated at compile time.
+ *
+ * Intermediate results allocated by operators are freed once the whole expression has been evaluated, so that results may
+ * refer to the contents of the values they were computed from.
+ */
+
+#include <alloca.h>
+#include <errno.h>
+#include <string.h>
+
+#include "kit-alloc.h"
+#include "kit-mockfail.h"
+#include "sxe-jitson-expr.h"
+#include "sxe-log.h"
+
+struct sxe_jitson_expr_vm {
+    const struct sxe_jitson  *values[SXE_JITSON_EXPR_MAX_DEPTH];
+    const struct sxe_jitson **owned;        // Intermediate results allocated by operators
+    unsigned                  top;          // Number of values on the stack
+    unsigned                  num_owned;    // Number of intermediate results
+};
+
+struct sxe_jitson_expr_instr;
+typedef bool (*sxe_jitson_expr_exec_t)(const struct sxe_jitson_expr_instr *instr, struct sxe_jitson_expr_vm *vm,
+                                       const struct sxe_jitson *const *args);
+
+struct sxe_jitson_expr_instr {
+    sxe_jitson_expr_exec_t exec;          // Handler for the instruction, specialized when it was compiled
+    union {
+        const struct sxe_jitson   *value;    // Constant value to push
+        unsigned                   arg;      // Index of the argument to push
+        union sxe_jitson_oper_func func;     // Operator's implementation, resolved for type at compile time
+    };
+    unsigned               op;            // Operator to apply
+    uint32_t               type;          // Type func was resolved for
+    bool                   is_owned;      // True if value was allocated by operator evaluated at compile time
+};
+
+struct sxe_jitson_expr {
+    struct sxe_jitson_expr_instr *instrs;
+    unsigned                      count;                                // Number of instructions
+    unsigned                      size;                                 // Number of instructions allocated
+    unsigned                      num_opers;                            // Number of operator instructions
+    unsigned                      depth;                                // Number of values on the stack after the last instruction
+    uint32_t                      types[SXE_JITSON_EXPR_MAX_DEPTH];     // Type of each value on the stack if known at compile time
+    const struct sxe_jitson     **retained;                             // Values allocated at compile time and no longer on the stack
+    unsigned                      num_retained;
+};
+
+/* Handlers for values
+ */
+
+static bool
+exec_value(const struct sxe_jitson_expr_instr *instr, struct sxe_jitson_expr_vm *vm, const struct sxe_jitson *const *args)
+{
+    SXE_UNUSED_PARAMETER(args);
+    vm->values[vm->top++] = instr->value;
+    return true;
+}
+
+static bool
+exec_arg(const struct sxe_jitson_expr_instr *instr, struct sxe_jitson_expr_vm *vm, const struct sxe_jitson *const *args)
+{
+    vm->values[vm->top++] = args[instr->arg];
+    return true;
+}
+
+/* Replace an operator's arguments on the stack with its result, keeping track of it if it was allocated by the operator
+ */
+static inline bool
+vm_push_result(struct sxe_jitson_expr_vm *vm, unsigned num_args, const struct sxe_jitson *result)
+{
+    if (!result)
+        return false;
+
+    vm->top -= num_args;
+
+    if (sxe_jitson_is_allocated(result) && result != vm->values[vm->top] && (num_args == 1 || result != vm->values[vm->top + 1]))
+        vm->owned[vm->num_owned++] = result;
+
+    vm->values[vm->top++] = result;
+    return true;
+}
+
+/* Handlers for unary operators
+ */
+
+static bool
+exec_unary(const struct sxe_jitson_expr_instr *instr, struct sxe_jitson_expr_vm *vm, const struct sxe_jitson *const *args)
+{
+    SXE_UNUSED_PARAMETER(args);
+    return vm_push_result(vm, 1, sxe_jitson_oper_apply_unary(instr->op, vm->values[vm->top - 1]));
+}
+
+static bool
+exec_unary_typed(const struct sxe_jitson_expr_instr *instr, struct sxe_jitson_expr_vm *vm, const struct sxe_jitson *const *args)
+{
+    const struct sxe_jitson *arg = sxe_jitson_dereference(vm->values[vm->top - 1]);
+
+    SXE_UNUSED_PARAMETER(args);
+
+    if (sxe_jitson_get_type_no_deref(arg) != instr->type)    // Argument doesn't have the type expected, so dispatch dynamically
+        return exec_unary(instr, vm, args);
+
+    return vm_push_result(vm, 1, instr->func.unary(arg));
+}
+
+/* Handlers for binary operators
+ */
+
+static bool
+exec_binary(const struct sxe_jitson_expr_instr *instr, struct sxe_jitson_expr_vm *vm, const struct sxe_jitson *const *args)
+{
+    SXE_UNUSED_PARAMETER(args);
+    return vm_push_result(vm, 2, sxe_jitson_oper_apply_binary(vm->values[vm->top - 2], instr->op, vm->values[vm->top - 1]));
+}
+
+static bool
+exec_binary_left_typed(const struct sxe_jitson_expr_instr *instr, struct sxe_jitson_expr_vm *vm,
+                       const struct sxe_jitson *const *args)
+{
+    const struct sxe_jitson *left = sxe_jitson_dereference(vm->values[vm->top - 2]);
+
+    if (sxe_jitson_get_type_no_deref(left) != instr->type)
+        return exec_binary(instr, vm, args);
+
+    return vm_push_result(vm, 2, instr->func.binary(left, sxe_jitson_dereference(vm->values[vm->top - 1])));
+}
+
+static bool
+exec_binary_right_typed(const struct sxe_jitson_expr_instr *instr, struct sxe_jitson_expr_vm *vm,
+                        const struct sxe_jitson *const *args)
+{
+    const struct sxe_jitson *right = sxe_jitson_dereference(vm->values[vm->top - 1]);
+
+    if (sxe_jitson_get_type_no_deref(right) != instr->type)
+        return exec_binary(instr, vm, args);
+
+    return vm_push_result(vm, 2, instr->func.binary(sxe_jitson_dereference(vm->values[vm->top - 2]), right));
+}
+
+/**
+ * Create a new, empty expression
+ *
+ * @return The expression or NULL on failure to allocate memory (ENOMEM)
+ */
+struct sxe_jitson_expr *
+sxe_jitson_expr_new(void)
+{
+    return MOCKERROR(MOCK_FAIL_EXPR_NEW, NULL, ENOMEM, kit_calloc(1, sizeof(struct sxe_jitson_expr)));
+}
+
+/**
+ * Free an expression and any values it allocated when it was compiled
+ */
+void
+sxe_jitson_expr_free(struct sxe_jitson_expr *expr)
+{
+    unsigned i;
+
+    if (!expr)
+        return;
+
+    for (i = 0; i < expr->count; i++)
+        if (expr->instrs[i].exec == exec_value && expr->instrs[i].is_owned)
+            sxe_jitson_free(expr->instrs[i].value);
+
+    for (i = 0; i < expr->num_retained; i++)
+        sxe_jitson_free(expr->retained[i]);
+
+    kit_free(expr->retained);
+    kit_free(expr->instrs);
+    kit_free(expr);
+}
+
+/* Append an instruction to an expression, returning it or NULL on failure to allocate memory
+ */
+static struct sxe_jitson_expr_instr *
+sxe_jitson_expr_append(struct sxe_jitson_expr *expr, sxe_jitson_expr_exec_t exec)
+{
+    struct sxe_jitson_expr_instr *instrs;
+    unsigned                      size;
+
+    if (expr->count == expr->size) {
+        size = expr->size ? 2 * expr->size : 8;
+
+        if (!(instrs = MOCKERROR(MOCK_FAIL_EXPR_APPEND, NULL, ENOMEM, kit_realloc(expr->instrs, size * sizeof(*instrs)))))
+            return NULL;
+
+        expr->instrs = instrs;
+        expr->size   = size;
+    }
+
+    expr->instrs[expr->count].exec     = exec;
+    expr->instrs[expr->count].op       = 0;
+    expr->instrs[expr->count].type     = SXE_JITSON_TYPE_INVALID;
+    expr->instrs[expr->count].is_owned = false;
+    return &expr->instrs[expr->count++];
+}
+
+/**
+ * Compile a constant value into an expression
+ *
+ * @param expr  The expression
+ * @param value The value, which must not be freed before the expression
+ *
+ * @return true on success, false on failure to allocate memory (ENOMEM)
+ */
+bool
+sxe_jitson_expr_push_value(struct sxe_jitson_expr *expr, const struct sxe_jitson *value)
+{
+    struct sxe_jitson_expr_instr *instr;
+
+    SXEA1(expr->depth < SXE_JITSON_EXPR_MAX_DEPTH, "Expressions can't be more than %u values deep", SXE_JITSON_EXPR_MAX_DEPTH);
+
+    if (!(instr = sxe_jitson_expr_append(expr, exec_value)))
+        return false;
+
+    instr->value               = value;
+    expr->types[expr->depth++] = sxe_jitson_get_type(value);
+    return true;
+}
+
+/**
+ * Compile an argument into an expression
+ *
+ * @param expr The expression
+ * @param arg  Index of the argument in the array passed to sxe_jitson_expr_eval
+ * @param type Type the argument is expected to have, or SXE_JITSON_TYPE_INVALID if not known
+ *
+ * @return true on success, false on failure to allocate memory (ENOMEM)
+ *
+ * @note Operators applied to an argument of a known type call the type's implementation directly when the argument has it
+ */
+bool
+sxe_jitson_expr_push_arg(struct sxe_jitson_expr *expr, unsigned arg, uint32_t type)
+{
+    struct sxe_jitson_expr_instr *instr;
+
+    SXEA1(expr->depth < SXE_JITSON_EXPR_MAX_DEPTH, "Expressions can't be more than %u values deep", SXE_JITSON_EXPR_MAX_DEPTH);
+
+    if (!(instr = sxe_jitson_expr_append(expr, exec_arg)))
+        return false;
+
+    instr->arg                 = arg;
+    expr->types[expr->depth++] = type;
+    return true;
+}
+
+/* Evaluate an operator whose arguments are the constants compiled by the last instructions, replacing them with the result
+ */
+static bool
+sxe_jitson_expr_fold(struct sxe_jitson_expr *expr, unsigned op, unsigned num_args)
+{
+    struct sxe_jitson_expr_instr *args = &expr->instrs[expr->count - num_args];
+    const struct sxe_jitson     **retained;
+    const struct sxe_jitson      *result;
+    unsigned                      i;
+    bool                          is_owned;
+
+    if (!(retained = kit_realloc(expr->retained, (expr->num_retained + num_args) * sizeof(*retained))))
+        return false;    /* COVERAGE EXCLUSION: Out of memory; the operator will just be evaluated at run time */
+
+    expr->retained = retained;
+    result         = num_args == 1 ? sxe_jitson_oper_apply_unary(op, args[0].value)
+                                   : sxe_jitson_oper_apply_binary(args[0].value, op, args[1].value);
+
+    if (!result) {    // Leave errors to be reported at run time
+        SXEL6("Failed to evaluate operator '%s' on constants: %s", sxe_jitson_oper_get_name(op), strerror(errno));
+        return false;
+    }
+
+    is_owned = sxe_jitson_is_allocated(result);
+
+    for (i = 0; i < num_args; i++)
+        if (result == args[i].value)    // The operator returned one of its arguments
+            is_owned = args[i].is_owned;
+        else if (args[i].is_owned)      // The result may refer to the argument, so keep it until the expression is freed
+            expr->retained[expr->num_retained++] = args[i].value;
+
+    expr->count                  -= num_args - 1;
+    expr->depth                  -= num_args - 1;
+    expr->types[expr->depth - 1]  = sxe_jitson_get_type(result);
+    args[0].value                 = result;
+    args[0].is_owned              = is_owned;
+    return true;
+}
+
+/**
+ * Compile an operator into an expression
+ *
+ * @param expr The expression
+ * @param op   The operator, which is applied to the value compiled last if unary, or the last two values if binary
+ *
+ * @return true on success, false on failure to allocate memory (ENOMEM)
+ */
+bool
+sxe_jitson_expr_push_oper(struct sxe_jitson_expr *expr, unsigned op)
+{
+    struct sxe_jitson_expr_instr *instr;
+    union sxe_jitson_oper_func    func;
+    sxe_jitson_expr_exec_t        exec;
+    unsigned                      flags    = sxe_jitson_oper_get_flags(op);
+    unsigned                      num_args = flags & SXE_JITSON_OPER_BINARY ? 2 : 1;
+    uint32_t                      type;
+
+    SXEA1(expr->depth >= num_args, "Operator '%s' needs %u arguments but only %u are compiled", sxe_jitson_oper_get_name(op),
+          num_args, expr->depth);
+
+    /* If all of the arguments are constants, the last instructions push them, so try to evaluate the operator now
+     */
+    if (expr->instrs[expr->count - 1].exec == exec_value && (num_args == 1 || expr->instrs[expr->count - 2].exec == exec_value)
+     && sxe_jitson_expr_fold(expr, op, num_args))
+        return true;
+
+    /* If the type of the argument that determines the implementation is known, resolve the implementation now
+     */
+    type = num_args == 1 || (flags & SXE_JITSON_OPER_TYPE_RIGHT) ? expr->types[expr->depth - 1] : expr->types[expr->depth - 2];
+    func = type == SXE_JITSON_TYPE_INVALID ? sxe_jitson_oper_func_null : sxe_jitson_oper_resolve(op, type);
+
+    if (!func.unary)
+        exec = num_args == 1 ? exec_unary : exec_binary;
+    else
+        exec = num_args == 1 ? exec_unary_typed : flags & SXE_JITSON_OPER_TYPE_RIGHT ? exec_binary_right_typed
+                                                                                     : exec_binary_left_typed;
+
+    if (!(instr = sxe_jitson_expr_append(expr, exec)))
+        return false;
+
+    instr->func                   = func;
+    instr->op                     = op;
+    instr->type                   = type;
+    expr->num_opers++;
+    expr->depth                  -= num_args - 1;
+    expr->types[expr->depth - 1]  = SXE_JITSON_TYPE_INVALID;    // The type of an operator's result is not known
+    return true;
+}
+
+/**
+ * Evaluate a compiled expression
+ *
+ * @param expr The expression, which must leave exactly one value on the stack
+ * @param args The values of the expression's arguments, or NULL if it has none
+ *
+ * @return The result or NULL on error. As with operators, the result must be freed by the caller with sxe_jitson_free.
+ *
+ * @note During a request (see sxe_jitson_arena_begin_request), the result may be allocated from the thread's arena, in which
+ *       case freeing it does nothing and it is freed when the request ends.
+ */
+const struct sxe_jitson *
+sxe_jitson_expr_eval(const struct sxe_jitson_expr *expr, const struct sxe_jitson *const *args)
+{
+    struct sxe_jitson_expr_vm vm;
+    struct sxe_jitson_stack  *stack = NULL;
+    struct sxe_jitson_arena  *arena, *saved = NULL;
+    const struct sxe_jitson  *result = NULL;
+    unsigned                  i;
+    bool                      is_owned;
+
+    SXEA1(expr->depth == 1, "An expression must compute 1 value, not %u", expr->depth);
+    vm.owned     = alloca(expr->num_opers * sizeof(*vm.owned));
+    vm.top       = 0;
+    vm.num_owned = 0;
+
+    /* During a request, the operators' results are gotten from the thread's stack into the thread's arena for this call only
+     */
+    if ((arena = sxe_jitson_arena_get_request()) && (stack = sxe_jitson_stack_get_thread())) {
+        saved = stack->arena;
+        sxe_jitson_stack_use_arena(stack, arena);
+    }
+
+    for (i = 0; i < expr->count; i++)
+        if (!expr->instrs[i].exec(&expr->instrs[i], &vm, args))
+            goto OUT;
+
+    result = vm.values[0];
+
+    for (is_owned = false, i = 0; i < vm.num_owned; i++)
+        if (vm.owned[i] == result)
+            is_owned = true;
+        else if (result >= vm.owned[i] && result < vm.owned[i] + sxe_jitson_size(vm.owned[i])) {
+            result   = arena ? sxe_jitson_arena_dup(arena, result) : sxe_jitson_dup(result);    // Part of a value being freed
+            is_owned = true;
+            break;
+        }
+
+    /* Values that weren't allocated by the expression's operators are returned by reference so the caller can free them. During
+     * a request, the copies and references are allocated from the thread's arena.
+     */
+    if (!is_owned && sxe_jitson_is_allocated(result))
+        result = arena ? sxe_jitson_arena_reference(arena, result) : sxe_jitson_create_reference(result);
+
+OUT:
+    for (i = 0; i < vm.num_owned; i++)
+        if (vm.owned[i] != result)
+            sxe_jitson_free(vm.owned[i]);
+
+    if (stack)
+        sxe_jitson_stack_use_arena(stack, saved);
+
+    return result;
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SXE_JITSON_EXPR_H
+#define SXE_JITSON_EXPR_H
+
+#include "sxe-jitson-oper.h"
+
+#define SXE_JITSON_EXPR_MAX_DEPTH 32    // Maximum number of values on the stack of an expression being evaluated
+
+struct sxe_jitson_expr;    // A compiled expression; see sxe-jitson-expr.c
+
+#include "sxe-jitson-expr-proto.h"
+
+#define MOCK_FAIL_EXPR_NEW    ((char *)sxe_jitson_expr_new + 0)
+#define MOCK_FAIL_EXPR_APPEND ((char *)sxe_jitson_expr_new + 1)
+
+#endif
@@ -49,8 +49,8 @@ sxe_jitson_in_array(const struct sxe_jitson *left, const struct sxe_jitson *righ
 {
     struct kit_sortedarray_class array_class;
     const struct sxe_jitson     *element, *result;
-    size_t                       len;
-    unsigned                     i;
+    size_t                       len, stop;
+    unsigned                     found, i, unhashed;
     uint32_t                     left_type;
 
     SXEA6(sxe_jitson_get_type(right) == SXE_JITSON_TYPE_ARRAY,
@@ -94,7 +94,20 @@ sxe_jitson_in_array(const struct sxe_jitson *left, const struct sxe_jitson *righ
         return match ? sxe_jitson_true : sxe_jitson_null;
     }
 
-    for (i = 0, len = sxe_jitson_len(right); i < len; i++) {    // For each element in the array
+    i    = 0;
+    len  = sxe_jitson_len(right);
+    stop = len;
+
+    /* If the array is large, use a hash set of its elements for O(1). Elements before the first equal element that can't be
+     * hashed (e.g. nested arrays) must still be checked for the value (transitive IN operation).
+     */
+    if (sxe_jitson_array_is_hashed(right) && sxe_jitson_is_hashable(left)
+     && (found = sxe_jitson_array_find(right, left, &unhashed)) != ~0U) {
+        i    = unhashed;
+        stop = found;
+    }
+
+    for (; i < stop; i++) {    // For each element in the array that needs to be checked
         element = sxe_jitson_array_get_element(right, i);
 
         if (left_type == sxe_jitson_get_type(element)) {
@@ -108,7 +121,7 @@ sxe_jitson_in_array(const struct sxe_jitson *left, const struct sxe_jitson *righ
             return element;    // Safe to return, because a containing value cannot test false
     }
 
-    return sxe_jitson_null;
+    return stop < len ? sxe_jitson_true : sxe_jitson_null;
 }
 
 /* Default implementation of IN for sxe-jitson standard types
@@ -21,6 +21,10 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <errno.h>
+#include <string.h>
+
+#include "kit-alloc.h"
 #include "kit-mockfail.h"
 #include "kit-sortedarray.h"
 #include "sxe-jitson-in.h"
@@ -109,6 +113,145 @@ close_array_and_get(struct sxe_jitson_stack *stack)
     return jitson;
 }
 
+#define GALLOP_RATIO 32    // If one array is this many times longer than the other, gallop through it instead of merging
+
+/* Ordered arrays of unsigned integers or strings of up to 7 characters, each in one jitson, can be intersected by comparing the
+ * raw 8 byte values of their elements as unsigned integers.
+ */
+static inline bool
+can_intersect_raw(const struct sxe_jitson *left, const struct sxe_jitson *right)
+{
+    uint32_t type = sxe_jitson_get_type_no_deref(&left[1]);
+
+    return left->uniform.size == sizeof(*left) && (left->type & right->type & SXE_JITSON_TYPE_IS_HOMO)
+        && (type == SXE_JITSON_TYPE_NUMBER || type == SXE_JITSON_TYPE_STRING) && type == sxe_jitson_get_type_no_deref(&right[1]);
+}
+
+/* Get the raw key of an element of an array being intersected, returning false if the element can't be compared by its key.
+ * Homogenous arrays of numbers can include doubles, and of strings can include references, so each element must be checked.
+ */
+static inline bool
+raw_key(const struct sxe_jitson *element, uint64_t *key)
+{
+    uint64_t nuls;
+
+    switch (element->type & (SXE_JITSON_TYPE_MASK | SXE_JITSON_TYPE_IS_UINT | SXE_JITSON_TYPE_IS_REF)) {
+    case SXE_JITSON_TYPE_NUMBER | SXE_JITSON_TYPE_IS_UINT:
+        *key = element->integer;
+        return true;
+
+    case SXE_JITSON_TYPE_STRING:    // An inline string; mask out any bytes after the NUL, then compare as a big endian number
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        nuls = (element->integer - 0x0101010101010101ULL) & ~element->integer & 0x8080808080808080ULL;    // Lowest bit exact
+        *key = __builtin_bswap64(element->integer & (((nuls & -nuls) >> 7) - 1));
+#else
+        nuls = strnlen(element->string, sizeof(element->string));
+        *key = nuls ? element->integer & ~0ULL << (64 - 8 * nuls) : 0;
+#endif
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/* Find the first element of an ordered uniform array from idx on whose key is >= key, probing exponentially further ahead then
+ * binary searching. Returns the element's index, count if there is none, or ~0U if an element can't be compared by its key.
+ */
+static unsigned
+gallop(const struct sxe_jitson *array, unsigned idx, unsigned count, uint64_t key)
+{
+    uint64_t probe_key;
+    unsigned low, high, mid, step;
+
+    for (low = idx, step = 1; (high = low + step) < count; low = high + 1, step *= 2) {
+        if (!raw_key(&array[1 + high], &probe_key))
+            return ~0U;
+
+        if (probe_key >= key)
+            break;
+    }
+
+    high = high < count ? high : count;    // The element >= key is in [low, high]; high == count if there's none
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+
+        if (!raw_key(&array[1 + mid], &probe_key))
+            return ~0U;
+
+        if (probe_key < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+/* Intersect ordered uniform arrays by comparing raw keys, saving the indices of matching left elements in ascending order.
+ * Galloping is used when one array is much longer than the other, and a branch free merge otherwise. Equal elements are matched
+ * pairwise. Returns the number of matches found, stopping at max, or ~0U if an element can't be compared by its key.
+ */
+static unsigned
+intersect_raw(const struct sxe_jitson *left, const struct sxe_jitson *right, unsigned *matches, unsigned max)
+{
+    uint64_t key_left, key_right;
+    unsigned i = 0, j = 0, count = 0;
+
+    if ((uint64_t)left->len * GALLOP_RATIO <= right->len) {    // Left is much shorter; look each element up in right
+        for (; i < left->len && count < max; i++, j++) {
+            if (!raw_key(&left[1 + i], &key_left) || (j = gallop(right, j, right->len, key_left)) == ~0U)
+                return ~0U;
+
+            if (j >= right->len)
+                break;
+
+            if (!raw_key(&right[1 + j], &key_right))
+                return ~0U;    /* COVERAGE EXCLUSION: gallop already got the key of every element it returns */
+
+            if (key_right == key_left)
+                matches[count++] = i;
+            else
+                j--;    // Not consumed
+        }
+
+        return count;
+    }
+
+    if ((uint64_t)right->len * GALLOP_RATIO <= left->len) {    // Right is much shorter; look each element up in left
+        for (; j < right->len && count < max; i++, j++) {
+            if (!raw_key(&right[1 + j], &key_right) || (i = gallop(left, i, left->len, key_right)) == ~0U)
+                return ~0U;
+
+            if (i >= left->len)
+                break;
+
+            if (!raw_key(&left[1 + i], &key_left))
+                return ~0U;    /* COVERAGE EXCLUSION: gallop already got the key of every element it returns */
+
+            if (key_left == key_right)
+                matches[count++] = i;
+            else
+                i--;    // Not consumed
+        }
+
+        return count;
+    }
+
+    while (i < left->len && j < right->len && count < max) {    // Merge, advancing past the smaller key or both if equal
+        if (!raw_key(&left[1 + i], &key_left) || !raw_key(&right[1 + j], &key_right))
+            return ~0U;
+
+        matches[count] = i;
+        count         += key_left == key_right;
+        i             += key_left <= key_right;
+        j             += key_right <= key_left;
+    }
+
+    return count;
+}
+
 /* Implementation of INTERSECT for an ordered sxe-jitson array type
  */
 static const struct sxe_jitson *
@@ -117,7 +260,9 @@ sxe_jitson_intersect_ordered_array(const struct sxe_jitson *left, const struct s
     struct kit_sortedarray_class array_class;
     struct sxe_jitson_stack     *stack;
     const struct sxe_jitson     *elem_lhs, *elem_rhs, *json = NULL;
+    unsigned                    *matches;
     size_t                       i, len_lhs;
+    unsigned                     count, max;
 
     SXEA6(sxe_jitson_get_type(right) == SXE_JITSON_TYPE_ARRAY,
           "Right hand side of an array INTERSECT expression cannot be JSON type %s", sxe_jitson_get_type_as_str(right));
@@ -145,6 +290,28 @@ sxe_jitson_intersect_ordered_array(const struct sxe_jitson *left, const struct s
             if (left->uniform.size != right->uniform.size)
                 goto EARLY_OUT;
 
+            if (can_intersect_raw(left, right)) {
+                max = left->len < right->len ? left->len : right->len;
+
+                if (!(matches = MOCKERROR(SXE_JITSON_INTERSECT_RAW, NULL, ENOMEM, kit_malloc(max * sizeof(*matches))))) {
+                    SXEL2(": Failed to allocate %u matches for an INTERSECT expression", max);
+                    goto ERROR_OUT;
+                }
+
+                if ((count = intersect_raw(left, right, matches, max)) != ~0U) {
+                    for (i = 0; i < count; i++)
+                        if (!intersect_add_element(stack, &left[1 + matches[i]])) {
+                            kit_free(matches);
+                            goto ERROR_OUT;
+                        }
+
+                    kit_free(matches);
+                    goto EARLY_OUT;
+                }
+
+                kit_free(matches);    // Some elements can't be compared by their keys, so do a normal intersection
+            }
+
             array_class.elem_class.size = left->uniform.size;
             array_class.elem_class.cmp  = (int (*)(const void *, const void *))sxe_jitson_cmp;
             array_class.visit           = intersect_add_element;
@@ -202,7 +369,9 @@ sxe_jitson_intersect_array(const struct sxe_jitson *left, const struct sxe_jitso
     struct sxe_jitson_stack     *stack;
     const struct sxe_jitson     *elem_lhs, *elem_rhs, *json = NULL;
     size_t                       i, j, len_lhs, len_rhs;
+    unsigned                     found;
     int                          ret;
+    bool                         hashed;
 
     SXEA6(sxe_jitson_get_type(right) == SXE_JITSON_TYPE_ARRAY,
           "Right hand side of an array INTERSECT expression cannot be JSON type %s", sxe_jitson_get_type_as_str(right));
@@ -221,10 +390,18 @@ sxe_jitson_intersect_array(const struct sxe_jitson *left, const struct sxe_jitso
         return NULL;
 
     len_lhs = sxe_jitson_len(left);
+    hashed  = sxe_jitson_array_is_hashed(right);
 
     for (i = 0; i < len_lhs; i++) {
         elem_lhs = sxe_jitson_array_get_element(left, i);
 
+        if (hashed && sxe_jitson_is_hashable(elem_lhs) && (found = sxe_jitson_array_find(right, elem_lhs, NULL)) != ~0U) {
+            if (found < right->len && !add_to_array(stack, elem_lhs))
+                goto ERROR_OUT;
+
+            continue;
+        }
+
         for (j = 0, len_rhs = sxe_jitson_len(right); j < len_rhs; j++) {
             elem_rhs = sxe_jitson_array_get_element(right, j);
 
@@ -262,6 +439,7 @@ sxe_jitson_intersect_test_ordered_array(const struct sxe_jitson *left, const str
     struct kit_sortedarray_class array_class;
     const struct sxe_jitson     *elem_lhs, *elem_rhs;
     size_t                       i, len_lhs;
+    unsigned                     count, match;
     bool                         found;
 
     SXEA6(sxe_jitson_get_type(right) == SXE_JITSON_TYPE_ARRAY,
@@ -288,6 +466,9 @@ sxe_jitson_intersect_test_ordered_array(const struct sxe_jitson *left, const str
             if (left->uniform.size != right->uniform.size)    // Different sized elements can't intersect
                 return sxe_jitson_false;
 
+            if (can_intersect_raw(left, right) && (count = intersect_raw(left, right, &match, 1)) != ~0U)
+                return count ? sxe_jitson_true : sxe_jitson_false;
+
             array_class.elem_class.size = left->uniform.size;
             array_class.elem_class.cmp  = (int (*)(const void *, const void *))sxe_jitson_cmp;
             array_class.visit           = intersect_check_element;
@@ -347,7 +528,9 @@ sxe_jitson_intersect_test_array(const struct sxe_jitson *left, const struct sxe_
 {
     const struct sxe_jitson     *elem_lhs, *elem_rhs;
     size_t                       i, j, len_lhs, len_rhs;
+    unsigned                     found;
     int                          ret;
+    bool                         hashed;
 
     SXEA6(sxe_jitson_get_type(right) == SXE_JITSON_TYPE_ARRAY,
           "Right hand side of an array INTERSECT expression cannot be JSON type %s", sxe_jitson_get_type_as_str(right));
@@ -363,10 +546,18 @@ sxe_jitson_intersect_test_array(const struct sxe_jitson *left, const struct sxe_
     }
 
     len_lhs = sxe_jitson_len(left);
+    hashed  = sxe_jitson_array_is_hashed(right);
 
     for (i = 0; i < len_lhs; i++) {
         elem_lhs = sxe_jitson_array_get_element(left, i);
 
+        if (hashed && sxe_jitson_is_hashable(elem_lhs) && (found = sxe_jitson_array_find(right, elem_lhs, NULL)) != ~0U) {
+            if (found < right->len)
+                return sxe_jitson_true;
+
+            continue;
+        }
+
         for (j = 0, len_rhs = sxe_jitson_len(right); j < len_rhs; j++) {
             elem_rhs = sxe_jitson_array_get_element(right, j);
 
@@ -13,6 +13,7 @@ extern unsigned sxe_jitson_oper_intersect_test;
 #   define SXE_JITSON_INTERSECT_ADD         ((const char *)sxe_jitson_intersect_init + 2)
 #   define SXE_JITSON_INTERSECT_ADD_INDEXED ((const char *)sxe_jitson_intersect_init + 3)
 #   define SXE_JITSON_INTERSECT_GET         ((const char *)sxe_jitson_intersect_init + 4)
+#   define SXE_JITSON_INTERSECT_RAW         ((const char *)sxe_jitson_intersect_init + 5)
 #endif
 
 #endif
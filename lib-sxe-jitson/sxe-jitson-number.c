@@ -0,0 +1,772 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Fast formatting and parsing of numbers as JSON. Doubles are formatted using the Grisu2 algorithm (Florian Loitsch, "Printing
+ * Floating-Point Numbers Quickly and Accurately with Integers", PLDI 2010), which produces the shortest (or in rare cases,
+ * nearly shortest) string of digits that reads back as the same double. Doubles are parsed using Clinger's fast path for
+ * small exact values and the Eisel-Lemire algorithm (Daniel Lemire, "Number Parsing at a Gigabyte per Second", 2021) for
+ * the rest, falling back to strtod only for the rare values that can't be correctly rounded from a 64 bit product.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sxe-jitson.h"
+
+struct diy_fp {
+    uint64_t f;    // Significand
+    int      e;    // Binary exponent
+};
+
+#define DP_SIGNIFICAND_SIZE 52
+#define DP_EXPONENT_BIAS    (0x3FF + DP_SIGNIFICAND_SIZE)
+#define DP_HIDDEN_BIT       0x0010000000000000ULL
+#define DP_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFULL
+#define DP_EXPONENT_MASK    0x7FF0000000000000ULL
+
+/* Normalized 64 bit significands and binary exponents of the powers of ten 10^-348, 10^-340, ..., 10^340
+ */
+static const struct {
+    uint64_t f;
+    int16_t  e;
+} cached_powers[] = {
+    {0xfa8fd5a0081c0288ULL, -1220}, {0xbaaee17fa23ebf76ULL, -1193}, {0x8b16fb203055ac76ULL, -1166},
+    {0xcf42894a5dce35eaULL, -1140}, {0x9a6bb0aa55653b2dULL, -1113}, {0xe61acf033d1a45dfULL, -1087},
+    {0xab70fe17c79ac6caULL, -1060}, {0xff77b1fcbebcdc4fULL, -1034}, {0xbe5691ef416bd60cULL, -1007},
+    {0x8dd01fad907ffc3cULL,  -980}, {0xd3515c2831559a83ULL,  -954}, {0x9d71ac8fada6c9b5ULL,  -927},
+    {0xea9c227723ee8bcbULL,  -901}, {0xaecc49914078536dULL,  -874}, {0x823c12795db6ce57ULL,  -847},
+    {0xc21094364dfb5637ULL,  -821}, {0x9096ea6f3848984fULL,  -794}, {0xd77485cb25823ac7ULL,  -768},
+    {0xa086cfcd97bf97f4ULL,  -741}, {0xef340a98172aace5ULL,  -715}, {0xb23867fb2a35b28eULL,  -688},
+    {0x84c8d4dfd2c63f3bULL,  -661}, {0xc5dd44271ad3cdbaULL,  -635}, {0x936b9fcebb25c996ULL,  -608},
+    {0xdbac6c247d62a584ULL,  -582}, {0xa3ab66580d5fdaf6ULL,  -555}, {0xf3e2f893dec3f126ULL,  -529},
+    {0xb5b5ada8aaff80b8ULL,  -502}, {0x87625f056c7c4a8bULL,  -475}, {0xc9bcff6034c13053ULL,  -449},
+    {0x964e858c91ba2655ULL,  -422}, {0xdff9772470297ebdULL,  -396}, {0xa6dfbd9fb8e5b88fULL,  -369},
+    {0xf8a95fcf88747d94ULL,  -343}, {0xb94470938fa89bcfULL,  -316}, {0x8a08f0f8bf0f156bULL,  -289},
+    {0xcdb02555653131b6ULL,  -263}, {0x993fe2c6d07b7facULL,  -236}, {0xe45c10c42a2b3b06ULL,  -210},
+    {0xaa242499697392d3ULL,  -183}, {0xfd87b5f28300ca0eULL,  -157}, {0xbce5086492111aebULL,  -130},
+    {0x8cbccc096f5088ccULL,  -103}, {0xd1b71758e219652cULL,   -77}, {0x9c40000000000000ULL,   -50},
+    {0xe8d4a51000000000ULL,   -24}, {0xad78ebc5ac620000ULL,     3}, {0x813f3978f8940984ULL,    30},
+    {0xc097ce7bc90715b3ULL,    56}, {0x8f7e32ce7bea5c70ULL,    83}, {0xd5d238a4abe98068ULL,   109},
+    {0x9f4f2726179a2245ULL,   136}, {0xed63a231d4c4fb27ULL,   162}, {0xb0de65388cc8ada8ULL,   189},
+    {0x83c7088e1aab65dbULL,   216}, {0xc45d1df942711d9aULL,   242}, {0x924d692ca61be758ULL,   269},
+    {0xda01ee641a708deaULL,   295}, {0xa26da3999aef774aULL,   322}, {0xf209787bb47d6b85ULL,   348},
+    {0xb454e4a179dd1877ULL,   375}, {0x865b86925b9bc5c2ULL,   402}, {0xc83553c5c8965d3dULL,   428},
+    {0x952ab45cfa97a0b3ULL,   455}, {0xde469fbd99a05fe3ULL,   481}, {0xa59bc234db398c25ULL,   508},
+    {0xf6c69a72a3989f5cULL,   534}, {0xb7dcbf5354e9beceULL,   561}, {0x88fcf317f22241e2ULL,   588},
+    {0xcc20ce9bd35c78a5ULL,   614}, {0x98165af37b2153dfULL,   641}, {0xe2a0b5dc971f303aULL,   667},
+    {0xa8d9d1535ce3b396ULL,   694}, {0xfb9b7cd9a4a7443cULL,   720}, {0xbb764c4ca7a44410ULL,   747},
+    {0x8bab8eefb6409c1aULL,   774}, {0xd01fef10a657842cULL,   800}, {0x9b10a4e5e9913129ULL,   827},
+    {0xe7109bfba19c0c9dULL,   853}, {0xac2820d9623bf429ULL,   880}, {0x80444b5e7aa7cf85ULL,   907},
+    {0xbf21e44003acdd2dULL,   933}, {0x8e679c2f5e44ff8fULL,   960}, {0xd433179d9c8cb841ULL,   986},
+    {0x9e19db92b4e31ba9ULL,  1013}, {0xeb96bf6ebadf77d9ULL,  1039}, {0xaf87023b9bf0ee6bULL,  1066}
+};
+
+static const uint64_t pow10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+    10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+    10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static const char digit_pairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                                  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                                  "8081828384858687888990919293949596979899";
+
+static inline struct diy_fp
+diy_fp_mul(struct diy_fp x, struct diy_fp y)
+{
+    uint64_t      a   = x.f >> 32, b = x.f & 0xFFFFFFFF, c = y.f >> 32, d = y.f & 0xFFFFFFFF;
+    uint64_t      ac  = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t      tmp = (bd >> 32) + (ad & 0xFFFFFFFF) + (bc & 0xFFFFFFFF) + (1ULL << 31);    // Round the low half
+    struct diy_fp ret = {ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64};
+
+    return ret;
+}
+
+static inline struct diy_fp
+diy_fp_normalize(struct diy_fp x)
+{
+    int shift = __builtin_clzll(x.f);
+
+    x.f <<= shift;
+    x.e  -= shift;
+    return x;
+}
+
+/* Compute the normalized boundaries m- and m+ of the interval of reals that round to the double v
+ */
+static void
+diy_fp_normalized_boundaries(struct diy_fp v, struct diy_fp *minus, struct diy_fp *plus)
+{
+    struct diy_fp pl = {(v.f << 1) + 1, v.e - 1};
+    struct diy_fp mi;
+
+    while (!(pl.f & (DP_HIDDEN_BIT << 1))) {
+        pl.f <<= 1;
+        pl.e--;
+    }
+
+    pl.f <<= 64 - DP_SIGNIFICAND_SIZE - 2;
+    pl.e  -= 64 - DP_SIGNIFICAND_SIZE - 2;
+
+    if (v.f == DP_HIDDEN_BIT) {    // The lower boundary is closer for powers of 2
+        mi.f = (v.f << 2) - 1;
+        mi.e = v.e - 2;
+    } else {
+        mi.f = (v.f << 1) - 1;
+        mi.e = v.e - 1;
+    }
+
+    mi.f <<= mi.e - pl.e;
+    mi.e   = pl.e;
+    *minus = mi;
+    *plus  = pl;
+}
+
+/* Get the cached power of ten c such that the binary exponent of e * c is in the range [-60, -32]. Sets *k to -log10(c).
+ */
+static inline struct diy_fp
+cached_power(int e, int *k)
+{
+    double        dk = (-61 - e) * 0.30102999566398114 + 347;    // dk must be positive, so can do ceiling in positive
+    int           ik = (int)dk;
+    unsigned      index;
+    struct diy_fp ret;
+
+    if (dk - ik > 0.0)
+        ik++;
+
+    index = (unsigned)((ik >> 3) + 1);
+    *k    = -(-348 + (int)(index << 3));    // Decimal exponent no need lookup table
+    ret.f = cached_powers[index].f;
+    ret.e = cached_powers[index].e;
+    return ret;
+}
+
+static inline unsigned
+count_decimal_digits32(uint32_t n)
+{
+    unsigned digits;
+
+    for (digits = 1; digits < 10 && n >= pow10[digits]; digits++) {
+    }
+
+    return digits;
+}
+
+/* Move the last digit down while the result is still in range and closer to the exact value
+ */
+static inline void
+grisu_round(char *buffer, unsigned len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
+{
+    while (rest < wp_w && delta - rest >= ten_kappa
+        && (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+/* Generate the shortest digits of w that are within delta of the upper boundary mp
+ */
+static unsigned
+grisu_digit_gen(struct diy_fp w, struct diy_fp mp, uint64_t delta, char *buffer, int *k)
+{
+    struct diy_fp one   = {1ULL << -mp.e, mp.e};
+    uint64_t      wp_w  = mp.f - w.f;
+    uint32_t      p1    = (uint32_t)(mp.f >> -one.e);
+    uint64_t      p2    = mp.f & (one.f - 1);
+    int           kappa = (int)count_decimal_digits32(p1);
+    unsigned      len   = 0;
+    uint64_t      tmp;
+    uint32_t      digit;
+    int           index;
+
+    while (kappa > 0) {
+        digit = (uint32_t)(p1 / pow10[kappa - 1]);
+        p1    = (uint32_t)(p1 % pow10[kappa - 1]);
+
+        if (digit || len)
+            buffer[len++] = (char)('0' + digit);
+
+        kappa--;
+
+        if ((tmp = ((uint64_t)p1 << -one.e) + p2) <= delta) {
+            *k += kappa;
+            grisu_round(buffer, len, delta, tmp, pow10[kappa] << -one.e, wp_w);
+            return len;
+        }
+    }
+
+    for (;;) {    // kappa == 0
+        p2    *= 10;
+        delta *= 10;
+        digit  = (uint32_t)(p2 >> -one.e);
+
+        if (digit || len)
+            buffer[len++] = (char)('0' + digit);
+
+        p2 &= one.f - 1;
+        kappa--;
+
+        if (p2 < delta) {
+            *k   += kappa;
+            index = -kappa;
+            grisu_round(buffer, len, delta, p2, one.f, wp_w * (index < 20 ? pow10[index] : 0));
+            return len;
+        }
+    }
+}
+
+/* Generate the digits of a positive, finite, nonzero double. The value is buffer * 10^*k. Returns the number of digits.
+ */
+static unsigned
+grisu2(double value, char *buffer, int *k)
+{
+    struct diy_fp v, w_m, w_p, c_mk, w;
+    uint64_t      bits;
+    int           biased_e;
+
+    memcpy(&bits, &value, sizeof(bits));
+    biased_e = (int)((bits & DP_EXPONENT_MASK) >> DP_SIGNIFICAND_SIZE);
+    v.f      = bits & DP_SIGNIFICAND_MASK;
+
+    if (biased_e != 0) {
+        v.f += DP_HIDDEN_BIT;
+        v.e  = biased_e - DP_EXPONENT_BIAS;
+    } else
+        v.e = 1 - DP_EXPONENT_BIAS;    // Denormal
+
+    diy_fp_normalized_boundaries(v, &w_m, &w_p);
+    c_mk = cached_power(w_p.e, k);
+    w    = diy_fp_mul(diy_fp_normalize(v), c_mk);
+    w_p  = diy_fp_mul(w_p, c_mk);
+    w_m  = diy_fp_mul(w_m, c_mk);
+    w_m.f++;
+    w_p.f--;
+    return grisu_digit_gen(w, w_p, w_p.f - w_m.f, buffer, k);
+}
+
+/**
+ * Format an unsigned integer in decimal
+ *
+ * @param value  The unsigned integer
+ * @param buffer A buffer of at least SXE_JITSON_NUMBER_MAX_LEN + 1 bytes
+ *
+ * @return The length of the formatted number, which is '\0' terminated
+ */
+unsigned
+sxe_jitson_uint_to_str(uint64_t value, char *buffer)
+{
+    char     digits[20];
+    unsigned len, pos = sizeof(digits);
+
+    while (value >= 100) {
+        pos -= 2;
+        memcpy(&digits[pos], &digit_pairs[(value % 100) * 2], 2);
+        value /= 100;
+    }
+
+    if (value >= 10) {
+        pos -= 2;
+        memcpy(&digits[pos], &digit_pairs[value * 2], 2);
+    } else
+        digits[--pos] = (char)('0' + value);
+
+    memcpy(buffer, &digits[pos], len = sizeof(digits) - pos);
+    buffer[len] = '\0';
+    return len;
+}
+
+/**
+ * Format a double as the shortest JSON number that will be parsed back to the same double
+ *
+ * @param value  The double
+ * @param buffer A buffer of at least SXE_JITSON_NUMBER_MAX_LEN + 1 bytes
+ *
+ * @return The length of the formatted number, which is '\0' terminated
+ *
+ * @note The notation matches printf's %G format: exponential notation is used if the decimal exponent is < -4 or >= 16, and
+ *       the exponent has a sign and at least 2 digits. Infinities and NaNs, which aren't valid JSON, are formatted by printf.
+ */
+unsigned
+sxe_jitson_number_to_str(double value, char *buffer)
+{
+    char    *out = buffer;
+    char     digits[20];
+    unsigned len, exp_abs;
+    int      k, point;
+
+    if (!isfinite(value))
+        return (unsigned)snprintf(buffer, SXE_JITSON_NUMBER_MAX_LEN + 1, "%G", value);
+
+    if (signbit(value)) {
+        *out++ = '-';
+        value  = -value;
+    }
+
+    if (value == 0.0) {
+        *out++ = '0';
+        *out   = '\0';
+        return (unsigned)(out - buffer);
+    }
+
+    len   = grisu2(value, digits, &k);
+    point = (int)len + k;    // Position of the decimal point relative to the first digit; the decimal exponent is point - 1
+
+    if (point >= -3 && point <= 16) {    // Decimal exponent in [-4, 16)
+        if (point >= (int)len) {         // Integer: digits followed by zeros
+            memcpy(out, digits, len);
+            memset(out + len, '0', point - len);
+            out += point;
+        } else if (point > 0) {          // Decimal point within the digits
+            memcpy(out, digits, point);
+            out[point] = '.';
+            memcpy(out + point + 1, digits + point, len - point);
+            out += len + 1;
+        } else {                         // Leading zeros after the decimal point
+            out[0] = '0';
+            out[1] = '.';
+            memset(out + 2, '0', -point);
+            memcpy(out + 2 - point, digits, len);
+            out += 2 - point + len;
+        }
+    } else {
+        *out++ = digits[0];
+
+        if (len > 1) {
+            *out++ = '.';
+            memcpy(out, digits + 1, len - 1);
+            out += len - 1;
+        }
+
+        *out++  = 'E';
+        *out++  = point - 1 < 0 ? '-' : '+';
+        exp_abs = point - 1 < 0 ? (unsigned)(1 - point) : (unsigned)(point - 1);
+
+        if (exp_abs >= 100) {
+            *out++   = (char)('0' + exp_abs / 100);
+            exp_abs %= 100;
+        }
+
+        memcpy(out, &digit_pairs[exp_abs * 2], 2);
+        out += 2;
+    }
+
+    *out = '\0';
+    return (unsigned)(out - buffer);
+}
+
+#define POW10_EXACT_MAX   22      // Largest power of ten that is exactly representable as a double
+#define POW10_TRUNC_MIN   -342    // Smallest power of ten whose truncated significand is in pow10_significands
+#define POW10_TRUNC_MAX   308     // Largest power of ten whose truncated significand is in pow10_significands
+#define MANTISSA_MAX_LEN  19      // Any decimal mantissa of up to 19 significant digits fits in a uint64_t
+
+static const double pow10_exact[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+    1e21, 1e22
+};
+
+/* Truncated, normalized 64 bit significands of the powers of ten 10^-342, 10^-341, ..., 10^308. The binary exponent of the
+ * significand of 10^q is floor(log2(10^q)) - 63, which is computed as ((217706 * q) >> 16) - 63.
+ */
+static const uint64_t pow10_significands[] = {
+    0xeef453d6923bd65aULL, 0x9558b4661b6565f8ULL, 0xbaaee17fa23ebf76ULL, 0xe95a99df8ace6f53ULL,
+    0x91d8a02bb6c10594ULL, 0xb64ec836a47146f9ULL, 0xe3e27a444d8d98b7ULL, 0x8e6d8c6ab0787f72ULL,
+    0xb208ef855c969f4fULL, 0xde8b2b66b3bc4723ULL, 0x8b16fb203055ac76ULL, 0xaddcb9e83c6b1793ULL,
+    0xd953e8624b85dd78ULL, 0x87d4713d6f33aa6bULL, 0xa9c98d8ccb009506ULL, 0xd43bf0effdc0ba48ULL,
+    0x84a57695fe98746dULL, 0xa5ced43b7e3e9188ULL, 0xcf42894a5dce35eaULL, 0x818995ce7aa0e1b2ULL,
+    0xa1ebfb4219491a1fULL, 0xca66fa129f9b60a6ULL, 0xfd00b897478238d0ULL, 0x9e20735e8cb16382ULL,
+    0xc5a890362fddbc62ULL, 0xf712b443bbd52b7bULL, 0x9a6bb0aa55653b2dULL, 0xc1069cd4eabe89f8ULL,
+    0xf148440a256e2c76ULL, 0x96cd2a865764dbcaULL, 0xbc807527ed3e12bcULL, 0xeba09271e88d976bULL,
+    0x93445b8731587ea3ULL, 0xb8157268fdae9e4cULL, 0xe61acf033d1a45dfULL, 0x8fd0c16206306babULL,
+    0xb3c4f1ba87bc8696ULL, 0xe0b62e2929aba83cULL, 0x8c71dcd9ba0b4925ULL, 0xaf8e5410288e1b6fULL,
+    0xdb71e91432b1a24aULL, 0x892731ac9faf056eULL, 0xab70fe17c79ac6caULL, 0xd64d3d9db981787dULL,
+    0x85f0468293f0eb4eULL, 0xa76c582338ed2621ULL, 0xd1476e2c07286faaULL, 0x82cca4db847945caULL,
+    0xa37fce126597973cULL, 0xcc5fc196fefd7d0cULL, 0xff77b1fcbebcdc4fULL, 0x9faacf3df73609b1ULL,
+    0xc795830d75038c1dULL, 0xf97ae3d0d2446f25ULL, 0x9becce62836ac577ULL, 0xc2e801fb244576d5ULL,
+    0xf3a20279ed56d48aULL, 0x9845418c345644d6ULL, 0xbe5691ef416bd60cULL, 0xedec366b11c6cb8fULL,
+    0x94b3a202eb1c3f39ULL, 0xb9e08a83a5e34f07ULL, 0xe858ad248f5c22c9ULL, 0x91376c36d99995beULL,
+    0xb58547448ffffb2dULL, 0xe2e69915b3fff9f9ULL, 0x8dd01fad907ffc3bULL, 0xb1442798f49ffb4aULL,
+    0xdd95317f31c7fa1dULL, 0x8a7d3eef7f1cfc52ULL, 0xad1c8eab5ee43b66ULL, 0xd863b256369d4a40ULL,
+    0x873e4f75e2224e68ULL, 0xa90de3535aaae202ULL, 0xd3515c2831559a83ULL, 0x8412d9991ed58091ULL,
+    0xa5178fff668ae0b6ULL, 0xce5d73ff402d98e3ULL, 0x80fa687f881c7f8eULL, 0xa139029f6a239f72ULL,
+    0xc987434744ac874eULL, 0xfbe9141915d7a922ULL, 0x9d71ac8fada6c9b5ULL, 0xc4ce17b399107c22ULL,
+    0xf6019da07f549b2bULL, 0x99c102844f94e0fbULL, 0xc0314325637a1939ULL, 0xf03d93eebc589f88ULL,
+    0x96267c7535b763b5ULL, 0xbbb01b9283253ca2ULL, 0xea9c227723ee8bcbULL, 0x92a1958a7675175fULL,
+    0xb749faed14125d36ULL, 0xe51c79a85916f484ULL, 0x8f31cc0937ae58d2ULL, 0xb2fe3f0b8599ef07ULL,
+    0xdfbdcece67006ac9ULL, 0x8bd6a141006042bdULL, 0xaecc49914078536dULL, 0xda7f5bf590966848ULL,
+    0x888f99797a5e012dULL, 0xaab37fd7d8f58178ULL, 0xd5605fcdcf32e1d6ULL, 0x855c3be0a17fcd26ULL,
+    0xa6b34ad8c9dfc06fULL, 0xd0601d8efc57b08bULL, 0x823c12795db6ce57ULL, 0xa2cb1717b52481edULL,
+    0xcb7ddcdda26da268ULL, 0xfe5d54150b090b02ULL, 0x9efa548d26e5a6e1ULL, 0xc6b8e9b0709f109aULL,
+    0xf867241c8cc6d4c0ULL, 0x9b407691d7fc44f8ULL, 0xc21094364dfb5636ULL, 0xf294b943e17a2bc4ULL,
+    0x979cf3ca6cec5b5aULL, 0xbd8430bd08277231ULL, 0xece53cec4a314ebdULL, 0x940f4613ae5ed136ULL,
+    0xb913179899f68584ULL, 0xe757dd7ec07426e5ULL, 0x9096ea6f3848984fULL, 0xb4bca50b065abe63ULL,
+    0xe1ebce4dc7f16dfbULL, 0x8d3360f09cf6e4bdULL, 0xb080392cc4349decULL, 0xdca04777f541c567ULL,
+    0x89e42caaf9491b60ULL, 0xac5d37d5b79b6239ULL, 0xd77485cb25823ac7ULL, 0x86a8d39ef77164bcULL,
+    0xa8530886b54dbdebULL, 0xd267caa862a12d66ULL, 0x8380dea93da4bc60ULL, 0xa46116538d0deb78ULL,
+    0xcd795be870516656ULL, 0x806bd9714632dff6ULL, 0xa086cfcd97bf97f3ULL, 0xc8a883c0fdaf7df0ULL,
+    0xfad2a4b13d1b5d6cULL, 0x9cc3a6eec6311a63ULL, 0xc3f490aa77bd60fcULL, 0xf4f1b4d515acb93bULL,
+    0x991711052d8bf3c5ULL, 0xbf5cd54678eef0b6ULL, 0xef340a98172aace4ULL, 0x9580869f0e7aac0eULL,
+    0xbae0a846d2195712ULL, 0xe998d258869facd7ULL, 0x91ff83775423cc06ULL, 0xb67f6455292cbf08ULL,
+    0xe41f3d6a7377eecaULL, 0x8e938662882af53eULL, 0xb23867fb2a35b28dULL, 0xdec681f9f4c31f31ULL,
+    0x8b3c113c38f9f37eULL, 0xae0b158b4738705eULL, 0xd98ddaee19068c76ULL, 0x87f8a8d4cfa417c9ULL,
+    0xa9f6d30a038d1dbcULL, 0xd47487cc8470652bULL, 0x84c8d4dfd2c63f3bULL, 0xa5fb0a17c777cf09ULL,
+    0xcf79cc9db955c2ccULL, 0x81ac1fe293d599bfULL, 0xa21727db38cb002fULL, 0xca9cf1d206fdc03bULL,
+    0xfd442e4688bd304aULL, 0x9e4a9cec15763e2eULL, 0xc5dd44271ad3cdbaULL, 0xf7549530e188c128ULL,
+    0x9a94dd3e8cf578b9ULL, 0xc13a148e3032d6e7ULL, 0xf18899b1bc3f8ca1ULL, 0x96f5600f15a7b7e5ULL,
+    0xbcb2b812db11a5deULL, 0xebdf661791d60f56ULL, 0x936b9fcebb25c995ULL, 0xb84687c269ef3bfbULL,
+    0xe65829b3046b0afaULL, 0x8ff71a0fe2c2e6dcULL, 0xb3f4e093db73a093ULL, 0xe0f218b8d25088b8ULL,
+    0x8c974f7383725573ULL, 0xafbd2350644eeacfULL, 0xdbac6c247d62a583ULL, 0x894bc396ce5da772ULL,
+    0xab9eb47c81f5114fULL, 0xd686619ba27255a2ULL, 0x8613fd0145877585ULL, 0xa798fc4196e952e7ULL,
+    0xd17f3b51fca3a7a0ULL, 0x82ef85133de648c4ULL, 0xa3ab66580d5fdaf5ULL, 0xcc963fee10b7d1b3ULL,
+    0xffbbcfe994e5c61fULL, 0x9fd561f1fd0f9bd3ULL, 0xc7caba6e7c5382c8ULL, 0xf9bd690a1b68637bULL,
+    0x9c1661a651213e2dULL, 0xc31bfa0fe5698db8ULL, 0xf3e2f893dec3f126ULL, 0x986ddb5c6b3a76b7ULL,
+    0xbe89523386091465ULL, 0xee2ba6c0678b597fULL, 0x94db483840b717efULL, 0xba121a4650e4ddebULL,
+    0xe896a0d7e51e1566ULL, 0x915e2486ef32cd60ULL, 0xb5b5ada8aaff80b8ULL, 0xe3231912d5bf60e6ULL,
+    0x8df5efabc5979c8fULL, 0xb1736b96b6fd83b3ULL, 0xddd0467c64bce4a0ULL, 0x8aa22c0dbef60ee4ULL,
+    0xad4ab7112eb3929dULL, 0xd89d64d57a607744ULL, 0x87625f056c7c4a8bULL, 0xa93af6c6c79b5d2dULL,
+    0xd389b47879823479ULL, 0x843610cb4bf160cbULL, 0xa54394fe1eedb8feULL, 0xce947a3da6a9273eULL,
+    0x811ccc668829b887ULL, 0xa163ff802a3426a8ULL, 0xc9bcff6034c13052ULL, 0xfc2c3f3841f17c67ULL,
+    0x9d9ba7832936edc0ULL, 0xc5029163f384a931ULL, 0xf64335bcf065d37dULL, 0x99ea0196163fa42eULL,
+    0xc06481fb9bcf8d39ULL, 0xf07da27a82c37088ULL, 0x964e858c91ba2655ULL, 0xbbe226efb628afeaULL,
+    0xeadab0aba3b2dbe5ULL, 0x92c8ae6b464fc96fULL, 0xb77ada0617e3bbcbULL, 0xe55990879ddcaabdULL,
+    0x8f57fa54c2a9eab6ULL, 0xb32df8e9f3546564ULL, 0xdff9772470297ebdULL, 0x8bfbea76c619ef36ULL,
+    0xaefae51477a06b03ULL, 0xdab99e59958885c4ULL, 0x88b402f7fd75539bULL, 0xaae103b5fcd2a881ULL,
+    0xd59944a37c0752a2ULL, 0x857fcae62d8493a5ULL, 0xa6dfbd9fb8e5b88eULL, 0xd097ad07a71f26b2ULL,
+    0x825ecc24c873782fULL, 0xa2f67f2dfa90563bULL, 0xcbb41ef979346bcaULL, 0xfea126b7d78186bcULL,
+    0x9f24b832e6b0f436ULL, 0xc6ede63fa05d3143ULL, 0xf8a95fcf88747d94ULL, 0x9b69dbe1b548ce7cULL,
+    0xc24452da229b021bULL, 0xf2d56790ab41c2a2ULL, 0x97c560ba6b0919a5ULL, 0xbdb6b8e905cb600fULL,
+    0xed246723473e3813ULL, 0x9436c0760c86e30bULL, 0xb94470938fa89bceULL, 0xe7958cb87392c2c2ULL,
+    0x90bd77f3483bb9b9ULL, 0xb4ecd5f01a4aa828ULL, 0xe2280b6c20dd5232ULL, 0x8d590723948a535fULL,
+    0xb0af48ec79ace837ULL, 0xdcdb1b2798182244ULL, 0x8a08f0f8bf0f156bULL, 0xac8b2d36eed2dac5ULL,
+    0xd7adf884aa879177ULL, 0x86ccbb52ea94baeaULL, 0xa87fea27a539e9a5ULL, 0xd29fe4b18e88640eULL,
+    0x83a3eeeef9153e89ULL, 0xa48ceaaab75a8e2bULL, 0xcdb02555653131b6ULL, 0x808e17555f3ebf11ULL,
+    0xa0b19d2ab70e6ed6ULL, 0xc8de047564d20a8bULL, 0xfb158592be068d2eULL, 0x9ced737bb6c4183dULL,
+    0xc428d05aa4751e4cULL, 0xf53304714d9265dfULL, 0x993fe2c6d07b7fabULL, 0xbf8fdb78849a5f96ULL,
+    0xef73d256a5c0f77cULL, 0x95a8637627989aadULL, 0xbb127c53b17ec159ULL, 0xe9d71b689dde71afULL,
+    0x9226712162ab070dULL, 0xb6b00d69bb55c8d1ULL, 0xe45c10c42a2b3b05ULL, 0x8eb98a7a9a5b04e3ULL,
+    0xb267ed1940f1c61cULL, 0xdf01e85f912e37a3ULL, 0x8b61313bbabce2c6ULL, 0xae397d8aa96c1b77ULL,
+    0xd9c7dced53c72255ULL, 0x881cea14545c7575ULL, 0xaa242499697392d2ULL, 0xd4ad2dbfc3d07787ULL,
+    0x84ec3c97da624ab4ULL, 0xa6274bbdd0fadd61ULL, 0xcfb11ead453994baULL, 0x81ceb32c4b43fcf4ULL,
+    0xa2425ff75e14fc31ULL, 0xcad2f7f5359a3b3eULL, 0xfd87b5f28300ca0dULL, 0x9e74d1b791e07e48ULL,
+    0xc612062576589ddaULL, 0xf79687aed3eec551ULL, 0x9abe14cd44753b52ULL, 0xc16d9a0095928a27ULL,
+    0xf1c90080baf72cb1ULL, 0x971da05074da7beeULL, 0xbce5086492111aeaULL, 0xec1e4a7db69561a5ULL,
+    0x9392ee8e921d5d07ULL, 0xb877aa3236a4b449ULL, 0xe69594bec44de15bULL, 0x901d7cf73ab0acd9ULL,
+    0xb424dc35095cd80fULL, 0xe12e13424bb40e13ULL, 0x8cbccc096f5088cbULL, 0xafebff0bcb24aafeULL,
+    0xdbe6fecebdedd5beULL, 0x89705f4136b4a597ULL, 0xabcc77118461cefcULL, 0xd6bf94d5e57a42bcULL,
+    0x8637bd05af6c69b5ULL, 0xa7c5ac471b478423ULL, 0xd1b71758e219652bULL, 0x83126e978d4fdf3bULL,
+    0xa3d70a3d70a3d70aULL, 0xccccccccccccccccULL, 0x8000000000000000ULL, 0xa000000000000000ULL,
+    0xc800000000000000ULL, 0xfa00000000000000ULL, 0x9c40000000000000ULL, 0xc350000000000000ULL,
+    0xf424000000000000ULL, 0x9896800000000000ULL, 0xbebc200000000000ULL, 0xee6b280000000000ULL,
+    0x9502f90000000000ULL, 0xba43b74000000000ULL, 0xe8d4a51000000000ULL, 0x9184e72a00000000ULL,
+    0xb5e620f480000000ULL, 0xe35fa931a0000000ULL, 0x8e1bc9bf04000000ULL, 0xb1a2bc2ec5000000ULL,
+    0xde0b6b3a76400000ULL, 0x8ac7230489e80000ULL, 0xad78ebc5ac620000ULL, 0xd8d726b7177a8000ULL,
+    0x878678326eac9000ULL, 0xa968163f0a57b400ULL, 0xd3c21bcecceda100ULL, 0x84595161401484a0ULL,
+    0xa56fa5b99019a5c8ULL, 0xcecb8f27f4200f3aULL, 0x813f3978f8940984ULL, 0xa18f07d736b90be5ULL,
+    0xc9f2c9cd04674edeULL, 0xfc6f7c4045812296ULL, 0x9dc5ada82b70b59dULL, 0xc5371912364ce305ULL,
+    0xf684df56c3e01bc6ULL, 0x9a130b963a6c115cULL, 0xc097ce7bc90715b3ULL, 0xf0bdc21abb48db20ULL,
+    0x96769950b50d88f4ULL, 0xbc143fa4e250eb31ULL, 0xeb194f8e1ae525fdULL, 0x92efd1b8d0cf37beULL,
+    0xb7abc627050305adULL, 0xe596b7b0c643c719ULL, 0x8f7e32ce7bea5c6fULL, 0xb35dbf821ae4f38bULL,
+    0xe0352f62a19e306eULL, 0x8c213d9da502de45ULL, 0xaf298d050e4395d6ULL, 0xdaf3f04651d47b4cULL,
+    0x88d8762bf324cd0fULL, 0xab0e93b6efee0053ULL, 0xd5d238a4abe98068ULL, 0x85a36366eb71f041ULL,
+    0xa70c3c40a64e6c51ULL, 0xd0cf4b50cfe20765ULL, 0x82818f1281ed449fULL, 0xa321f2d7226895c7ULL,
+    0xcbea6f8ceb02bb39ULL, 0xfee50b7025c36a08ULL, 0x9f4f2726179a2245ULL, 0xc722f0ef9d80aad6ULL,
+    0xf8ebad2b84e0d58bULL, 0x9b934c3b330c8577ULL, 0xc2781f49ffcfa6d5ULL, 0xf316271c7fc3908aULL,
+    0x97edd871cfda3a56ULL, 0xbde94e8e43d0c8ecULL, 0xed63a231d4c4fb27ULL, 0x945e455f24fb1cf8ULL,
+    0xb975d6b6ee39e436ULL, 0xe7d34c64a9c85d44ULL, 0x90e40fbeea1d3a4aULL, 0xb51d13aea4a488ddULL,
+    0xe264589a4dcdab14ULL, 0x8d7eb76070a08aecULL, 0xb0de65388cc8ada8ULL, 0xdd15fe86affad912ULL,
+    0x8a2dbf142dfcc7abULL, 0xacb92ed9397bf996ULL, 0xd7e77a8f87daf7fbULL, 0x86f0ac99b4e8dafdULL,
+    0xa8acd7c0222311bcULL, 0xd2d80db02aabd62bULL, 0x83c7088e1aab65dbULL, 0xa4b8cab1a1563f52ULL,
+    0xcde6fd5e09abcf26ULL, 0x80b05e5ac60b6178ULL, 0xa0dc75f1778e39d6ULL, 0xc913936dd571c84cULL,
+    0xfb5878494ace3a5fULL, 0x9d174b2dcec0e47bULL, 0xc45d1df942711d9aULL, 0xf5746577930d6500ULL,
+    0x9968bf6abbe85f20ULL, 0xbfc2ef456ae276e8ULL, 0xefb3ab16c59b14a2ULL, 0x95d04aee3b80ece5ULL,
+    0xbb445da9ca61281fULL, 0xea1575143cf97226ULL, 0x924d692ca61be758ULL, 0xb6e0c377cfa2e12eULL,
+    0xe498f455c38b997aULL, 0x8edf98b59a373fecULL, 0xb2977ee300c50fe7ULL, 0xdf3d5e9bc0f653e1ULL,
+    0x8b865b215899f46cULL, 0xae67f1e9aec07187ULL, 0xda01ee641a708de9ULL, 0x884134fe908658b2ULL,
+    0xaa51823e34a7eedeULL, 0xd4e5e2cdc1d1ea96ULL, 0x850fadc09923329eULL, 0xa6539930bf6bff45ULL,
+    0xcfe87f7cef46ff16ULL, 0x81f14fae158c5f6eULL, 0xa26da3999aef7749ULL, 0xcb090c8001ab551cULL,
+    0xfdcb4fa002162a63ULL, 0x9e9f11c4014dda7eULL, 0xc646d63501a1511dULL, 0xf7d88bc24209a565ULL,
+    0x9ae757596946075fULL, 0xc1a12d2fc3978937ULL, 0xf209787bb47d6b84ULL, 0x9745eb4d50ce6332ULL,
+    0xbd176620a501fbffULL, 0xec5d3fa8ce427affULL, 0x93ba47c980e98cdfULL, 0xb8a8d9bbe123f017ULL,
+    0xe6d3102ad96cec1dULL, 0x9043ea1ac7e41392ULL, 0xb454e4a179dd1877ULL, 0xe16a1dc9d8545e94ULL,
+    0x8ce2529e2734bb1dULL, 0xb01ae745b101e9e4ULL, 0xdc21a1171d42645dULL, 0x899504ae72497ebaULL,
+    0xabfa45da0edbde69ULL, 0xd6f8d7509292d603ULL, 0x865b86925b9bc5c2ULL, 0xa7f26836f282b732ULL,
+    0xd1ef0244af2364ffULL, 0x8335616aed761f1fULL, 0xa402b9c5a8d3a6e7ULL, 0xcd036837130890a1ULL,
+    0x802221226be55a64ULL, 0xa02aa96b06deb0fdULL, 0xc83553c5c8965d3dULL, 0xfa42a8b73abbf48cULL,
+    0x9c69a97284b578d7ULL, 0xc38413cf25e2d70dULL, 0xf46518c2ef5b8cd1ULL, 0x98bf2f79d5993802ULL,
+    0xbeeefb584aff8603ULL, 0xeeaaba2e5dbf6784ULL, 0x952ab45cfa97a0b2ULL, 0xba756174393d88dfULL,
+    0xe912b9d1478ceb17ULL, 0x91abb422ccb812eeULL, 0xb616a12b7fe617aaULL, 0xe39c49765fdf9d94ULL,
+    0x8e41ade9fbebc27dULL, 0xb1d219647ae6b31cULL, 0xde469fbd99a05fe3ULL, 0x8aec23d680043beeULL,
+    0xada72ccc20054ae9ULL, 0xd910f7ff28069da4ULL, 0x87aa9aff79042286ULL, 0xa99541bf57452b28ULL,
+    0xd3fa922f2d1675f2ULL, 0x847c9b5d7c2e09b7ULL, 0xa59bc234db398c25ULL, 0xcf02b2c21207ef2eULL,
+    0x8161afb94b44f57dULL, 0xa1ba1ba79e1632dcULL, 0xca28a291859bbf93ULL, 0xfcb2cb35e702af78ULL,
+    0x9defbf01b061adabULL, 0xc56baec21c7a1916ULL, 0xf6c69a72a3989f5bULL, 0x9a3c2087a63f6399ULL,
+    0xc0cb28a98fcf3c7fULL, 0xf0fdf2d3f3c30b9fULL, 0x969eb7c47859e743ULL, 0xbc4665b596706114ULL,
+    0xeb57ff22fc0c7959ULL, 0x9316ff75dd87cbd8ULL, 0xb7dcbf5354e9beceULL, 0xe5d3ef282a242e81ULL,
+    0x8fa475791a569d10ULL, 0xb38d92d760ec4455ULL, 0xe070f78d3927556aULL, 0x8c469ab843b89562ULL,
+    0xaf58416654a6babbULL, 0xdb2e51bfe9d0696aULL, 0x88fcf317f22241e2ULL, 0xab3c2fddeeaad25aULL,
+    0xd60b3bd56a5586f1ULL, 0x85c7056562757456ULL, 0xa738c6bebb12d16cULL, 0xd106f86e69d785c7ULL,
+    0x82a45b450226b39cULL, 0xa34d721642b06084ULL, 0xcc20ce9bd35c78a5ULL, 0xff290242c83396ceULL,
+    0x9f79a169bd203e41ULL, 0xc75809c42c684dd1ULL, 0xf92e0c3537826145ULL, 0x9bbcc7a142b17ccbULL,
+    0xc2abf989935ddbfeULL, 0xf356f7ebf83552feULL, 0x98165af37b2153deULL, 0xbe1bf1b059e9a8d6ULL,
+    0xeda2ee1c7064130cULL, 0x9485d4d1c63e8be7ULL, 0xb9a74a0637ce2ee1ULL, 0xe8111c87c5c1ba99ULL,
+    0x910ab1d4db9914a0ULL, 0xb54d5e4a127f59c8ULL, 0xe2a0b5dc971f303aULL, 0x8da471a9de737e24ULL,
+    0xb10d8e1456105dadULL, 0xdd50f1996b947518ULL, 0x8a5296ffe33cc92fULL, 0xace73cbfdc0bfb7bULL,
+    0xd8210befd30efa5aULL, 0x8714a775e3e95c78ULL, 0xa8d9d1535ce3b396ULL, 0xd31045a8341ca07cULL,
+    0x83ea2b892091e44dULL, 0xa4e4b66b68b65d60ULL, 0xce1de40642e3f4b9ULL, 0x80d2ae83e9ce78f3ULL,
+    0xa1075a24e4421730ULL, 0xc94930ae1d529cfcULL, 0xfb9b7cd9a4a7443cULL, 0x9d412e0806e88aa5ULL,
+    0xc491798a08a2ad4eULL, 0xf5b5d7ec8acb58a2ULL, 0x9991a6f3d6bf1765ULL, 0xbff610b0cc6edd3fULL,
+    0xeff394dcff8a948eULL, 0x95f83d0a1fb69cd9ULL, 0xbb764c4ca7a4440fULL, 0xea53df5fd18d5513ULL,
+    0x92746b9be2f8552cULL, 0xb7118682dbb66a77ULL, 0xe4d5e82392a40515ULL, 0x8f05b1163ba6832dULL,
+    0xb2c71d5bca9023f8ULL, 0xdf78e4b2bd342cf6ULL, 0x8bab8eefb6409c1aULL, 0xae9672aba3d0c320ULL,
+    0xda3c0f568cc4f3e8ULL, 0x8865899617fb1871ULL, 0xaa7eebfb9df9de8dULL, 0xd51ea6fa85785631ULL,
+    0x8533285c936b35deULL, 0xa67ff273b8460356ULL, 0xd01fef10a657842cULL, 0x8213f56a67f6b29bULL,
+    0xa298f2c501f45f42ULL, 0xcb3f2f7642717713ULL, 0xfe0efb53d30dd4d7ULL, 0x9ec95d1463e8a506ULL,
+    0xc67bb4597ce2ce48ULL, 0xf81aa16fdc1b81daULL, 0x9b10a4e5e9913128ULL, 0xc1d4ce1f63f57d72ULL,
+    0xf24a01a73cf2dccfULL, 0x976e41088617ca01ULL, 0xbd49d14aa79dbc82ULL, 0xec9c459d51852ba2ULL,
+    0x93e1ab8252f33b45ULL, 0xb8da1662e7b00a17ULL, 0xe7109bfba19c0c9dULL, 0x906a617d450187e2ULL,
+    0xb484f9dc9641e9daULL, 0xe1a63853bbd26451ULL, 0x8d07e33455637eb2ULL, 0xb049dc016abc5e5fULL,
+    0xdc5c5301c56b75f7ULL, 0x89b9b3e11b6329baULL, 0xac2820d9623bf429ULL, 0xd732290fbacaf133ULL,
+    0x867f59a9d4bed6c0ULL, 0xa81f301449ee8c70ULL, 0xd226fc195c6a2f8cULL, 0x83585d8fd9c25db7ULL,
+    0xa42e74f3d032f525ULL, 0xcd3a1230c43fb26fULL, 0x80444b5e7aa7cf85ULL, 0xa0555e361951c366ULL,
+    0xc86ab5c39fa63440ULL, 0xfa856334878fc150ULL, 0x9c935e00d4b9d8d2ULL, 0xc3b8358109e84f07ULL,
+    0xf4a642e14c6262c8ULL, 0x98e7e9cccfbd7dbdULL, 0xbf21e44003acdd2cULL, 0xeeea5d5004981478ULL,
+    0x95527a5202df0ccbULL, 0xbaa718e68396cffdULL, 0xe950df20247c83fdULL, 0x91d28b7416cdd27eULL,
+    0xb6472e511c81471dULL, 0xe3d8f9e563a198e5ULL, 0x8e679c2f5e44ff8fULL
+};
+
+static inline uint64_t
+load_eight_digits(const char *str)
+{
+    uint64_t chunk;
+
+    memcpy(&chunk, str, sizeof(chunk));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    chunk = __builtin_bswap64(chunk);
+#endif
+    return chunk;
+}
+
+/* Return true if all 8 characters in a chunk loaded by load_eight_digits are ASCII digits
+ */
+static inline bool
+is_eight_digits(uint64_t chunk)
+{
+    return ((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+        == 0x3333333333333333ULL;
+}
+
+/* Convert a chunk of 8 ASCII digits loaded by load_eight_digits to its value with 3 multiplies instead of 8
+ */
+static inline uint32_t
+eight_digits_value(uint64_t chunk)
+{
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 100 + (1000000ULL << 32);
+    const uint64_t mul2 = 1 + (10000ULL << 32);
+
+    chunk -= 0x3030303030303030ULL;
+    chunk  = chunk * 10 + (chunk >> 8);    // Each even byte is now the value of a pair of digits
+    return (uint32_t)(((chunk & mask) * mul1 + ((chunk >> 16) & mask) * mul2) >> 32);
+}
+
+/**
+ * Convert a string of digits to an unsigned integer, equivalently to strtoul with base 10 (or base 0 if allow_hex is true)
+ *
+ * @param str       An unsigned integer as returned by sxe_jitson_source_get_number with *is_uint_out set to true
+ * @param len       The length of the unsigned integer
+ * @param allow_hex True to convert a '0x' prefixed number as hexadecimal (and, like strtoul, a '0' prefixed number as octal)
+ *
+ * @return The value, or UINT64_MAX with errno set to ERANGE if the number is too large
+ */
+uint64_t
+sxe_jitson_str_to_uint(const char *str, size_t len, bool allow_hex)
+{
+    uint64_t value = 0;
+    size_t   i     = 0;
+    char     c;
+
+    if (allow_hex && len > 1 && str[0] == '0') {
+        if (str[1] != 'x')
+            return strtoul(str, NULL, 0);    // Octal is rare enough to leave to the C library
+
+        for (i = 2; i < len; i++) {
+            if (value >> 60)
+                goto OVERFLOW;
+
+            c     = str[i];
+            value = value << 4 | (unsigned)(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+        }
+
+        return value;
+    }
+
+    for (; len - i >= 8; i += 8)
+        if (__builtin_mul_overflow(value, 100000000, &value)
+         || __builtin_add_overflow(value, eight_digits_value(load_eight_digits(&str[i])), &value))
+            goto OVERFLOW;
+
+    for (; i < len; i++)
+        if (__builtin_mul_overflow(value, 10, &value) || __builtin_add_overflow(value, (unsigned)(str[i] - '0'), &value))
+            goto OVERFLOW;
+
+    return value;
+
+OVERFLOW:
+    errno = ERANGE;
+    return UINT64_MAX;
+}
+
+/* Convert mantissa * 10^exponent to the nearest double using the Eisel-Lemire algorithm with a truncated 64 bit power of ten.
+ * Returns false if the result can't be proven correctly rounded or is denormal or infinite, in which case the caller falls back.
+ */
+static bool
+eisel_lemire(uint64_t mantissa, int exponent, double *value_out)
+{
+    unsigned __int128 product;
+    uint64_t          hi, lo, bits;
+    unsigned          lz, shift;
+    int               biased_e;
+
+    if (exponent < POW10_TRUNC_MIN || exponent > POW10_TRUNC_MAX)
+        return false;
+
+    lz        = __builtin_clzll(mantissa);
+    mantissa <<= lz;
+    product   = (unsigned __int128)mantissa * pow10_significands[exponent - POW10_TRUNC_MIN];
+    hi        = (uint64_t)(product >> 64);
+    lo        = (uint64_t)product;
+
+    /* The exact product is in [product, product + mantissa), so if the low half could carry into the bits of hi that are
+     * kept or rounded, the result is ambiguous.
+     */
+    if ((hi & 0x1FF) == 0x1FF && lo + mantissa < lo)
+        return false;
+
+    shift = (unsigned)(hi >> 63) + 9;    // Keep 54 bits: 53 for the significand and 1 for rounding
+    bits  = hi >> shift;
+
+    if ((bits & 1) && lo == 0 && (hi & ((1ULL << shift) - 1)) == 0)    // Possibly exactly halfway; needs ties to even
+        return false;
+
+    bits     = (bits + (bits & 1)) >> 1;
+    biased_e = ((217706 * exponent) >> 16) - 63 + 64 + (int)shift + 1 - (int)lz + DP_EXPONENT_BIAS;
+
+    if (bits == DP_HIDDEN_BIT << 1) {    // Rounding up overflowed the significand
+        bits >>= 1;
+        biased_e++;
+    }
+
+    if (biased_e <= 0 || biased_e >= 0x7FF)
+        return false;
+
+    bits = (uint64_t)biased_e << DP_SIGNIFICAND_SIZE | (bits & DP_SIGNIFICAND_MASK);
+    memcpy(value_out, &bits, sizeof(bits));
+    return true;
+}
+
+/**
+ * Convert a JSON number to a double, equivalently to strtod
+ *
+ * @param str An number as returned by sxe_jitson_source_get_number
+ * @param len The length of the number
+ *
+ * @return The nearest double to the value of the number
+ */
+double
+sxe_jitson_str_to_number(const char *str, size_t len)
+{
+    const char *end      = str + len;
+    const char *next     = str;
+    const char *digits;
+    const char *fraction = NULL;
+    uint64_t    mantissa = 0;
+    uint64_t    chunk;
+    unsigned    significant;
+    int         exponent = 0;
+    int         exp_part = 0;
+    bool        negative = false;
+    bool        exp_negative;
+    double      value;
+
+    if (*next == '-') {
+        negative = true;
+        next++;
+    }
+
+    for (digits = next; end - next >= 8 && is_eight_digits(chunk = load_eight_digits(next)); next += 8)
+        mantissa = mantissa * 100000000 + eight_digits_value(chunk);
+
+    for (; next < end && (unsigned)(*next - '0') < 10; next++)
+        mantissa = mantissa * 10 + (unsigned)(*next - '0');
+
+    significant = (unsigned)(next - digits);
+
+    if (next < end && *next == '.') {
+        fraction = ++next;
+
+        for (; end - next >= 8 && is_eight_digits(chunk = load_eight_digits(next)); next += 8)
+            mantissa = mantissa * 100000000 + eight_digits_value(chunk);
+
+        for (; next < end && (unsigned)(*next - '0') < 10; next++)
+            mantissa = mantissa * 10 + (unsigned)(*next - '0');
+
+        exponent     = -(int)(next - fraction);
+        significant += (unsigned)(next - fraction);
+    }
+
+    if (significant > MANTISSA_MAX_LEN) {    // Leading zeros are not significant, but may have been counted
+        for (; digits < next && (*digits == '0' || *digits == '.'); digits++)
+            significant -= *digits == '0';
+
+        if (significant > MANTISSA_MAX_LEN)    // The mantissa has overflowed and must be handled by strtod
+            return strtod(str, NULL);
+    }
+
+    if (next < end && (*next == 'e' || *next == 'E')) {
+        exp_negative = *++next == '-';
+        next        += *next == '-' || *next == '+';
+
+        for (; next < end && (unsigned)(*next - '0') < 10; next++)
+            if (exp_part < 100000)    // Cap the exponent to avoid overflow; any larger exponent is 0 or infinity
+                exp_part = exp_part * 10 + (*next - '0');
+
+        exponent += exp_negative ? -exp_part : exp_part;
+    }
+
+    if (mantissa == 0)
+        return negative ? -0.0 : 0.0;
+
+    if (mantissa <= DP_HIDDEN_BIT << 1 && exponent >= -POW10_EXACT_MAX && exponent <= POW10_EXACT_MAX) {    // Clinger
+        value = exponent < 0 ? (double)mantissa / pow10_exact[-exponent] : (double)mantissa * pow10_exact[exponent];
+        return negative ? -value : value;
+    }
+
+    if (!eisel_lemire(mantissa, exponent, &value))
+        return strtod(str, NULL);
+
+    return negative ? -value : value;
+}
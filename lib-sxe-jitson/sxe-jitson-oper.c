@@ -143,6 +143,36 @@ sxe_jitson_oper_get_name(unsigned op)
     return opers[op].name;
 }
 
+/**
+ * Get the flags an operator was registered with
+ */
+unsigned
+sxe_jitson_oper_get_flags(unsigned op)
+{
+    SXEA1(op <= num_opers, "Operator %u is invalid with only %u operators registered", op, num_opers);
+    return opers[op].flags;
+}
+
+/**
+ * Resolve the function that implements an operator for a type, as the apply functions do on every call
+ *
+ * @param op   The operator
+ * @param type The type of the argument (or for binary operators, the type of the argument whose type is applied)
+ *
+ * @return The type's implementation if there is one, otherwise the default, which may be sxe_jitson_oper_func_null
+ */
+union sxe_jitson_oper_func
+sxe_jitson_oper_resolve(unsigned op, unsigned type)
+{
+    SXEA1(op <= num_opers, "Operator %u is invalid with only %u operators registered", op, num_opers);
+    SXEA1(type < num_types, "Type %u is >= number of types %u", type, num_types);
+
+    if (op < type_opers[type].num_opers && type_opers[type].opers[op].unary)
+        return type_opers[type].opers[op];
+
+    return opers[op].def_func;
+}
+
 const struct sxe_jitson *
 sxe_jitson_oper_apply_unary(unsigned op, const struct sxe_jitson *arg)
 {
@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Parallel loading of large JSON arrays and newline delimited JSON (NDJSON). The JSON is split into chunks at safe boundaries,
+ * which are found by a structural prescan for arrays or are simply newlines for NDJSON. Each chunk is loaded onto its own stack
+ * by a thread, and the values loaded are then stitched together into one array.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kit-alloc.h"
+#include "sxe-jitson.h"
+#include "sxe-log.h"
+
+#define JITSON_PARALLEL_MIN_CHUNK 65536    // Minimum bytes of JSON per chunk; smaller JSON is loaded by fewer threads
+
+#define JITSON_PARALLEL_ARRAY_FLAGS (SXE_JITSON_TYPE_IS_ORD | SXE_JITSON_TYPE_IS_UNIF | SXE_JITSON_TYPE_IS_HOMO)
+
+struct sxe_jitson_chunk {
+    const char              *json;          // Start of the chunk's JSON
+    size_t                   len;           // Length of the chunk's JSON
+    struct sxe_jitson_stack *stack;         // Stack the chunk's values are loaded onto, one after another
+    unsigned                 values;        // Number of values loaded
+    unsigned                 first_size;    // Size in jitsons of the first value loaded
+    unsigned                 last;          // Stack index of the last value loaded
+    uint32_t                 type;          // Array flags that hold for the values loaded, if optimizing
+    uint32_t                 flags;         // Parsing flags
+    int                      error;         // errno if the chunk failed to load or 0
+    bool                     ndjson;        // True if values are separated by newlines, false if by commas
+    bool                     threaded;      // True if a thread was started to load the chunk
+    pthread_t                thread;        // The thread, if one was started
+};
+
+/* Return the number of chunks to split JSON of a given length into
+ */
+static unsigned
+sxe_jitson_parallel_chunks(size_t len, unsigned threads)
+{
+    long cpus;
+
+    if (threads == 0)
+        threads = (cpus = sysconf(_SC_NPROCESSORS_ONLN)) > 0 ? (unsigned)cpus : 1;
+
+    if (len / JITSON_PARALLEL_MIN_CHUNK < threads)
+        threads = len / JITSON_PARALLEL_MIN_CHUNK ?: 1;
+
+    return threads;
+}
+
+/* Clear any of the ordered, uniform, and homogenous array flags that don't hold for a pair of adjacent elements. The checks are
+ * the same ones made by sxe_jitson_stack_load_json.
+ */
+static uint32_t
+sxe_jitson_parallel_check_pair(uint32_t type, const struct sxe_jitson *previous, unsigned previous_size,
+                               const struct sxe_jitson *current, unsigned current_size)
+{
+    if ((previous->type | current->type) & SXE_JITSON_TYPE_IS_LAZY)    // Lazy elements can't be compared without parsing
+        type &= ~(SXE_JITSON_TYPE_IS_ORD | SXE_JITSON_TYPE_IS_HOMO);
+
+    if ((type & SXE_JITSON_TYPE_IS_ORD) && sxe_jitson_cmp(previous, current) > 0)
+        type &= ~SXE_JITSON_TYPE_IS_ORD;
+
+    if ((type & SXE_JITSON_TYPE_IS_UNIF) && previous_size != current_size)
+        type &= ~SXE_JITSON_TYPE_IS_UNIF;
+
+    if ((type & SXE_JITSON_TYPE_IS_HOMO) && previous->type != current->type)
+        type &= ~SXE_JITSON_TYPE_IS_HOMO;
+
+    return type;
+}
+
+/* Load the values in a chunk onto a new stack. This is the body of each worker thread.
+ */
+static void *
+sxe_jitson_parallel_load_chunk(void *chunk_void)
+{
+    struct sxe_jitson_chunk *chunk = chunk_void;
+    struct sxe_jitson_source source;
+    const char              *start;
+    unsigned                 current;
+    char                     c;
+
+    sxe_jitson_source_from_buffer(&source, chunk->json, chunk->len, chunk->flags);
+    chunk->type = chunk->flags & SXE_JITSON_FLAG_OPTIMIZE ? JITSON_PARALLEL_ARRAY_FLAGS : 0;
+
+    if (!(chunk->stack = sxe_jitson_stack_new(1)))
+        goto ERROR;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+    for (;;) {
+        if (chunk->ndjson && sxe_jitson_source_peek_nonspace(&source) == '\0')    // Skip blank lines up to the end of the chunk
+            break;
+
+        current = chunk->stack->count;
+        start   = source.next;
+
+        /* Each NDJSON line is a separate document, but array elements are nested values, which may be loaded lazily
+         */
+        if (!(chunk->ndjson ? sxe_jitson_stack_load_json(chunk->stack, &source)
+                            : sxe_jitson_stack_load_nested(chunk->stack, &source)))
+            goto ERROR;
+
+        /* An NDJSON document can't span lines, whether or not the chunks were split between its lines
+         */
+        if (chunk->ndjson && memchr(start, '\n', source.next - start))
+            goto INVALID;
+
+        if (chunk->values++ == 0)
+            chunk->first_size = chunk->stack->count;
+        else if (chunk->type)
+            chunk->type = sxe_jitson_parallel_check_pair(chunk->type, &chunk->stack->jitsons[chunk->last], current - chunk->last,
+                                                         &chunk->stack->jitsons[current], chunk->stack->count - current);
+
+        chunk->last = current;
+
+        if (chunk->ndjson) {    // The rest of the line must be empty
+            while ((c = sxe_jitson_source_peek_char(&source)) == ' ' || c == '\t' || c == '\r')
+                source.next++;
+
+            if (c == '\n')
+                source.next++;
+            else if (c != '\0')
+                goto INVALID;
+        }
+        else if ((c = sxe_jitson_source_get_nonspace(&source)) != ',') {
+            if (c == '\0')    // End of the chunk
+                break;
+
+            goto INVALID;
+        }
+    }
+
+    return NULL;
+
+INVALID:
+    errno = EINVAL;
+
+ERROR:
+    chunk->error = errno;
+    SXEL2(": Failed to load value %u of a JSON chunk at '%s'", chunk->values, sxe_jitson_source_left(&source));
+    return NULL;
+}
+
+/* Free the values loaded from a chunk and its stack
+ */
+static void
+sxe_jitson_parallel_free_chunk(struct sxe_jitson_chunk *chunk)
+{
+    unsigned i, size;
+
+    if (!chunk->stack)
+        return;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+    for (i = 0; i < chunk->stack->count; i += size) {
+        size = sxe_jitson_size(&chunk->stack->jitsons[i]);
+        sxe_jitson_free_containee(&chunk->stack->jitsons[i]);
+    }
+
+    sxe_jitson_stack_free(chunk->stack);
+    chunk->stack = NULL;
+}
+
+/* Load the chunks in parallel and stitch the values loaded into an array. The first chunk is loaded by the calling thread.
+ */
+static struct sxe_jitson *
+sxe_jitson_parallel_load(struct sxe_jitson_chunk *chunks, unsigned count)
+{
+    struct sxe_jitson *array;
+    size_t             size, values;
+    unsigned           i, idx, previous, previous_size;
+    uint32_t           type;
+    int                error = 0;
+
+    for (i = 1; i < count; i++)
+        chunks[i].threaded = pthread_create(&chunks[i].thread, NULL, sxe_jitson_parallel_load_chunk, &chunks[i]) == 0;
+
+    if (count)
+        sxe_jitson_parallel_load_chunk(&chunks[0]);
+
+    for (i = 1; i < count; i++)
+        if (chunks[i].threaded)
+            pthread_join(chunks[i].thread, NULL);
+        else
+            sxe_jitson_parallel_load_chunk(&chunks[i]);    /* COVERAGE EXCLUSION: Failed to start a thread */
+
+    for (size = 1, values = 0, i = 0; i < count; i++) {
+        error   = error ?: chunks[i].error;
+        size   += chunks[i].stack ? chunks[i].stack->count : 0;
+        values += chunks[i].values;
+    }
+
+    if (!error && (size > UINT_MAX || values > UINT32_MAX)) {
+        SXEL2(": Array of %zu values in %zu jitsons is too large", values, size);
+        error = EOVERFLOW;
+    }
+
+    if (!error && !(array = kit_malloc((size + 1) * sizeof(*array))))    // Leave room for a uniform array's hash set slot
+        error = errno;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+    if (error) {
+        for (i = 0; i < count; i++)
+            sxe_jitson_parallel_free_chunk(&chunks[i]);
+
+        errno = error;
+        return NULL;
+    }
+
+    /* Copy each chunk's values into the array, which takes ownership of anything they refer to
+     */
+    type = SXE_JITSON_TYPE_ARRAY | (chunks[0].flags & SXE_JITSON_FLAG_OPTIMIZE ? JITSON_PARALLEL_ARRAY_FLAGS : 0);
+
+    for (idx = 1, previous = 0, previous_size = 0, i = 0; i < count; i++) {
+        if (chunks[i].values) {
+            if (previous && (type & JITSON_PARALLEL_ARRAY_FLAGS))    // Check the elements on either side of the boundary
+                type = sxe_jitson_parallel_check_pair(type, &array[previous], previous_size, chunks[i].stack->jitsons,
+                                                      chunks[i].first_size);
+
+            type         &= chunks[i].type | ~JITSON_PARALLEL_ARRAY_FLAGS;
+            previous      = idx + chunks[i].last;
+            previous_size = chunks[i].stack->count - chunks[i].last;
+            memcpy(&array[idx], chunks[i].stack->jitsons, chunks[i].stack->count * sizeof(*array));
+            idx          += chunks[i].stack->count;
+        }
+
+        sxe_jitson_stack_free(chunks[i].stack);
+    }
+
+    array->type = type | SXE_JITSON_TYPE_ALLOCED;
+    array->len  = (uint32_t)values;
+
+    if (values <= 1)    // Arrays with fewer than two elements are not considered ordered
+        array->type &= ~SXE_JITSON_TYPE_IS_ORD;
+
+    if (values && (array->type & SXE_JITSON_TYPE_IS_UNIF)) {
+        array->uniform.size = sizeof(*array) * (size - 1) / values;
+        array->uniform.type = array->type & SXE_JITSON_TYPE_IS_HOMO ? SXE_JITSON_TYPE_MASK & array[1].type
+                                                                    : SXE_JITSON_TYPE_INVALID;    // Mixed list
+
+        if (values >= SXE_JITSON_HASHED_MIN) {
+            array->type                            |= SXE_JITSON_TYPE_HAS_SET;
+            *sxe_jitson_array_get_set_slot(array)   = NULL;    // The hash set is built on the first search
+        }
+    }
+    else
+        array->integer = size;    // Store the offset past the array
+
+    return array;
+}
+
+/**
+ * Load a JSON array using multiple threads
+ *
+ * @param json    The JSON, which must be an array
+ * @param len     The length of the JSON
+ * @param flags   Parsing flags; see sxe_jitson_source_from_buffer
+ * @param threads The maximum number of threads to use, or 0 to use one per CPU
+ *
+ * @return The array or NULL on error (EINVAL if the JSON isn't a valid array, ENOMEM on out of memory)
+ *
+ * @note The array is split into chunks at top level commas found by prescanning it. Each chunk's elements are loaded by a thread,
+ *       then all the elements are copied into the array. JSON too small to be worth splitting is loaded by the calling thread.
+ */
+struct sxe_jitson *
+sxe_jitson_parallel_load_array(const char *json, size_t len, uint32_t flags, unsigned threads)
+{
+    struct sxe_jitson_source  source;
+    struct sxe_jitson_stack  *stack;
+    struct sxe_jitson_chunk  *chunks;
+    struct sxe_jitson        *array;
+    const char               *end;
+    size_t                    target;
+    unsigned                  count, depth, i;
+
+    sxe_jitson_source_from_buffer(&source, json, len, flags);
+
+    if ((count = sxe_jitson_parallel_chunks(len, threads)) == 1) {    // Not worth splitting
+        if (sxe_jitson_source_peek_nonspace(&source) != '[')
+            goto INVALID;
+
+        if (!(stack = sxe_jitson_stack_get_thread()) || !sxe_jitson_stack_load_json(stack, &source))
+            return NULL;
+
+        array = sxe_jitson_stack_get_jitson(stack);
+
+        if (array && sxe_jitson_source_peek_nonspace(&source) != '\0') {    // Trailing garbage
+            sxe_jitson_free(array);
+            goto INVALID;
+        }
+
+        return array;
+    }
+
+    if (sxe_jitson_source_get_nonspace(&source) != '[')
+        goto INVALID;
+
+    for (end = json + len; end > source.next && isspace(end[-1]); end--) {    // Find the closing bracket from the end
+    }
+
+    if (end == source.next || *--end != ']')
+        goto INVALID;
+
+    if (!(chunks = kit_calloc(count, sizeof(*chunks))))
+        return NULL;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+    source.end      = end;
+    chunks[0].json  = source.next;
+    chunks[0].flags = flags;
+
+    if (sxe_jitson_source_peek_nonspace(&source) == '\0') {    // A body of only whitespace is an empty array
+        array = sxe_jitson_parallel_load(chunks, 0);
+        kit_free(chunks);
+        return array;
+    }
+
+    /* Prescan the array's structure, splitting it at the first top level comma after each target offset. The chunks are
+     * loaded by the real parser, so an invalid array still fails to load even though only strings and brackets are checked.
+     */
+    for (i = 1, depth = 1, target = len / count; i < count && depth > 0;) {
+        switch (sxe_jitson_source_get_char(&source)) {
+        case '[':
+        case '{':
+            depth++;
+            break;
+
+        case ']':
+        case '}':
+            depth--;
+            break;
+
+        case ',':
+            if (depth == 1 && (size_t)(source.next - json) > target) {
+                chunks[i - 1].len = source.next - 1 - chunks[i - 1].json;
+                chunks[i].json    = source.next;
+                target            = len / count * ++i;
+            }
+
+            break;
+
+        case '"':
+            if (!sxe_jitson_source_skip_string(&source))
+                depth = 0;    // Let the parser report the error
+
+            break;
+
+        case '\0':
+            depth = 0;
+            break;
+        }
+    }
+
+    chunks[i - 1].len = end - chunks[i - 1].json;
+
+    for (count = i, i = 0; i < count; i++)
+        chunks[i].flags = flags;
+
+    array = sxe_jitson_parallel_load(chunks, count);
+    kit_free(chunks);
+    return array;
+
+INVALID:
+    SXEL2(": JSON is not an array: '%s'", sxe_jitson_source_left(&source));
+    errno = EINVAL;
+    return NULL;
+}
+
+/**
+ * Load newline delimited JSON (NDJSON) using multiple threads
+ *
+ * @param json    The JSON, with one value per line; blank lines are ignored, and a value spanning lines is invalid
+ * @param len     The length of the JSON
+ * @param flags   Parsing flags; see sxe_jitson_source_from_buffer
+ * @param threads The maximum number of threads to use, or 0 to use one per CPU
+ *
+ * @return An array of the values or NULL on error (EINVAL if a line isn't a valid JSON value, ENOMEM on out of memory)
+ *
+ * @note The JSON is split into chunks at newlines, which are only valid between values. Each chunk's values are loaded by a
+ *       thread, then all the values are copied into the array.
+ */
+struct sxe_jitson *
+sxe_jitson_parallel_load_ndjson(const char *json, size_t len, uint32_t flags, unsigned threads)
+{
+    struct sxe_jitson_chunk *chunks;
+    struct sxe_jitson       *array;
+    const char              *end = json + len;
+    const char              *start, *target, *newline;
+    unsigned                 count, i;
+
+    count = sxe_jitson_parallel_chunks(len, threads);
+
+    if (!(chunks = kit_calloc(count, sizeof(*chunks))))
+        return NULL;    /* COVERAGE EXCLUSION: Out of memory condition */
+
+    for (start = json, i = 0; i < count && start < end; i++) {    // Split at the first newline after each target offset
+        target           = json + len / count * (i + 1);
+        target           = target < start ? start : target;
+        newline          = i < count - 1 ? memchr(target, '\n', end - target) : NULL;
+        chunks[i].json   = start;
+        chunks[i].len    = (newline ? newline + 1 : end) - start;
+        chunks[i].flags  = flags;
+        chunks[i].ndjson = true;
+        start           += chunks[i].len;
+    }
+
+    array = sxe_jitson_parallel_load(chunks, i);
+    kit_free(chunks);
+    return array;
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Compiled paths. A path like "a.b[3].c" is parsed once into steps, interning each member name so that its hashes are
+ * computed once, then evaluated against any number of jitson values without reparsing or rehashing.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kit-alloc.h"
+#include "kit-mockfail.h"
+#include "sxe-jitson-path.h"
+#include "sxe-log.h"
+
+/**
+ * Compile a path into a form that can be efficiently evaluated
+ *
+ * @param path A path composed of member names separated by '.' and array element indices in brackets (e.g. "a.b[3].c")
+ *
+ * @return The compiled path or NULL on error (EINVAL if the path is malformed or ENOMEM on memory allocation failure)
+ *
+ * @note Member names can't contain '.' or '['. The empty path refers to the root value.
+ */
+struct sxe_jitson_path *
+sxe_jitson_path_compile(const char *path)
+{
+    struct sxe_jitson_path *compiled;
+    const char             *next;
+    char                   *end;
+    size_t                  len;
+    unsigned                count;
+
+    for (count = 0, next = path; *next; next++)    // Count the maximum number of steps
+        count += *next == '.' || *next == '[';
+
+    if (!(compiled = MOCKERROR(sxe_jitson_path_compile, NULL, ENOMEM,
+                               kit_malloc(sizeof(*compiled) + (count + 1) * sizeof(compiled->steps[0])))))
+        return NULL;
+
+    compiled->count = 0;
+
+    for (next = path; *next;) {
+        if (*next == '[') {
+            if (!isdigit((unsigned char)next[1]))
+                goto INVALID;
+
+            compiled->steps[compiled->count].symbol = NULL;
+            compiled->steps[compiled->count].idx    = strtoul(next + 1, &end, 10);
+
+            if (*end != ']')
+                goto INVALID;
+
+            next = end + 1;
+        }
+        else {
+            if ((len = strcspn(next, ".[")) == 0)    // Empty member names are not allowed
+                goto INVALID;
+
+            if (!(compiled->steps[compiled->count].symbol = sxe_jitson_symbol_intern(next, len)))
+                goto ERROR;
+
+            next += len;
+        }
+
+        compiled->count++;    // Count the step before checking what follows it so that it's freed on error
+
+        if (*next == '.') {
+            if (next[1] == '\0' || next[1] == '.' || next[1] == '[')    // A '.' must be followed by a member name
+                goto INVALID;
+
+            next++;
+        }
+        else if (*next != '\0' && *next != '[')    // After an index, only '.', '[' or the end of the path are allowed
+            goto INVALID;
+    }
+
+    return compiled;
+
+INVALID:
+    SXEL2("Invalid path '%s' at offset %zu", path, (size_t)(next - path));
+    errno = EINVAL;
+
+ERROR:
+    sxe_jitson_path_free(compiled);
+    return NULL;
+}
+
+/**
+ * Free a compiled path
+ */
+void
+sxe_jitson_path_free(struct sxe_jitson_path *path)
+{
+    unsigned i;
+
+    if (path == NULL)
+        return;
+
+    for (i = 0; i < path->count; i++)
+        if (path->steps[i].symbol)
+            sxe_jitson_symbol_release(path->steps[i].symbol);
+
+    kit_free(path);
+}
+
+/**
+ * Evaluate a compiled path against a jitson value
+ *
+ * @param path The compiled path
+ * @param root The jitson value to which the path is applied
+ *
+ * @return The value found or NULL if there is no such member (ENOKEY) or element (ERANGE), if a step is applied to a value of
+ *         the wrong type (EINVAL), or on memory allocation failure while indexing (ENOMEM)
+ */
+const struct sxe_jitson *
+sxe_jitson_path_eval(const struct sxe_jitson_path *path, const struct sxe_jitson *root)
+{
+    const struct sxe_jitson *value = root;
+    unsigned                 i;
+
+    for (i = 0; i < path->count && value; i++) {
+        value = sxe_jitson_dereference(value);
+
+        if (path->steps[i].symbol) {
+            if (sxe_jitson_get_type_no_deref(value) != SXE_JITSON_TYPE_OBJECT) {
+                SXEL6("Can't get member '%s' of a %s", path->steps[i].symbol->name, sxe_jitson_get_type_as_str(value));
+                errno = EINVAL;
+                return NULL;
+            }
+
+            value = sxe_jitson_object_get_member_symbol(value, path->steps[i].symbol);
+        }
+        else {
+            if (sxe_jitson_get_type_no_deref(value) != SXE_JITSON_TYPE_ARRAY) {
+                SXEL6("Can't get element %zu of a %s", path->steps[i].idx, sxe_jitson_get_type_as_str(value));
+                errno = EINVAL;
+                return NULL;
+            }
+
+            value = sxe_jitson_array_get_element(value, path->steps[i].idx);
+        }
+    }
+
+    return value;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SXE_JITSON_PATH_H
+#define SXE_JITSON_PATH_H
+
+#include "sxe-jitson.h"
+
+/* A step in a compiled path is either a member name (whose interned symbol caches its hashes) or an array element index
+ */
+struct sxe_jitson_path_step {
+    const struct sxe_jitson_symbol *symbol;    // Member name's symbol or NULL if the step is an array element index
+    size_t                          idx;       // Array element index, if symbol is NULL
+};
+
+struct sxe_jitson_path {
+    unsigned                    count;      // Number of steps
+    struct sxe_jitson_path_step steps[];
+};
+
+#include "sxe-jitson-path-proto.h"
+
+#endif
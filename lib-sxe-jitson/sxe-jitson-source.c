@@ -283,6 +283,128 @@ INVALID:
     return NULL;
 }
 
+/**
+ * Scan the characters of a JSON string in a source that can be copied as is
+ *
+ * @param source Source positioned within a string
+ *
+ * @return The number of characters before the next '"', '\\', control character (including '\0') or the end of the source.
+ *         The characters are not consumed.
+ *
+ * @note Scans 8 bytes at a time. If the source is NUL terminated, the string is scanned a byte at a time up to an 8 byte
+ *       boundary, after which only aligned words are loaded; these can never cross a page boundary, so reading beyond the
+ *       terminating NUL can't fault.
+ */
+size_t
+sxe_jitson_source_scan_string(const struct sxe_jitson_source *source)
+{
+    const char *next = source->next;
+    uint64_t    word, mask;
+
+    if (source->end == (const char *)~0ULL) {
+        for (; (uintptr_t)next % sizeof(word); next++)
+            if ((unsigned char)*next <= 0x1F || *next == '"' || *next == '\\')
+                return next - source->next;
+
+        for (;; next += sizeof(word)) {
+            memcpy(&word, __builtin_assume_aligned(next, sizeof(word)), sizeof(word));
+
+            if ((mask = sxe_jitson_swar_special(word)))
+                return next - source->next + sxe_jitson_swar_first(mask);
+        }
+    }
+
+    for (; source->end - next >= (ptrdiff_t)sizeof(word); next += sizeof(word)) {
+        memcpy(&word, next, sizeof(word));    // Unaligned safe load; compiles to a single move
+
+        if ((mask = sxe_jitson_swar_special(word)))
+            return next - source->next + sxe_jitson_swar_first(mask);
+    }
+
+    for (; next < source->end; next++)
+        if ((unsigned char)*next <= 0x1F || *next == '"' || *next == '\\')
+            break;
+
+    return next - source->next;
+}
+
+/**
+ * Skip the rest of a string whose opening '"' has been consumed, up to and including its closing '"'
+ *
+ * @param source Source positioned after the opening '"'
+ *
+ * @return true on success or false with errno EINVAL if the source ends before the closing '"'
+ *
+ * @note Escape sequences are skipped, but not checked.
+ */
+bool
+sxe_jitson_source_skip_string(struct sxe_jitson_source *source)
+{
+    char c;
+
+    for (;;) {
+        source->next += sxe_jitson_source_scan_string(source);
+
+        if ((c = sxe_jitson_source_get_char(source)) == '"')
+            return true;
+
+        if (c == '\\')    // Skip the escaped character, which may be a '"'
+            c = sxe_jitson_source_get_char(source);
+
+        if (c == '\0') {
+            errno = EINVAL;
+            return false;
+        }
+    }
+}
+
+/**
+ * Get an array or object from a source without parsing it, by matching its brackets
+ *
+ * @param source  Source positioned at a '[' or '{'
+ * @param len_out Set to the length of the array or object
+ *
+ * @return Pointer to the array or object or NULL with errno EINVAL if the source ends before the closing bracket
+ *
+ * @note Only strings and brackets are checked, so the array or object may still turn out to be invalid when it is parsed.
+ */
+const char *
+sxe_jitson_source_get_container(struct sxe_jitson_source *source, size_t *len_out)
+{
+    const char *container = source->next;
+    unsigned    depth     = 0;
+
+    do {
+        switch (sxe_jitson_source_get_char(source)) {
+        case '[':
+        case '{':
+            depth++;
+            break;
+
+        case ']':
+        case '}':
+            depth--;
+            break;
+
+        case '"':    // Skip over strings, which may contain brackets
+            if (!sxe_jitson_source_skip_string(source))
+                return NULL;
+
+            break;
+
+        case '\0':
+            goto INVALID;
+        }
+    } while (depth > 0);
+
+    *len_out = source->next - container;
+    return container;
+
+INVALID:
+    errno = EINVAL;
+    return NULL;
+}
+
 /**
  * Get a literal, non-JSON character string
  *
@@ -23,6 +23,7 @@
  */
 
 #include <errno.h>
+#include <limits.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -37,8 +38,8 @@
 #include "sxe-thread.h"
 #include "sxe-unicode.h"
 
-#define JITSON_STACK_INIT_SIZE 1       // The initial numer of tokens in a per thread stack
-#define JITSON_STACK_MAX_INCR  4096    // The maximum the stack will grow by
+#define JITSON_STACK_INIT_SIZE    1    // The initial numer of tokens in a per thread stack
+#define JITSON_STACK_BYTES_PER_JITSON 8    // Estimated bytes of JSON per jitson, used to reserve space when the length is known
 
 /* A per thread stack is kept for parsing. It's per thread for lockless thread safety, and automatically grows as needed.
  */
@@ -81,9 +82,10 @@ sxe_jitson_stack_new(unsigned init_size)
  *
  * @param The stack
  *
- * @return The parsed or constructed jitson
+ * @return The parsed or constructed jitson, or NULL on failure to allocate memory (ENOMEM)
  *
- * @note Aborts if there is no jitson on the stack or if there is a partially constructed one
+ * @note Aborts if there is no jitson on the stack or if there is a partially constructed one. If the stack is using an arena,
+ *       the jitson is copied into the arena, and will be freed when the arena is reset.
  */
 struct sxe_jitson *
 sxe_jitson_stack_get_jitson(struct sxe_jitson_stack *stack)
@@ -95,6 +97,17 @@ sxe_jitson_stack_get_jitson(struct sxe_jitson_stack *stack)
     SXEA1(!stack->open,   "Can't get a jitson there's an open collection");
     SXEE6("(stack=%p)", stack);
 
+    if (stack->arena) {    // Copy the jitson into the arena, keeping the stack's memory to be reused
+        SXEA1(stack->borrow < stack->count, "Can't get a jitson from a stack that hasn't been grown");
+
+        if ((ret = sxe_jitson_arena_alloc(stack->arena, stack->count - stack->borrow))) {
+            memcpy(ret, &stack->jitsons[stack->borrow], (stack->count - stack->borrow) * sizeof(*stack->jitsons));
+            stack->count = stack->borrow;
+        }
+
+        goto OUT;
+    }
+
     if (stack->borrow) {
         SXEA1(stack->borrow < stack->count, "Can't get a jitson from a borrowed stack that hasn't been grown");
         size = (stack->count - stack->borrow) * sizeof(*stack->jitsons);
@@ -192,7 +205,54 @@ sxe_jitson_stack_free(struct sxe_jitson_stack *stack)
     kit_free(stack);
 }
 
-/* Reserve space on stack, expanding it if needed to make room for at least 'more' new values
+/**
+ * Use an arena for the jitsons gotten from a stack
+ *
+ * @param stack The stack
+ * @param arena The arena, or NULL to go back to allocating each jitson gotten from the stack
+ *
+ * @note The stack's memory is reused after each sxe_jitson_stack_get_jitson instead of being handed off with the jitson
+ */
+void
+sxe_jitson_stack_use_arena(struct sxe_jitson_stack *stack, struct sxe_jitson_arena *arena)
+{
+    stack->arena = arena;
+}
+
+/**
+ * Reserve space on a stack for at least a number of jitsons beyond those in use, allowing them to be added without expanding it
+ *
+ * @param stack The stack
+ * @param more  The number of jitsons to reserve space for
+ *
+ * @return true on success, false on failure to allocate memory (ENOMEM)
+ */
+bool
+sxe_jitson_stack_reserve(struct sxe_jitson_stack *stack, unsigned more)
+{
+    struct sxe_jitson *new_jitsons;
+    unsigned           new_maximum = stack->count + more;
+
+    if (new_maximum <= stack->maximum) {
+        if (stack->jitsons)
+            return true;
+
+        new_maximum = stack->maximum;    // The jitsons were handed off by sxe_jitson_stack_get_jitson
+    }
+
+    if (!(new_jitsons = MOCKERROR(MOCK_FAIL_STACK_RESERVE, NULL, ENOMEM,
+                                  kit_realloc(stack->jitsons, (size_t)new_maximum * sizeof(*stack->jitsons))))) {
+        SXEL2(": Failed to reserve %u jitsons for the stack", new_maximum);
+        return false;
+    }
+
+    stack->maximum = new_maximum;
+    stack->jitsons = new_jitsons;
+    return true;
+}
+
+/* Reserve space on stack, expanding it if needed to make room for at least 'more' new values. The stack at least doubles in size
+ * each time it grows, so building a large value copies each jitson a constant number of times on average.
  *
  * @return The index of the first new slot on the stack, or SXE_JITSON_STACK_ERROR on error (ENOMEM)
  */
@@ -202,12 +262,10 @@ sxe_jitson_stack_expand(struct sxe_jitson_stack *stack, unsigned more)
     unsigned expanded = stack->count + more;
 
     if (expanded > stack->maximum) {
-        unsigned new_maximum;
+        unsigned new_maximum = stack->maximum ?: 1;
 
-        if (expanded < JITSON_STACK_MAX_INCR)
-            new_maximum = ((expanded - 1) / stack->maximum + 1) * stack->maximum;
-        else
-            new_maximum = ((expanded - 1) / JITSON_STACK_MAX_INCR + 1) * JITSON_STACK_MAX_INCR;
+        while (new_maximum < expanded)
+            new_maximum = new_maximum > UINT_MAX / 2 ? UINT_MAX : 2 * new_maximum;
 
         struct sxe_jitson *new_jitsons = MOCKERROR(MOCK_FAIL_STACK_EXPAND, NULL, ENOMEM,
                                                   kit_realloc(stack->jitsons, (size_t)new_maximum * sizeof(*stack->jitsons)));
@@ -238,7 +296,8 @@ bool
 sxe_jitson_stack_load_string(struct sxe_jitson_stack *stack, struct sxe_jitson_source *source)
 {
     struct sxe_jitson *jitson;
-    unsigned           i, idx, space, unicode;
+    size_t             run;
+    unsigned           i, idx, more, space, unicode;
     char               c, utf8[4];
 
     if (sxe_jitson_source_get_nonspace(source) != '"') {
@@ -254,7 +313,32 @@ sxe_jitson_stack_load_string(struct sxe_jitson_stack *stack, struct sxe_jitson_s
     jitson->len  = 0;
     space        = sizeof(jitson->string);    // Amount of space left in the current jitson
 
-    while ((c = sxe_jitson_source_get_char(source)) != '"') {
+    for (;;) {
+        if ((run = sxe_jitson_source_scan_string(source)) > 0) {    // Copy characters that need no special handling in bulk
+            if ((source->flags & SXE_JITSON_FLAG_VALID_UTF8) && !sxe_unicode_is_utf8(source->next, run)) {
+                errno = EILSEQ;
+                goto ERROR;
+            }
+
+            if (run >= space) {    // If there's not enough space left including an extra byte for the trailing '\0'
+                more = (unsigned)((run - space) / sizeof(*jitson) + 1);
+
+                if (sxe_jitson_stack_expand(stack, more) == SXE_JITSON_STACK_ERROR)
+                    goto ERROR;
+
+                jitson = &stack->jitsons[idx];    // In case the jitsons were moved by realloc
+                space += more * sizeof(*jitson);
+            }
+
+            memcpy(&jitson->string[jitson->len], source->next, run);
+            jitson->len  += run;
+            space        -= run;
+            source->next += run;
+        }
+
+        if ((c = sxe_jitson_source_get_char(source)) == '"')
+            break;
+
         if (c == '\0') {   // No terminating "
             errno = EINVAL;
             goto ERROR;
@@ -363,6 +447,26 @@ ERROR:
     return false;
 }
 
+/* Replace the member name just loaded at index idx on the stack with a reference to its interned symbol
+ */
+static bool
+sxe_jitson_stack_intern_member_name(struct sxe_jitson_stack *stack, unsigned idx)
+{
+    const struct sxe_jitson_symbol *symbol;
+    struct sxe_jitson              *name = &stack->jitsons[idx];
+
+    if (!(symbol = sxe_jitson_symbol_intern(name->string, name->len))) {
+        stack->count = idx;    // Discard the member name
+        return false;
+    }
+
+    name->type      = SXE_JITSON_TYPE_STRING | SXE_JITSON_TYPE_IS_REF | SXE_JITSON_TYPE_IS_SYM;
+    name->len       = symbol->len;
+    name->reference = symbol->name;
+    stack->count    = idx + 1;    // The member name now takes only one jitson
+    return true;
+}
+
 /**
  * Duplicate a jitson value onto the stack
  *
@@ -387,6 +491,22 @@ sxe_jitson_stack_dup_at_index(struct sxe_jitson_stack *stack, unsigned idx, cons
     return ret;
 }
 
+/* Reserve a slot after a large uniform array that has just been closed for the hash set used to search it. Because a uniform
+ * array has no index, this is the only place the set can be kept. Failure to reserve the slot is harmless: the array is searched
+ * linearly.
+ */
+static void
+sxe_jitson_stack_reserve_set_slot(struct sxe_jitson_stack *stack, unsigned idx)
+{
+    unsigned slot;
+
+    if (stack->jitsons[idx].len < SXE_JITSON_HASHED_MIN || (slot = sxe_jitson_stack_expand(stack, 1)) == SXE_JITSON_STACK_ERROR)
+        return;
+
+    memset(&stack->jitsons[slot], 0, sizeof(stack->jitsons[slot]));    // Stack may have moved; NULL the set pointer
+    stack->jitsons[idx].type |= SXE_JITSON_TYPE_HAS_SET;
+}
+
 /* Character classes used by the parser
  */
 #define INV 0    // Invalid (control character, non-ASCII character, etc.)
@@ -413,6 +533,60 @@ static char jitson_class[256] = { INV, INV, INV, INV, INV, INV, INV, INV, INV, I
                                   INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV,
                                   INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV, INV };
 
+/* Load an array or object as a lazy reference to its JSON, to be parsed when it's first accessed
+ */
+static bool
+sxe_jitson_stack_load_lazy(struct sxe_jitson_stack *stack, struct sxe_jitson_source *source)
+{
+    const char *container;
+    size_t      len;
+    unsigned    idx;
+
+    if ((idx = sxe_jitson_stack_expand(stack, 2)) == SXE_JITSON_STACK_ERROR)
+        return false;
+
+    if (!(container = sxe_jitson_source_get_container(source, &len))) {
+        stack->count = idx;
+        return false;
+    }
+
+    if (len > UINT32_MAX) {    // The length of the JSON must fit in the len field
+        stack->count = idx;
+        errno        = EMSGSIZE;
+        return false;
+    }
+
+    stack->last                       = idx;
+    stack->jitsons[idx].type          = SXE_JITSON_TYPE_REFERENCE | SXE_JITSON_TYPE_IS_LAZY;
+    stack->jitsons[idx].len           = 0;
+    stack->jitsons[idx].jitref        = NULL;    // Set when the container is parsed
+    stack->jitsons[idx + 1].type      = source->flags;
+    stack->jitsons[idx + 1].len       = (uint32_t)len;
+    stack->jitsons[idx + 1].reference = container;
+    return true;
+}
+
+/**
+ * Load a value nested in an array or object onto a sxe-jitson stack
+ *
+ * @param stack  The stack to load onto
+ * @param source A sxe_jitson_source object
+ *
+ * @return true if the JSON was successfully loaded or false on error
+ *
+ * @note If the source is lazy, an array or object is scanned but not parsed, and is loaded as a lazy reference.
+ */
+bool
+sxe_jitson_stack_load_nested(struct sxe_jitson_stack *stack, struct sxe_jitson_source *source)
+{
+    char c;
+
+    if ((source->flags & SXE_JITSON_FLAG_LAZY) && ((c = sxe_jitson_source_peek_nonspace(source)) == '[' || c == '{'))
+        return sxe_jitson_stack_load_lazy(stack, source);
+
+    return sxe_jitson_stack_load_json(stack, source);
+}
+
 /**
  * Load a JSON onto a sxe-jitson stack.
  * See https://www.json.org/json-en.html
@@ -429,9 +603,8 @@ sxe_jitson_stack_load_json(struct sxe_jitson_stack *stack, struct sxe_jitson_sou
 {
     const struct sxe_jitson *jitson, *cast_arg = NULL;
     const char              *token;
-    char                    *endptr;
-    size_t                   len;
-    unsigned                 current, idx, previous;
+    size_t                   hint, len;
+    unsigned                 current, idx, previous, size;
     bool                     is_uint;
     char                     c;
 
@@ -440,6 +613,12 @@ sxe_jitson_stack_load_json(struct sxe_jitson_stack *stack, struct sxe_jitson_sou
         return false;
     }
 
+    /* When starting to load a value from JSON of known length, reserve the space it's likely to need. Failure isn't an error.
+     */
+    if (stack->count == stack->borrow && source->end != (const char *)~0ULL
+     && (hint = (size_t)(source->end - source->next) / JITSON_STACK_BYTES_PER_JITSON) > stack->maximum - stack->count)
+        sxe_jitson_stack_reserve(stack, hint < UINT_MAX - stack->count ? (unsigned)hint : UINT_MAX - stack->count);
+
     if ((idx = sxe_jitson_stack_expand(stack, 1)) == SXE_JITSON_STACK_ERROR)    // Get an empty jitson
         return false;
 
@@ -470,10 +649,13 @@ sxe_jitson_stack_load_json(struct sxe_jitson_stack *stack, struct sxe_jitson_sou
             if (!sxe_jitson_stack_load_string(stack, source))    // Member name must be a string
                 goto ERROR;
 
+            if ((source->flags & SXE_JITSON_FLAG_INTERN) && !sxe_jitson_stack_intern_member_name(stack, previous))
+                goto ERROR;
+
             if (sxe_jitson_source_get_nonspace(source) != ':')
                 goto INVALID;
 
-            if (!sxe_jitson_stack_load_json(stack, source))    // Value can be any JSON value
+            if (!sxe_jitson_stack_load_nested(stack, source))    // Value can be any JSON value
                 goto ERROR;
 
             stack->jitsons[idx].len++;
@@ -483,6 +665,10 @@ sxe_jitson_stack_load_json(struct sxe_jitson_stack *stack, struct sxe_jitson_sou
 
         if (c == '}') {
             stack->jitsons[idx].integer = stack->count - idx;    // Store the size = offset past the object
+
+            if ((source->flags & SXE_JITSON_FLAG_OPTIMIZE) && stack->jitsons[idx].len >= SXE_JITSON_PERFECT_MIN)
+                stack->jitsons[idx].type |= SXE_JITSON_TYPE_IS_PERF;    // Index it with a perfect hash when first accessed
+
             return true;
         }
 
@@ -507,12 +693,17 @@ sxe_jitson_stack_load_json(struct sxe_jitson_stack *stack, struct sxe_jitson_sou
             previous = stack->last;
             current  = stack->count;    // Index of JSON value about to be loaded
 
-            if (!sxe_jitson_stack_load_json(stack, source))    // Value can be any JSON value
+            if (!sxe_jitson_stack_load_nested(stack, source))    // Value can be any JSON value
                 goto ERROR;
 
             /* If optimization is enabled and there's at least one element already in the array.
              */
             if ((source->flags & SXE_JITSON_FLAG_OPTIMIZE) && stack->jitsons[idx].len > 0) {
+                /* Lazy elements can't be compared without parsing them, so the array can't be known to be ordered.
+                 */
+                if ((stack->jitsons[previous].type | stack->jitsons[current].type) & SXE_JITSON_TYPE_IS_LAZY)
+                    stack->jitsons[idx].type &= ~(SXE_JITSON_TYPE_IS_ORD | SXE_JITSON_TYPE_IS_HOMO);
+
                 /* If the array is currently ordered and the previous element is greater than the current one or they can't be
                  * compared, clear the ordered flag.
                  */
@@ -547,6 +738,7 @@ sxe_jitson_stack_load_json(struct sxe_jitson_stack *stack, struct sxe_jitson_sou
             stack->jitsons[idx].uniform.size = sizeof(struct sxe_jitson) * (stack->count - (idx + 1)) / stack->jitsons[idx].len;
             stack->jitsons[idx].uniform.type = stack->jitsons[idx].type & SXE_JITSON_TYPE_IS_HOMO
                                                ? stack->jitsons[stack->open].type : SXE_JITSON_TYPE_INVALID;    // Mixed list
+            sxe_jitson_stack_reserve_set_slot(stack, idx);
         }
         else
             stack->jitsons[idx].integer = stack->count - idx;    // Store the offset past the object
@@ -560,13 +752,11 @@ sxe_jitson_stack_load_json(struct sxe_jitson_stack *stack, struct sxe_jitson_sou
 
         if (is_uint) {
             stack->jitsons[idx].type    = SXE_JITSON_TYPE_NUMBER | SXE_JITSON_TYPE_IS_UINT;
-            stack->jitsons[idx].integer = strtoul(token, &endptr,
-                                                  sxe_jitson_source_get_flags(source) & SXE_JITSON_FLAG_ALLOW_HEX ? 0 : 10);
-            SXEA6(endptr - token == (ptrdiff_t)len, "strtoul failed to parse '%.*s'", (int)len, token);
+            stack->jitsons[idx].integer = sxe_jitson_str_to_uint(token, len,
+                                                                 sxe_jitson_source_get_flags(source) & SXE_JITSON_FLAG_ALLOW_HEX);
         } else {
             stack->jitsons[idx].type   = SXE_JITSON_TYPE_NUMBER;
-            stack->jitsons[idx].number = strtod(token, &endptr);
-            SXEA6(endptr - token == (ptrdiff_t)len, "strtod failed to parse '%.*s'", (int)len, token);
+            stack->jitsons[idx].number = sxe_jitson_str_to_number(token, len);
         }
 
         return true;
@@ -637,6 +827,13 @@ INVALID:
 
 ERROR:
     sxe_jitson_free(cast_arg);
+
+    if (source->flags & SXE_JITSON_FLAG_INTERN)    // Release symbols referred to by member names in any values being discarded
+        for (current = idx + 1; current < stack->count; current += size) {
+            size = sxe_jitson_size(&stack->jitsons[current]);
+            sxe_jitson_free_containee(&stack->jitsons[current]);
+        }
+
     stack->count = idx;    // Discard any data that this function added to the stack
     return false;
 }
@@ -1117,7 +1314,7 @@ sxe_jitson_stack_add_dup_members(struct sxe_jitson_stack *stack, const struct sx
     SXEA1((stack->jitsons[object].type & ~SXE_JITSON_TYPE_IS_LOCAL) == SXE_JITSON_TYPE_OBJECT, "Members can only be added to an object");
     SXEA1(!stack->jitsons[object].partial.no_value,              "Member name already added without a value");
 
-    jitson = sxe_jitson_is_reference(jitson) ? jitson->jitref : jitson;
+    jitson = sxe_jitson_dereference(jitson);
     SXEA1((jitson->type & SXE_JITSON_TYPE_MASK) == SXE_JITSON_TYPE_OBJECT, "Can't add members from JSON type %s",
                                                                            sxe_jitson_get_type_as_str(jitson));
 
@@ -1152,7 +1349,7 @@ sxe_jitson_stack_close_collection(struct sxe_jitson_stack *stack)
     SXEA1(stack->open, "There must be an open collection on the stack");
 
     unsigned           idx        = stack->open - 1;
-    struct sxe_jitson *collection = &stack->jitsons[idx];    // Safe to use a pointer because no stack expansion is done
+    struct sxe_jitson *collection = &stack->jitsons[idx];    // Safe to use a pointer until the set slot is reserved
 
     SXEA1(collection->type != SXE_JITSON_TYPE_OBJECT || !collection->partial.no_value,
           "Index %u is an object with a member name with no value", idx);
@@ -1165,10 +1362,16 @@ sxe_jitson_stack_close_collection(struct sxe_jitson_stack *stack)
         collection->uniform.size = sizeof(struct sxe_jitson) * (stack->count - (idx + 1)) / collection->len;
         collection->uniform.type = collection->type & SXE_JITSON_TYPE_IS_HOMO ? (SXE_JITSON_TYPE_MASK & collection[1].type)
                                                                               : SXE_JITSON_TYPE_INVALID;    // Mixed list
+        sxe_jitson_stack_reserve_set_slot(stack, idx);    // May move the stack, so collection can't be used after this
     }
-    else
+    else {
         collection->integer = stack->count - idx;    // Store the offset past the object or array
 
+        if ((sxe_jitson_flags & SXE_JITSON_FLAG_OPTIMIZE) && (collection->type & SXE_JITSON_TYPE_MASK) == SXE_JITSON_TYPE_OBJECT
+         && collection->len >= SXE_JITSON_PERFECT_MIN)
+            collection->type |= SXE_JITSON_TYPE_IS_PERF;    // Index it with a perfect hash when first accessed
+    }
+
     if (stack->open)
         sxe_jitson_stack_value_added(stack, sxe_jitson_flags);
 
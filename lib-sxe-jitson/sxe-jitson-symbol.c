@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2026 Cisco Systems, Inc. and its affiliates
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Interned member names. When a source is parsed with SXE_JITSON_FLAG_INTERN, each member name is replaced by a reference to
+ * a symbol in a table shared by all parsed jitsons, so that repeated member names are stored once and lookups by symbol can
+ * compare addresses instead of strings. Symbols are reference counted, and are freed when the last reference is released.
+ *
+ * Existing symbols are looked up without the lock, so that threads parsing in parallel don't serialize on it. Changes to the
+ * table are made under the lock. Symbols and tables that are removed are retired rather than freed, and retired memory is only
+ * freed when no thread is looking up a symbol. A lookup that races with a change may miss, in which case the symbol is looked
+ * up again under the lock.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "kit-alloc.h"
+#include "kit-mockfail.h"
+#include "sxe-hash.h"
+#include "sxe-jitson.h"
+#include "sxe-log.h"
+
+#define SYMBOL_BUCKETS_MIN 64    // Initial number of buckets in the symbol table; always a power of 2
+
+struct symbol_table {
+    struct symbol_table      *retired;     // Next retired table waiting to be freed
+    uint32_t                  buckets;     // Number of buckets; always a power of 2
+    struct sxe_jitson_symbol *bucket[];    // Hash buckets
+};
+
+static pthread_mutex_t           symbol_lock    = PTHREAD_MUTEX_INITIALIZER;    // Lock around changes to the symbol table
+static struct symbol_table      *symbol_table   = NULL;                         // Hash table, or NULL if there are no symbols
+static uint32_t                  symbol_count   = 0;
+static unsigned                  symbol_readers = 0;                            // Threads looking up symbols without the lock
+static struct sxe_jitson_symbol *symbol_retired = NULL;                         // Symbols waiting to be freed
+static struct symbol_table      *table_retired  = NULL;                         // Tables waiting to be freed
+
+/* Free retired symbols and tables if no thread is looking up a symbol without the lock. Called with the symbol lock held.
+ */
+static void
+sxe_jitson_symbol_reclaim(void)
+{
+    struct sxe_jitson_symbol *symbol;
+    struct symbol_table      *table;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);    // Anything retired must be unreachable before checking for readers
+
+    if (__atomic_load_n(&symbol_readers, __ATOMIC_SEQ_CST))
+        return;
+
+    while ((symbol = symbol_retired)) {
+        symbol_retired = symbol->next;
+        kit_free(symbol);
+    }
+
+    while ((table = table_retired)) {
+        table_retired = table->retired;
+        kit_free(table);
+    }
+}
+
+/* Double the number of buckets in the symbol table. Called with the symbol lock held. Failure to grow is harmless.
+ *
+ * Symbols are moved to the new table in place, so a lookup in the old table may be diverted to the wrong bucket and miss.
+ */
+static void
+sxe_jitson_symbol_table_grow(void)
+{
+    struct sxe_jitson_symbol *symbol, *next;
+    struct symbol_table      *table;
+    uint32_t                  i, buckets = 2 * symbol_table->buckets;
+
+    if (!(table = kit_calloc(1, sizeof(*table) + buckets * sizeof(table->bucket[0])))) {
+        SXEL6("Failed to grow the symbol table to %u buckets", buckets);    /* COVERAGE EXCLUSION: Out of memory */
+        return;                                                              /* COVERAGE EXCLUSION: Out of memory */
+    }
+
+    table->buckets = buckets;
+
+    for (i = 0; i < symbol_table->buckets; i++)
+        for (symbol = symbol_table->bucket[i]; symbol; symbol = next) {
+            next = symbol->next;
+            __atomic_store_n(&symbol->next, table->bucket[symbol->hash & (buckets - 1)], __ATOMIC_RELEASE);
+            table->bucket[symbol->hash & (buckets - 1)] = symbol;
+        }
+
+    symbol_table->retired = table_retired;
+    table_retired         = symbol_table;
+    __atomic_store_n(&symbol_table, table, __ATOMIC_RELEASE);
+}
+
+/* Look up a symbol without the lock, returning it with a reference added, or NULL if it wasn't found
+ */
+static struct sxe_jitson_symbol *
+sxe_jitson_symbol_find(const char *name, size_t len, uint64_t hash)
+{
+    struct sxe_jitson_symbol *symbol = NULL;
+    struct symbol_table      *table;
+    uint32_t                  refs;
+
+    __atomic_add_fetch(&symbol_readers, 1, __ATOMIC_SEQ_CST);    // Nothing can be freed until this thread is done
+
+    if ((table = __atomic_load_n(&symbol_table, __ATOMIC_ACQUIRE)))
+        for (symbol = __atomic_load_n(&table->bucket[hash & (table->buckets - 1)], __ATOMIC_ACQUIRE); symbol;
+             symbol = __atomic_load_n(&symbol->next, __ATOMIC_ACQUIRE))
+            if (symbol->hash == hash && symbol->len == len && memcmp(symbol->name, name, len) == 0) {
+                refs = __atomic_load_n(&symbol->refs, __ATOMIC_RELAXED);
+
+                while (refs && !__atomic_compare_exchange_n(&symbol->refs, &refs, refs + 1, false, __ATOMIC_ACQUIRE,
+                                                            __ATOMIC_RELAXED))
+                    ;
+
+                symbol = refs ? symbol : NULL;    // A symbol with no references is being retired
+                break;
+            }
+
+    __atomic_sub_fetch(&symbol_readers, 1, __ATOMIC_RELEASE);
+    return symbol;
+}
+
+/**
+ * Intern a name, returning its symbol with a reference to it
+ *
+ * @param name The name
+ * @param len  The length of the name or 0 to use strlen
+ *
+ * @return The symbol or NULL on failure to allocate memory (ENOMEM)
+ *
+ * @note The reference must be released with sxe_jitson_symbol_release. Symbols have the same address for as long as any
+ *       reference is held, so a held symbol can be used for fast lookups with sxe_jitson_object_get_member_symbol. Existing
+ *       symbols are found without taking the lock.
+ */
+const struct sxe_jitson_symbol *
+sxe_jitson_symbol_intern(const char *name, size_t len)
+{
+    struct sxe_jitson_symbol *symbol;
+    struct symbol_table      *table;
+    uint64_t                  hash;
+
+    len  = len ?: strlen(name);
+    hash = sxe_hash_64(name, len);
+
+    if ((symbol = sxe_jitson_symbol_find(name, len, hash)))
+        return symbol;
+
+    SXEA1(pthread_mutex_lock(&symbol_lock) == 0, "Can't take the symbol table lock");
+
+    if (symbol_table)    // Look again, in case it was added or the lookup raced with a change
+        for (symbol = symbol_table->bucket[hash & (symbol_table->buckets - 1)]; symbol; symbol = symbol->next)
+            if (symbol->hash == hash && symbol->len == len && memcmp(symbol->name, name, len) == 0) {
+                __atomic_add_fetch(&symbol->refs, 1, __ATOMIC_RELAXED);
+                goto OUT;
+            }
+
+    if (!symbol_table) {
+        if (!(table = MOCKERROR(MOCK_FAIL_SYMBOL_TABLE, NULL, ENOMEM,
+                                kit_calloc(1, sizeof(*table) + SYMBOL_BUCKETS_MIN * sizeof(table->bucket[0]))))) {
+            symbol = NULL;
+            goto OUT;
+        }
+
+        table->buckets = SYMBOL_BUCKETS_MIN;
+        __atomic_store_n(&symbol_table, table, __ATOMIC_RELEASE);
+    }
+
+    if (!(symbol = MOCKERROR(MOCK_FAIL_SYMBOL_INTERN, NULL, ENOMEM, kit_malloc(sizeof(*symbol) + len + 1)))) {
+        if (symbol_count == 0) {    // Don't keep an empty table around
+            symbol_table->retired = table_retired;
+            table_retired         = symbol_table;
+            __atomic_store_n(&symbol_table, NULL, __ATOMIC_RELEASE);
+        }
+
+        goto OUT;
+    }
+
+    symbol->hash = hash;
+    symbol->sum  = sxe_hash_sum(name, len);
+    symbol->refs = 1;
+    symbol->len  = (uint32_t)len;
+    memcpy(symbol->name, name, len);
+    symbol->name[len] = '\0';
+
+    if (++symbol_count > symbol_table->buckets)
+        sxe_jitson_symbol_table_grow();
+
+    symbol->next = symbol_table->bucket[hash & (symbol_table->buckets - 1)];
+    __atomic_store_n(&symbol_table->bucket[hash & (symbol_table->buckets - 1)], symbol, __ATOMIC_RELEASE);    // Publish it
+
+OUT:
+    sxe_jitson_symbol_reclaim();
+    pthread_mutex_unlock(&symbol_lock);
+    return symbol;
+}
+
+/**
+ * Add a reference to a symbol that the caller already holds a reference to
+ *
+ * @return The symbol
+ */
+const struct sxe_jitson_symbol *
+sxe_jitson_symbol_add_ref(const struct sxe_jitson_symbol *symbol)
+{
+    __atomic_add_fetch(&SXE_CAST_NOCONST(struct sxe_jitson_symbol *, symbol)->refs, 1, __ATOMIC_RELAXED);
+    return symbol;
+}
+
+/**
+ * Release a reference to a symbol, freeing it if it was the last one
+ *
+ * @note Releasing any reference but the last is lock free. The last reference is released under the lock, and the symbol is
+ *       removed from the table. Its memory is freed once no thread is looking up a symbol without the lock.
+ */
+void
+sxe_jitson_symbol_release(const struct sxe_jitson_symbol *symbol)
+{
+    struct sxe_jitson_symbol  *sym     = SXE_CAST_NOCONST(struct sxe_jitson_symbol *, symbol);
+    struct sxe_jitson_symbol **link;
+    uint32_t                   refs    = __atomic_load_n(&sym->refs, __ATOMIC_RELAXED);
+
+    while (refs > 1)    // On failure, refs is updated to the current count
+        if (__atomic_compare_exchange_n(&sym->refs, &refs, refs - 1, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            return;
+
+    SXEA1(pthread_mutex_lock(&symbol_lock) == 0, "Can't take the symbol table lock");
+
+    if (__atomic_sub_fetch(&sym->refs, 1, __ATOMIC_ACQ_REL) == 0) {    // May have been referenced again since it was read
+        for (link = &symbol_table->bucket[sym->hash & (symbol_table->buckets - 1)]; *link != sym; link = &(*link)->next)
+            SXEA6(*link, "Symbol '%s' is not in the symbol table", sym->name);
+
+        __atomic_store_n(link, sym->next, __ATOMIC_RELEASE);
+        __atomic_store_n(&sym->next, symbol_retired, __ATOMIC_RELEASE);    // A lookup at the symbol will just miss
+        symbol_retired = sym;
+
+        if (--symbol_count == 0) {
+            symbol_table->retired = table_retired;
+            table_retired         = symbol_table;
+            __atomic_store_n(&symbol_table, NULL, __ATOMIC_RELEASE);
+        }
+
+        sxe_jitson_symbol_reclaim();
+    }
+
+    pthread_mutex_unlock(&symbol_lock);
+}
+
+/**
+ * Get the number of symbols currently interned
+ */
+unsigned
+sxe_jitson_symbol_count(void)
+{
+    return symbol_count;
+}
@@ -130,7 +130,7 @@ unsigned
 sxe_jitson_get_type(const struct sxe_jitson *jitson)
 {
     if (sxe_jitson_is_reference(jitson))
-        return sxe_jitson_get_type(jitson->jitref);
+        return sxe_jitson_get_type(sxe_jitson_dereference(jitson));
 
     return jitson->type & SXE_JITSON_TYPE_MASK;
 }
@@ -222,36 +222,24 @@ sxe_jitson_number_test(const struct sxe_jitson *jitson)
     return jitson->number != 0.0 ? SXE_JITSON_TEST_TRUE : SXE_JITSON_TEST_FALSE;
 }
 
-#define NUMBER_MAX_LEN 24    // Enough space for the largest double and the largest uint64_t
-
 static char *
 sxe_jitson_number_build_json(const struct sxe_jitson *jitson, struct sxe_factory *factory)
 {
     char    *ret;
     unsigned len;
 
-    if ((ret = sxe_factory_reserve(factory, NUMBER_MAX_LEN)) == NULL)
+    if ((ret = sxe_factory_reserve(factory, SXE_JITSON_NUMBER_MAX_LEN)) == NULL)
         return NULL;
 
-    if (jitson->type & SXE_JITSON_TYPE_IS_UINT) {
-        len = snprintf(ret, NUMBER_MAX_LEN + 1, "%"PRIu64, sxe_jitson_get_uint(jitson));
-        SXEA6(len <= NUMBER_MAX_LEN, "As a string, numeric value %"PRIu64" is more than %u characters long",
-              sxe_jitson_get_uint(jitson), NUMBER_MAX_LEN);
-    } else {
-        /* The format %.17G comes from:
-        *    https://stackoverflow.com/questions/16839658/printf-width-specifier-to-maintain-precision-of-floating-point-value
-        *
-        * Using .17G reveals rounding errors in the encoding of fractions. For example:
-        *    got:      "pi":3.1415899999999999,"number":1.1415900000000001
-        *    expected: "pi":3.14159,           "number":1.14159
-        *
-        * Reducing the format to .16G rounds the numbers back to what was orinally parsed.
-        */
-        len = snprintf(ret, NUMBER_MAX_LEN + 1, "%.16G", sxe_jitson_get_number(jitson));
-        SXEA6(len <= NUMBER_MAX_LEN, "As a string, numeric value %.16G is more than %u characters long",
-              sxe_jitson_get_number(jitson), NUMBER_MAX_LEN);
-    }
+    /* Doubles are formatted with the shortest representation that parses back to the same value, so 3.14159 is output as
+     * 3.14159 rather than 3.1415899999999999 (see sxe-jitson-number.c).
+     */
+    if (jitson->type & SXE_JITSON_TYPE_IS_UINT)
+        len = sxe_jitson_uint_to_str(sxe_jitson_get_uint(jitson), ret);
+    else
+        len = sxe_jitson_number_to_str(sxe_jitson_get_number(jitson), ret);
 
+    SXEA6(len <= SXE_JITSON_NUMBER_MAX_LEN, "As a string, numeric value is %u characters long", len);
     sxe_factory_commit(factory, len);
     return sxe_factory_look(factory, NULL);
 }
@@ -296,11 +284,25 @@ sxe_jitson_type_register_number(void)
                                     sxe_jitson_number_build_json, sxe_jitson_number_cmp, NULL);
 }
 
+/* Strings that refer to interned symbols release their reference when freed
+ */
+static void
+sxe_jitson_string_free(struct sxe_jitson *jitson)
+{
+    if (jitson->type & SXE_JITSON_TYPE_IS_SYM)
+        sxe_jitson_symbol_release(sxe_jitson_get_symbol(jitson));
+
+    sxe_jitson_free_base(jitson);
+}
+
 size_t
 sxe_jitson_string_len(const struct sxe_jitson *jitson)
 {
     size_t len;
 
+    if (jitson->type & SXE_JITSON_TYPE_IS_SYM)    // Interned member names know their lengths
+        return sxe_jitson_get_symbol(jitson)->len;
+
     if (jitson->type & SXE_JITSON_TYPE_IS_KEY)    // Object keys use the len field to store a link offset
         return jitson->type & SXE_JITSON_TYPE_IS_REF ? strlen(jitson->reference) : strlen(jitson->string);    // SonarQube False Positive
 
@@ -340,6 +342,11 @@ sxe_jitson_string_test(const struct sxe_jitson *jitson)
 static bool
 sxe_jitson_string_clone(const struct sxe_jitson *jitson, struct sxe_jitson *clone)
 {
+    if (jitson->type & SXE_JITSON_TYPE_IS_SYM) {    // The clone shares the symbol
+        sxe_jitson_symbol_add_ref(sxe_jitson_get_symbol(jitson));
+        return true;
+    }
+
     /* If the jitson owns the string it's refering to, it must be duplicated
      */
     if ((jitson->type & SXE_JITSON_TYPE_IS_OWN)
@@ -351,34 +358,56 @@ sxe_jitson_string_clone(const struct sxe_jitson *jitson, struct sxe_jitson *clon
     return true;
 }
 
+/* Return the offset of the first character in string that must be escaped, or len if there isn't one. Scans 8 bytes at a
+ * time (SWAR) so that the common case of long strings with no special characters is fast.
+ */
+static size_t
+sxe_jitson_string_find_escape(const char *string, size_t len)
+{
+    uint64_t word, mask;
+    size_t   i;
+
+    for (i = 0; i + sizeof(word) <= len; i += sizeof(word)) {
+        memcpy(&word, &string[i], sizeof(word));    // Unaligned safe load; compiles to a single move
+
+        if ((mask = sxe_jitson_swar_special(word)))
+            return i + sxe_jitson_swar_first(mask);
+    }
+
+    for (; i < len; i++)
+        if ((unsigned char)string[i] <= 0x1F || string[i] == '"' || string[i] == '\\')
+            break;
+
+    return i;
+}
+
 static char *
 sxe_jitson_string_build_json(const struct sxe_jitson *jitson, struct sxe_factory *factory)
 {
-    const char *string;
-    char       *buffer;
-    size_t      len;
-    unsigned    first, i;
+    static const char hex[] = "0123456789abcdef";
+    const char       *string;
+    char             *buffer;
+    size_t            len, first, i;
 
     len    = sxe_jitson_len(jitson);
     string = sxe_jitson_get_string(jitson, NULL);
     sxe_factory_add(factory, "\"", 1);
 
-    for (first = i = 0; i < len; i++)
-        /* If the character is a control character or " or \, encode it as a unicode escape sequence.
-         * (unsigned char) casts are used to allow any UTF8 encoded string.
-         */
-        if ((unsigned char)string[i] <= 0x1F || string[i] == '"' || string[i] == '\\') {
-            if (first < i)
-                sxe_factory_add(factory, &string[first], i - first);
+    /* If a character is a control character or " or \, encode it as a unicode escape sequence. Any other byte is copied as
+     * is to allow any UTF8 encoded string.
+     */
+    for (first = 0; (i = first + sxe_jitson_string_find_escape(&string[first], len - first)) < len; first = i + 1) {
+        if (first < i)
+            sxe_factory_add(factory, &string[first], i - first);
 
-            if ((buffer = sxe_factory_reserve(factory, sizeof("\\u0000"))) == NULL)
-                return NULL;    /* COVERAGE EXCLUSION: Memory allocation failure */
+        if ((buffer = sxe_factory_reserve(factory, sizeof("\\u0000"))) == NULL)
+            return NULL;    /* COVERAGE EXCLUSION: Memory allocation failure */
 
-            snprintf(buffer, sizeof("\\u0000"), "\\u00%02x", (unsigned char)string[i]);
-            SXEA6(strlen(buffer) == sizeof("\\u0000") - 1, "Unicode escape sequence should always be 6 characters long");
-            sxe_factory_commit(factory, sizeof("\\u0000") - 1);
-            first = i + 1;
-        }
+        memcpy(buffer, "\\u00", sizeof("\\u00") - 1);
+        buffer[4] = hex[(unsigned char)string[i] >> 4];
+        buffer[5] = hex[(unsigned char)string[i] & 0xF];
+        sxe_factory_commit(factory, sizeof("\\u0000") - 1);
+    }
 
     if (first < len)
         sxe_factory_add(factory, &string[first], len - first);
@@ -400,6 +429,9 @@ sxe_jitson_string_cmp(const struct sxe_jitson *left, const struct sxe_jitson *ri
 static int
 sxe_jitson_string_eq(const struct sxe_jitson *left, const struct sxe_jitson *right)
 {
+    if (left->type & right->type & SXE_JITSON_TYPE_IS_SYM)    // Interned names are equal only if they're the same symbol
+        return left->reference == right->reference ? SXE_JITSON_TEST_TRUE : SXE_JITSON_TEST_FALSE;
+
     if (left->len && right->len && left->len != right->len)    // If both lengths are known and different, not equal!
         return SXE_JITSON_TEST_FALSE;
 
@@ -411,7 +443,7 @@ sxe_jitson_string_eq(const struct sxe_jitson *left, const struct sxe_jitson *rig
 uint32_t
 sxe_jitson_type_register_string(void)
 {
-    return sxe_jitson_type_register("string", sxe_jitson_free_base, sxe_jitson_string_test, sxe_jitson_string_size,
+    return sxe_jitson_type_register("string", sxe_jitson_string_free, sxe_jitson_string_test, sxe_jitson_string_size,
                                     sxe_jitson_string_len, sxe_jitson_string_clone, sxe_jitson_string_build_json,
                                     sxe_jitson_string_cmp, sxe_jitson_string_eq);
 }
@@ -438,7 +470,8 @@ sxe_jitson_array_size(const struct sxe_jitson *jitson)
     if (jitson->type & SXE_JITSON_TYPE_IS_REF)     // Concatenations are alway 2 jitsons in size
         return 2;
     else if (jitson->type & SXE_JITSON_TYPE_IS_UNIF)    // Uniform arrays have their element sizes in bytes; round up to jitsons
-        return 1 + jitson->len * ((jitson->uniform.size + sizeof(*jitson) - 1) / sizeof(*jitson));
+        return 1 + jitson->len * ((jitson->uniform.size + sizeof(*jitson) - 1) / sizeof(*jitson))
+                 + (jitson->type & SXE_JITSON_TYPE_HAS_SET ? 1 : 0);    // Plus the slot for the hash set, if any
 
     return sxe_jitson_size_indexed(jitson);
 }
@@ -485,6 +518,10 @@ sxe_jitson_array_free(struct sxe_jitson *jitson)
         jitson->type &= ~SXE_JITSON_TYPE_IS_OWN;    // Remove ownership so free_base won't try to free the first reference
     }
 
+    if ((jitson->type & (SXE_JITSON_TYPE_IS_REF | SXE_JITSON_TYPE_IS_UNIF | SXE_JITSON_TYPE_INDEXED)) == SXE_JITSON_TYPE_INDEXED
+     || (jitson->type & SXE_JITSON_TYPE_HAS_SET))
+        kit_free(*sxe_jitson_array_get_set_slot(jitson));    // Free the array's hash set, if any
+
     sxe_jitson_free_base(jitson);
 }
 
@@ -498,20 +535,23 @@ sxe_jitson_array_free(struct sxe_jitson *jitson)
 bool
 sxe_jitson_array_clone(const struct sxe_jitson *jitson, struct sxe_jitson *clone)
 {
-    size_t   size;
     unsigned i, len;
 
     if ((len = jitson->len) == 0)
         return true;
 
+    if (jitson->type & SXE_JITSON_TYPE_HAS_SET)
+        *sxe_jitson_array_get_set_slot(clone) = NULL;    // The clone's hash set, if needed, will be built on its first search
+
     if (jitson->type & SXE_JITSON_TYPE_INDEXED) {
-        if (!(clone->index = MOCKERROR(MOCK_FAIL_ARRAY_CLONE, NULL, ENOMEM, kit_malloc((size = (len + 1) * sizeof(jitson->index[0]))))))
+        if (!(clone->index = MOCKERROR(MOCK_FAIL_ARRAY_CLONE, NULL, ENOMEM, kit_malloc(SXE_JITSON_ARRAY_INDEX_SIZE(len)))))
         {
-            SXEL2("Failed to allocate %zu bytes to clone an array", (len + 1) * sizeof(jitson->index[0]));
+            SXEL2("Failed to allocate %zu bytes to clone an array", SXE_JITSON_ARRAY_INDEX_SIZE(len));
             return false;
         }
 
-        memcpy(clone->index, jitson->index, size);
+        memcpy(clone->index, jitson->index, (len + 1) * sizeof(jitson->index[0]));
+        *sxe_jitson_array_get_set_slot(clone) = NULL;    // The clone's hash set, if needed, will be built on its first search
     }
 
     for (i = 0; i < len; i++)
@@ -691,8 +731,11 @@ sxe_jitson_object_clone(const struct sxe_jitson *jitson, struct sxe_jitson *clon
     if (jitson->type & SXE_JITSON_TYPE_INDEXED) {    // If the object is already indexed, must clone it's index
         size = (len + 1) * sizeof(jitson->index[0]);
 
+        if (jitson->type & SXE_JITSON_TYPE_IS_PERF)    // Perfect hash indices also include the number of buckets and pilots
+            size += (1 + jitson->index[len + 1]) * sizeof(jitson->index[0]);
+
         if (!(clone->index = MOCKERROR(MOCK_FAIL_OBJECT_CLONE, NULL, ENOMEM, kit_malloc(size)))) {
-            SXEL2("Failed to allocate %zu bytes to clone an object", (len + 1) * sizeof(jitson->index[0]));
+            SXEL2("Failed to allocate %zu bytes to clone an object", size);
             return false;
         }
 
@@ -756,29 +799,61 @@ sxe_jitson_type_register_object(void)
                                     sxe_jitson_len_base, sxe_jitson_object_clone, sxe_jitson_object_build_json, NULL, NULL);
 }
 
+/* Lazy references are followed by a token that refers to the JSON they will be parsed from.
+ */
+static uint32_t
+sxe_jitson_reference_size(const struct sxe_jitson *jitson)
+{
+    return jitson->type & SXE_JITSON_TYPE_IS_LAZY ? 2 : 1;
+}
+
+static void
+sxe_jitson_reference_free(struct sxe_jitson *jitson)
+{
+    if (jitson->type & SXE_JITSON_TYPE_IS_LAZY)    // If the referred to value was parsed, free it
+        sxe_jitson_free(__atomic_exchange_n(&jitson->jitref, NULL, __ATOMIC_ACQ_REL));
+
+    sxe_jitson_free_base(jitson);
+}
+
+/* A clone of a lazy reference is parsed independently on first access.
+ */
+static bool
+sxe_jitson_reference_clone(const struct sxe_jitson *jitson, struct sxe_jitson *clone)
+{
+    if (jitson->type & SXE_JITSON_TYPE_IS_LAZY)
+        clone->jitref = NULL;
+
+    return true;
+}
+
 static int
 sxe_jitson_reference_test(const struct sxe_jitson *jitson)
 {
-    return jitson_types[sxe_jitson_get_type(jitson->jitref)].test(jitson->jitref);
+    jitson = sxe_jitson_dereference(jitson);
+    return jitson_types[sxe_jitson_get_type(jitson)].test(jitson);
 }
 
 static size_t
 sxe_jitson_reference_len(const struct sxe_jitson *jitson)
 {
-    return jitson_types[sxe_jitson_get_type(jitson->jitref)].len(jitson->jitref);
+    jitson = sxe_jitson_dereference(jitson);
+    return jitson_types[sxe_jitson_get_type(jitson)].len(jitson);
 }
 
 char *
 sxe_jitson_reference_build_json(const struct sxe_jitson *jitson, struct sxe_factory *factory)
 {
-    return jitson_types[sxe_jitson_get_type(jitson->jitref)].build_json(jitson->jitref, factory);
+    jitson = sxe_jitson_dereference(jitson);
+    return jitson_types[sxe_jitson_get_type(jitson)].build_json(jitson, factory);
 }
 
 uint32_t
 sxe_jitson_type_register_reference(void)
 {
-    return sxe_jitson_type_register("reference", sxe_jitson_free_base, sxe_jitson_reference_test, sxe_jitson_size_1,
-                                    sxe_jitson_reference_len, NULL, sxe_jitson_reference_build_json, NULL, NULL);
+    return sxe_jitson_type_register("reference", sxe_jitson_reference_free, sxe_jitson_reference_test,
+                                    sxe_jitson_reference_size, sxe_jitson_reference_len, sxe_jitson_reference_clone,
+                                    sxe_jitson_reference_build_json, NULL, NULL);
 }
 
 /**
@@ -933,8 +1008,8 @@ sxe_jitson_cmp(const struct sxe_jitson *left, const struct sxe_jitson *right)
     if (!left || !right)    // Garbage in, error out
         return SXE_JITSON_CMP_ERROR;
 
-    left  = sxe_jitson_is_reference(left)  ? left->jitref  : left;     // OK because refs to refs are not allowed
-    right = sxe_jitson_is_reference(right) ? right->jitref : right;    // OK because refs to refs are not allowed
+    left  = sxe_jitson_dereference(left);
+    right = sxe_jitson_dereference(right);
 
     uint32_t type = left->type & SXE_JITSON_TYPE_MASK;
 
@@ -957,8 +1032,8 @@ sxe_jitson_eq(const struct sxe_jitson *left, const struct sxe_jitson *right)
     int ret;
 
     SXEA1(left && right, "both left and right values must be provided");
-    left  = sxe_jitson_is_reference(left)  ? left->jitref  : left;     // OK because refs to refs are not allowed
-    right = sxe_jitson_is_reference(right) ? right->jitref : right;    // OK because refs to refs are not allowed
+    left  = sxe_jitson_dereference(left);
+    right = sxe_jitson_dereference(right);
 
     uint32_t type = left->type & SXE_JITSON_TYPE_MASK;
 
@@ -60,6 +60,61 @@ sxe_jitson_new(const char *json)
     return sxe_jitson_stack_get_jitson(stack);
 }
 
+/**
+ * Parse the array or object that a lazy reference refers to, if it hasn't already been parsed
+ *
+ * @param lazy A lazy reference, created when parsing nested arrays and objects with SXE_JITSON_FLAG_LAZY
+ *
+ * @return The parsed array or object, or sxe_jitson_null with errno set if it is invalid or memory can't be allocated
+ *
+ * @note If threads race to parse the same reference, the first to finish wins and the others free their values.
+ */
+const struct sxe_jitson *
+sxe_jitson_lazy_parse(const struct sxe_jitson *lazy)
+{
+    struct sxe_jitson_source  source;
+    struct sxe_jitson_stack   iou;
+    struct sxe_jitson_stack  *stack;
+    struct sxe_jitson_arena  *arena;
+    const struct sxe_jitson  *json   = lazy + 1;    // Token that refers to the JSON to parse
+    const struct sxe_jitson  *parsed = NULL;
+    const struct sxe_jitson  *value;
+
+    SXEA6(lazy->type & SXE_JITSON_TYPE_IS_LAZY, "Can't parse a jitson that isn't a lazy reference");
+
+    if ((value = __atomic_load_n(&lazy->jitref, __ATOMIC_ACQUIRE)))    // Already parsed
+        return value;
+
+    if (!(stack = sxe_jitson_stack_get_thread()))
+        return sxe_jitson_null;
+
+    arena = stack->arena;    // The parsed value is owned by the reference, so it must be allocated
+    sxe_jitson_stack_use_arena(stack, NULL);
+    sxe_jitson_stack_borrow(stack, &iou);
+    sxe_jitson_source_from_buffer(&source, json->reference, json->len, json->type);
+
+    if (sxe_jitson_stack_load_json(stack, &source))
+        value = sxe_jitson_stack_get_jitson(stack);
+
+    sxe_jitson_stack_return(stack, &iou);
+    sxe_jitson_stack_use_arena(stack, arena);
+
+    if (!value) {
+        SXEL2("Failed to parse lazily loaded JSON '%.*s': %s", (int)(json->len < 64 ? json->len : 64),
+              (const char *)json->reference, strerror(errno));
+        return sxe_jitson_null;
+    }
+
+    if (!__atomic_compare_exchange_n(&SXE_CAST_NOCONST(struct sxe_jitson *, lazy)->jitref, &parsed, value, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        SXEL4("Detected a race in lazy parsing");    /* COVERAGE EXCLUSION: Race condition */
+        sxe_jitson_free(value);                      /* COVERAGE EXCLUSION: Race condition */
+        value = parsed;                              /* COVERAGE EXCLUSION: Race condition */
+    }
+
+    return value;
+}
+
 /**
  * Get the unsigned integer value of a jitson whose type is SXE_JITSON_TYPE_NUMBER
  *
@@ -70,7 +125,7 @@ sxe_jitson_new(const char *json)
 uint64_t
 sxe_jitson_get_uint(const struct sxe_jitson *jitson)
 {
-    jitson = sxe_jitson_is_reference(jitson) ? jitson->jitref : jitson;    // OK because refs to refs are not allowed
+    jitson = sxe_jitson_dereference(jitson);
     SXEA6(sxe_jitson_get_type(jitson) == SXE_JITSON_TYPE_NUMBER,
           "Can't get the numeric value of a %s", sxe_jitson_type_to_str(jitson->type));
 
@@ -98,7 +153,7 @@ sxe_jitson_get_uint(const struct sxe_jitson *jitson)
 double
 sxe_jitson_get_number(const struct sxe_jitson *jitson)
 {
-    jitson = sxe_jitson_is_reference(jitson) ? jitson->jitref : jitson;    // OK because refs to refs are not allowed
+    jitson = sxe_jitson_dereference(jitson);
     SXEA6(sxe_jitson_get_type(jitson) == SXE_JITSON_TYPE_NUMBER,
           "Can't get the numeric value of a %s", sxe_jitson_type_to_str(jitson->type));
 
@@ -127,7 +182,7 @@ sxe_jitson_get_number(const struct sxe_jitson *jitson)
 const char *
 sxe_jitson_get_string(const struct sxe_jitson *jitson, size_t *len_out)
 {
-    jitson = sxe_jitson_is_reference(jitson) ? jitson->jitref : jitson;    // OK because refs to refs are not allowed
+    jitson = sxe_jitson_dereference(jitson);
     SXEA6(sxe_jitson_get_type(jitson) == SXE_JITSON_TYPE_STRING,
           "Can't get the string value of a %s", sxe_jitson_type_to_str(jitson->type));
 
@@ -145,38 +200,191 @@ sxe_jitson_get_string(const struct sxe_jitson *jitson, size_t *len_out)
 bool
 sxe_jitson_get_bool(const struct sxe_jitson *jitson)
 {
-    jitson = sxe_jitson_is_reference(jitson) ? jitson->jitref : jitson;    // OK because refs to refs are not allowed
+    jitson = sxe_jitson_dereference(jitson);
     SXEA6(sxe_jitson_get_type(jitson) == SXE_JITSON_TYPE_BOOL,
           "Can't get the boolean value of a %s", sxe_jitson_type_to_str(jitson->type));
     return jitson->boolean;
 }
 
-/**
- * Get a member's value from an object
+#define PERFECT_LOAD 4    // Average number of member names per bucket in a perfect hash index
+
+/* Reduce a 32 bit hash to the range [0, range) without a division
+ */
+static inline uint32_t
+perfect_reduce(uint32_t hash, uint32_t range)
+{
+    return (uint32_t)(((uint64_t)hash * range) >> 32);
+}
+
+/* Map a member name's hash to its slot given the pilot value of its bucket. The hash is remixed with the pilot (using the
+ * splitmix64 finalizer) so that each pilot value tried during construction is effectively an independent hash function.
+ */
+static inline uint32_t
+perfect_slot(uint64_t hash, uint32_t pilot, uint32_t len)
+{
+    hash ^= (pilot + 1) * 0x9E3779B97F4A7C15ULL;
+    hash  = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash  = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return perfect_reduce((uint32_t)((hash ^ (hash >> 31)) >> 32), len);
+}
+
+/* Order buckets by decreasing number of member names. The number of member names is in the upper 32 bits.
+ */
+static int
+perfect_bucket_cmp(const void *left, const void *right)
+{
+    uint64_t left_size = *(const uint64_t *)left, right_size = *(const uint64_t *)right;
+
+    return left_size < right_size ? 1 : left_size > right_size ? -1 : 0;
+}
+
+/* Build a minimal perfect hash index for an object by hashing member names into buckets, then finding a pilot value for each
+ * bucket, largest first, that displaces all of its member names into free slots (CHD/PTHash style). Lookups then take one
+ * hash of the name, one probe of the index and one comparison.
  *
- * @param jitson An object
- * @param name   The member name
- * @param len    Length of the member name or 0 if not known
+ * Index layout: [0, len) offset of the member name in each slot, [len] size of the object in jitsons (set by the caller),
+ * [len + 1] number of buckets, [len + 2, len + 2 + buckets) pilot value of each bucket.
  *
- * @return The member's value or NULL on error (ENOMEM) or if the member name was not found (ENOKEY).
+ * @return The index or NULL on allocation failure or if the member names can't be perfectly hashed (e.g. duplicate names)
  */
-const struct sxe_jitson *
-sxe_jitson_object_get_member(const struct sxe_jitson *jitson, const char *name, size_t len)
+static uint32_t *
+sxe_jitson_object_index_perfect(volatile struct sxe_jitson *vol_jit)
 {
-    volatile struct sxe_jitson *vol_jit;
-    struct sxe_jitson          *member;
-    const struct sxe_jitson    *con_memb;
-    uint32_t                   *bucket, *index;
-    const char                 *memname;
-    size_t                      memlen;
-    unsigned                    i;
-    bool                        is_race, do_lock;
+    const struct sxe_jitson_symbol *symbol;
+    struct sxe_jitson              *member;
+    uint64_t                       *hashes, *order, *taken;
+    uint32_t                       *index, *first, *sorted, *offsets;
+    void                           *scratch;
+    size_t                          memlen;
+    uint32_t                        buckets, bucket, len, pilot, pilot_max, slot, start, sum, count;
+    unsigned                        i, j, k;
+
+    len       = vol_jit->len;
+    buckets   = (len + PERFECT_LOAD - 1) / PERFECT_LOAD;
+    pilot_max = len <= UINT32_MAX / 64 ? len * 64 : UINT32_MAX;    // Chance that a free slot exists but isn't found is < e^-64
+
+    if (!(index = MOCKERROR(MOCK_FAIL_OBJECT_PERFECT, NULL, ENOMEM, kit_calloc(1, (len + 2 + buckets) * sizeof(*index)))))
+        return NULL;
+
+    /* Carve all scratch arrays out of one allocation. 64 bit arrays come first to keep them aligned.
+     */
+    if (!(scratch = kit_calloc(1, (len + buckets + (len + 63) / 64) * sizeof(uint64_t)
+                                + (buckets + 2 * len) * sizeof(uint32_t)))) {
+        kit_free(index);    /* COVERAGE EXCLUSION: Out of memory condition */
+        return NULL;        /* COVERAGE EXCLUSION: Out of memory condition */
+    }
 
-    jitson = sxe_jitson_is_reference(jitson) ? jitson->jitref : jitson;    // OK because refs to refs are not allowed
+    hashes  = scratch;
+    order   = hashes + len;
+    taken   = order + buckets;
+    first   = (uint32_t *)(taken + (len + 63) / 64);
+    sorted  = first + buckets;
+    offsets = sorted + len;
+
+    /* Hash each member name and count the member names in each bucket
+     */
+    for (member = SXE_CAST(struct sxe_jitson *, vol_jit + 1), i = 0; i < len; i++) {
+        if ((symbol = sxe_jitson_get_symbol(member)))    // Interned member names come with their hashes
+            hashes[i] = symbol->hash;
+        else {
+            memlen    = member->type & SXE_JITSON_TYPE_IS_REF ? strlen(member->reference) : member->len;
+            hashes[i] = sxe_hash_64(sxe_jitson_get_string(member, NULL), memlen);
+        }
+
+        offsets[i] = (uint32_t)(member - vol_jit);
+        first[perfect_reduce(hashes[i] >> 32, buckets)]++;
+        member     = member + sxe_jitson_size(member);    // Skip the member name
+        member     = member + sxe_jitson_size(member);    // Skip the member value
+    }
+
+    for (sum = 0, bucket = 0; bucket < buckets; bucket++) {    // Convert the counts into the start of each bucket
+        order[bucket] = (uint64_t)first[bucket] << 32 | bucket;
+        count         = first[bucket];
+        first[bucket] = sum;
+        sum          += count;
+    }
+
+    for (i = 0; i < len; i++)    // Group the member names by bucket. After this, first[bucket] is the end of the bucket
+        sorted[first[perfect_reduce(hashes[i] >> 32, buckets)]++] = i;
+
+    qsort(order, buckets, sizeof(*order), perfect_bucket_cmp);
+
+    for (i = 0; i < buckets && order[i] >> 32; i++) {    // For each nonempty bucket, largest first
+        bucket = (uint32_t)order[i];
+        start  = bucket ? first[bucket - 1] : 0;
+
+        for (j = start + 1; j < first[bucket]; j++)    // Names with identical hashes can't be separated
+            for (k = start; k < j; k++)
+                if (hashes[sorted[j]] == hashes[sorted[k]]) {
+                    SXEL6("Object has duplicate member names or a 64 bit hash collision");
+                    goto ERROR;
+                }
+
+        for (pilot = 0; ; pilot++) {
+            if (pilot == pilot_max) {
+                /* COVERAGE EXCLUSION: Astronomically unlikely */
+                SXEL6("Failed to place a bucket of %u member names in a perfect hash", (unsigned)(order[i] >> 32));
+                goto ERROR;    /* COVERAGE EXCLUSION: Astronomically unlikely */
+            }
+
+            for (j = start; j < first[bucket]; j++) {    // Claim the slots of all names in the bucket, stopping at a conflict
+                slot = perfect_slot(hashes[sorted[j]], pilot, len);
+
+                if (taken[slot / 64] & (1ULL << slot % 64))
+                    break;
+
+                taken[slot / 64] |= 1ULL << slot % 64;
+            }
+
+            if (j == first[bucket])    // All names were placed
+                break;
+
+            while (j-- > start) {    // Release the slots claimed using this pilot value
+                slot              = perfect_slot(hashes[sorted[j]], pilot, len);
+                taken[slot / 64] &= ~(1ULL << slot % 64);
+            }
+        }
+
+        index[len + 2 + bucket] = pilot;
+
+        for (j = start; j < first[bucket]; j++)
+            index[perfect_slot(hashes[sorted[j]], pilot, len)] = offsets[sorted[j]];
+    }
+
+    for (i = 0; i < len; i++)    // Each member name is alone in its slot
+        vol_jit[offsets[i]].link = 0;
+
+    index[len + 1] = buckets;
+    kit_free(scratch);
+    return index;
+
+ERROR:
+    kit_free(scratch);
+    kit_free(index);
+    return NULL;
+}
+
+/* Get a member's value from an object given its name and, if it's interned, its symbol
+ */
+static const struct sxe_jitson *
+sxe_jitson_object_find_member(const struct sxe_jitson *jitson, const char *name, size_t len,
+                              const struct sxe_jitson_symbol *symbol)
+{
+    volatile struct sxe_jitson     *vol_jit;
+    struct sxe_jitson              *member;
+    const struct sxe_jitson        *con_memb;
+    const struct sxe_jitson_symbol *memsym;
+    uint32_t                       *bucket, *index;
+    const char                     *memname;
+    uint64_t                        hash;
+    size_t                          memlen;
+    unsigned                        i;
+    bool                            is_race, do_lock;
+
+    jitson = sxe_jitson_dereference(jitson);
     vol_jit = SXE_CAST_NOCONST(volatile struct sxe_jitson *, jitson);
     SXEA1(sxe_jitson_get_type(jitson) == SXE_JITSON_TYPE_OBJECT, "Can't get a member value from a %s",
           sxe_jitson_type_to_str(vol_jit->type));
-    len = len ?: strlen(name);    // SonarQube False Positive
 
     if (vol_jit->len == 0) {    // Empty object
         errno = ENOKEY;
@@ -188,23 +396,35 @@ sxe_jitson_object_get_member(const struct sxe_jitson *jitson, const char *name,
             SXEA1(pthread_mutex_lock(&type_indexing) == 0, "Can't take indexing lock");
 
         if (!(is_race = (vol_jit->type & SXE_JITSON_TYPE_INDEXED))) {    // Recheck under the lock in case of a race
-            /* Allocate an array of len buckets + 1 to store the size in jitsons
-            */
-            if (!(index = MOCKERROR(MOCK_FAIL_OBJECT_GET_MEMBER, NULL, ENOMEM,
-                                    kit_calloc(1, (vol_jit->len + 1) * sizeof(uint32_t))))) {
-                if (do_lock)
-                    pthread_mutex_unlock(&type_indexing);
-                return NULL;
-            }
-
-            for (member = SXE_CAST(struct sxe_jitson *, vol_jit + 1), i = 0; i < vol_jit->len; i++) {
-                // Only time it's safe to use vol_memb->len to get the length of the member name (if it's not a reference)
-                memlen       = member->type & SXE_JITSON_TYPE_IS_REF ? strlen(member->reference) : member->len;    // SonarQube False Positive
-                bucket       = &index[sxe_hash_sum(sxe_jitson_get_string(member, NULL), memlen) % vol_jit->len];
-                member->link = *bucket;
-                *bucket      = (uint32_t)(member - vol_jit);
-                member       = member + sxe_jitson_size(member);    // Skip the member name
-                member       = member + sxe_jitson_size(member);    // Skip the member value
+            /* Large optimized objects get a perfect hash index. If one can't be built, fall back to a chained index.
+             */
+            if ((vol_jit->type & SXE_JITSON_TYPE_IS_PERF) && !(index = sxe_jitson_object_index_perfect(vol_jit)))
+                vol_jit->type &= ~SXE_JITSON_TYPE_IS_PERF;
+
+            if (!(vol_jit->type & SXE_JITSON_TYPE_IS_PERF)) {
+                /* Allocate an array of len buckets + 1 to store the size in jitsons
+                 */
+                if (!(index = MOCKERROR(MOCK_FAIL_OBJECT_GET_MEMBER, NULL, ENOMEM,
+                                        kit_calloc(1, (vol_jit->len + 1) * sizeof(uint32_t))))) {
+                    if (do_lock)
+                        pthread_mutex_unlock(&type_indexing);
+                    return NULL;
+                }
+
+                for (member = SXE_CAST(struct sxe_jitson *, vol_jit + 1), i = 0; i < vol_jit->len; i++) {
+                    if ((memsym = sxe_jitson_get_symbol(member)))    // Interned member names come with their hashes
+                        bucket = &index[memsym->sum % vol_jit->len];
+                    else {
+                        // Only time it's safe to use vol_memb->len to get the length of the member name (if it's not a reference)
+                        memlen = member->type & SXE_JITSON_TYPE_IS_REF ? strlen(member->reference) : member->len;    // SonarQube False Positive
+                        bucket = &index[sxe_hash_sum(sxe_jitson_get_string(member, NULL), memlen) % vol_jit->len];
+                    }
+
+                    member->link = *bucket;
+                    *bucket      = (uint32_t)(member - vol_jit);
+                    member       = member + sxe_jitson_size(member);    // Skip the member name
+                    member       = member + sxe_jitson_size(member);    // Skip the member value
+                }
             }
 
             /* ORDER IS IMPORTANT HERE. Must save vol_jit->integer before overwriting it by setting vol_jit->index.
@@ -222,10 +442,37 @@ sxe_jitson_object_get_member(const struct sxe_jitson *jitson, const char *name,
             SXEL4("Detected a race in just in time object indexing");    /* COVERAGE EXCLUSION: Race condition */
     }
 
-    for (i = jitson->index[sxe_hash_sum(name, len) % jitson->len]; i != 0; i = con_memb->link) {
+    if (jitson->type & SXE_JITSON_TYPE_IS_PERF) {    // Perfect hash index: one probe and one comparison
+        hash     = symbol ? symbol->hash : sxe_hash_64(name, len);
+        i        = jitson->index[jitson->len + 2 + perfect_reduce(hash >> 32, jitson->index[jitson->len + 1])];
+        con_memb = &jitson[jitson->index[perfect_slot(hash, i, jitson->len)]];
+        SXEA6(sxe_jitson_get_type(con_memb) == SXE_JITSON_TYPE_STRING, "Object keys must be strings, not %s",
+              sxe_jitson_type_to_str(con_memb->type));
+        memname  = con_memb->type & SXE_JITSON_TYPE_IS_REF ? con_memb->reference : con_memb->string;
+
+        if (memname == name)                                // Same symbol
+            return con_memb + sxe_jitson_size(con_memb);    // Skip the member name, returning the value
+
+        if (!(symbol && (con_memb->type & SXE_JITSON_TYPE_IS_SYM))    // Different symbols are different names
+         && strncmp(memname, name, len) == 0 && memname[len] == '\0')  // Member names are always NUL terminated
+            return con_memb + sxe_jitson_size(con_memb);                // Skip the member name, returning the value
+
+        errno = ENOKEY;
+        return NULL;
+    }
+
+    for (i = jitson->index[(symbol ? symbol->sum : sxe_hash_sum(name, len)) % jitson->len]; i != 0; i = con_memb->link) {
         con_memb = &jitson[i];
         SXEA6(sxe_jitson_get_type(con_memb) == SXE_JITSON_TYPE_STRING, "Object keys must be strings, not %s",
               sxe_jitson_type_to_str(con_memb->type));
+
+        if ((memsym = sxe_jitson_get_symbol(con_memb))) {    // Interned member names are compared by symbol if possible
+            if (memsym == symbol || (!symbol && memsym->len == len && memcmp(memsym->name, name, len) == 0))
+                return con_memb + 1;    // Skip the member name, returning the value
+
+            continue;
+        }
+
         memname = sxe_jitson_get_string(con_memb, &memlen);
         SXEA6(memname, "A member name should always be a valid string");
 
@@ -237,6 +484,41 @@ sxe_jitson_object_get_member(const struct sxe_jitson *jitson, const char *name,
     return NULL;
 }
 
+/**
+ * Get a member's value from an object
+ *
+ * @param jitson An object
+ * @param name   The member name
+ * @param len    Length of the member name or 0 if not known
+ *
+ * @return The member's value or NULL on error (ENOMEM) or if the member name was not found (ENOKEY).
+ *
+ * @note Objects of at least SXE_JITSON_PERFECT_MIN members that were parsed or constructed with SXE_JITSON_FLAG_OPTIMIZE are
+ *       indexed with a perfect hash on first access.
+ */
+const struct sxe_jitson *
+sxe_jitson_object_get_member(const struct sxe_jitson *jitson, const char *name, size_t len)
+{
+    return sxe_jitson_object_find_member(jitson, name, len ?: strlen(name), NULL);    // SonarQube False Positive
+}
+
+/**
+ * Get a member's value from an object given the member name's interned symbol
+ *
+ * @param jitson An object
+ * @param symbol The member name's symbol, from sxe_jitson_symbol_intern
+ *
+ * @return The member's value or NULL on error (ENOMEM) or if the member name was not found (ENOKEY).
+ *
+ * @note The member name's hash isn't recomputed, and member names in objects parsed with SXE_JITSON_FLAG_INTERN are compared
+ *       by address rather than by content.
+ */
+const struct sxe_jitson *
+sxe_jitson_object_get_member_symbol(const struct sxe_jitson *jitson, const struct sxe_jitson_symbol *symbol)
+{
+    return sxe_jitson_object_find_member(jitson, symbol->name, symbol->len, symbol);
+}
+
 /**
  * Get an element's value from an array or an array-like jitson
  *
@@ -256,7 +538,7 @@ sxe_jitson_array_get_element(const struct sxe_jitson *jitson, size_t idx)
     unsigned                    i;
     bool                        is_race, do_lock;
 
-    vol_jit = SXE_CAST_NOCONST(volatile struct sxe_jitson *, sxe_jitson_is_reference(jitson) ? jitson->jitref : jitson);
+    vol_jit = SXE_CAST_NOCONST(volatile struct sxe_jitson *, sxe_jitson_dereference(jitson));
 
     if (idx >= vol_jit->len) {
         SXEL2("Array element index %zu is not less than len %u", idx, vol_jit->len);
@@ -282,10 +564,10 @@ sxe_jitson_array_get_element(const struct sxe_jitson *jitson, size_t idx)
             SXEA1(pthread_mutex_lock(&type_indexing) == 0, "Can't take indexing lock");
 
         if (!(is_race = (vol_jit->type & SXE_JITSON_TYPE_INDEXED))) {    // Recheck under the lock in case of a race
-            /* Allocate an array of len offsets + 1 to store the size in jitsons
+            /* Allocate an array of len offsets + 1 to store the size in jitsons and a pointer to the array's hash set
              */
             if (!(index = MOCKERROR(MOCK_FAIL_ARRAY_GET_ELEMENT, NULL, ENOMEM,
-                                    kit_malloc((vol_jit->len + 1) * sizeof(uint32_t))))) {
+                                    kit_malloc(SXE_JITSON_ARRAY_INDEX_SIZE(vol_jit->len))))) {
                 if (do_lock)
                     pthread_mutex_unlock(&type_indexing);
                 return NULL;
@@ -301,6 +583,7 @@ sxe_jitson_array_get_element(const struct sxe_jitson *jitson, size_t idx)
              */
             index[vol_jit->len] = (uint32_t)vol_jit->integer;    // Store the size at the end
             vol_jit->index      = index;
+            *sxe_jitson_array_get_set_slot(SXE_CAST_NOCONST(const struct sxe_jitson *, vol_jit)) = NULL;
             vol_jit->type      |= SXE_JITSON_TYPE_INDEXED;
         }
 
@@ -316,6 +599,190 @@ sxe_jitson_array_get_element(const struct sxe_jitson *jitson, size_t idx)
     return SXE_CAST_NOCONST(const struct sxe_jitson *, &vol_jit[vol_jit->index[idx]]);
 }
 
+/* A hash set of the elements of an array, allowing elements equal to a value to be found in O(1)
+ */
+struct sxe_jitson_array_set {
+    uint32_t mask;        // Number of slots - 1. The number of slots is a power of 2 at least twice the length of the array.
+    uint32_t unhashed;    // Index of the first element that can't be hashed (e.g. a nested array) or the array's length if none
+    uint32_t slots[];     // Index + 1 of the first element with each distinct value, or 0 for an empty slot
+};
+
+/* Hash a value consistently with sxe_jitson_eq, returning false if values of its type can't be hashed
+ */
+static bool
+sxe_jitson_hash_value(const struct sxe_jitson *value, uint64_t *hash_out)
+{
+    const struct sxe_jitson_symbol *symbol;
+    const char                     *string;
+    size_t                          len;
+    double                          number;
+
+    value = sxe_jitson_dereference(value);
+
+    switch (sxe_jitson_get_type_no_deref(value)) {
+    case SXE_JITSON_TYPE_NULL:
+        *hash_out = 0;
+        return true;
+
+    case SXE_JITSON_TYPE_BOOL:
+        *hash_out = value->boolean;
+        return true;
+
+    case SXE_JITSON_TYPE_NUMBER:    // Unsigned integers and doubles with the same value must have the same hash
+        if (value->type & SXE_JITSON_TYPE_IS_UINT)
+            *hash_out = value->integer;
+        else if ((number = value->number) >= 0.0 && number < 18446744073709551616.0 && number == (double)(uint64_t)number)
+            *hash_out = (uint64_t)number;
+        else
+            memcpy(hash_out, &number, sizeof(*hash_out));
+
+        *hash_out *= 0x9E3779B97F4A7C15ULL;    // Spread the bits of small integers
+        return true;
+
+    case SXE_JITSON_TYPE_STRING:
+        if ((symbol = sxe_jitson_get_symbol(value)))    // Interned strings have already been hashed
+            *hash_out = symbol->hash;
+        else {
+            string    = sxe_jitson_get_string(value, &len);
+            *hash_out = sxe_hash_64(string, len);
+        }
+
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+static inline uint32_t
+array_set_slot(const struct sxe_jitson_array_set *set, uint64_t hash)
+{
+    return (uint32_t)(hash ^ (hash >> 32)) & set->mask;
+}
+
+/* Get an element of an array being hashed, which is either uniform or indexed
+ */
+static inline const struct sxe_jitson *
+array_set_element(const struct sxe_jitson *array, uint32_t i)
+{
+    if (array->type & SXE_JITSON_TYPE_IS_UNIF)
+        return &array[1 + i * (array->uniform.size / sizeof(*array))];
+
+    return &array[array->index[i]];
+}
+
+/* Build a hash set of the elements of a uniform or indexed array. Only the first of equal elements is added.
+ */
+static struct sxe_jitson_array_set *
+sxe_jitson_array_set_build(const struct sxe_jitson *array)
+{
+    struct sxe_jitson_array_set *set;
+    const struct sxe_jitson     *element;
+    uint64_t                     hash;
+    uint32_t                     i, slot, slots;
+
+    for (slots = 2; slots < 2 * array->len;)
+        slots *= 2;
+
+    if (!(set = MOCKERROR(MOCK_FAIL_ARRAY_SET, NULL, ENOMEM, kit_calloc(1, sizeof(*set) + slots * sizeof(set->slots[0])))))
+        return NULL;
+
+    set->mask     = slots - 1;
+    set->unhashed = array->len;
+
+    for (i = 0; i < array->len; i++) {
+        element = array_set_element(array, i);
+
+        if (!sxe_jitson_hash_value(element, &hash)) {
+            if (set->unhashed == array->len)
+                set->unhashed = i;
+
+            continue;
+        }
+
+        for (slot = array_set_slot(set, hash); set->slots[slot]; slot = (slot + 1) & set->mask)
+            if (sxe_jitson_eq(element, array_set_element(array, set->slots[slot] - 1)) == SXE_JITSON_TEST_TRUE)
+                break;    // A previous element is equal to this one
+
+        if (!set->slots[slot])
+            set->slots[slot] = i + 1;
+    }
+
+    return set;
+}
+
+/**
+ * Find the first element of an array that is equal to a value using a hash set of the array's elements
+ *
+ * @param jitson   An array or array-like value for which sxe_jitson_array_is_hashed is true
+ * @param value    The value to look for, which must be null, a boolean, a number, or a string
+ * @param unhashed NULL or a pointer to a variable set to the index of the first element that couldn't be hashed (e.g. a nested
+ *                 array or object), or the length of the array if all elements were hashed
+ *
+ * @return The index of the element, the length of the array if there is no equal element, or ~0U on error (ENOMEM, or EINVAL
+ *         if the value can't be hashed)
+ *
+ * @note The hash set is built thread safely on the first search of the array, and is freed with it
+ */
+unsigned
+sxe_jitson_array_find(const struct sxe_jitson *jitson, const struct sxe_jitson *value, unsigned *unhashed)
+{
+    struct sxe_jitson_array_set  *set, **set_slot;
+    const struct sxe_jitson      *element;
+    uint64_t                      hash;
+    uint32_t                      slot;
+    bool                          do_lock;
+
+    jitson = sxe_jitson_dereference(jitson);
+    SXEA6(!(jitson->type & SXE_JITSON_TYPE_IS_REF)
+       && (!(jitson->type & SXE_JITSON_TYPE_IS_UNIF) || (jitson->type & SXE_JITSON_TYPE_HAS_SET)),
+          "Can't hash a uniform array with no slot for a hash set or a concatenation of arrays");
+
+    if (!sxe_jitson_hash_value(value, &hash)) {
+        errno = EINVAL;
+        return ~0U;
+    }
+
+    if (jitson->len == 0) {
+        if (unhashed)
+            *unhashed = 0;
+
+        return 0;
+    }
+
+    if (!(jitson->type & (SXE_JITSON_TYPE_INDEXED | SXE_JITSON_TYPE_IS_UNIF))    // Index the array if needed
+     && !sxe_jitson_array_get_element(jitson, 0))
+        return ~0U;
+
+    set_slot = sxe_jitson_array_get_set_slot(jitson);
+
+    if (!(set = __atomic_load_n(set_slot, __ATOMIC_ACQUIRE))) {    // If not already, build the hash set thread safely
+        if ((do_lock = !sxe_jitson_is_local(jitson)))
+            SXEA1(pthread_mutex_lock(&type_indexing) == 0, "Can't take indexing lock");
+
+        if (!(set = __atomic_load_n(set_slot, __ATOMIC_ACQUIRE)) && (set = sxe_jitson_array_set_build(jitson)))
+            __atomic_store_n(set_slot, set, __ATOMIC_RELEASE);    // Publish the hash set only once it's complete
+
+        if (do_lock)
+            pthread_mutex_unlock(&type_indexing);
+
+        if (!set)
+            return ~0U;
+    }
+
+    if (unhashed)
+        *unhashed = set->unhashed;
+
+    for (slot = array_set_slot(set, hash); set->slots[slot]; slot = (slot + 1) & set->mask) {
+        element = array_set_element(jitson, set->slots[slot] - 1);
+
+        if (sxe_jitson_eq(value, element) == SXE_JITSON_TEST_TRUE)
+            return set->slots[slot] - 1;
+    }
+
+    return jitson->len;
+}
+
 struct sxe_jitson *
 sxe_jitson_make_null(struct sxe_jitson *jitson)
 {
@@ -372,7 +839,7 @@ sxe_jitson_make_reference(struct sxe_jitson *jitson, const struct sxe_jitson *to
 {
     jitson->type   = SXE_JITSON_TYPE_REFERENCE;
     // Don't create references to references
-    jitson->jitref = (to->type & SXE_JITSON_TYPE_MASK) == SXE_JITSON_TYPE_REFERENCE ? to->jitref : to;
+    jitson->jitref = sxe_jitson_dereference(to);
     return jitson;
 }
 
@@ -389,7 +856,7 @@ sxe_jitson_dup(const struct sxe_jitson *jitson)
     struct sxe_jitson *dup;
     size_t             size;
 
-    jitson = sxe_jitson_is_reference(jitson) ? jitson->jitref : jitson;    // OK because refs to refs are not allowed
+    jitson = sxe_jitson_dereference(jitson);
     size   = sxe_jitson_size(jitson) * sizeof(*jitson);
 
     if (!(dup = MOCKERROR(MOCK_FAIL_DUP, NULL, ENOMEM, kit_malloc(size))))
@@ -411,9 +878,19 @@ sxe_jitson_to_json(const struct sxe_jitson *jitson, size_t *len_out)
 {
     struct sxe_factory factory[1];
     char              *json;
+    size_t             estimate;
 
     SXEE7("(jitson=%p,len_out=%p)", jitson, len_out);
-    sxe_factory_alloc_make(factory, 0, 0);
+
+    /* Estimate the size of the JSON up front so that the factory rarely has to grow it. Strings usually need their length
+     * plus quotes; anything else typically needs no more than one byte of JSON per byte of jitson.
+     */
+    if (sxe_jitson_get_type(jitson) == SXE_JITSON_TYPE_STRING)
+        estimate = sxe_jitson_len(jitson) + 2 + sxe_jitson_len(jitson) / 8;
+    else
+        estimate = sxe_jitson_size(jitson) * SXE_JITSON_TOKEN_SIZE;
+
+    sxe_factory_alloc_make(factory, estimate, estimate > 4096 ? estimate : 0);    // Grow by at least the estimate
     json = sxe_jitson_build_json(jitson, factory) ? sxe_factory_remove(factory, len_out) : NULL;
     SXER7("return json=%p", json);
     return json;
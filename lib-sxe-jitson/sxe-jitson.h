@@ -37,6 +37,9 @@
 #define SXE_JITSON_FLAG_ALLOW_IDENTS 0x00000004    // Return parsed identifiers (default if sxe_jitson_ident_register called)
 #define SXE_JITSON_FLAG_OPTIMIZE     0x00000008    // Slows parsing but allows smaller values and faster operations.
 #define SXE_JITSON_FLAG_CHECK_ORDER  SXE_JITSON_FLAG_OPTIMIZE    // Check whether arrays are ordered (backward compatibility)
+#define SXE_JITSON_FLAG_INTERN       0x00000010    // Intern member names as shared symbols when parsing
+#define SXE_JITSON_FLAG_VALID_UTF8   0x00000020    // Fail to parse strings that aren't valid UTF-8 (escapes aren't checked)
+#define SXE_JITSON_FLAG_LAZY         0x00000040    // Don't parse nested arrays and objects until accessed. JSON must persist.
 
 #define SXE_JITSON_MIN_TYPES 8    // The minimum number of types for JSON
 
@@ -52,6 +55,10 @@
 #define SXE_JITSON_TYPE_MASK     0x0000FFFF    // Bits included in the type enumeration
 #define SXE_JITSON_TYPE_MK_SORT  0x00010000    // Set to allow insertion in order into a sorted array
 #define SXE_JITSON_TYPE_IS_LOCAL 0x00020000    // Flag set if the object is thread-local
+#define SXE_JITSON_TYPE_IS_PERF  0x00040000    // Flag set for large optimized objects that are indexed with a perfect hash
+#define SXE_JITSON_TYPE_IS_SYM   0x00080000    // Flag set for strings that are references to the name of an interned symbol
+#define SXE_JITSON_TYPE_IS_LAZY  0x00100000    // Flag set for references to JSON arrays or objects that are parsed when accessed
+#define SXE_JITSON_TYPE_HAS_SET  0x00200000    // Flag set for large uniform arrays, which are followed by a slot for a hash set
 #define SXE_JITSON_TYPE_IS_HOMO  0x01000000    // Flag set for arrays that contain homogenously typed elements
 #define SXE_JITSON_TYPE_IS_UNIF  0x02000000    // Flag set for arrays that contain uniformly sized elements (so no index needed)
 #define SXE_JITSON_TYPE_IS_ORD   0x04000000    // Flag set for arrays that are ordered (element types must be homogenous)
@@ -72,16 +79,22 @@
 #define SXE_JITSON_CMP_ERROR (INT_MAX)
 
 #define SXE_JITSON_STACK_ERROR (~0U)
+#define SXE_JITSON_PERFECT_MIN 64    // Minimum number of members for an optimized object to be given a perfect hash index
+#define SXE_JITSON_HASHED_MIN  16    // Minimum number of elements for an unordered array to be searched using a hash set
 #define SXE_JITSON_TOKEN_SIZE  sizeof(struct sxe_jitson)
 #define SXE_JITSON_STRING_SIZE sizeof(((struct sxe_jitson *)0)->string)
+#define SXE_JITSON_NUMBER_MAX_LEN 24    // Enough space for the largest double and the largest uint64_t
 
 struct sxe_jitson;          // Partial structure decalaration required due to mutually recursive definition
 struct sxe_jitson_stack;    // Partial structure decalaration required due to mutually recursive definition
+struct sxe_jitson_array_set;    // Hash set of the elements of an array; see sxe-jitson.c
+struct sxe_jitson_arena;        // Arena of jitsons that are freed together; see sxe-jitson-arena.c
 typedef bool (*sxe_jitson_castfunc_t)(struct sxe_jitson_stack *stack, const struct sxe_jitson *from);
 
 /* A jitson token. Copied strings of > 7 bytes length continue into the next token. Collections (arrays and objects) may
  * initially store the size in jitsons of the entire collection in integer. If so, the size is atomically replaced by the index
- * on first access.
+ * on first access. A lazy reference's jitref is NULL until the first access parses the array or object it refers to. It is
+ * followed by a token whose type is the parsing flags, whose len is the length of the JSON, and whose reference points to it.
  */
 struct sxe_jitson {
     union {
@@ -115,6 +128,17 @@ struct sxe_jitson {
     };
 };
 
+/* An interned member name. A symbol's address identifies it for as long as a reference to it is held.
+ */
+struct sxe_jitson_symbol {
+    struct sxe_jitson_symbol *next;       // Next symbol in the same bucket of the symbol table, or retired symbol
+    uint64_t                  hash;       // sxe_hash_64 of the name, as used by perfect hash indices
+    uint32_t                  sum;        // sxe_hash_sum of the name, as used by chained indices
+    uint32_t                  refs;       // Number of references to the symbol
+    uint32_t                  len;        // Length of the name
+    char                      name[];     // The name, NUL terminated
+};
+
 struct sxe_jitson_source {
     const char *json;     // Pointer into a buffer containing JSON to be parsed
     const char *next;     // Pointer to the next character to be parsed
@@ -126,12 +150,13 @@ struct sxe_jitson_source {
 };
 
 struct sxe_jitson_stack {
-    unsigned           maximum;    // Number of jitsons currently allocated to the stack
-    unsigned           count;      // Number of jitsons currently in use on the stack
-    struct sxe_jitson *jitsons;
-    unsigned           open;       // Index + 1 of the deepest open collection that's under construction or 0 if none
-    unsigned           last;       // Index of the last jitson object added to the stack
-    unsigned           borrow;     // Point at which this stack was last borrowed
+    unsigned                 maximum;    // Number of jitsons currently allocated to the stack
+    unsigned                 count;      // Number of jitsons currently in use on the stack
+    struct sxe_jitson       *jitsons;
+    unsigned                 open;       // Index + 1 of the deepest open collection that's under construction or 0 if none
+    unsigned                 last;       // Index of the last jitson object added to the stack
+    unsigned                 borrow;     // Point at which this stack was last borrowed
+    struct sxe_jitson_arena *arena;      // Arena jitsons gotten from the stack are copied into, or NULL to allocate them
 };
 
 /* Constants. sxe_jitson_type_initialize must be called before using them
@@ -143,8 +168,13 @@ extern const struct sxe_jitson *sxe_jitson_null;
 extern uint32_t sxe_jitson_flags;    // JSON extensions allowed by default (override with a sxe_jitson_source)
 
 #include "sxe-jitson-proto.h"
+#include "sxe-jitson-arena-proto.h"
+#include "sxe-jitson-diff-proto.h"
+#include "sxe-jitson-number-proto.h"
+#include "sxe-jitson-parallel-proto.h"
 #include "sxe-jitson-source-proto.h"
 #include "sxe-jitson-stack-proto.h"
+#include "sxe-jitson-symbol-proto.h"
 #include "sxe-jitson-type-proto.h"
 
 /**
@@ -160,6 +190,39 @@ sxe_jitson_get_type_no_deref(const struct sxe_jitson *jitson)
     return jitson->type & SXE_JITSON_TYPE_MASK;
 }
 
+#define SXE_JITSON_SWAR_ONES  0x0101010101010101ULL
+#define SXE_JITSON_SWAR_HIGHS 0x8080808080808080ULL
+#define SXE_JITSON_SWAR_LOWS  0x7F7F7F7F7F7F7F7FULL
+
+/* Return a word with the high bit set in each byte of an 8 byte word that is special in a JSON string: a control character
+ * (< 0x20), '"' or '\\'. A byte is zero after XORing with a character iff it equals the character. On little endian hosts,
+ * only the bit of the first special byte in memory order is guaranteed to be exact, since a borrow can only carry into later
+ * bytes. On big endian hosts, the first byte in memory order is the high byte, so every bit must be exact.
+ */
+static inline uint64_t
+sxe_jitson_swar_special(uint64_t word)
+{
+    uint64_t quote     = word ^ (SXE_JITSON_SWAR_ONES * '"');
+    uint64_t backslash = word ^ (SXE_JITSON_SWAR_ONES * '\\');
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return ((word - SXE_JITSON_SWAR_ONES * 0x20) | (quote - SXE_JITSON_SWAR_ONES) | (backslash - SXE_JITSON_SWAR_ONES))
+         & ~word & SXE_JITSON_SWAR_HIGHS;
+#else    // Adding to the low 7 bits of each byte can't carry into the next byte, so these tests are exact
+    return ~((((word & SXE_JITSON_SWAR_LOWS) + SXE_JITSON_SWAR_ONES * 0x60) | word)
+           & (((quote & SXE_JITSON_SWAR_LOWS) + SXE_JITSON_SWAR_LOWS) | quote)
+           & (((backslash & SXE_JITSON_SWAR_LOWS) + SXE_JITSON_SWAR_LOWS) | backslash)) & SXE_JITSON_SWAR_HIGHS;
+#endif
+}
+
+/* Given a nonzero mask returned by sxe_jitson_swar_special, return the offset of the first special byte in the word
+ */
+static inline unsigned
+sxe_jitson_swar_first(uint64_t mask)
+{
+    return (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ? __builtin_ctzll(mask) : __builtin_clzll(mask)) >> 3;
+}
+
 /* Inline functions to create an easier to use interface.
  */
 
@@ -184,7 +247,61 @@ sxe_jitson_is_reference(const struct sxe_jitson *jitson)
 static inline const struct sxe_jitson *
 sxe_jitson_dereference(const struct sxe_jitson *jitson)
 {
-    return sxe_jitson_is_reference(jitson) ? jitson->jitref : jitson;    // OK because refs to refs are not allowed
+    if (!sxe_jitson_is_reference(jitson))
+        return jitson;
+
+    // OK because refs to refs are not allowed
+    return jitson->type & SXE_JITSON_TYPE_IS_LAZY ? sxe_jitson_lazy_parse(jitson) : jitson->jitref;
+}
+
+/**
+ * Get the symbol that a string jitson refers to
+ *
+ * @return The symbol or NULL if the jitson is not an interned member name
+ */
+static inline const struct sxe_jitson_symbol *
+sxe_jitson_get_symbol(const struct sxe_jitson *jitson)
+{
+    if (!(jitson->type & SXE_JITSON_TYPE_IS_SYM))
+        return NULL;
+
+    return (const struct sxe_jitson_symbol *)((const char *)jitson->reference - offsetof(struct sxe_jitson_symbol, name));
+}
+
+/* The index of an array is the offsets of its elements followed by its size, then a pointer, aligned, to its hash set if any
+ */
+#define SXE_JITSON_ARRAY_INDEX_SIZE(len) ((((len) + 2) & ~1U) * sizeof(uint32_t) + sizeof(struct sxe_jitson_array_set *))
+
+/* Get the slot for the pointer to an array's hash set, which is in its index or, for a uniform array with
+ * SXE_JITSON_TYPE_HAS_SET, in the jitson after its elements
+ */
+static inline struct sxe_jitson_array_set **
+sxe_jitson_array_get_set_slot(const struct sxe_jitson *array)
+{
+    if (array->type & SXE_JITSON_TYPE_IS_UNIF)
+        return (struct sxe_jitson_array_set **)&array[1 + array->len * (array->uniform.size / sizeof(*array))];
+
+    return (struct sxe_jitson_array_set **)&array->index[(array->len + 2) & ~1U];
+}
+
+/* Return true if an array is large enough and has a place to keep a hash set of its elements (see sxe_jitson_array_find)
+ */
+static inline bool
+sxe_jitson_array_is_hashed(const struct sxe_jitson *array)
+{
+    return array->len >= SXE_JITSON_HASHED_MIN && !(array->type & SXE_JITSON_TYPE_IS_REF)
+        && (!(array->type & SXE_JITSON_TYPE_IS_UNIF) || (array->type & SXE_JITSON_TYPE_HAS_SET));
+}
+
+/* Return true if a value can be looked up in an array's hash set
+ */
+static inline bool
+sxe_jitson_is_hashable(const struct sxe_jitson *value)
+{
+    uint32_t type = sxe_jitson_get_type(value);
+
+    return type == SXE_JITSON_TYPE_NULL || type == SXE_JITSON_TYPE_BOOL || type == SXE_JITSON_TYPE_NUMBER
+        || type == SXE_JITSON_TYPE_STRING;
 }
 
 static inline bool
@@ -507,6 +624,14 @@ sxe_jitson_len_array(const struct sxe_jitson *jitson)
 #define MOCK_FAIL_STACK_EXPAND           ((char *)sxe_jitson_new + 4)
 #define MOCK_FAIL_OBJECT_GET_MEMBER      ((char *)sxe_jitson_new + 5)
 #define MOCK_FAIL_ARRAY_GET_ELEMENT      ((char *)sxe_jitson_new + 6)
+#define MOCK_FAIL_OBJECT_PERFECT         ((char *)sxe_jitson_new + 7)
+#define MOCK_FAIL_SYMBOL_TABLE           ((char *)sxe_jitson_new + 8)
+#define MOCK_FAIL_SYMBOL_INTERN          ((char *)sxe_jitson_new + 9)
+#define MOCK_FAIL_ARRAY_SET              ((char *)sxe_jitson_new + 10)
+#define MOCK_FAIL_STACK_RESERVE          ((char *)sxe_jitson_new + 11)
+#define MOCK_FAIL_ARENA_NEW              ((char *)sxe_jitson_new + 12)
+#define MOCK_FAIL_ARENA_BLOCK            ((char *)sxe_jitson_new + 13)
+#define MOCK_FAIL_ARENA_THREAD           ((char *)sxe_jitson_new + 14)
 #define MOCK_FAIL_DUP                    ((char *)sxe_jitson_dup + 0)
 #define MOCK_FAIL_OBJECT_CLONE           ((char *)sxe_jitson_dup + 1)
 #define MOCK_FAIL_ARRAY_CLONE            ((char *)sxe_jitson_dup + 2)
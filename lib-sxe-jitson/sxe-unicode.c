@@ -19,6 +19,9 @@
  * THE SOFTWARE.
  */
 
+#include <stdint.h>
+#include <string.h>
+
 #include "sxe-log.h"
 #include "sxe-unicode.h"
 
@@ -65,3 +68,67 @@ sxe_unicode_to_utf8(unsigned unicode, char *utf_out)
     SXEL2("sxe_unicode_to_utf8: %u is not a valid unicode code point", unicode);
     return 0;
 }
+
+/**
+ * Determine whether a string is valid UTF-8
+ *
+ * @param utf8 The string, which need not be '\0' terminated
+ * @param len  The length of the string in bytes
+ *
+ * @return true if the string is valid UTF-8 as defined by RFC 3629, which disallows overlong encodings, surrogates (U+D800
+ *         through U+DFFF) and code points greater than U+10FFFF
+ *
+ * @note ASCII is skipped 8 bytes at a time, so that the common case of mostly ASCII strings is fast.
+ */
+bool
+sxe_unicode_is_utf8(const char *utf8, size_t len)
+{
+    const unsigned char *next = (const unsigned char *)utf8;
+    const unsigned char *end  = next + len;
+    uint64_t             word;
+    unsigned             i, more;
+    unsigned char        min, max;    // Range of the second byte of a multibyte sequence
+
+    while (next < end) {
+        if (end - next >= (ptrdiff_t)sizeof(word)) {
+            memcpy(&word, next, sizeof(word));
+
+            if (!(word & 0x8080808080808080ULL)) {    // All 8 bytes are ASCII
+                next += sizeof(word);
+                continue;
+            }
+        }
+
+        if (*next < 0x80) {
+            next++;
+            continue;
+        }
+
+        min = 0x80;
+        max = 0xBF;
+
+        if (*next >= 0xC2 && *next <= 0xDF)    // 0xC0 and 0xC1 could only start overlong 2 byte encodings
+            more = 1;
+        else if (*next >= 0xE0 && *next <= 0xEF) {
+            more = 2;
+            min  = *next == 0xE0 ? 0xA0 : min;    // Disallow overlong 3 byte encodings
+            max  = *next == 0xED ? 0x9F : max;    // Disallow surrogates
+        } else if (*next >= 0xF0 && *next <= 0xF4) {
+            more = 3;
+            min  = *next == 0xF0 ? 0x90 : min;    // Disallow overlong 4 byte encodings
+            max  = *next == 0xF4 ? 0x8F : max;    // Disallow code points > U+10FFFF
+        } else
+            return false;    // A continuation byte or a lead byte that is never valid
+
+        if (end - next <= (ptrdiff_t)more || next[1] < min || next[1] > max)
+            return false;
+
+        for (i = 2; i <= more; i++)
+            if ((next[i] & 0xC0) != 0x80)
+                return false;
+
+        next += more + 1;
+    }
+
+    return true;
+}
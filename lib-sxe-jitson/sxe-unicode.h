@@ -22,6 +22,9 @@
 #ifndef SXE_UNICODE_H
 #define SXE_UNICODE_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "sxe-unicode-proto.h"
 
 #endif
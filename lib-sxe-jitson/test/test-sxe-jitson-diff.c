@@ -0,0 +1,187 @@
+/* Test diffs, patches, and merges of jitson values
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <tap.h>
+
+#include "sxe-jitson.h"
+#include "sxe-thread.h"
+
+/* Return true if a jitson's JSON is as expected
+ */
+static bool
+is_json(const struct sxe_jitson *jitson, const char *expected)
+{
+    char *json = sxe_jitson_to_json(jitson, NULL);
+    bool  same = json && strcmp(json, expected) == 0;
+
+    if (!same)
+        diag("Expected %s, got %s", expected, json ?: "NULL");
+
+    kit_free(json);
+    return same;
+}
+
+/* Return true if a patch operation has the expected op and path, and a value with the expected JSON if one is expected
+ */
+static bool
+is_op(const struct sxe_jitson *operation, const char *op, const char *path, const char *value)
+{
+    const struct sxe_jitson *member = sxe_jitson_object_get_member(operation, "value", 5);
+
+    return strcmp(sxe_jitson_get_string(sxe_jitson_object_get_member(operation, "op", 2), NULL), op) == 0
+        && strcmp(sxe_jitson_get_string(sxe_jitson_object_get_member(operation, "path", 4), NULL), path) == 0
+        && (value ? member && is_json(member, value) : !member);
+}
+
+/* Return true if patching from with the diff from from to to results in to
+ */
+static bool
+is_round_trip(const char *from_json, const char *to_json)
+{
+    struct sxe_jitson *from  = sxe_jitson_new(from_json);
+    struct sxe_jitson *to    = sxe_jitson_new(to_json);
+    struct sxe_jitson *patch = sxe_jitson_diff(from, to);
+    struct sxe_jitson *result;
+    char              *expected;
+    bool               same;
+
+    result   = sxe_jitson_patch(from, patch);
+    expected = sxe_jitson_to_json(to, NULL);
+    same     = result && is_json(result, expected);
+    kit_free(expected);
+    sxe_jitson_free(result);
+    sxe_jitson_free(patch);
+    sxe_jitson_free(to);
+    sxe_jitson_free(from);
+    return same;
+}
+
+/* Apply a patch given as JSON, returning the result or NULL on error
+ */
+static struct sxe_jitson *
+patch_with(const struct sxe_jitson *value, const char *patch_json)
+{
+    struct sxe_jitson *patch  = sxe_jitson_new(patch_json);
+    struct sxe_jitson *result = sxe_jitson_patch(value, patch);
+
+    sxe_jitson_free(patch);
+    return result;
+}
+
+int
+main(void)
+{
+    struct sxe_jitson       *from, *to, *patch, *result, *merge;
+    const struct sxe_jitson *member;
+    uint64_t                 start_allocations;
+
+    plan_tests(43);
+    start_allocations = kit_memory_allocations();
+    sxe_jitson_initialize(0, 0);
+
+    diag("Diffs");
+    {
+        from = sxe_jitson_new("{\"a\": 1, \"b\": [1, 2, 3], \"c\": {\"d\": \"x\"}, \"e/~\": true}");
+        to   = sxe_jitson_new("{\"a\": 2, \"b\": [1, 2], \"c\": {\"d\": \"x\", \"f\": null}, \"g\": \"new\"}");
+        ok(patch = sxe_jitson_diff(from, to),                                        "Diffed two objects");
+        is(sxe_jitson_len(patch), 5,                                                "Got the expected number of operations");
+        ok(is_op(sxe_jitson_array_get_element(patch, 0), "replace", "/a", "2"),      "The first operation replaces a");
+        ok(is_op(sxe_jitson_array_get_element(patch, 1), "remove", "/b/2", NULL),    "The second removes the last element of b");
+        ok(is_op(sxe_jitson_array_get_element(patch, 2), "add", "/c/f", "null"),     "The third adds a nested member");
+        ok(is_op(sxe_jitson_array_get_element(patch, 3), "remove", "/e~1~0", NULL),  "The fourth removes an escaped member name");
+        ok(is_op(sxe_jitson_array_get_element(patch, 4), "add", "/g", "\"new\""),    "The fifth adds a member");
+        sxe_jitson_free(patch);
+
+        ok(patch = sxe_jitson_diff(from, from),                                      "Diffed an object with itself");
+        is(sxe_jitson_len(patch), 0,                                                "There are no differences");
+        sxe_jitson_free(patch);
+        sxe_jitson_free(to);
+
+        to = sxe_jitson_new("[\"different\"]");
+        ok(patch = sxe_jitson_diff(from, to),                                        "Diffed values of different types");
+        ok(is_op(sxe_jitson_array_get_element(patch, 0), "replace", "", "[\"different\"]"), "The whole value is replaced");
+        sxe_jitson_free(patch);
+        sxe_jitson_free(to);
+        sxe_jitson_free(from);
+
+        ok(is_round_trip("{\"a\": 1, \"b\": [1, 2, 3], \"c\": {\"d\": \"x\"}}",
+                         "{\"a\": 2, \"b\": [1, 2], \"c\": {\"d\": \"y\"}}"),
+           "Patching with a diff of objects results in the target object");
+        ok(is_round_trip("[1, [2, 3], {\"a\": []}]", "[1, [2, 3, 4, 5], {\"a\": [\"b\"]}, null]"),
+           "Patching with a diff of arrays results in the target array");
+        ok(is_round_trip("[1, 2, 3, 4]", "[0]"),                                     "Patching can remove several elements");
+        ok(is_round_trip("\"string\"", "{\"now\": \"an object\"}"),                 "Patching can replace the whole value");
+    }
+
+    diag("Patches");
+    {
+        from = sxe_jitson_new("{\"big\": {\"x\": [1, 2, 3], \"y\": \"a string that takes more than one jitson\"}, "
+                              "\"list\": [\"first\", \"second\"], \"n\": 0}");
+        ok(result = patch_with(from, "[{\"op\": \"replace\", \"path\": \"/n\", \"value\": 1}]"), "Replaced a member");
+        ok(member = sxe_jitson_object_get_member(result, "big", 3),                  "Got the unchanged member");
+        ok(sxe_jitson_is_reference(member),                                         "It's a reference");
+        ok(sxe_jitson_dereference(member) == sxe_jitson_object_get_member(from, "big", 3), "It refers to the original value");
+        sxe_jitson_free(result);
+
+        ok(result = patch_with(from, "[{\"op\": \"add\", \"path\": \"/list/1\", \"value\": \"between\"},"
+                                     " {\"op\": \"add\", \"path\": \"/list/-\", \"value\": \"last\"},"
+                                     " {\"op\": \"remove\", \"path\": \"/list/0\"},"
+                                     " {\"op\": \"add\", \"path\": \"/big/z\", \"value\": {\"new\": true}},"
+                                     " {\"op\": \"remove\", \"path\": \"/big/y\"}]"), "Applied several operations");
+        ok(is_json(sxe_jitson_object_get_member(result, "list", 4), "[\"between\",\"second\",\"last\"]"), "The list was changed");
+        ok(is_json(sxe_jitson_object_get_member(sxe_jitson_object_get_member(result, "big", 3), "z", 1), "{\"new\":true}"),
+           "The nested member was added");
+        ok(!sxe_jitson_object_get_member(sxe_jitson_object_get_member(result, "big", 3), "y", 1),
+           "The nested member was removed");
+        ok(sxe_jitson_dereference(sxe_jitson_object_get_member(sxe_jitson_object_get_member(result, "big", 3), "x", 1))
+           == sxe_jitson_object_get_member(sxe_jitson_object_get_member(from, "big", 3), "x", 1),
+           "The unchanged nested member still refers to the original value");
+        sxe_jitson_free(result);
+
+        ok(result = patch_with(from, "[]"),                                          "Applied an empty patch");
+        ok(sxe_jitson_dereference(result) == from,                                  "The result refers to the original value");
+        sxe_jitson_free(result);
+
+        errno = 0;
+        ok(!patch_with(from, "[{\"op\": \"remove\", \"path\": \"/missing\"}]"),     "Failed to remove a missing member");
+        is(errno, EINVAL,                                                           "Got the expected error");
+        ok(!patch_with(from, "[{\"op\": \"replace\", \"path\": \"/list/2\", \"value\": 0}]"), "Failed to replace past the end");
+        ok(!patch_with(from, "[{\"op\": \"add\", \"path\": \"/n/x\", \"value\": 0}]"), "Failed to add to a number");
+        ok(!patch_with(from, "[{\"op\": \"add\", \"path\": \"/list/01\", \"value\": 0}]"), "Failed to add at an invalid index");
+        ok(!patch_with(from, "[{\"op\": \"move\", \"path\": \"/n\", \"from\": \"/m\"}]"), "Failed an unsupported operation");
+        ok(!patch_with(from, "[{\"op\": \"add\", \"path\": \"/n\"}]"),              "Failed to add without a value");
+        ok(!patch_with(from, "[{\"op\": \"replace\", \"path\": \"/n\", \"value\": 2}, {\"op\": \"remove\", \"path\": \"\"}]"),
+           "Failed to remove the whole value after a successful operation");
+        sxe_jitson_free(from);
+    }
+
+    diag("Merges");
+    {
+        from  = sxe_jitson_new("{\"a\": \"b\", \"c\": {\"d\": \"e\", \"f\": \"g\"}, \"keep\": [1, 2, 3]}");
+        merge = sxe_jitson_new("{\"a\": \"z\", \"c\": {\"f\": null}, \"h\": {\"i\": null, \"j\": 1}}");
+        ok(result = sxe_jitson_merge(from, merge),                                   "Merged a patch into an object");
+        is(sxe_jitson_len(result), 4,                                               "The merged object has 4 members");
+        ok(is_json(sxe_jitson_object_get_member(result, "a", 1), "\"z\""),          "The patched member was replaced");
+        ok(is_json(sxe_jitson_object_get_member(result, "c", 1), "{\"d\":\"e\"}"),    "The nested null member was removed");
+        ok(is_json(sxe_jitson_object_get_member(result, "h", 1), "{\"j\":1}"),       "The null in the added member was dropped");
+        ok(sxe_jitson_dereference(sxe_jitson_object_get_member(result, "keep", 4))
+           == sxe_jitson_object_get_member(from, "keep", 4),
+           "The unchanged member refers to the original value");
+        sxe_jitson_free(result);
+        sxe_jitson_free(merge);
+
+        merge = sxe_jitson_new("[\"replaced\"]");
+        ok(result = sxe_jitson_merge(from, merge),                                   "Merged a non-object patch");
+        ok(is_json(result, "[\"replaced\"]"),                                       "It replaced the value");
+        sxe_jitson_free(result);
+        sxe_jitson_free(merge);
+        sxe_jitson_free(from);
+    }
+
+    sxe_jitson_finalize();
+    sxe_thread_memory_free(SXE_THREAD_MEMORY_ALL);
+    is(kit_memory_allocations(), start_allocations, "No memory was leaked");
+    return exit_status();
+}
@@ -0,0 +1,184 @@
+/* Test the sxe-jitson compiled expression extension
+ */
+
+#include <errno.h>
+#include <tap.h>
+
+#include "kit-mockfail.h"
+#include "sxe-jitson-expr.h"
+#include "sxe-jitson-in.h"
+#include "sxe-jitson-intersect.h"
+#include "sxe-thread.h"
+
+static unsigned len_op;
+
+static const struct sxe_jitson *
+len_op_default(const struct sxe_jitson *arg)
+{
+    if (!sxe_jitson_supports_len(arg)) {
+        errno = EOPNOTSUPP;
+        return NULL;
+    }
+
+    return sxe_jitson_create_uint(sxe_jitson_len(arg));
+}
+
+int
+main(void)
+{
+    union sxe_jitson_oper_func func;
+    struct sxe_jitson_expr    *expr;
+    struct sxe_jitson         *array, *object, *other;
+    const struct sxe_jitson   *args[2], *result;
+    struct sxe_jitson          value;
+    uint64_t                   start_allocations;
+    unsigned                   i;
+
+    plan_tests(50);
+    start_allocations = kit_memory_allocations();
+    sxe_jitson_initialize(0, SXE_JITSON_FLAG_OPTIMIZE);
+    sxe_jitson_in_init();
+    sxe_jitson_intersect_init();
+    func.unary = len_op_default;
+    len_op     = sxe_jitson_oper_register("len", SXE_JITSON_OPER_UNARY, func);
+
+    array  = sxe_jitson_new("[1,2,3,5,8]");
+    object = sxe_jitson_new("{\"a\":[2,4],\"b\":\"bee\"}");
+    other  = sxe_jitson_new("[2,3,4]");
+
+    diag("Operators with typed handlers resolved at compile time");
+    {
+        ok(expr = sxe_jitson_expr_new(),                                       "Created an expression");
+        ok(sxe_jitson_expr_push_arg(expr, 0, SXE_JITSON_TYPE_INVALID),         "Compiled argument 0 of unknown type");
+        ok(sxe_jitson_expr_push_value(expr, array),                            "Compiled a constant array");
+        ok(sxe_jitson_expr_push_oper(expr, sxe_jitson_oper_in),                "Compiled IN");
+        args[0] = sxe_jitson_make_uint(&value, 5);
+        is(sxe_jitson_expr_eval(expr, args), sxe_jitson_true,                  "5 IN [1,2,3,5,8]");
+        args[0] = sxe_jitson_make_uint(&value, 4);
+        is(sxe_jitson_expr_eval(expr, args), sxe_jitson_null,                  "4 not IN [1,2,3,5,8]");
+        sxe_jitson_expr_free(expr);
+
+        /* len(arg0 INTERSECT [1,2,3,5,8]) with arg0 an array, then with arg0 a string (falls back to dynamic dispatch)
+         */
+        ok(expr = sxe_jitson_expr_new(),                                       "Created an expression");
+        ok(sxe_jitson_expr_push_arg(expr, 0, SXE_JITSON_TYPE_ARRAY),           "Compiled argument 0, an array");
+        ok(sxe_jitson_expr_push_value(expr, array),                            "Compiled a constant array");
+        ok(sxe_jitson_expr_push_oper(expr, sxe_jitson_oper_intersect),         "Compiled INTERSECT");
+        ok(sxe_jitson_expr_push_oper(expr, len_op),                            "Compiled len");
+        args[0] = other;
+        ok(result = sxe_jitson_expr_eval(expr, args),                          "Evaluated len([2,3,4] INTERSECT [1,2,3,5,8])");
+        is(sxe_jitson_get_uint(result), 2,                                     "Result is 2");
+        sxe_jitson_free(result);
+        args[0] = sxe_jitson_make_string_ref(&value, "str");
+        ok(!sxe_jitson_expr_eval(expr, args),                                  "Can't INTERSECT a string with an array");
+        sxe_jitson_expr_free(expr);
+
+        /* (arg1 IN arg0) where arg0 is an object: the result is part of arg 0, so it's returned as a reference
+         */
+        ok(expr = sxe_jitson_expr_new(),                                       "Created an expression");
+        ok(sxe_jitson_expr_push_arg(expr, 1, SXE_JITSON_TYPE_STRING),          "Compiled argument 1, a string");
+        ok(sxe_jitson_expr_push_arg(expr, 0, SXE_JITSON_TYPE_OBJECT),          "Compiled argument 0, an object");
+        ok(sxe_jitson_expr_push_oper(expr, sxe_jitson_oper_in),                "Compiled IN");
+        args[0] = object;
+        args[1] = sxe_jitson_make_string_ref(&value, "b");
+        ok(result = sxe_jitson_expr_eval(expr, args),                          "Evaluated \"b\" IN {...}");
+        is_eq(sxe_jitson_get_string(result, NULL), "bee",                      "Result is \"bee\"");
+        sxe_jitson_free(result);
+        args[0] = array;
+        ok(result = sxe_jitson_expr_eval(expr, args),                          "Evaluated the same expression on an array");
+        is(result, sxe_jitson_null,                                            "\"b\" is not IN [1,2,3,5,8]");
+        sxe_jitson_expr_free(expr);
+    }
+
+    diag("Operators on constants are evaluated at compile time");
+    {
+        ok(expr = sxe_jitson_expr_new(),                                       "Created an expression");
+        sxe_jitson_expr_push_value(expr, sxe_jitson_make_string_ref(&value, "b"));
+        sxe_jitson_expr_push_value(expr, object);
+        ok(sxe_jitson_expr_push_oper(expr, sxe_jitson_oper_in),                "Compiled \"b\" IN {...}");
+        ok(result = sxe_jitson_expr_eval(expr, NULL),                          "Evaluated \"b\" IN {...}");
+        is_eq(sxe_jitson_get_string(result, NULL), "bee",                      "Result is \"bee\"");
+        sxe_jitson_free(result);
+        sxe_jitson_expr_free(expr);
+
+        ok(expr = sxe_jitson_expr_new(),                                       "Created an expression");
+        sxe_jitson_expr_push_value(expr, other);
+        sxe_jitson_expr_push_value(expr, array);
+        sxe_jitson_expr_push_oper(expr, sxe_jitson_oper_intersect);
+        sxe_jitson_expr_push_oper(expr, len_op);
+        ok(result = sxe_jitson_expr_eval(expr, NULL),                          "Evaluated len([2,3,4] INTERSECT [1,2,3,5,8])");
+        is(sxe_jitson_get_uint(result), 2,                                     "Result is 2");
+        sxe_jitson_free(result);
+        sxe_jitson_expr_free(expr);
+    }
+
+    diag("Temporary results allocated from the thread's arena during a request");
+    {
+        struct sxe_jitson_arena *arena;
+        uint64_t                 allocations;
+
+        MOCKFAIL_START_TESTS(1, MOCK_FAIL_ARENA_THREAD);
+        ok(!sxe_jitson_arena_begin_request(),                                  "Failed to allocate the thread's arena");
+        MOCKFAIL_END_TESTS();
+
+        ok(!sxe_jitson_arena_get_request(),                                    "No request is in progress");
+        ok(arena = sxe_jitson_arena_begin_request(),                           "Began a request");
+        is(sxe_jitson_arena_get_request(), arena,                              "The thread's arena is used during the request");
+        expr = sxe_jitson_expr_new();
+        sxe_jitson_expr_push_arg(expr, 0, SXE_JITSON_TYPE_ARRAY);
+        sxe_jitson_expr_push_value(expr, array);
+        sxe_jitson_expr_push_oper(expr, sxe_jitson_oper_intersect);
+        args[0] = other;
+        ok(result = sxe_jitson_expr_eval(expr, args),                          "Evaluated [2,3,4] INTERSECT [1,2,3,5,8]");
+        ok(!sxe_jitson_is_allocated(result),                                   "The result was not allocated");
+        is(sxe_jitson_len(result), 2,                                          "It has 2 elements");
+        allocations = kit_memory_allocations();
+
+        for (i = 0; i < 100; i++)
+            sxe_jitson_free(sxe_jitson_expr_eval(expr, args));
+
+        is(kit_memory_allocations(), allocations,                              "No more memory was allocated for 100 results");
+        sxe_jitson_expr_free(expr);
+
+        expr = sxe_jitson_expr_new();
+        sxe_jitson_expr_push_arg(expr, 0, SXE_JITSON_TYPE_ARRAY);
+        ok(result = sxe_jitson_expr_eval(expr, args),                          "Evaluated an expression returning an argument");
+        ok(!sxe_jitson_is_allocated(result) && sxe_jitson_dereference(result) == other, "It's a reference in the arena");
+        sxe_jitson_expr_free(expr);
+
+        ok(result = sxe_jitson_new("[1, 2]"),                                  "Parsed a value during the request");
+        ok(sxe_jitson_is_allocated(result),                                    "Values not from expressions are still allocated");
+        sxe_jitson_free(result);
+        ok(!sxe_jitson_stack_get_thread()->arena,                              "The thread's stack only uses the arena in eval");
+
+        is(sxe_jitson_arena_begin_request(), arena,                            "Began a nested request");
+        sxe_jitson_arena_end_request();
+        is(sxe_jitson_arena_get_request(), arena,                              "The arena is used until the outer request ends");
+        sxe_jitson_arena_end_request();
+        ok(!sxe_jitson_arena_get_request(),                                    "The request ended");
+        ok(!sxe_jitson_stack_get_thread()->arena,                              "The thread's stack no longer uses the arena");
+    }
+
+    diag("Failure cases");
+    {
+        MOCKFAIL_START_TESTS(1, MOCK_FAIL_EXPR_NEW);
+        ok(!sxe_jitson_expr_new(),                                             "Failed to allocate an expression");
+        MOCKFAIL_END_TESTS();
+
+        expr = sxe_jitson_expr_new();
+        MOCKFAIL_START_TESTS(2, MOCK_FAIL_EXPR_APPEND);
+        ok(!sxe_jitson_expr_push_value(expr, array),                           "Failed to allocate instructions");
+        is(errno, ENOMEM,                                                      "Error is ENOMEM");
+        MOCKFAIL_END_TESTS();
+        sxe_jitson_expr_free(expr);
+    }
+
+    sxe_jitson_free(array);
+    sxe_jitson_free(object);
+    sxe_jitson_free(other);
+    sxe_jitson_oper_fini();
+    sxe_jitson_finalize();
+    sxe_thread_memory_free(SXE_THREAD_MEMORY_ALL);
+    is(kit_memory_allocations(), start_allocations, "No memory was leaked");
+    return exit_status();
+}
@@ -1,6 +1,7 @@
 /* Test the sxe-jitson operator extension
  */
 
+#include <errno.h>
 #include <string.h>
 #include <tap.h>
 
@@ -90,7 +91,7 @@ main(void)
     uint64_t                   start_allocations;
     unsigned                   and_op;
 
-    tap_plan(90, TAP_FLAG_LINE_ON_OK, NULL);    // Display test line numbers in OK messages (useful for tracing)
+    tap_plan(139, TAP_FLAG_LINE_ON_OK, NULL);    // Display test line numbers in OK messages (useful for tracing)
     start_allocations = kit_memory_allocations();
     // KIT_ALLOC_SET_LOG(1);    // Turn off when done
 
@@ -386,6 +387,146 @@ main(void)
         sxe_jitson_free(coll_rhs);
     }
 
+    diag("Test IN and INTERSECT on large unordered arrays, which use a hash set");
+    {
+        unsigned unhashed;
+
+        collection = sxe_jitson_new("[\"domain-one.example\", 7, \"b\", [\"nested\", \"x\"], 3.5, \"domain-two.example\", "
+                                    "true, null, 2, {\"k\": 1}, \"domain-three.example\", 12, \"c\", 42, "
+                                    "\"domain-four.example\", \"domain-four.example\", 1e3, \"zz\"]");
+        ok(!(collection->type & (SXE_JITSON_TYPE_IS_ORD | SXE_JITSON_TYPE_IS_UNIF)), "Array is unordered and not uniform");
+        is(sxe_jitson_in(sxe_jitson_make_uint(&arg, 7), collection), sxe_jitson_true,      "7 is in the array");
+        is(sxe_jitson_in(sxe_jitson_make_number(&arg, 2.0), collection), sxe_jitson_true,  "2.0 is in the array (as 2)");
+        is(sxe_jitson_in(sxe_jitson_make_uint(&arg, 1000), collection), sxe_jitson_true,   "1000 is in the array (as 1e3)");
+        is(sxe_jitson_in(sxe_jitson_make_bool(&arg, false), collection), sxe_jitson_null,  "false is not in the array");
+        is(sxe_jitson_in(sxe_jitson_make_string_ref(&arg, "domain-one.example"), collection), sxe_jitson_true,
+           "A long string is in the array");
+        is(sxe_jitson_in(sxe_jitson_make_string_ref(&arg, "missing"), collection), sxe_jitson_null,
+           "A missing string is not in the array");
+        ok(result = sxe_jitson_in(sxe_jitson_make_string_ref(&arg, "x"), collection), "IN is transitive for hashed arrays");
+        is(sxe_jitson_get_type(result), SXE_JITSON_TYPE_ARRAY,                               "Found the nested array");
+        ok(result = sxe_jitson_in(sxe_jitson_make_string_ref(&arg, "k"), collection), "IN is transitive to nested objects");
+        is(sxe_jitson_get_type(result), SXE_JITSON_TYPE_OBJECT,                              "Found the nested object");
+        is(sxe_jitson_array_find(collection, sxe_jitson_make_string_ref(&arg, "domain-four.example"), &unhashed), 14,
+           "Found the first of the duplicate strings");
+        is(unhashed, 3,                                                                       "The nested array wasn't hashed");
+        is(sxe_jitson_array_find(collection, sxe_jitson_array_get_element(collection, 3), NULL), ~0U,
+           "Can't find an array in a hash set");
+        is(errno, EINVAL,                                                                     "Error is EINVAL");
+
+        ok(coll_rhs = sxe_jitson_dup(collection),                                             "Duplicated the hashed array");
+        is(sxe_jitson_in(sxe_jitson_make_string_ref(&arg, "c"), coll_rhs), sxe_jitson_true,  "\"c\" is in the duplicate");
+        sxe_jitson_free(coll_rhs);
+
+        coll_rhs = sxe_jitson_new("[\"b\", 42, \"nope\", [\"nested\", \"x\"]]");
+        ok(result = sxe_jitson_intersect(coll_rhs, collection),                              "Intersected with a hashed array");
+        is(sxe_jitson_len(result), 3,                                                         "Intersection has 3 elements");
+        sxe_jitson_free(result);
+        is(sxe_jitson_intersect_test(coll_rhs, collection), sxe_jitson_true,                  "Arrays intersect");
+        sxe_jitson_free(coll_rhs);
+        coll_rhs = sxe_jitson_new("[\"nope\", 99]");
+        is(sxe_jitson_intersect_test(coll_rhs, collection), sxe_jitson_false,                 "Arrays don't intersect");
+        sxe_jitson_free(coll_rhs);
+        sxe_jitson_free(collection);
+
+        collection = sxe_jitson_new("[\"domain-one.example\", 7, \"b\", \"a\", 3.5, \"domain-two.example\", true, null, 2, "
+                                    "false, \"domain-three.example\", 12, \"c\", 42, \"domain-four.example\", 1e3]");
+        MOCKFAIL_START_TESTS(2, MOCK_FAIL_ARRAY_SET);
+        is(sxe_jitson_in(sxe_jitson_make_uint(&arg, 42), collection), sxe_jitson_true,     "Found 42 without a hash set");
+        is(sxe_jitson_in(sxe_jitson_make_uint(&arg, 43), collection), sxe_jitson_null,     "Didn't find 43 without a hash set");
+        MOCKFAIL_END_TESTS();
+        is(sxe_jitson_in(sxe_jitson_make_uint(&arg, 42), collection), sxe_jitson_true,     "Found 42 with a hash set");
+        sxe_jitson_free(collection);
+
+        collection = sxe_jitson_new("[\"p\", \"c\", \"x\", \"a\", \"m\", \"q\", \"b\", \"z\", \"d\", \"y\", \"e\", \"w\", "
+                                    "\"f\", \"v\", \"g\", \"u\"]");
+        is(collection->type & (SXE_JITSON_TYPE_IS_ORD | SXE_JITSON_TYPE_IS_UNIF | SXE_JITSON_TYPE_HAS_SET),
+           SXE_JITSON_TYPE_IS_UNIF | SXE_JITSON_TYPE_HAS_SET,                                "Unordered uniform array has a set");
+        is(sxe_jitson_in(sxe_jitson_make_string_ref(&arg, "g"), collection), sxe_jitson_true, "g is in the uniform array");
+        is(sxe_jitson_in(sxe_jitson_make_string_ref(&arg, "h"), collection), sxe_jitson_null, "h is not in the uniform array");
+        ok(*sxe_jitson_array_get_set_slot(collection),                                        "The uniform array was hashed");
+        is(sxe_jitson_in(sxe_jitson_make_uint(&arg, 1), collection), sxe_jitson_null,      "1 is not in the uniform array");
+        coll_rhs = sxe_jitson_new("[\"zz\", [\"g\"]]");
+        errno    = 0;
+        is(sxe_jitson_intersect_test(coll_rhs, collection), sxe_jitson_false,                 "Unhashable elems don't intersect");
+        is(errno, 0,                                                                          "Falling back didn't set errno");
+        sxe_jitson_free(coll_rhs);
+        ok(coll_rhs = sxe_jitson_dup(collection),                                             "Duplicated the hashed array");
+        ok(!*sxe_jitson_array_get_set_slot(coll_rhs),                                         "The duplicate has no set yet");
+        is(sxe_jitson_in(sxe_jitson_make_string_ref(&arg, "u"), coll_rhs), sxe_jitson_true,  "u is in the duplicate");
+        sxe_jitson_free(coll_rhs);
+        sxe_jitson_free(collection);
+    }
+
+    diag("Test INTERSECT on ordered arrays of unsigned integers and short strings, which compares their values directly");
+    {
+        struct sxe_jitson *evens, *threes;
+        char              *json;
+        size_t             len;
+        unsigned           i;
+
+        json = kit_malloc(8 * 1000 + 3);
+
+        for (len = 0, i = 0; i < 1000; i++)
+            len += sprintf(&json[len], "%c%u", i ? ',' : '[', 2 * i);
+
+        strcpy(&json[len], "]");
+        evens = sxe_jitson_new(json);
+
+        for (len = 0, i = 0; i < 1000; i++)
+            len += sprintf(&json[len], "%c%u", i ? ',' : '[', 3 * i);
+
+        strcpy(&json[len], "]");
+        threes = sxe_jitson_new(json);
+        kit_free(json);
+
+        ok(result = sxe_jitson_intersect(evens, threes),                        "Intersected arrays of similar size");
+        is(sxe_jitson_len(result), 334,                                          "Intersection has 334 elements");
+        is(sxe_jitson_get_uint(sxe_jitson_array_get_element(result, 333)), 1998, "Last is 1998");
+        sxe_jitson_free(result);
+
+        collection = sxe_jitson_new("[3, 6, 600, 1998, 5000]");
+        ok(result = sxe_jitson_intersect(collection, evens),                     "Intersected a short array with a long one");
+        is_eq(json = sxe_jitson_to_json(result, NULL), "[6,600,1998]",           "Intersection is correct");
+        kit_free(json);
+        sxe_jitson_free(result);
+        ok(result = sxe_jitson_intersect(evens, collection),                     "Intersected a long array with a short one");
+        is_eq(json = sxe_jitson_to_json(result, NULL), "[6,600,1998]",           "Intersection is correct");
+        kit_free(json);
+        sxe_jitson_free(result);
+        is(sxe_jitson_intersect_test(collection, threes), sxe_jitson_true,       "Short array intersects with a long one");
+        is(sxe_jitson_intersect_test(threes, collection), sxe_jitson_true,       "Long array intersects with a short one");
+        sxe_jitson_free(collection);
+
+        collection = sxe_jitson_new("[1, 5001, 5003]");
+        is(sxe_jitson_intersect_test(collection, evens), sxe_jitson_false,       "Odd numbers don't intersect with evens");
+        sxe_jitson_free(collection);
+
+        MOCKFAIL_START_TESTS(1, SXE_JITSON_INTERSECT_RAW);
+        ok(!sxe_jitson_intersect(evens, threes),                                 "Can't intersect if matches can't be allocated");
+        MOCKFAIL_END_TESTS();
+        sxe_jitson_free(threes);
+        sxe_jitson_free(evens);
+
+        collection = sxe_jitson_new("[1, 2, 2, 2, 3]");
+        coll_rhs   = sxe_jitson_new("[2, 2, 4]");
+        ok(result = sxe_jitson_intersect(collection, coll_rhs),                  "Intersected arrays with duplicates");
+        is_eq(json = sxe_jitson_to_json(result, NULL), "[2,2]",                  "Duplicates are matched pairwise");
+        kit_free(json);
+        sxe_jitson_free(result);
+        sxe_jitson_free(coll_rhs);
+        sxe_jitson_free(collection);
+
+        collection = sxe_jitson_new("[\"a\", \"ab\", \"abc\", \"b\", \"zzzzzzz\"]");
+        coll_rhs   = sxe_jitson_new("[\"\", \"ab\", \"abd\", \"b\", \"ba\"]");
+        ok(result = sxe_jitson_intersect(collection, coll_rhs),                  "Intersected arrays of short strings");
+        is_eq(json = sxe_jitson_to_json(result, NULL), "[\"ab\",\"b\"]",           "Intersection is correct");
+        kit_free(json);
+        sxe_jitson_free(result);
+        sxe_jitson_free(coll_rhs);
+        sxe_jitson_free(collection);
+    }
+
     sxe_jitson_oper_fini();
     sxe_jitson_type_fini();
     sxe_thread_memory_free(SXE_THREAD_MEMORY_ALL);
@@ -0,0 +1,159 @@
+/* Test parallel loading of large JSON arrays and NDJSON
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <tap.h>
+
+#include "sxe-jitson.h"
+#include "sxe-thread.h"
+
+#define ELEMENTS 100000    // Enough elements that the JSON is split into several chunks
+
+/* Load JSON with a single thread, for comparison
+ */
+static struct sxe_jitson *
+load_sequential(const char *json, size_t len, uint32_t flags)
+{
+    struct sxe_jitson_source source;
+
+    sxe_jitson_source_from_buffer(&source, json, len, flags);
+    return sxe_jitson_stack_load_json(sxe_jitson_stack_get_thread(), &source)
+           ? sxe_jitson_stack_get_jitson(sxe_jitson_stack_get_thread()) : NULL;
+}
+
+/* Return true if JSON loaded in parallel is the same as when loaded by a single thread, including its array flags
+ */
+static bool
+is_same_as_sequential(const struct sxe_jitson *array, const char *json, size_t len, uint32_t flags)
+{
+    struct sxe_jitson *expected = load_sequential(json, len, flags);
+    char              *expected_json, *array_json;
+    bool               same;
+
+    expected_json = sxe_jitson_to_json(expected, NULL);
+    array_json    = sxe_jitson_to_json(array, NULL);
+    same          = array->type == expected->type && strcmp(array_json, expected_json) == 0;
+    kit_free(array_json);
+    kit_free(expected_json);
+    sxe_jitson_free(expected);
+    return same;
+}
+
+int
+main(void)
+{
+    struct sxe_jitson *array;
+    char              *json;
+    size_t             len, size;
+    uint64_t           start_allocations;
+    unsigned           i;
+
+    plan_tests(39);
+    start_allocations = kit_memory_allocations();
+    sxe_jitson_initialize(0, 0);
+    size = (size_t)ELEMENTS * 48 + 8;
+    json = kit_malloc(size);
+
+    diag("Large arrays");
+    {
+        for (len = 0, i = 0; i < ELEMENTS; i++)
+            len += snprintf(&json[len], size - len, "%c%u", i ? ',' : '[', i);
+
+        len += snprintf(&json[len], size - len, "]\n");
+        ok(array = sxe_jitson_parallel_load_array(json, len, SXE_JITSON_FLAG_OPTIMIZE, 4),  "Loaded an ordered array");
+        is(sxe_jitson_len(array), ELEMENTS,                                                 "It has all the elements");
+        is(sxe_jitson_get_uint(sxe_jitson_array_get_element(array, ELEMENTS - 1)), ELEMENTS - 1, "The last one is correct");
+        ok(array->type & SXE_JITSON_TYPE_IS_ORD,                                            "It's ordered");
+        ok(is_same_as_sequential(array, json, len, SXE_JITSON_FLAG_OPTIMIZE),               "It's the same as a sequential load");
+        sxe_jitson_free(array);
+
+        json[1] = '9';    // The first element is now 9, so the array is no longer ordered
+        ok(array = sxe_jitson_parallel_load_array(json, len, SXE_JITSON_FLAG_OPTIMIZE, 4),  "Loaded an unordered array");
+        ok(!(array->type & SXE_JITSON_TYPE_IS_ORD),                                         "It's not ordered");
+        ok(is_same_as_sequential(array, json, len, SXE_JITSON_FLAG_OPTIMIZE),               "It's the same as a sequential load");
+        sxe_jitson_free(array);
+
+        for (len = 0, i = 0; i < ELEMENTS; i++)
+            len += i % 3 == 0 ? snprintf(&json[len], size - len, "%c\"string, number %u\"", i ? ',' : '[', i)
+                 : i % 3 == 1 ? snprintf(&json[len], size - len, ",{\"i\": %u, \"a\": [%u, \"]\"]}", i, i)
+                 :              snprintf(&json[len], size - len, ",%u.5", i);
+
+        len += snprintf(&json[len], size - len, "]");
+        ok(array = sxe_jitson_parallel_load_array(json, len, SXE_JITSON_FLAG_OPTIMIZE, 0),  "Loaded a mixed array");
+        is(sxe_jitson_len(array), ELEMENTS,                                                 "It has all the elements");
+        ok(!(array->type & (SXE_JITSON_TYPE_IS_HOMO | SXE_JITSON_TYPE_IS_UNIF)),            "It's not homogenous or uniform");
+        ok(is_same_as_sequential(array, json, len, SXE_JITSON_FLAG_OPTIMIZE),               "It's the same as a sequential load");
+        sxe_jitson_free(array);
+
+        ok(array = sxe_jitson_parallel_load_array(json, len, SXE_JITSON_FLAG_LAZY, 4),      "Loaded the array lazily");
+        ok(sxe_jitson_array_get_element(array, 1)->type & SXE_JITSON_TYPE_IS_LAZY,          "Its objects are lazy");
+        is(sxe_jitson_get_uint(sxe_jitson_object_get_member(sxe_jitson_array_get_element(array, ELEMENTS - 3), "i", 1)),
+           ELEMENTS - 3,                                                                    "A lazy object is parsed on access");
+        sxe_jitson_free(array);
+
+        json[len - 1] = ',';
+        errno         = 0;
+        ok(!sxe_jitson_parallel_load_array(json, len, 0, 4),                                "Failed to load without the ']'");
+        is(errno, EINVAL,                                                                   "Got the expected error");
+        json[len - 1]                  = ']';
+        *strstr(json, "{\"i\": 50002") = '}';    // Break one of the elements in the middle
+        errno                          = 0;
+        ok(!sxe_jitson_parallel_load_array(json, len, 0, 4),                                "Failed to load an invalid element");
+        is(errno, EINVAL,                                                                   "Got the expected error");
+        ok(!sxe_jitson_parallel_load_array(&json[1], len - 1, 0, 4),                        "Failed to load a non-array");
+
+        ok(array = sxe_jitson_parallel_load_array(" [1, 2] ", 8, 0, 4),                    "Loaded a small array");
+        is(sxe_jitson_len(array), 2,                                                        "It has both elements");
+        sxe_jitson_free(array);
+        ok(!sxe_jitson_parallel_load_array("[1, 2] 3", 8, 0, 4),                            "Failed to load an array with junk");
+
+        memset(json, ' ', size);
+        json[0]        = '[';
+        json[size - 1] = ']';
+        ok(array = sxe_jitson_parallel_load_array(json, size, SXE_JITSON_FLAG_OPTIMIZE, 4), "Loaded a large empty array");
+        is(sxe_jitson_len(array), 0,                                                        "It has no elements");
+        sxe_jitson_free(array);
+    }
+
+    diag("NDJSON");
+    {
+        for (len = 0, i = 0; i < ELEMENTS; i++)
+            len += snprintf(&json[len], size - len, "{\"id\": %u, \"name\": \"line\\n%u\"}\r\n%s", i, i, i % 7 ? "" : "\n");
+
+        ok(array = sxe_jitson_parallel_load_ndjson(json, len, SXE_JITSON_FLAG_OPTIMIZE, 4), "Loaded NDJSON");
+        is(sxe_jitson_len(array), ELEMENTS,                                                 "It has all the documents");
+        is(sxe_jitson_get_uint(sxe_jitson_object_get_member(sxe_jitson_array_get_element(array, ELEMENTS / 2), "id", 2)),
+           ELEMENTS / 2,                                                                    "The middle one is correct");
+        sxe_jitson_free(array);
+
+        json[len - 2] = ' ';    // The last line no longer ends with a newline
+        ok(array = sxe_jitson_parallel_load_ndjson(json, len - 1, 0, 4),                    "Loaded without a final newline");
+        is(sxe_jitson_len(array), ELEMENTS,                                                 "It has all the documents");
+        sxe_jitson_free(array);
+
+        ok(array = sxe_jitson_parallel_load_ndjson("", 0, 0, 4),                            "Loaded empty NDJSON");
+        is(sxe_jitson_len(array), 0,                                                        "It has no documents");
+        sxe_jitson_free(array);
+        errno = 0;
+        ok(!sxe_jitson_parallel_load_ndjson("{}\n[] []\n", 9, 0, 4),                        "Failed to load 2 values on a line");
+        is(errno, EINVAL,                                                                   "Got the expected error");
+        errno = 0;
+        ok(!sxe_jitson_parallel_load_ndjson("{\"a\":\n1}\n", 9, 0, 4),                       "Failed to load a value on 2 lines");
+        is(errno, EINVAL,                                                                   "Got the expected error");
+
+        for (len = 0, i = 0; i < ELEMENTS; i++)    // Wherever the chunks are split, a value on 2 lines is rejected the same way
+            len += snprintf(&json[len], size - len, i % 1000 == 999 ? "[%u,\n%u]\n" : "[%u, %u]\n", i, i);
+
+        errno = 0;
+        ok(!sxe_jitson_parallel_load_ndjson(json, len, 0, 4),                               "Failed to load values on 2 lines");
+        is(errno, EINVAL,                                                                   "Got the expected error");
+    }
+
+    kit_free(json);
+    sxe_jitson_finalize();
+    sxe_thread_memory_free(SXE_THREAD_MEMORY_ALL);
+    is(kit_memory_allocations(), start_allocations, "No memory was leaked");
+    return exit_status();
+}
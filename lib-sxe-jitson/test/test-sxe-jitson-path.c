@@ -0,0 +1,103 @@
+/* Test the sxe-jitson compiled path API
+ */
+
+#include <errno.h>
+#include <tap.h>
+
+#include "kit-mockfail.h"
+#include "sxe-jitson-path.h"
+#include "sxe-thread.h"
+
+int
+main(void)
+{
+    struct sxe_jitson_source  source;
+    struct sxe_jitson_path   *path;
+    struct sxe_jitson        *jitson;
+    struct sxe_jitson_stack  *stack;
+    const struct sxe_jitson  *value;
+    uint64_t                  start_allocations;
+
+    plan_tests(33);
+    start_allocations = kit_memory_allocations();
+    sxe_jitson_initialize(0, 0);
+    stack = sxe_jitson_stack_get_thread();
+
+    diag("Happy path cases");
+    {
+        ok(jitson = sxe_jitson_new("{\"a\":{\"b\":[0,1,2,{\"c\":\"found\"}],\"d\":[[5,6]]}}"), "Parsed an object");
+        ok(path = sxe_jitson_path_compile("a.b[3].c"),                                    "Compiled 'a.b[3].c'");
+        is(path->count, 4,                                                               "It has 4 steps");
+        ok(value = sxe_jitson_path_eval(path, jitson),                                   "Evaluated it");
+        is_eq(sxe_jitson_get_string(value, NULL), "found",                               "Found the expected value");
+        ok(sxe_jitson_path_eval(path, jitson) == value,                                  "Evaluated it again");
+        sxe_jitson_path_free(path);
+
+        ok(path = sxe_jitson_path_compile("a.d[0][1]"),                                  "Compiled 'a.d[0][1]'");
+        is(sxe_jitson_get_uint(sxe_jitson_path_eval(path, jitson)), 6,                   "Found 6");
+        sxe_jitson_path_free(path);
+
+        ok(path = sxe_jitson_path_compile(""),                                           "Compiled the empty path");
+        ok(sxe_jitson_path_eval(path, jitson) == jitson,                                 "It evaluates to the root");
+        sxe_jitson_path_free(path);
+
+        ok(path = sxe_jitson_path_compile("[1].x"),                                      "Compiled '[1].x'");
+        sxe_jitson_free(jitson);
+        sxe_jitson_source_from_string(&source, "[0,{\"x\":true}]", SXE_JITSON_FLAG_INTERN);
+        ok(sxe_jitson_stack_load_json(stack, &source),                                   "Loaded an array with interning");
+        jitson = sxe_jitson_stack_get_jitson(stack);
+        ok(sxe_jitson_get_bool(sxe_jitson_path_eval(path, jitson)),                      "Found true with interned member names");
+        sxe_jitson_path_free(path);
+        sxe_jitson_free(jitson);
+    }
+
+    diag("Evaluation failures");
+    {
+        ok(jitson = sxe_jitson_new("{\"a\":[1,2],\"b\":3}"),                             "Parsed an object");
+        ok(path = sxe_jitson_path_compile("c"),                                          "Compiled 'c'");
+        ok(!sxe_jitson_path_eval(path, jitson),                                          "No member 'c'");
+        is(errno, ENOKEY,                                                                "Error is ENOKEY");
+        sxe_jitson_path_free(path);
+        ok(path = sxe_jitson_path_compile("a[2]"),                                       "Compiled 'a[2]'");
+        ok(!sxe_jitson_path_eval(path, jitson),                                          "No element 2");
+        is(errno, ERANGE,                                                                "Error is ERANGE");
+        sxe_jitson_path_free(path);
+        ok(path = sxe_jitson_path_compile("b.c"),                                        "Compiled 'b.c'");
+        ok(!sxe_jitson_path_eval(path, jitson),                                          "Can't get a member of a number");
+        is(errno, EINVAL,                                                                "Error is EINVAL");
+        sxe_jitson_path_free(path);
+        ok(path = sxe_jitson_path_compile("b[0]"),                                       "Compiled 'b[0]'");
+        ok(!sxe_jitson_path_eval(path, jitson),                                          "Can't get an element of a number");
+        is(errno, EINVAL,                                                                "Error is EINVAL");
+        sxe_jitson_path_free(path);
+        sxe_jitson_free(jitson);
+    }
+
+    diag("Compilation failures");
+    {
+        const char *invalid[] = {".a", "a.", "a..b", "a.[0]", "a[", "a[x]", "a[1", "a[1]b"};
+        unsigned    i, failed;
+
+        for (failed = 0, i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+            failed += !sxe_jitson_path_compile(invalid[i]) && errno == EINVAL;
+
+        is(failed, sizeof(invalid) / sizeof(invalid[0]),                                 "All invalid paths failed with EINVAL");
+
+        MOCKFAIL_START_TESTS(2, sxe_jitson_path_compile);
+        ok(!sxe_jitson_path_compile("a.b"),                                              "Failed to allocate a path");
+        is(errno, ENOMEM,                                                                "Error is ENOMEM");
+        MOCKFAIL_END_TESTS();
+
+        MOCKFAIL_START_TESTS(2, MOCK_FAIL_SYMBOL_INTERN);
+        MOCKFAIL_SET_SKIP(1);
+        ok(!sxe_jitson_path_compile("a.b"),                                              "Failed to intern the second name");
+        is(errno, ENOMEM,                                                                "Error is ENOMEM");
+        MOCKFAIL_END_TESTS();
+        is(sxe_jitson_symbol_count(), 0,                                                 "No symbols were leaked");
+    }
+
+    sxe_jitson_finalize();
+    sxe_thread_memory_free(SXE_THREAD_MEMORY_ALL);
+    is(kit_memory_allocations(), start_allocations, "No memory was leaked");
+    return exit_status();
+}
@@ -14,7 +14,7 @@ main(void)
     size_t                   len;
     uint64_t                 start_allocations;
 
-    plan_tests(28);
+    plan_tests(39);
     start_allocations = kit_memory_allocations();
     // KIT_ALLOC_SET_LOG(1);    // Turn off when done
 
@@ -92,6 +92,46 @@ main(void)
         is(sxe_jitson_source_peek_token(&source, &len), NULL, "Correctly detected lack of token in buffer source");
     }
 
+    diag("Test string scanning and UTF-8 validation");
+    {
+        struct sxe_jitson_stack *stack = sxe_jitson_stack_get_thread();
+        struct sxe_jitson       *jitson;
+
+        sxe_jitson_type_init(0, 0);    // Needed to free the loaded strings
+        sxe_jitson_source_from_string(&source, "\"0123456789abcdefghij\\n\"", SXE_JITSON_FLAG_STRICT);
+        source.next++;
+        is(sxe_jitson_source_scan_string(&source), 20,         "Scanned up to the backslash in a string source");
+        sxe_jitson_source_from_buffer(&source, "0123456789abcdefghij", 19, SXE_JITSON_FLAG_STRICT);
+        is(sxe_jitson_source_scan_string(&source), 19,         "Scanned up to the end of a buffer source");
+        sxe_jitson_source_from_buffer(&source, "01234567\x01", 9, SXE_JITSON_FLAG_STRICT);
+        is(sxe_jitson_source_scan_string(&source), 8,          "Scanned up to a control character");
+
+        sxe_jitson_source_from_string(&source, "\"0123456789abcdefghij\\n0123456789abcdefghijklmnopqrstuvwxyz\\\"\"",
+                                      SXE_JITSON_FLAG_STRICT);
+        ok(sxe_jitson_stack_load_string(stack, &source),      "Loaded a long string with escapes");
+        jitson = sxe_jitson_stack_get_jitson(stack);
+        is_eq(sxe_jitson_get_string(jitson, NULL), "0123456789abcdefghij\n0123456789abcdefghijklmnopqrstuvwxyz\"",
+              "Got the expected string");
+        sxe_jitson_free(jitson);
+
+        sxe_jitson_source_from_string(&source, "\"line 1\nline 2\"", SXE_JITSON_FLAG_STRICT);
+        sxe_jitson_source_set_file_line(&source, NULL, 1);
+        ok(sxe_jitson_stack_load_string(stack, &source),      "Loaded a string containing a newline");
+        is(source.line, 2,                                    "Newlines in strings are still counted");
+        sxe_jitson_free(sxe_jitson_stack_get_jitson(stack));
+
+        sxe_jitson_source_from_string(&source, "\"caf\xC3\xA9\"", SXE_JITSON_FLAG_VALID_UTF8);
+        ok(sxe_jitson_stack_load_string(stack, &source),      "Loaded a valid UTF-8 string when validating");
+        sxe_jitson_free(sxe_jitson_stack_get_jitson(stack));
+        sxe_jitson_source_from_string(&source, "\"caf\xC3(\"", SXE_JITSON_FLAG_VALID_UTF8);
+        ok(!sxe_jitson_stack_load_string(stack, &source),     "Failed to load an invalid UTF-8 string when validating");
+        is(errno, EILSEQ,                                     "errno is EILSEQ");
+        sxe_jitson_source_from_string(&source, "\"caf\xC3(\"", SXE_JITSON_FLAG_STRICT);
+        ok(sxe_jitson_stack_load_string(stack, &source),      "Loaded an invalid UTF-8 string when not validating");
+        sxe_jitson_free(sxe_jitson_stack_get_jitson(stack));
+        sxe_jitson_type_fini();
+    }
+
     diag("Test repeated sxe_jitson_source_get_char()");
     {
         /* Although nothing currently does this, ensure that repeated calls at end-of-string work */
@@ -1,6 +1,7 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <string.h>
 #include <tap.h>
@@ -67,6 +68,29 @@ test_constructing_ordered_array(const char *name, bool expect_ordered, ...)
     test_stacked_array_is_ordered(stack, name, expect_ordered);
 }
 
+/* Intern and release the same names many times, racing with other threads doing the same
+ */
+static void *
+intern_thread(void *unused)
+{
+    const struct sxe_jitson_symbol *symbol;
+    char                            name[16];
+    unsigned                        i;
+
+    SXE_UNUSED_PARAMETER(unused);
+
+    for (i = 0; i < 100000; i++) {
+        snprintf(name, sizeof(name), "name%u", i % 100);
+
+        if (!(symbol = sxe_jitson_symbol_intern(name, 0)) || strcmp(symbol->name, name) != 0)
+            return NULL;
+
+        sxe_jitson_symbol_release(symbol);
+    }
+
+    return (void *)1;
+}
+
 int
 main(void)
 {
@@ -79,7 +103,7 @@ main(void)
     size_t                   len;
     uint64_t                 start_allocations;
 
-    tap_plan(520 + 5 * 27, TAP_FLAG_LINE_ON_OK, NULL);    // Display test line numbers in OK messages (useful for tracing)
+    tap_plan(597 + 5 * 27 + 29 + 16 + 24, TAP_FLAG_LINE_ON_OK, NULL);    // Display test line numbers in OK messages (useful for tracing)
     start_allocations = kit_memory_allocations();
     // KIT_ALLOC_SET_LOG(1);    // Turn off when done
 
@@ -210,6 +234,32 @@ main(void)
         sxe_jitson_free(jitson);
         errno = 0;
 
+        ok(jitson = sxe_jitson_new("0777"),                     "Parsed '0777' (error %s)", strerror(errno));
+        is(sxe_jitson_get_uint(jitson), 0777,                   "With hex enabled, a leading 0 is octal, as with strtoul");
+        sxe_jitson_free(jitson);
+
+        ok(jitson = sxe_jitson_new("18446744073709551615"),     "Parsed the largest uint (error %s)", strerror(errno));
+        is(sxe_jitson_get_uint(jitson), UINT64_MAX,             "It's value is UINT64_MAX");
+        is(errno, 0,                                            "Error = %s", strerror(errno));
+        sxe_jitson_free(jitson);
+
+        ok(jitson = sxe_jitson_new("18446744073709551616"),     "Parsed a uint that's too large (error %s)", strerror(errno));
+        is(sxe_jitson_get_uint(jitson), UINT64_MAX,             "It's value is UINT64_MAX");
+        is(errno, ERANGE,                                       "Error = %s", strerror(errno));
+        sxe_jitson_free(jitson);
+        errno = 0;
+
+        /* Numbers that take the Clinger, Eisel-Lemire, and strtod paths must all be correctly rounded
+         */
+        const char *numbers[] = {"123456.789e-3", "0.000123456789012345678", "-9007199254740993", "2.2250738585072014E-308",
+                                 "4.9E-324", "1.7976931348623157e308", "1e400", "3.14159265358979323846264338327950288"};
+
+        for (len = 0; len < sizeof(numbers) / sizeof(numbers[0]); len++) {
+            jitson = sxe_jitson_new(numbers[len]);
+            ok(jitson && sxe_jitson_get_number(jitson) == strtod(numbers[len], NULL), "Parsed %s correctly", numbers[len]);
+            sxe_jitson_free(jitson);
+        }
+
         ok(jitson = sxe_jitson_new("\"\""),                                "Parsed '\"\"' (error %s)", strerror(errno));
         is(sxe_jitson_get_type(jitson),            SXE_JITSON_TYPE_STRING, "'\"\"' is a string");
         is_eq(sxe_jitson_get_string(jitson, NULL), "",                     "Correct value");
@@ -405,6 +455,80 @@ main(void)
         kit_free(json_out);
     }
 
+    diag("Test perfect hash indexing of large optimized objects");
+    {
+        char     big_json[2048], name[16];
+        unsigned i, found;
+
+        for (len = 0, i = 0; i < 2 * SXE_JITSON_PERFECT_MIN; i++)
+            len += snprintf(&big_json[len], sizeof(big_json) - len, "%c\"member%u\":%u", i ? ',' : '{', i, i);
+
+        snprintf(&big_json[len], sizeof(big_json) - len, "}");
+        sxe_jitson_source_from_string(&source, big_json, SXE_JITSON_FLAG_OPTIMIZE);
+        ok(sxe_jitson_stack_load_json(stack, &source),              "Loaded a large object with optimization");
+        ok(jitson = sxe_jitson_stack_get_jitson(stack),             "Got the object from the stack");
+        ok(jitson->type & SXE_JITSON_TYPE_IS_PERF,                  "Large optimized object will be perfectly hashed");
+
+        for (found = 0, i = 0; i < 2 * SXE_JITSON_PERFECT_MIN; i++) {
+            snprintf(name, sizeof(name), "member%u", i);
+            found += (member = sxe_jitson_object_get_member(jitson, name, 0)) && sxe_jitson_get_uint(member) == i;
+        }
+
+        is(found, 2 * SXE_JITSON_PERFECT_MIN,                       "Found all members");
+        ok(jitson->type & SXE_JITSON_TYPE_IS_PERF,                  "Object was indexed with a perfect hash");
+        ok(!sxe_jitson_object_get_member(jitson, "member9999", 0),  "No member 'member9999'");
+        is(errno, ENOKEY,                                           "Error is ENOKEY");
+        ok(!sxe_jitson_object_get_member(jitson, "member1", 6),     "No member 'member' (prefix of 'member1')");
+        ok(member = sxe_jitson_object_get_member(jitson, "member12", 7), "Found 'member1' given a length");
+        is(sxe_jitson_get_uint(member), 1,                          "It's value is 1");
+
+        ok(clone = sxe_jitson_dup(jitson),                          "Duplicated the perfectly hashed object");
+        ok(member = sxe_jitson_object_get_member(clone, "member127", 0), "Found 'member127' in the clone");
+        is(sxe_jitson_get_uint(member), 127,                        "It's value is 127");
+        json_out = sxe_jitson_to_json(clone, &len);
+        is(len, strlen(big_json),                                   "Clone encodes to JSON of the same length");
+        kit_free(json_out);
+        sxe_jitson_free(clone);
+        sxe_jitson_free(jitson);
+
+        MOCKFAIL_START_TESTS(2, MOCK_FAIL_OBJECT_PERFECT);
+        sxe_jitson_source_from_string(&source, big_json, SXE_JITSON_FLAG_OPTIMIZE);
+        jitson = sxe_jitson_stack_load_json(stack, &source) ? sxe_jitson_stack_get_jitson(stack) : NULL;
+        ok(jitson && (member = sxe_jitson_object_get_member(jitson, "member64", 0)), "Failure to allocate falls back");
+
+        if (jitson)
+            ok(!(jitson->type & SXE_JITSON_TYPE_IS_PERF),           "Object was not perfectly hashed");
+        else
+            skip(1, "Failed to load the object");
+
+        MOCKFAIL_END_TESTS();
+        sxe_jitson_free(jitson);
+
+        memcpy(&big_json[1], "\"member1\"", sizeof("\"member1\"") - 1);    // Make the first member name a duplicate
+        sxe_jitson_source_from_string(&source, big_json, SXE_JITSON_FLAG_OPTIMIZE);
+        ok(sxe_jitson_stack_load_json(stack, &source),              "Loaded a large object with a duplicate member name");
+        ok(jitson = sxe_jitson_stack_get_jitson(stack),             "Got the object from the stack");
+        ok(member = sxe_jitson_object_get_member(jitson, "member2", 0), "Found 'member2'");
+        ok(!(jitson->type & SXE_JITSON_TYPE_IS_PERF),               "Duplicate member names prevent perfect hashing");
+        sxe_jitson_free(jitson);
+
+        sxe_jitson_flags |= SXE_JITSON_FLAG_OPTIMIZE;
+        sxe_jitson_stack_open_object(stack, "constructed");
+
+        for (i = 0; i < SXE_JITSON_PERFECT_MIN; i++) {
+            snprintf(name, sizeof(name), "m%u", i);
+            sxe_jitson_stack_add_member_uint(stack, name, i);
+        }
+
+        sxe_jitson_stack_close_object(stack, "constructed");
+        sxe_jitson_flags &= ~SXE_JITSON_FLAG_OPTIMIZE;
+        ok(jitson = sxe_jitson_stack_get_jitson(stack),             "Constructed a large object with optimization");
+        ok(jitson->type & SXE_JITSON_TYPE_IS_PERF,                  "Constructed object will be perfectly hashed");
+        ok(member = sxe_jitson_object_get_member(jitson, "m63", 0), "Found 'm63'");
+        is(sxe_jitson_get_uint(member), 63,                         "It's value is 63");
+        sxe_jitson_free(jitson);
+    }
+
     diag("Test array element function and reencoding");
     {
         ok(jitson = sxe_jitson_new("[0, \"anotherlongstring\", {\"member\": null}, true]"),
@@ -1206,6 +1330,240 @@ main(void)
         is(errno, EOVERFLOW,                                                                            "It's EOVERFLOW");
     }
 
+    diag("Test shortest round trip formatting of numbers and fast string escaping");
+    {
+        const char *numbers[][2] = {{"0.1", "0.1"}, {"0.30000000000000004", "0.30000000000000004"}, {"1e21", "1E+21"},
+                                    {"1e-7", "1E-07"}, {"5e-324", "5E-324"}, {"-0.0", "-0"}, {"123.456e3", "123456"},
+                                    {"1.7976931348623157e308", "1.7976931348623157E+308"}, {"1E16", "1E+16"},
+                                    {"-1234567890123456", "-1234567890123456"}, {"18446744073709551615", "18446744073709551615"}};
+        char        buf[SXE_JITSON_NUMBER_MAX_LEN + 1];
+        unsigned    i;
+
+        for (i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++) {
+            jitson = sxe_jitson_new(numbers[i][0]);
+            is_eq(json_out = sxe_jitson_to_json(jitson, NULL), numbers[i][1], "Formatted %s as expected", numbers[i][0]);
+            kit_free(json_out);
+            sxe_jitson_free(jitson);
+        }
+
+        buf[sxe_jitson_number_to_str(0.1 + 0.2, buf)] = '\0';
+        ok(strtod(buf, NULL) == 0.1 + 0.2, "0.1 + 0.2 formatted as %s round trips", buf);
+
+        ok(jitson = sxe_jitson_new("\"0123456789abcd\\u0001ef\\\"01234567\\\\\""), "Parsed a string with escapes near word boundaries");
+        is_eq(json_out = sxe_jitson_to_json(jitson, NULL), "\"0123456789abcd\\u0001ef\\u002201234567\\u005c\"",
+              "Escaped characters in and after the 8 byte words are encoded");
+        kit_free(json_out);
+        sxe_jitson_free(jitson);
+    }
+
+    diag("Test interning of member names");
+    {
+        const struct sxe_jitson_symbol *alpha, *beta;
+        pthread_t                       threads[4];
+        void                           *result;
+        char                            big_json[2048];
+        unsigned                        i, interned, symbols;
+
+        symbols = sxe_jitson_symbol_count();
+        sxe_jitson_source_from_string(&source, "{\"alpha\":1,\"beta\":{\"alpha\":2},\"gamma\":[{\"beta\":3}]}",
+                                      SXE_JITSON_FLAG_INTERN);
+        ok(sxe_jitson_stack_load_json(stack, &source),                   "Loaded an object with interned member names");
+        ok(jitson = sxe_jitson_stack_get_jitson(stack),                  "Got the object from the stack");
+        is(sxe_jitson_symbol_count(), symbols + 3,                       "Three distinct member names were interned");
+        is(sxe_jitson_size(jitson), 12,                                  "Interned member names take one jitson each");
+        ok(sxe_jitson_get_symbol(jitson + 1),                            "First member name is a symbol");
+        is_eq(sxe_jitson_get_string(jitson + 1, &len), "alpha",          "It's 'alpha'");
+        is(len, 5,                                                       "It's length is 5");
+        ok(member = sxe_jitson_object_get_member(jitson, "beta", 0),     "Found member 'beta' by name");
+        is(sxe_jitson_get_symbol(jitson + 1), sxe_jitson_get_symbol(member + 1), "Both 'alpha's are the same symbol");
+
+        ok(alpha = sxe_jitson_symbol_intern("alpha", 0),                 "Interned 'alpha'");
+        is(alpha, sxe_jitson_get_symbol(jitson + 1),                     "It's the symbol used by the object");
+        ok(beta = sxe_jitson_symbol_intern("betamax", 4),                "Interned 'beta' given a length");
+        is(sxe_jitson_symbol_count(), symbols + 3,                       "No new symbols were added");
+        is(sxe_jitson_get_uint(sxe_jitson_object_get_member_symbol(member, alpha)), 2, "Found nested 'alpha' by symbol");
+        ok(!sxe_jitson_object_get_member_symbol(member, beta),           "Nested object has no member 'beta'");
+        is(errno, ENOKEY,                                                "Error is ENOKEY");
+        is_eq(json_out = sxe_jitson_to_json(jitson, NULL), "{\"alpha\":1,\"beta\":{\"alpha\":2},\"gamma\":[{\"beta\":3}]}",
+              "Object with interned member names encodes as JSON");
+        kit_free(json_out);
+
+        ok(clone = sxe_jitson_dup(jitson),                               "Duplicated the object");
+        sxe_jitson_free(jitson);
+        is(sxe_jitson_symbol_count(), symbols + 3,                       "Clone holds references to the symbols");
+        is(sxe_jitson_get_symbol(clone + 1), alpha,                      "Clone's first member name is the same symbol");
+        sxe_jitson_free(clone);
+        is(sxe_jitson_symbol_count(), symbols + 2,                       "Only the symbols still referenced remain");
+
+        ok(jitson = sxe_jitson_new("{\"alpha\":0,\"beta\":1}"),          "Parsed an object without interning");
+        is(sxe_jitson_get_uint(sxe_jitson_object_get_member_symbol(jitson, beta)), 1, "Found 'beta' by symbol anyway");
+        sxe_jitson_free(jitson);
+        sxe_jitson_symbol_release(alpha);
+        sxe_jitson_symbol_release(beta);
+        is(sxe_jitson_symbol_count(), symbols,                           "All symbols were freed");
+
+        sxe_jitson_source_from_string(&source, "{\"alpha\":1,\"beta\":[{\"gamma\":2},]}", SXE_JITSON_FLAG_INTERN);
+        ok(!sxe_jitson_stack_load_json(stack, &source),                  "Failed to load invalid JSON with interning");
+        is(sxe_jitson_symbol_count(), symbols,                           "Symbols in discarded values were released");
+
+        MOCKFAIL_START_TESTS(2, MOCK_FAIL_SYMBOL_TABLE);
+        sxe_jitson_source_from_string(&source, "{\"alpha\":1}", SXE_JITSON_FLAG_INTERN);
+        ok(!sxe_jitson_stack_load_json(stack, &source),                  "Failed to load JSON when the symbol table can't be allocated");
+        is(errno, ENOMEM,                                                "Error is ENOMEM");
+        MOCKFAIL_END_TESTS();
+
+        MOCKFAIL_START_TESTS(2, MOCK_FAIL_SYMBOL_INTERN);
+        sxe_jitson_source_from_string(&source, "{\"alpha\":1}", SXE_JITSON_FLAG_INTERN);
+        ok(!sxe_jitson_stack_load_json(stack, &source),                  "Failed to load JSON when a symbol can't be allocated");
+        is(sxe_jitson_symbol_count(), symbols,                           "No symbols were leaked");
+        MOCKFAIL_END_TESTS();
+
+        for (len = 0, i = 0; i < 2 * SXE_JITSON_PERFECT_MIN; i++)
+            len += snprintf(&big_json[len], sizeof(big_json) - len, "%c\"member%u\":%u", i ? ',' : '{', i, i);
+
+        snprintf(&big_json[len], sizeof(big_json) - len, "}");
+        sxe_jitson_source_from_string(&source, big_json, SXE_JITSON_FLAG_OPTIMIZE | SXE_JITSON_FLAG_INTERN);
+        ok(sxe_jitson_stack_load_json(stack, &source),                   "Loaded a large object with optimization and interning");
+        ok(jitson = sxe_jitson_stack_get_jitson(stack),                  "Got the object from the stack");
+        ok(alpha = sxe_jitson_symbol_intern("member99", 0),              "Interned 'member99'");
+        is(sxe_jitson_get_uint(sxe_jitson_object_get_member_symbol(jitson, alpha)), 99, "Found 'member99' by symbol");
+        ok(jitson->type & SXE_JITSON_TYPE_IS_PERF,                       "Object was indexed with a perfect hash");
+        is(sxe_jitson_get_uint(sxe_jitson_object_get_member(jitson, "member98", 0)), 98, "Found 'member98' by name");
+        sxe_jitson_symbol_release(alpha);
+        ok(alpha = sxe_jitson_symbol_intern("member999", 0),             "Interned 'member999'");
+        ok(!sxe_jitson_object_get_member_symbol(jitson, alpha),          "Object has no 'member999'");
+        sxe_jitson_symbol_release(alpha);
+        sxe_jitson_free(jitson);
+        is(sxe_jitson_symbol_count(), symbols,                           "All symbols were freed");
+
+        for (i = 0; i < 4; i++)
+            pthread_create(&threads[i], NULL, intern_thread, NULL);
+
+        for (interned = i = 0; i < 4; i++) {
+            pthread_join(threads[i], &result);
+            interned += result != NULL;
+        }
+
+        is(interned, 4,                                                  "Threads interned and released names concurrently");
+        is(sxe_jitson_symbol_count(), symbols,                           "All of their symbols were freed");
+    }
+
+    diag("Test stack growth, reservation, and arenas");
+    {
+        struct sxe_jitson_stack *own_stack;
+        struct sxe_jitson_arena *arena;
+        struct sxe_jitson       *first;
+        char                     json[1024];
+        unsigned                 i;
+
+        ok(own_stack = sxe_jitson_stack_new(1),                             "Created a stack with 1 jitson");
+        is(sxe_jitson_stack_expand(own_stack, 5), 0,                        "Expanded it by 5 jitsons");
+        is(own_stack->maximum, 8,                                           "Stack doubled in size until it was large enough");
+        ok(sxe_jitson_stack_reserve(own_stack, 100),                        "Reserved 100 more jitsons");
+        is(own_stack->maximum, 105,                                         "Stack has room for exactly 100 more");
+        ok(sxe_jitson_stack_reserve(own_stack, 10),                         "Reserved 10 more jitsons");
+        is(own_stack->maximum, 105,                                         "Stack didn't change size");
+        MOCKFAIL_START_TESTS(1, MOCK_FAIL_STACK_RESERVE);
+        ok(!sxe_jitson_stack_reserve(own_stack, 1000),                      "Can't reserve if realloc fails");
+        MOCKFAIL_END_TESTS();
+        sxe_jitson_stack_clear(own_stack);
+
+        for (len = 0, i = 0; i < 200; i++)
+            len += snprintf(&json[len], sizeof(json) - len, "%c%u", i ? ',' : '[', i);
+
+        snprintf(&json[len], sizeof(json) - len, "]");
+        sxe_jitson_source_from_buffer(&source, json, strlen(json), SXE_JITSON_FLAG_STRICT);
+        ok(sxe_jitson_stack_load_json(own_stack, &source),                  "Loaded an array from a buffer");
+        ok(own_stack->maximum >= strlen(json) / 8,                          "Space was reserved based on the buffer length");
+        ok(jitson = sxe_jitson_stack_get_jitson(own_stack),                 "Got the array");
+        is(sxe_jitson_len(jitson), 200,                                     "It has 200 elements");
+        sxe_jitson_free(jitson);
+
+        MOCKFAIL_START_TESTS(1, MOCK_FAIL_ARENA_NEW);
+        ok(!sxe_jitson_arena_new(0),                                        "Can't create an arena if malloc fails");
+        MOCKFAIL_END_TESTS();
+        ok(arena = sxe_jitson_arena_new(8),                                 "Created an arena with blocks of 8 jitsons");
+        sxe_jitson_stack_use_arena(own_stack, arena);
+
+        sxe_jitson_source_from_string(&source, "{\"a\":[1,2],\"b\":\"a string longer than 7 characters\"}", 0);
+        ok(sxe_jitson_stack_load_json(own_stack, &source),                  "Loaded an object");
+        ok(first = sxe_jitson_stack_get_jitson(own_stack),                  "Got the object from the arena");
+        ok(!sxe_jitson_is_allocated(first),                                 "Object is not separately allocated");
+        ok(own_stack->jitsons,                                              "Stack kept its memory");
+        is(sxe_jitson_get_uint(sxe_jitson_array_get_element(sxe_jitson_object_get_member(first, "a", 0), 1)), 2,
+           "Indexed the object and the array in it");
+        sxe_jitson_free(first);    // Does nothing
+
+        sxe_jitson_source_from_buffer(&source, json, strlen(json), SXE_JITSON_FLAG_STRICT);
+        ok(sxe_jitson_stack_load_json(own_stack, &source),                  "Loaded an array larger than the arena's blocks");
+        ok(jitson = sxe_jitson_stack_get_jitson(own_stack),                 "Got the array from the arena");
+        is(sxe_jitson_get_uint(sxe_jitson_array_get_element(jitson, 199)), 199, "Last element is 199");
+        is_eq(sxe_jitson_get_string(sxe_jitson_object_get_member(first, "b", 0), NULL), "a string longer than 7 characters",
+              "First value is still intact");
+
+        sxe_jitson_source_from_string(&source, "[true]", 0);
+        ok(sxe_jitson_stack_load_json(own_stack, &source),                  "Loaded a small array");
+        MOCKFAIL_START_TESTS(1, MOCK_FAIL_ARENA_BLOCK);
+        ok(!sxe_jitson_stack_get_jitson(own_stack),                         "Can't get a value if a block can't be allocated");
+        MOCKFAIL_END_TESTS();
+        ok(jitson = sxe_jitson_stack_get_jitson(own_stack),                 "Got the array on retry");
+        sxe_jitson_arena_reset(arena);
+
+        sxe_jitson_source_from_string(&source, "[false]", 0);
+        ok(sxe_jitson_stack_load_json(own_stack, &source),                  "Loaded another small array");
+        ok(jitson = sxe_jitson_stack_get_jitson(own_stack),                 "Got the array from the reset arena");
+        ok(!sxe_jitson_test(sxe_jitson_array_get_element(jitson, 0)),       "Its element is false");
+        sxe_jitson_stack_use_arena(own_stack, NULL);
+        sxe_jitson_arena_free(arena);
+        sxe_jitson_stack_free(own_stack);
+    }
+
+    diag("Test lazy parsing of nested arrays and objects");
+    {
+        const struct sxe_jitson *lazy, *nested;
+        struct sxe_jitson       *dup;
+        char                    *second;
+        const char              *json = "{\"a\":{\"b\":[1,2,{\"c\":\"}\\\"]\"}]},\"d\":[3,4],\"e\":\"x\"}";
+
+        sxe_jitson_source_from_string(&source, json, SXE_JITSON_FLAG_LAZY);
+        ok(sxe_jitson_stack_load_json(stack, &source),                      "Loaded JSON lazily");
+        ok(jitson = sxe_jitson_stack_get_jitson(stack),                     "Got the object");
+        is(sxe_jitson_size(jitson), 9,                                      "Nested values take 2 jitsons each");
+        lazy = sxe_jitson_object_get_member(jitson, "a", 0);
+        ok(lazy->type & SXE_JITSON_TYPE_IS_LAZY && !lazy->jitref,           "Member 'a' is an unparsed lazy reference");
+        is(sxe_jitson_get_type(lazy), SXE_JITSON_TYPE_OBJECT,               "Member 'a' is an object");
+        ok(lazy->jitref,                                                    "Getting its type parsed it");
+        ok(nested = sxe_jitson_object_get_member(lazy, "b", 0),             "Got member 'b' of the lazy object");
+        ok(nested->type & SXE_JITSON_TYPE_IS_LAZY,                          "Member 'b' is also lazy");
+        is_eq(sxe_jitson_get_string(sxe_jitson_object_get_member(sxe_jitson_array_get_element(nested, 2), "c", 0), NULL),
+              "}\"]",                                                         "Brackets in strings were skipped");
+        is(sxe_jitson_len(sxe_jitson_object_get_member(jitson, "d", 0)), 2, "Unparsed member 'd' has 2 elements");
+        ok(dup = sxe_jitson_new(json),                                      "Parsed the same JSON eagerly");
+        is_eq(json_out = sxe_jitson_to_json(jitson, NULL), second = sxe_jitson_to_json(dup, NULL),
+              "The lazy object is encoded the same way as the eager one");
+        kit_free(json_out);
+        kit_free(second);
+        sxe_jitson_free(dup);
+        ok(dup = sxe_jitson_dup(jitson),                                    "Duplicated the lazy object");
+        ok(!sxe_jitson_object_get_member(dup, "a", 0)->jitref,              "Its lazy reference will be parsed independently");
+        is(sxe_jitson_get_type(sxe_jitson_object_get_member(dup, "a", 0)), SXE_JITSON_TYPE_OBJECT, "And can be");
+        sxe_jitson_free(dup);
+        sxe_jitson_free(jitson);
+
+        sxe_jitson_source_from_string(&source, "[[1],{\"x\" 2}]", SXE_JITSON_FLAG_LAZY | SXE_JITSON_FLAG_OPTIMIZE);
+        ok(sxe_jitson_stack_load_json(stack, &source),                      "Loaded an array with invalid nested JSON lazily");
+        ok(jitson = sxe_jitson_stack_get_jitson(stack),                     "Got the array");
+        ok(!(jitson->type & (SXE_JITSON_TYPE_IS_ORD | SXE_JITSON_TYPE_IS_HOMO)), "Arrays of lazy values are not ordered");
+        is(sxe_jitson_get_type(sxe_jitson_array_get_element(jitson, 1)), SXE_JITSON_TYPE_NULL, "Invalid lazy JSON is null");
+        is(errno, EINVAL,                                                   "And errno is EINVAL");
+        sxe_jitson_free(jitson);
+
+        sxe_jitson_source_from_string(&source, "[1,[\"]\"", SXE_JITSON_FLAG_LAZY);
+        ok(!sxe_jitson_stack_load_json(stack, &source),                     "Failed to lazily load an unterminated array");
+        is(errno, EINVAL,                                                   "And errno is EINVAL");
+        errno = 0;
+    }
+
     sxe_jitson_type_fini();
     sxe_thread_memory_free(SXE_THREAD_MEMORY_ALL);
     is(kit_memory_allocations(), start_allocations, "No memory was leaked");
@@ -10,7 +10,7 @@ main(void)
     size_t memory;
     char   utf8[8];
 
-    plan_tests(10);
+    plan_tests(19);
     memset(utf8, 0, sizeof(utf8));
     memory = test_memory();
 
@@ -24,6 +24,16 @@ main(void)
     is_eq(utf8,                               "\xF0\x90\x8D\x88", "'\U00010348' is encoded as 0xF0 0x90 0x8D 0x88");
     is(sxe_unicode_to_utf8(0xFFFFFFFF, utf8), 0,                  "0xFFFFFFFF is an invalid code point");
 
+    ok(sxe_unicode_is_utf8("plain ASCII that is longer than 8 bytes", 39),    "ASCII is valid UTF-8");
+    ok(sxe_unicode_is_utf8("\xC2\xA2 \xE2\x82\xAC \xF0\x90\x8D\x88", 11),       "2, 3 and 4 byte sequences are valid");
+    ok(!sxe_unicode_is_utf8("\xC0\x80", 2),                                   "Overlong 2 byte encodings are invalid");
+    ok(!sxe_unicode_is_utf8("\xE0\x80\x80", 3),                               "Overlong 3 byte encodings are invalid");
+    ok(!sxe_unicode_is_utf8("\xED\xA0\x80", 3),                               "Surrogates are invalid");
+    ok(!sxe_unicode_is_utf8("\xF4\x90\x80\x80", 4),                           "Code points > U+10FFFF are invalid");
+    ok(!sxe_unicode_is_utf8("12345678\xE2\x82", 10),                          "Truncated sequences are invalid");
+    ok(!sxe_unicode_is_utf8("\xE2\x82(", 3),                                   "Bad continuation bytes are invalid");
+    ok(!sxe_unicode_is_utf8("\x80", 1),                                       "Unexpected continuation bytes are invalid");
+
     is(test_memory(),                         memory,             "No memory was leaked");
     return exit_status();
 }